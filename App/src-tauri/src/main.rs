@@ -11,6 +11,7 @@
 use tauri_appconicrypt_lab_lib as lib;
 use lib::Config;
 
+mod protocol;
 mod ws;
 
 #[tauri::command]
@@ -40,8 +41,12 @@ async fn main() {
     });
 
     // 4️ Arrancar Tauri una vez que los servicios están listos
+    let plotter_url = config.plotter_url.clone();
     tauri::Builder::default()
         .invoke_handler(tauri::generate_handler![ping])
+        .register_uri_scheme_protocol(protocol::SCHEME, move |_app, request| {
+            protocol::handle(&plotter_url, request)
+        })
         .run(tauri::generate_context!())
         .expect("error while running tauri application");
 }
\ No newline at end of file
@@ -0,0 +1,88 @@
+//----------------------------------------------------------------//
+// PROTOCOL - Esquema conic:// para respuestas binarias del núcleo
+//----------------------------------------------------------------//
+
+use std::{error::Error, thread};
+
+use tauri::http::{Request, Response, ResponseBuilder};
+
+/// Nombre del esquema: el frontend pide `conic://localhost/<ruta>`
+/// (`https://conic.localhost/<ruta>` en Windows; `convertFileSrc` de
+/// @tauri-apps/api construye la URL correcta).
+pub const SCHEME: &str = "conic";
+
+/// Rutas del esquema y su ruta equivalente en el servidor Python.
+const ROUTES: &[(&str, &str)] = &[("/vertices", "/conic/vertices")];
+
+/// Atiende una petición `conic://` reenviándola al plotter.
+///
+/// # Detalles
+/// - El cuerpo (JSON con coeficientes y opciones) se reenvía tal cual.
+/// - La respuesta del núcleo es binaria y se devuelve sin tocar como
+///   `application/octet-stream`: el WebView la recibe en un ArrayBuffer
+///   sin pasar por JSON ni base64.
+/// - El handler se ejecuta en el hilo del bucle de eventos, dentro del
+///   runtime de Tokio de `main`; el cliente bloqueante de reqwest no puede
+///   usarse ahí, así que la petición va en un hilo aparte.
+///
+/// # Argumentos
+/// - `plotter_url`: URL base del servidor Python.
+/// - `request`: Petición recibida por el WebView.
+pub fn handle(plotter_url: &str, request: &Request) -> Result<Response, Box<dyn Error>> {
+    let path = request
+        .uri()
+        .split("://")
+        .nth(1)
+        .and_then(|rest| rest.find('/').map(|i| &rest[i..]))
+        .unwrap_or("/");
+    let path = path.split('?').next().unwrap_or(path);
+
+    let target = match ROUTES.iter().find(|(from, _)| *from == path) {
+        Some((_, to)) => format!("{}{}", plotter_url.trim_end_matches('/'), to),
+        None => {
+            return ResponseBuilder::new()
+                .status(404)
+                .header("Access-Control-Allow-Origin", "*")
+                .mimetype("text/plain")
+                .body(format!("Ruta desconocida: {}", path).into_bytes());
+        }
+    };
+
+    let body = request.body().clone();
+    let forwarded = thread::spawn(move || -> Result<(u16, String, Vec<u8>), String> {
+        let res = reqwest::blocking::Client::new()
+            .post(&target)
+            .header("Content-Type", "application/json")
+            .body(body)
+            .send()
+            .map_err(|e| e.to_string())?;
+        let status = res.status().as_u16();
+        let mimetype = res
+            .headers()
+            .get("Content-Type")
+            .and_then(|v| v.to_str().ok())
+            .unwrap_or("application/octet-stream")
+            .to_string();
+        let bytes = res.bytes().map_err(|e| e.to_string())?.to_vec();
+        Ok((status, mimetype, bytes))
+    })
+    .join();
+
+    match forwarded {
+        Ok(Ok((status, mimetype, bytes))) => ResponseBuilder::new()
+            .status(status)
+            .header("Access-Control-Allow-Origin", "*")
+            .mimetype(&mimetype)
+            .body(bytes),
+        Ok(Err(e)) => ResponseBuilder::new()
+            .status(502)
+            .header("Access-Control-Allow-Origin", "*")
+            .mimetype("text/plain")
+            .body(format!("Plotter no disponible: {}", e).into_bytes()),
+        Err(_) => ResponseBuilder::new()
+            .status(500)
+            .header("Access-Control-Allow-Origin", "*")
+            .mimetype("text/plain")
+            .body(b"Error interno del protocolo".to_vec()),
+    }
+}
@@ -2,18 +2,533 @@
 // WS - Servidor WebSocket (Tokio + tokio-tungstenite)
 //----------------------------------------------------------------//
 
+use std::collections::HashMap;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, Mutex};
+
 use futures_util::{SinkExt, StreamExt};
-use tokio::net::TcpListener;
+use serde::{Deserialize, Serialize};
+use serde_json::{value::RawValue, Map, Value};
+use tokio::net::{TcpListener, TcpStream};
+use tokio::sync::broadcast::{self, error::RecvError};
+use tokio::sync::{mpsc, watch};
+use tokio::task::JoinHandle;
 use tokio_tungstenite::{accept_async, tungstenite::Message};
 use crate::lib::Config;
 
+/// Mensajes pendientes de envío por conexión. Si el cliente no lee, la
+/// cola se llena, el cálculo de esa conexión espera y deja de leerse su
+/// socket: la presión vuelve al cliente en vez de crecer en memoria.
+const OUTBOX_CAPACITY: usize = 32;
+
+/// Frames que un suscriptor puede llevar de retraso en un tema. Quien se
+/// queda más atrás se da de baja (`dropped`) en vez de frenar al resto.
+const TOPIC_CAPACITY: usize = 16;
+
+//--------------------------------//
+// Protocolo
+//--------------------------------//
+
+/// Coeficientes de la cónica y opciones del núcleo.
+#[derive(Debug, Clone, Deserialize, Serialize)]
+pub struct ConicRequest {
+    #[serde(rename = "A")]
+    pub a: f64,
+    #[serde(rename = "B")]
+    pub b: f64,
+    #[serde(rename = "C")]
+    pub c: f64,
+    #[serde(rename = "D")]
+    pub d: f64,
+    #[serde(rename = "E")]
+    pub e: f64,
+    #[serde(rename = "F")]
+    pub f: f64,
+    /// Resto de opciones (`window`, `samples`, …): se reenvían tal cual.
+    #[serde(flatten)]
+    pub options: Map<String, Value>,
+}
+
+/// Mensajes del cliente, distinguidos por el campo `type`.
+#[derive(Debug, Deserialize)]
+#[serde(tag = "type", rename_all = "snake_case")]
+pub enum ClientMessage {
+    /// Analizar una cónica; `id` vuelve en la respuesta.
+    Conic {
+        id: u64,
+        #[serde(flatten)]
+        request: ConicRequest,
+    },
+    /// Recibir los resultados del tema (y el último, si ya hay uno).
+    Subscribe { topic: String },
+    Unsubscribe { topic: String },
+    /// Calcular una cónica para todos los suscriptores del tema. Como con
+    /// `Conic`, cada `id` recibe (por el tema) `result`, `error` o
+    /// `superseded`; una cónica igual a la ya calculada recibe ese mismo
+    /// resultado con su `id`.
+    Publish {
+        topic: String,
+        id: u64,
+        #[serde(flatten)]
+        request: ConicRequest,
+    },
+    Ping,
+}
+
+/// Mensajes del servidor, distinguidos por el campo `event`.
+#[derive(Debug, Serialize)]
+#[serde(tag = "event", rename_all = "snake_case")]
+pub enum ServerMessage<'a> {
+    Connected,
+    Pong,
+    /// Respuesta del núcleo a la petición `id`, incrustada sin reparsear.
+    Result {
+        #[serde(skip_serializing_if = "Option::is_none")]
+        topic: Option<&'a str>,
+        id: u64,
+        result: &'a RawValue,
+    },
+    /// La petición `id` no se calculará (o se abandonó a medias) porque
+    /// llegó otra cónica más nueva: cada `id` recibe `result`, `error` o
+    /// `superseded`. En un tema, también lleva `topic`.
+    Superseded {
+        #[serde(skip_serializing_if = "Option::is_none")]
+        topic: Option<&'a str>,
+        id: u64,
+    },
+    /// Suscripción cortada por ir demasiado atrasada.
+    Dropped { topic: &'a str },
+    /// Fallo de la petición `id`; en un tema, también lleva `topic`.
+    Error {
+        #[serde(skip_serializing_if = "Option::is_none")]
+        topic: Option<&'a str>,
+        #[serde(skip_serializing_if = "Option::is_none")]
+        id: Option<u64>,
+        error: String,
+    },
+}
+
+impl ServerMessage<'_> {
+    /// Serializa el mensaje como JSON.
+    pub fn text(&self) -> String {
+        serde_json::to_string(self).expect("ServerMessage siempre serializa")
+    }
+
+    /// Serializa el mensaje como frame de texto.
+    pub fn frame(&self) -> Message {
+        Message::Text(self.text())
+    }
+}
+
+//--------------------------------//
+// Cálculo
+//--------------------------------//
+
+/// Envía el cuerpo JSON de una cónica a `/conic` del plotter y devuelve
+/// su respuesta sin tocar.
+async fn forward_conic(
+    client: &reqwest::Client,
+    url: &str,
+    body: Vec<u8>,
+) -> Result<Box<RawValue>, String> {
+    let res = client
+        .post(url)
+        .header("Content-Type", "application/json")
+        .body(body)
+        .send()
+        .await
+        .map_err(|e| format!("Plotter no disponible: {}", e))?;
+    let bytes = res.bytes().await.map_err(|e| e.to_string())?;
+    serde_json::from_slice(&bytes).map_err(|e| format!("Respuesta inválida del núcleo: {}", e))
+}
+
+/// Última cónica pedida por una conexión (o publicada en un tema). `seq`
+/// la numera quien la envía, así que distingue dos peticiones aunque el
+/// cliente repita `id`.
+#[derive(Debug, Clone)]
+struct Latest {
+    seq: u64,
+    id: u64,
+    request: ConicRequest,
+}
+
+/// Calcula siempre la última cónica recibida por la conexión.
+///
+/// # Detalles
+/// - El canal `watch` guarda solo el valor más reciente: las peticiones
+///   que llegan mientras otra está en el núcleo se pisan entre sí y solo
+///   se calcula la última. `taken` guarda el `seq` de la que se tomó,
+///   para que el lector conteste `superseded` a las pisadas sin tomar.
+/// - Una cónica nueva también abandona la petición en curso (`select!`
+///   suelta su future y con él la conexión al plotter), que recibe
+///   `superseded`: nunca se espera a un resultado ya viejo.
+/// - Termina al cerrarse la conexión (se suelta el `watch::Sender`) o
+///   el escritor.
+async fn compute_latest(
+    mut requests: watch::Receiver<Option<Latest>>,
+    taken: Arc<AtomicU64>,
+    outbox: mpsc::Sender<Message>,
+    client: reqwest::Client,
+    url: Arc<str>,
+) {
+    // true si ya hay una cónica nueva sin tomar (la vio el select!)
+    let mut ready = false;
+    loop {
+        if !ready && requests.changed().await.is_err() {
+            break;
+        }
+        ready = false;
+
+        // Se marca como tomada bajo el cerrojo del watch: el lector no
+        // puede pisarla entre la lectura y el store
+        let latest = {
+            let current = requests.borrow_and_update();
+            if let Some(l) = current.as_ref() {
+                taken.store(l.seq, Ordering::Release);
+            }
+            current.clone()
+        };
+        let Some(Latest { id, request, .. }) = latest else { continue };
+
+        let body = serde_json::to_vec(&request).expect("ConicRequest siempre serializa");
+        let frame = tokio::select! {
+            res = forward_conic(&client, &url, body) => match res {
+                Ok(raw) => ServerMessage::Result { topic: None, id, result: &raw }.frame(),
+                Err(error) => ServerMessage::Error { topic: None, id: Some(id), error }.frame(),
+            },
+            changed = requests.changed() => {
+                if changed.is_err() {
+                    break;
+                }
+                ready = true;
+                ServerMessage::Superseded { topic: None, id }.frame()
+            }
+        };
+        if outbox.send(frame).await.is_err() {
+            break;
+        }
+    }
+}
+
+//--------------------------------//
+// Temas
+//--------------------------------//
+
+/// Un tema: último pedido, último resultado y canal de difusión. `seq` y
+/// `taken` cumplen el mismo papel que en `compute_latest`.
+struct Topic {
+    requests: watch::Sender<Option<Latest>>,
+    seq: u64,
+    taken: Arc<AtomicU64>,
+    frames: broadcast::Sender<Arc<str>>,
+    last: Arc<Mutex<Option<Arc<str>>>>,
+}
+
+/// Temas compartidos por todas las conexiones, más el acceso al plotter.
+#[derive(Clone)]
+struct Hub {
+    topics: Arc<Mutex<HashMap<String, Topic>>>,
+    client: reqwest::Client,
+    url: Arc<str>,
+}
+
+impl Hub {
+    fn new(client: reqwest::Client, url: Arc<str>) -> Self {
+        Self { topics: Arc::default(), client, url }
+    }
+
+    /// Aplica `f` al tema `name`, creándolo (con su calculador) si no existe.
+    fn with_topic<R>(&self, name: &str, f: impl FnOnce(&Topic) -> R) -> R {
+        let mut topics = self.topics.lock().unwrap();
+        let topic = topics.entry(name.to_string()).or_insert_with(|| {
+            let (requests, pending) = watch::channel(None);
+            let taken = Arc::new(AtomicU64::new(0));
+            let (frames, _) = broadcast::channel(TOPIC_CAPACITY);
+            let last = Arc::new(Mutex::new(None));
+            tokio::spawn(compute_topic(
+                name.into(),
+                pending,
+                taken.clone(),
+                frames.clone(),
+                last.clone(),
+                self.client.clone(),
+                self.url.clone(),
+            ));
+            Topic { requests, seq: 0, taken, frames, last }
+        });
+        f(topic)
+    }
+
+    /// Se suscribe a `name` y devuelve también su último resultado. Bajo
+    /// el cerrojo de `last`: no se pierde ni se repite ningún frame.
+    fn subscribe(&self, name: &str) -> (broadcast::Receiver<Arc<str>>, Option<Arc<str>>) {
+        self.with_topic(name, |t| {
+            let last = t.last.lock().unwrap();
+            (t.frames.subscribe(), last.clone())
+        })
+    }
+
+    /// Pide `request` para los suscriptores de `name`. Publicar no crea
+    /// el tema: sin suscriptores no existe, y devuelve false. Si pisa una
+    /// petición que el calculador no llegó a tomar, difunde su
+    /// `superseded`.
+    fn publish(&self, name: &str, id: u64, request: ConicRequest) -> bool {
+        let mut topics = self.topics.lock().unwrap();
+        let Some(topic) = topics.get_mut(name) else { return false };
+        topic.seq += 1;
+        let seq = topic.seq;
+        match topic.requests.send_replace(Some(Latest { seq, id, request })) {
+            Some(prev) if topic.taken.load(Ordering::Acquire) != prev.seq => {
+                let frame = ServerMessage::Superseded { topic: Some(name), id: prev.id }.text();
+                let _ = topic.frames.send(frame.into());
+            }
+            _ => {}
+        }
+        true
+    }
+
+    /// Borra `name` si ya nadie lo escucha (su calculador termina).
+    fn release(&self, name: &str) {
+        let mut topics = self.topics.lock().unwrap();
+        if topics.get(name).map_or(false, |t| t.frames.receiver_count() == 0) {
+            topics.remove(name);
+        }
+    }
+}
+
+/// Calculador de un tema: como `compute_latest`, pero cada resultado se
+/// serializa una vez y se difunde el mismo `Arc<str>` a todos.
+///
+/// # Detalles
+/// - Si la última petición es igual a la ya calculada (otra ventana
+///   publicó lo mismo), no se vuelve a pedir al núcleo: se difunde la
+///   respuesta guardada con el `id` nuevo.
+/// - `broadcast::send` nunca espera: un suscriptor lento pierde frames y
+///   se da de baja en `forward_topic`.
+async fn compute_topic(
+    name: Arc<str>,
+    mut requests: watch::Receiver<Option<Latest>>,
+    taken: Arc<AtomicU64>,
+    frames: broadcast::Sender<Arc<str>>,
+    last: Arc<Mutex<Option<Arc<str>>>>,
+    client: reqwest::Client,
+    url: Arc<str>,
+) {
+    // Cuerpo y respuesta de la última cónica calculada con éxito
+    let mut computed: Option<(Vec<u8>, Box<RawValue>)> = None;
+    while requests.changed().await.is_ok() {
+        // Tomada bajo el cerrojo del watch, como en compute_latest
+        let latest = {
+            let current = requests.borrow_and_update();
+            if let Some(l) = current.as_ref() {
+                taken.store(l.seq, Ordering::Release);
+            }
+            current.clone()
+        };
+        let Some(Latest { id, request, .. }) = latest else { continue };
+
+        let body = serde_json::to_vec(&request).expect("ConicRequest siempre serializa");
+        let cached = match &computed {
+            Some((prev, raw)) if *prev == body => {
+                Some(ServerMessage::Result { topic: Some(&name), id, result: raw }.text())
+            }
+            _ => None,
+        };
+
+        let frame: Arc<str> = match cached {
+            Some(text) => text,
+            None => match forward_conic(&client, &url, body.clone()).await {
+                Ok(raw) => {
+                    let text = ServerMessage::Result { topic: Some(&name), id, result: &raw }.text();
+                    computed = Some((body, raw));
+                    text
+                }
+                Err(error) => ServerMessage::Error { topic: Some(&name), id: Some(id), error }.text(),
+            },
+        }
+        .into();
+
+        let mut slot = last.lock().unwrap();
+        *slot = Some(frame.clone());
+        let _ = frames.send(frame);
+    }
+}
+
+/// Pasa los frames de un tema a la cola de una conexión.
+///
+/// Al quedarse más de `TOPIC_CAPACITY` frames atrás se corta con
+/// `{"event":"dropped"}`: el cliente puede volver a suscribirse y
+/// recibirá el último resultado.
+async fn forward_topic(
+    hub: Hub,
+    name: String,
+    mut frames: broadcast::Receiver<Arc<str>>,
+    last: Option<Arc<str>>,
+    outbox: mpsc::Sender<Message>,
+) {
+    let mut next = last;
+    loop {
+        if let Some(frame) = next.take() {
+            if outbox.send(Message::Text(frame.to_string())).await.is_err() {
+                break;
+            }
+        }
+        match frames.recv().await {
+            Ok(frame) => next = Some(frame),
+            Err(RecvError::Lagged(_)) => {
+                let _ = outbox.send(ServerMessage::Dropped { topic: &name }.frame()).await;
+                break;
+            }
+            Err(RecvError::Closed) => break,
+        }
+    }
+    drop(frames);
+    hub.release(&name);
+}
+
+//--------------------------------//
+// Conexiones
+//--------------------------------//
+
+/// Atiende una conexión: lector, calculador y escritor en tareas aparte.
+///
+/// # Detalles
+/// - El escritor es el único dueño del sink y vacía la cola acotada.
+/// - El lector decodifica cada frame con `ClientMessage`; las cónicas van
+///   al `watch` del calculador y nunca esperan al núcleo.
+/// - Cada suscripción es una tarea `forward_topic` que escribe en la
+///   misma cola.
+/// - Al cerrar, el lector suelta su lado, corta sus suscripciones y
+///   espera a las demás tareas.
+async fn handle_connection(stream: TcpStream, hub: Hub) {
+    let ws_stream = match accept_async(stream).await {
+        Ok(ws) => ws,
+        Err(e) => {
+            eprintln!("[WS] Fallo al hacer handshake WS: {}", e);
+            return;
+        }
+    };
+
+    println!("[WS] Nueva conexión establecida ");
+    let (mut write, mut read) = ws_stream.split();
+
+    let (outbox, mut pending) = mpsc::channel::<Message>(OUTBOX_CAPACITY);
+    let writer = tokio::spawn(async move {
+        while let Some(frame) = pending.recv().await {
+            if let Err(e) = write.send(frame).await {
+                eprintln!("[WS] Error enviando respuesta: {}", e);
+                break;
+            }
+        }
+    });
+
+    let (latest, requests) = watch::channel(None);
+    let taken = Arc::new(AtomicU64::new(0));
+    let mut seq = 0;
+    let worker = tokio::spawn(compute_latest(
+        requests,
+        taken.clone(),
+        outbox.clone(),
+        hub.client.clone(),
+        hub.url.clone(),
+    ));
+    let mut subscriptions: HashMap<String, JoinHandle<()>> = HashMap::new();
+
+    // Enviar mensaje inicial
+    if outbox.send(ServerMessage::Connected.frame()).await.is_ok() {
+        // Bucle principal del WebSocket
+        while let Some(msg_res) = read.next().await {
+            let text = match msg_res {
+                Ok(Message::Text(text)) => text,
+                Ok(Message::Close(_)) => break,
+                Ok(_) => continue,
+                Err(e) => {
+                    eprintln!("[WS] Error leyendo mensaje: {}", e);
+                    break;
+                }
+            };
+
+            let reply = match serde_json::from_str::<ClientMessage>(&text) {
+                Ok(ClientMessage::Conic { id, request }) => {
+                    seq += 1;
+                    match latest.send_replace(Some(Latest { seq, id, request })) {
+                        Some(prev) if taken.load(Ordering::Acquire) != prev.seq => {
+                            ServerMessage::Superseded { topic: None, id: prev.id }.frame()
+                        }
+                        _ => continue,
+                    }
+                }
+                Ok(ClientMessage::Subscribe { topic }) => {
+                    if let Some(old) = subscriptions.remove(&topic) {
+                        unsubscribe(&hub, &topic, old).await;
+                    }
+                    let (frames, last) = hub.subscribe(&topic);
+                    let task = forward_topic(hub.clone(), topic.clone(), frames, last, outbox.clone());
+                    subscriptions.insert(topic, tokio::spawn(task));
+                    continue;
+                }
+                Ok(ClientMessage::Unsubscribe { topic }) => {
+                    if let Some(task) = subscriptions.remove(&topic) {
+                        unsubscribe(&hub, &topic, task).await;
+                    }
+                    continue;
+                }
+                Ok(ClientMessage::Publish { topic, id, request }) => {
+                    if hub.publish(&topic, id, request) {
+                        continue;
+                    }
+                    ServerMessage::Error {
+                        topic: Some(&topic),
+                        id: Some(id),
+                        error: "Tema sin suscriptores".to_string(),
+                    }
+                    .frame()
+                }
+                Ok(ClientMessage::Ping) => ServerMessage::Pong.frame(),
+                Err(e) => ServerMessage::Error {
+                    topic: None,
+                    id: None,
+                    error: format!("Mensaje inválido: {}", e),
+                }
+                .frame(),
+            };
+            if outbox.send(reply).await.is_err() {
+                break;
+            }
+        }
+    }
+
+    drop(latest);
+    for (topic, task) in subscriptions {
+        unsubscribe(&hub, &topic, task).await;
+    }
+    let _ = worker.await;
+    drop(outbox);
+    let _ = writer.await;
+    println!("[WS] Conexión cerrada");
+}
+
+/// Corta la suscripción `task` a `topic` y libera el tema si se queda solo.
+async fn unsubscribe(hub: &Hub, topic: &str, task: JoinHandle<()>) {
+    task.abort();
+    let _ = task.await;
+    hub.release(topic);
+}
+
 /// Inicia un servidor WebSocket asíncrono.
 ///
 /// # Detalles
 /// - Escucha conexiones en la dirección configurada.
-/// - Envía un mensaje de bienvenida al conectar.
-/// - Hace eco de los mensajes recibidos.
-/// - Cada conexión se maneja en una tarea Tokio separada.
+/// - Envía `{"event":"connected"}` al conectar.
+/// - Reenvía los mensajes `{"type":"conic","id":…,"A":…,…}` al plotter y
+///   devuelve `{"event":"result","id":…,"result":{…}}`; las ráfagas se
+///   reducen a la última cónica y las demás reciben
+///   `{"event":"superseded","id":…}` (ver `compute_latest`).
+/// - Temas: `subscribe`/`unsubscribe` y `publish` (una cónica calculada
+///   una sola vez para todos los suscriptores, ver `compute_topic`). Un
+///   tema vive mientras tiene suscriptores: publicar en uno sin ellos
+///   devuelve `error` con su `topic`.
+/// - Cada conexión se maneja en tareas Tokio separadas.
 ///
 /// # Argumentos
 /// - `config`: Configuración centralizada con URLs y puerto WS.
@@ -27,6 +542,11 @@ pub async fn start_ws_server(config: Config) {
     println!("[WS] Accediendo al CORE en {}", config.core_url);
     println!("[WS] Accediendo al PLOTTER en {}", config.plotter_url);
 
+    // Un único cliente HTTP: reutiliza conexiones entre peticiones
+    let client = reqwest::Client::new();
+    let conic_url: Arc<str> = format!("{}/conic", config.plotter_url.trim_end_matches('/')).into();
+    let hub = Hub::new(client, conic_url);
+
     loop {
         let (stream, _) = match listener.accept().await {
             Ok(s) => s,
@@ -36,53 +556,6 @@ pub async fn start_ws_server(config: Config) {
             }
         };
 
-        // Variables para uso futuro con core/plotter
-        let _core = config.core_url.clone();
-        let _plotter = config.plotter_url.clone();
-
-        tokio::spawn(async move {
-            let ws_stream = match accept_async(stream).await {
-                Ok(ws) => ws,
-                Err(e) => {
-                    eprintln!("[WS] Fallo al hacer handshake WS: {}", e);
-                    return;
-                }
-            };
-
-            println!("[WS] Nueva conexión establecida ");
-            let (mut write, mut read) = ws_stream.split();
-
-            // Enviar mensaje inicial
-            if let Err(e) = write
-                .send(Message::Text(r#"{"event":"connected"}"#.into()))
-                .await
-            {
-                eprintln!("[WS] Error enviando bienvenida: {}", e);
-                return;
-            }
-
-            // Bucle principal del WebSocket
-            while let Some(msg_res) = read.next().await {
-                let msg = match msg_res {
-                    Ok(m) => m,
-                    Err(e) => {
-                        eprintln!("[WS] Error leyendo mensaje: {}", e);
-                        break;
-                    }
-                };
-
-                if msg.is_text() || msg.is_binary() {
-                    let txt = msg.to_text().unwrap_or("<binary>");
-                    println!("[WS] Mensaje recibido: {}", txt);
-
-                    if let Err(e) = write.send(Message::Text(format!("Echo: {}", txt))).await {
-                        eprintln!("[WS] Error enviando respuesta: {}", e);
-                        break;
-                    }
-                }
-            }
-
-            println!("[WS] Conexión cerrada");
-        });
+        tokio::spawn(handle_connection(stream, hub.clone()));
     }
-}
\ No newline at end of file
+}
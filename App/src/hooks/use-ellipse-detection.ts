@@ -0,0 +1,128 @@
+import * as React from "react";
+import { ENV } from "../env";
+
+export interface EllipseDetection {
+  type: string;
+  ellipse: { cx: number; cy: number; a: number; b: number; theta: number };
+  pixels: number;
+  residual: number;
+  coverage: number;
+}
+
+interface DetectFrame {
+  detections: EllipseDetection[];
+  compute_ms: number;
+}
+
+interface DetectResponse {
+  ok: boolean;
+  error?: string;
+  width: number;
+  height: number;
+  frames: DetectFrame[];
+}
+
+export interface DetectionState {
+  detections: EllipseDetection[];
+  width: number;
+  height: number;
+  computeMs: number;
+  fps: number;
+  error: string | null;
+}
+
+const EMPTY: DetectionState = {
+  detections: [],
+  width: 0,
+  height: 0,
+  computeMs: 0,
+  fps: 0,
+  error: null,
+};
+
+/**
+ * Envía fotogramas RGBA del vídeo al modo "detect" del núcleo (ruta
+ * /detect del servidor) y devuelve las elipses del último fotograma.
+ * Solo hay una petición en vuelo: si el núcleo va más lento que la
+ * cámara se descartan fotogramas en lugar de acumular latencia.
+ */
+export function useEllipseDetection(
+  videoRef: React.RefObject<HTMLVideoElement | null>,
+  enabled: boolean,
+) {
+  const [state, setState] = React.useState<DetectionState>(EMPTY);
+
+  React.useEffect(() => {
+    if (!enabled) {
+      setState(EMPTY);
+      return;
+    }
+
+    const canvas = document.createElement("canvas");
+    const ctx = canvas.getContext("2d", { willReadFrequently: true });
+    let inFlight = false;
+    let cancelled = false;
+    let frameId = 0;
+    let lastDone = performance.now();
+
+    const tick = async () => {
+      frameId = requestAnimationFrame(tick);
+      const video = videoRef.current;
+      if (inFlight || !ctx || !video || video.readyState < 2) return;
+
+      const width = video.videoWidth;
+      const height = video.videoHeight;
+      if (!width || !height) return;
+
+      if (canvas.width !== width || canvas.height !== height) {
+        canvas.width = width;
+        canvas.height = height;
+      }
+      ctx.drawImage(video, 0, 0, width, height);
+      const pixels = ctx.getImageData(0, 0, width, height).data;
+
+      inFlight = true;
+      try {
+        const res = await fetch(
+          `${ENV.PLOTTER_URL}/detect?width=${width}&height=${height}&channels=4`,
+          {
+            method: "POST",
+            headers: { "Content-Type": "application/octet-stream" },
+            body: pixels.buffer as ArrayBuffer,
+          },
+        );
+        const json: DetectResponse = await res.json();
+        if (cancelled) return;
+        if (!res.ok || !json.ok) {
+          throw new Error(json.error || "Error backend");
+        }
+
+        const now = performance.now();
+        const frame = json.frames[0];
+        setState({
+          detections: frame?.detections ?? [],
+          width: json.width,
+          height: json.height,
+          computeMs: frame?.compute_ms ?? 0,
+          fps: 1000 / Math.max(1, now - lastDone),
+          error: null,
+        });
+        lastDone = now;
+      } catch (err: any) {
+        if (!cancelled) {
+          setState((prev) => ({ ...prev, error: err?.message ?? String(err) }));
+        }
+      } finally {
+        inFlight = false;
+      }
+    };
+
+    frameId = requestAnimationFrame(tick);
+    return () => {
+      cancelled = true;
+      cancelAnimationFrame(frameId);
+    };
+  }, [enabled, videoRef]);
+
+  return state;
+}
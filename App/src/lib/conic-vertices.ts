@@ -0,0 +1,104 @@
+import { ENV } from "../env";
+
+/**
+ * Buffer de vértices del núcleo (modo "vertices", formato en
+ * Core/src/vertices.h). Todas las vistas apuntan al ArrayBuffer recibido:
+ * no se copia ni se recorre ningún vértice en JavaScript.
+ */
+export interface VertexRange {
+  conic: number;
+  offset: number;
+  count: number;
+  stripOffset: number;
+  stripCount: number;
+  indexOffset: number;
+  indexCount: number;
+  branch: number;
+  closed: boolean;
+}
+
+export interface ConicVertices {
+  ranges: VertexRange[];
+  /** xyz intercalado de todas las polilíneas. */
+  lines: Float32Array;
+  /** xyz de las tiras de trazo grueso (vacío si no se pidieron). */
+  strips: Float32Array;
+  /** Lista de triángulos sobre strips. */
+  indices: Uint32Array;
+}
+
+export interface VertexOptions {
+  window?: [number, number, number, number];
+  /** Tamaño del lienzo (px) en el que se dibuja window. */
+  width?: number;
+  height?: number;
+  /** Grosor del trazo (px); 0 = solo líneas. */
+  line_width?: number;
+  /** Tolerancia de simplificación (px). */
+  tolerance?: number;
+}
+
+const HEADER_BYTES = 32;
+const RANGE_BYTES = 32;
+
+export function parseConicVertices(buffer: ArrayBuffer): ConicVertices {
+  const view = new DataView(buffer);
+  const magic = String.fromCharCode(
+    view.getUint8(0), view.getUint8(1), view.getUint8(2), view.getUint8(3),
+  );
+  if (magic !== "CVTX") throw new Error("Buffer de vértices inválido");
+
+  const polylines = view.getUint32(12, true);
+  const vertices = view.getUint32(16, true);
+  const stripVertices = view.getUint32(20, true);
+  const indexCount = view.getUint32(24, true);
+
+  const ranges: VertexRange[] = [];
+  for (let k = 0; k < polylines; k++) {
+    const o = HEADER_BYTES + k * RANGE_BYTES;
+    ranges.push({
+      conic: view.getUint32(o, true),
+      offset: view.getUint32(o + 4, true),
+      count: view.getUint32(o + 8, true),
+      stripOffset: view.getUint32(o + 12, true),
+      stripCount: view.getUint32(o + 16, true),
+      indexOffset: view.getUint32(o + 20, true),
+      indexCount: view.getUint32(o + 24, true),
+      branch: view.getUint16(o + 28, true),
+      closed: (view.getUint16(o + 30, true) & 1) !== 0,
+    });
+  }
+
+  let at = HEADER_BYTES + polylines * RANGE_BYTES;
+  const lines = new Float32Array(buffer, at, vertices * 3);
+  at += vertices * 12;
+  const strips = new Float32Array(buffer, at, stripVertices * 3);
+  at += stripVertices * 12;
+  const indices = new Uint32Array(buffer, at, indexCount);
+  return { ranges, lines, strips, indices };
+}
+
+/**
+ * Pide el buffer de vértices de una cónica. En la app de escritorio va por
+ * el esquema conic:// de Tauri (binario directo); en el navegador, por la
+ * ruta /conic/vertices del servidor.
+ */
+export async function fetchConicVertices(
+  coeffs: { A: number; B: number; C: number; D: number; E: number; F: number },
+  options: VertexOptions = {},
+): Promise<ConicVertices> {
+  const isTauri = typeof window !== "undefined" && "__TAURI__" in (window as any);
+  let url = `${ENV.PLOTTER_URL}/conic/vertices`;
+  if (isTauri) {
+    const { convertFileSrc } = await import("@tauri-apps/api/tauri");
+    url = convertFileSrc("vertices", "conic");
+  }
+
+  const res = await fetch(url, {
+    method: "POST",
+    headers: { "Content-Type": "application/json" },
+    body: JSON.stringify({ ...coeffs, ...options }),
+  });
+  if (!res.ok) throw new Error((await res.text()) || "Error backend");
+  return parseConicVertices(await res.arrayBuffer());
+}
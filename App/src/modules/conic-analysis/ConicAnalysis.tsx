@@ -9,6 +9,13 @@ import { Line, OrthographicCamera } from '@react-three/drei';
 import { Header } from '../Header/Header';
 import { MetaCard } from '../../components/ui/MetaCard';
 import { InterpretationGrid } from '../../components/ui/InterpretationGrid';
+import { fetchConicVertices, type ConicVertices } from '../../lib/conic-vertices';
+
+// Zoom de la cámara para la ventana por defecto del núcleo (lado 20): la
+// cámara encuadra siempre la ventana en (20 · CAMERA_ZOOM) px, y el trazo
+// se pide en píxeles sobre ese mismo lienzo
+const CAMERA_ZOOM = 20;
+const VERTEX_OPTIONS = { width: 20 * CAMERA_ZOOM, height: 20 * CAMERA_ZOOM, line_width: 2 };
 
 function generateEquation(coeffs: {
   A: number;
@@ -46,8 +53,54 @@ type ConicResult = {
   rotation?: { has_rotation: boolean; theta: number };
   canonical?: { exists: boolean; a: number; b: number };
   points: { x: number; y: number }[];
+  segments: ConicSegment[];
+  // Ventana [xmin, ymin, xmax, ymax] en la que el núcleo recortó "segments"
+  window?: [number, number, number, number];
+};
+
+// Polilínea de una rama, ya en orden de dibujo (campo "segments" del núcleo)
+type ConicSegment = {
+  branch: number;
+  closed: boolean;
+  points: [number, number][];
 };
 
+// [x0, y0, x1, y1, ...] -> [[x0, y0], [x1, y1], ...] (una sola vez por respuesta)
+function toSegments(raw: any[] | undefined): ConicSegment[] {
+  return (raw ?? []).map((s) => {
+    const flat: number[] = s.points ?? [];
+    const points: [number, number][] = [];
+    for (let i = 0; i + 1 < flat.length; i += 2) points.push([flat[i], flat[i + 1]]);
+    return { branch: s.branch ?? 0, closed: !!s.closed, points };
+  });
+}
+
+// Trazo grueso del núcleo: las tiras y los índices se suben tal cual como
+// una única geometría indexada (sin recorrer vértices en JS)
+function ConicStrokes({ vertices, color }: { vertices: ConicVertices; color: string }) {
+  if (vertices.indices.length === 0) return null;
+  return (
+    <mesh>
+      <bufferGeometry>
+        <bufferAttribute
+          attach="attributes-position"
+          array={vertices.strips}
+          count={vertices.strips.length / 3}
+          itemSize={3}
+        />
+        <bufferAttribute
+          attach="index"
+          array={vertices.indices}
+          count={vertices.indices.length}
+          itemSize={1}
+        />
+      </bufferGeometry>
+      {/* side = 2: THREE.DoubleSide (los giros invierten el sentido de las tiras) */}
+      <meshBasicMaterial color={color} side={2} />
+    </mesh>
+  );
+}
+
 export function ConicAnalysis() {
   const containerRef = useRef<HTMLDivElement>(null);
   // motion values SOLO para el root motion.div
@@ -150,6 +203,10 @@ export function ConicAnalysis() {
 
   const [loading, setLoading] = useState(false);
   const [result, setResult] = useState<ConicResult | null>(null);
+  const [vertices, setVertices] = useState<ConicVertices | null>(null);
+  // Número del último análisis pedido: las respuestas de uno anterior
+  // (resultado o buffer de vértices) se descartan al llegar
+  const requestSeq = useRef(0);
 
   const handleInputChange = (field: keyof ConicCoefficients, value: string) => {
     setCoefficients(prev => ({ ...prev, [field]: value }));
@@ -170,7 +227,9 @@ export function ConicAnalysis() {
   };
 
   function handleClear() {
+    requestSeq.current++;
     setResult(null);
+    setVertices(null);
     setCoefficients({
       A: '0',
       B: '0',
@@ -185,15 +244,29 @@ export function ConicAnalysis() {
   async function runConicAnalysis(coeffs: {
     A: number; B: number; C: number; D: number; E: number; F: number
   }) {
+    const seq = ++requestSeq.current;
+    const stale = () => seq !== requestSeq.current;
+
+    // Muestra el resultado y pide el buffer binario con su misma ventana;
+    // hasta que llega (o si falla) se dibujan las polilíneas de "segments"
+    const show = (mapped: ConicResult) => {
+      setResult(mapped);
+      fetchConicVertices(coeffs, mapped.window ? { ...VERTEX_OPTIONS, window: mapped.window } : VERTEX_OPTIONS)
+        .then((v) => { if (!stale()) setVertices(v); })
+        .catch((err) => console.warn('Buffer de vértices no disponible', err));
+    };
+
     try {
       setLoading(true);
       setResult(null);
+      setVertices(null);
 
       const isTauri = typeof window !== 'undefined' && '__TAURI__' in (window as any);
       if (isTauri) {
         try {
           const { invoke } = await import('@tauri-apps/api/tauri');
           const json = await invoke<any>('analyze_conic', { coeffs });
+          if (stale()) return;
           const mapped: ConicResult = {
             ok: json.ok,
             type: json.type,
@@ -202,8 +275,10 @@ export function ConicAnalysis() {
             rotation: json.rotation,
             canonical: json.canonical,
             points: json.points || [],
+            segments: toSegments(json.segments),
+            window: json.window,
           };
-          setResult(mapped);
+          show(mapped);
           return;
         } catch (tauriErr) {
           console.warn('Tauri ha fallado', tauriErr);
@@ -227,6 +302,7 @@ export function ConicAnalysis() {
         }
 
         const json = await res.json();
+        if (stale()) return;
 
         console.group(" CONIC ANALYSIS RESULT");
         console.log("Tipo:", json.type);
@@ -251,6 +327,7 @@ export function ConicAnalysis() {
         }
 
         console.log("Número de puntos:", json.points?.length ?? 0);
+        console.log("Segmentos:", json.segments?.length ?? 0);
         console.groupEnd();
       const mapped: ConicResult = {
         ok: json.ok,
@@ -260,97 +337,36 @@ export function ConicAnalysis() {
         rotation: json.rotation,
         canonical: json.canonical,
         points: json.points || [],
+        segments: toSegments(json.segments),
+        window: json.window,
       };
-      setResult(mapped);
+      show(mapped);
     } catch (e) {
-      console.error('conic analysis ha fallado', e);
+      if (!stale()) console.error('conic analysis ha fallado', e);
     } finally {
-      setLoading(false);
+      if (!stale()) setLoading(false);
     }
   }
 
-  // Genera puntos analíticos para círculo y elipse (canónica)
-  function generateCanonicalPoints(
-    type: string,
-    center: { x: number; y: number },
-    canonical: { a: number; b: number },
-    steps = 256
-  ): [number, number, number][] {
-    const pts: [number, number, number][] = [];
-
-    if (type === 'CIRCLE') {
-      for (let i = 0; i <= steps; i++) {
-        const t = (i / steps) * Math.PI * 2;
-        const x = center.x + canonical.a * Math.cos(t);
-        const y = center.y + canonical.a * Math.sin(t);
-        pts.push([x, y, 0]);
-      }
-    }
-
-    if (type === 'ELLIPSE') {
-      for (let i = 0; i <= steps; i++) {
-        const t = (i / steps) * Math.PI * 2;
-        const x = center.x + canonical.a * Math.cos(t);
-        const y = center.y + canonical.b * Math.sin(t);
-        pts.push([x, y, 0]);
-      }
-    }
-
-    return pts;
-  }
-
-  // Genera ramas analíticas para hipérbola canónica
-  function generateHyperbolaPoints(
-    center: { x: number; y: number },
-    canonical: { a: number; b: number },
-    range = 5,
-    steps = 200
-  ) {
-    const left: [number, number, number][] = [];
-    const right: [number, number, number][] = [];
-
-    for (let i = 0; i <= steps; i++) {
-      const t = (i / steps) * range + 1e-3;
-
-      const x = canonical.a * Math.cosh(t);
-      const y = canonical.b * Math.sinh(t);
-
-      right.push([center.x + x, center.y + y, 0]);
-      left.push([center.x - x, center.y + y, 0]);
-    }
-
-    return { left, right };
-  }
-
-  // Separa ramas de hipérbola por pares (y1/y2) para evitar cruces y glitches
-  function splitHyperbola(points: {x:number, y:number}[]) {
-    const branch1: [number, number, number][] = [];
-    const branch2: [number, number, number][] = [];
-
-    for (let i = 0; i < points.length; i += 2) {
-      const p1 = points[i];
-      const p2 = points[i + 1];
-      if (!p2) continue;
-      branch1.push([p1.x, p1.y, 0]);
-      branch2.push([p2.x, p2.y, 0]);
-    }
-
-    return { branch1, branch2 };
-  }
-
   // Helper: solo renderiza Line si hay al menos 2 puntos
   function safeLine(
-    points: [number, number, number][],
-    color = "#00ff88"
+    points: [number, number][],
+    color = "#00ff88",
+    key?: number
   ) {
     if (!points || points.length < 2) return null;
-    return <Line points={points} color={color} lineWidth={2} />;
+    return <Line key={key} points={points} color={color} lineWidth={2} />;
   }
 
-  // Calcula el centro visual para la cámara
-  const visualCenter = result?.center?.exists
-    ? [result.center.x, result.center.y, 100]
-    : [0, 0, 100];
+  // Centro y zoom de la cámara: encuadran la ventana que eligió el núcleo
+  // (centrada en la cónica); sin ella, el centro de la cónica o el origen
+  const win = result?.window;
+  const visualCenter = win
+    ? [(win[0] + win[2]) / 2, (win[1] + win[3]) / 2, 100]
+    : result?.center?.exists
+      ? [result.center.x, result.center.y, 100]
+      : [0, 0, 100];
+  const cameraZoom = win ? (20 * CAMERA_ZOOM) / (win[2] - win[0]) : CAMERA_ZOOM;
 
   return (
     <div className="w-full h-screen flex flex-col overflow-hidden">
@@ -617,56 +633,13 @@ export function ConicAnalysis() {
                             <OrthographicCamera
                               makeDefault
                               position={visualCenter as [number, number, number]}
-                              zoom={20}
+                              zoom={cameraZoom}
                             />
 
-                            {/* Círculo / Elipse canónica */}
-                            {result.canonical?.exists && result.center?.exists &&
-                              result.type !== 'HYPERBOLA' &&
-                              safeLine(
-                                generateCanonicalPoints(
-                                  result.type,
-                                  { x: result.center.x, y: result.center.y },
-                                  result.canonical
-                                )
-                              )
-                            }
-
-                            {/* Hipérbola canónica */}
-                            {result.type === 'HYPERBOLA' &&
-                              result.canonical?.exists &&
-                              result.center?.exists && (() => {
-                                const { left, right } = generateHyperbolaPoints(
-                                  result.center,
-                                  result.canonical
-                                );
-                                return (
-                                  <>
-                                    <Line points={left} color="#00ff88" lineWidth={2} />
-                                    <Line points={right} color="#00ff88" lineWidth={2} />
-                                  </>
-                                );
-                              })()
-                            }
-
-                            {/* Hipérbola fallback (si no hay canónica) */}
-                            {result.type === 'HYPERBOLA' &&
-                              (!result.canonical?.exists || !result.center?.exists) &&
-                              result.points?.length > 1 && (() => {
-                                const { branch1, branch2 } = splitHyperbola(result.points);
-                                return (
-                                  <>
-                                    {safeLine(branch1)}
-                                    {safeLine(branch2)}
-                                  </>
-                                );
-                              })()
-                            }
-
-                            {/* Fallback general */}
-                            {!result.canonical?.exists && result.points?.length > 1 &&
-                              safeLine(result.points.map(p => [p.x, p.y, 0]))
-                            }
+                            {/* Buffer de vértices del núcleo o, si no llegó, una polilínea por rama */}
+                            {vertices
+                              ? <ConicStrokes vertices={vertices} color="#00ff88" />
+                              : result.segments.map((seg, i) => safeLine(seg.points, "#00ff88", i))}
                           </Canvas>
                         )}
                       </>
@@ -1,9 +1,10 @@
-import { useEffect, useRef, useState } from 'react';
+import { useEffect, useMemo, useRef, useState } from 'react';
 import { Camera, CameraOff, Activity, X } from 'lucide-react';
 import { motion, AnimatePresence, useMotionValue, useTransform } from 'framer-motion';
 import { Header } from './../Header/Header';
 import styles from './VideoTerminalPanel.module.css';
 import { TypingText } from '../../components/ui/TypingText';
+import { useEllipseDetection } from '../../hooks/use-ellipse-detection';
 
 interface BiometricResult {
   id: string;
@@ -75,6 +76,23 @@ export function VideoTerminalPanel() {
   const mouseY = useMotionValue(0);
   const [parallaxReady, setParallaxReady] = useState(false);
 
+  // Detección de elipses en el núcleo sobre la señal de la cámara
+  const detection = useEllipseDetection(videoRef, isStreaming && !streamError);
+  const results = useMemo<BiometricResult[]>(() => {
+    if (detection.detections.length === 0) return staticResults;
+    const timestamp = new Date().toLocaleTimeString();
+    return detection.detections.map((d, i) => ({
+      id: `det-${i}`,
+      timestamp,
+      feature: `${d.type === 'CIRCLE' ? 'Círculo' : 'Elipse'} (${d.pixels} px)`,
+      vectors: `[${[d.ellipse.cx, d.ellipse.cy, d.ellipse.a, d.ellipse.b, d.ellipse.theta]
+        .map((v) => v.toFixed(2))
+        .join(', ')}]`,
+      confidence: Math.max(0, Math.min(1, 1 - d.residual)),
+      status: 'success',
+    }));
+  }, [detection.detections]);
+
   // Marcos (poco movimiento)
   const panelX = useTransform(mouseX, [-300, 300], [-1.2, 1.2]);
   const panelY = useTransform(mouseY, [-300, 300], [-0.8, 0.8]);
@@ -288,7 +306,11 @@ export function VideoTerminalPanel() {
                           >
                             <TypingText text="Captura de Video" speed={60} cursorDelay={2000} />
                           </motion.h2>
-                          <p className="text-sm text-gray-400">Señal de cámara en tiempo real</p>
+                          <p className="text-sm text-gray-400">
+                            Señal de cámara en tiempo real
+                            {detection.fps > 0 &&
+                              ` · ${detection.fps.toFixed(1)} fps · núcleo ${detection.computeMs.toFixed(1)} ms`}
+                          </p>
                         </div>
                       </div>
                       <button
@@ -321,12 +343,36 @@ export function VideoTerminalPanel() {
                       </div>
                     </div>
                   ) : (
-                    <video
-                      ref={videoRef}
-                      autoPlay
-                      playsInline
-                      className="w-full h-full object-contain rounded-lg"
-                    />
+                    <div className="relative w-full h-full">
+                      <video
+                        ref={videoRef}
+                        autoPlay
+                        playsInline
+                        className="w-full h-full object-contain rounded-lg"
+                      />
+                      {/* Elipses detectadas: mismo encuadre que object-contain */}
+                      {detection.width > 0 && (
+                        <svg
+                          className="absolute inset-0 w-full h-full pointer-events-none"
+                          viewBox={`0 0 ${detection.width} ${detection.height}`}
+                          preserveAspectRatio="xMidYMid meet"
+                        >
+                          {detection.detections.map((d, i) => (
+                            <ellipse
+                              key={i}
+                              cx={d.ellipse.cx}
+                              cy={d.ellipse.cy}
+                              rx={d.ellipse.a}
+                              ry={d.ellipse.b}
+                              transform={`rotate(${(d.ellipse.theta * 180) / Math.PI} ${d.ellipse.cx} ${d.ellipse.cy})`}
+                              fill="none"
+                              stroke="#8b5cf6"
+                              strokeWidth={3}
+                            />
+                          ))}
+                        </svg>
+                      )}
+                    </div>
                   )}
                 </motion.div>
               </motion.div>
@@ -422,7 +468,7 @@ export function VideoTerminalPanel() {
                         </tr>
                       </thead>
                       <tbody>
-                        {staticResults.map((result) => (
+                        {results.map((result) => (
                           <tr
                             key={result.id}
                             className="
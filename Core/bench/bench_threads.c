@@ -0,0 +1,102 @@
+//================================================================//
+// BENCH - Escalado del thread pool (work stealing)
+//================================================================//
+//
+// Mide el speedup de tp_parallel_for sobre dos cargas representativas:
+//  - batch:  analyze_conic_columns sobre N cónicas aleatorias
+//            (limitado por memoria, ~100 ns por fila).
+//  - sample: analyze_conic completo con muestreo (limitado por cómputo).
+//
+// Uso: bin/bench_threads [filas] [max_hilos]
+//
+//--------------------------------//
+// Includes y dependencias
+//--------------------------------//
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "conics.h"
+#include "threadpool.h"
+#include "utils.h"
+
+typedef struct {
+    ConicCoeffColumns  in;
+    ConicResultColumns out;
+} BenchJob;
+
+static void batch_range(size_t begin, size_t end, void* ctx) {
+    BenchJob* job = ctx;
+    analyze_conic_columns(&job->in, &job->out, begin, end);
+}
+
+static void sample_range(size_t begin, size_t end, void* ctx) {
+    BenchJob* job = ctx;
+    for (size_t i = begin; i < end; i++) {
+        ConicResult r = analyze_conic(job->in.A[i], job->in.B[i], job->in.C[i],
+                                      job->in.D[i], job->in.E[i], job->in.F[i]);
+        job->out.delta[i] = (double)r.point_count;
+    }
+}
+
+/**
+ * @brief Mejor de tres ejecuciones de fn sobre [0, n) en milisegundos.
+ */
+static double time_run(RangeFn fn, BenchJob* job, size_t n) {
+    double best = 1e300;
+    for (int rep = 0; rep < 3; rep++) {
+        double t0 = now_ms();
+        tp_parallel_for(0, n, 0, fn, job);
+        double dt = now_ms() - t0;
+        if (dt < best) best = dt;
+    }
+    return best;
+}
+
+int main(int argc, char** argv) {
+    size_t n = argc > 1 ? (size_t)atol(argv[1]) : 2000000;
+    int max_threads = argc > 2 ? atoi(argv[2]) : tp_init(0);
+    tp_shutdown();
+
+    double* cols = malloc(n * 14 * sizeof(double));
+    int32_t* type = malloc(n * sizeof(int32_t));
+    uint32_t* flags = malloc(n * sizeof(uint32_t));
+    if (!cols || !type || !flags) {
+        fprintf(stderr, "sin memoria para %zu filas\n", n);
+        return 1;
+    }
+
+    srand(42);
+    for (size_t i = 0; i < n * 6; i++) cols[i] = (double)rand() / RAND_MAX * 10.0 - 5.0;
+
+    BenchJob job = {
+        { cols, cols + n, cols + 2 * n, cols + 3 * n, cols + 4 * n, cols + 5 * n },
+        { type, flags, cols + 6 * n, cols + 7 * n, cols + 8 * n,
+          cols + 9 * n, cols + 10 * n, cols + 11 * n }
+    };
+
+    size_t n_sample = n / 20 ? n / 20 : 1;
+    double base_batch = 0.0, base_sample = 0.0;
+
+    // Potencias de dos por debajo de max_threads y, al final, max_threads
+    if (max_threads < 1) max_threads = 1;
+    int counts[32];
+    int ncounts = 0;
+    for (int t = 1; t < max_threads && ncounts < 31; t *= 2) counts[ncounts++] = t;
+    counts[ncounts++] = max_threads;
+
+    printf("%8s %14s %9s %14s %9s\n", "hilos", "batch (ms)", "speedup", "sample (ms)", "speedup");
+    for (int k = 0; k < ncounts; k++) {
+        const int t = counts[k];
+        tp_init(t);
+        double tb = time_run(batch_range, &job, n);
+        double ts = time_run(sample_range, &job, n_sample);
+        tp_shutdown();
+
+        if (t == 1) { base_batch = tb; base_sample = ts; }
+        printf("%8d %14.2f %8.2fx %14.2f %8.2fx\n",
+               t, tb, base_batch / tb, ts, base_sample / ts);
+    }
+
+    free(cols); free(type); free(flags);
+    return 0;
+}
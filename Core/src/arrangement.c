@@ -0,0 +1,427 @@
+//================================================================//
+// ARRANGEMENT - Fase amplia, intersección exacta y topología
+//================================================================//
+//
+// Escala a decenas de miles de cónicas: la fase amplia ordena una sola
+// vez las cajas por x y cada cónica recorre solo las que empiezan antes
+// de que ella termine, así que el coste de intersección exacta depende
+// de los solapes reales y no de N².
+//
+//--------------------------------//
+// Includes y dependencias
+//--------------------------------//
+#include "arrangement.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "budget.h"
+#include "conics.h"
+#include "intersect.h"
+#include "threadpool.h"
+
+/**
+ * @file arrangement.c
+ * @brief Arreglo plano de cónicas descrito en arrangement.h.
+ */
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+typedef struct {
+    double   x0, x1, y0, y1;
+    uint32_t id;
+} SapBox;
+
+typedef struct {
+    double   x, y;
+    uint32_t conic_a, conic_b;
+    int      multiplicity;
+} RawVertex;
+
+typedef struct {
+    uint32_t conic;
+    int32_t  branch;
+    double   t;
+    uint32_t vertex;
+} Incidence;
+
+//-------------------------------------------//
+//            FUNCIONES AUXILIARES           //
+//-------------------------------------------//
+
+static int cmp_sap(const void* a, const void* b) {
+    double x = ((const SapBox*)a)->x0, y = ((const SapBox*)b)->x0;
+    return (x > y) - (x < y);
+}
+
+static int cmp_raw(const void* a, const void* b) {
+    double x = ((const RawVertex*)a)->x, y = ((const RawVertex*)b)->x;
+    return (x > y) - (x < y);
+}
+
+static int cmp_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static int cmp_incidence(const void* a, const void* b) {
+    const Incidence* p = a;
+    const Incidence* q = b;
+    if (p->conic != q->conic) return p->conic < q->conic ? -1 : 1;
+    if (p->branch != q->branch) return p->branch < q->branch ? -1 : 1;
+    return (p->t > q->t) - (p->t < q->t);
+}
+
+/**
+ * @brief Rama y parámetro de (x, y) a lo largo de la curva del marco f.
+ * @return false si la cónica no admite aristas (degenerada).
+ */
+static bool curve_param(const ConicFrame* f, double x, double y, int32_t* branch, double* t) {
+    double cs = f->cos_t, sn = f->sin_t;
+    *branch = 0;
+
+    switch (f->type) {
+        case CONIC_CIRCLE:
+        case CONIC_ELLIPSE:
+            *t = atan2(y - f->cy, x - f->cx);
+            return true;
+
+        case CONIC_HYPERBOLA: {
+            double u =  cs*(x - f->cx) + sn*(y - f->cy);
+            double v = -sn*(x - f->cx) + cs*(y - f->cy);
+            // Eje transverso: el que corta la curva (l·u² = -f0 > 0)
+            if (f->l1 * f->f0 < 0) {
+                *branch = u >= 0 ? 1 : -1;
+                *t = v;
+            } else {
+                *branch = v >= 0 ? 1 : -1;
+                *t = u;
+            }
+            return true;
+        }
+
+        case CONIC_PARABOLA:
+            // La parábola es una gráfica sobre el eje con autovalor no nulo
+            *t = fabs(f->l1) < fabs(f->l2) ? -sn*x + cs*y : cs*x + sn*y;
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+//-------------------------------------------//
+//           FASES PARALELAS                 //
+//-------------------------------------------//
+
+typedef struct {
+    const double* coeffs;
+    const double* window;
+    double*       bounds;
+    ConicFrame*   frames;
+} BoundsJob;
+
+static void bounds_range(size_t begin, size_t end, void* ctx) {
+    BoundsJob* job = ctx;
+    for (size_t i = begin; i < end; i++) {
+        const double* c = job->coeffs + 6 * i;
+        double* box = job->bounds + 4 * i;
+        conic_frame(c, &job->frames[i]);
+        if (!conic_bounds(c, job->window, box)) box[0] = box[1] = box[2] = box[3] = NAN;
+    }
+}
+
+typedef struct {
+    const SapBox* boxes;
+    size_t        count;
+    size_t*       offsets;      // candidatos por caja (1ª pasada) / inicio (2ª)
+    uint32_t*     pairs;        // NULL en la pasada de conteo
+} SapJob;
+
+/**
+ * @brief Recorre las cajas que empiezan antes de que termine la caja i.
+ * @details Con pairs == NULL solo cuenta; si no, escribe a partir de
+ *          offsets[i]. Ambas pasadas visitan los mismos pares.
+ */
+static void sap_range(size_t begin, size_t end, void* ctx) {
+    SapJob* job = ctx;
+    const SapBox* b = job->boxes;
+
+    for (size_t i = begin; i < end; i++) {
+        size_t k = job->pairs ? job->offsets[i] : 0;
+        size_t found = 0;
+        for (size_t j = i + 1; j < job->count && b[j].x0 <= b[i].x1; j++) {
+            if (b[j].y0 > b[i].y1 || b[j].y1 < b[i].y0) continue;
+            if (job->pairs) {
+                job->pairs[2 * (k + found)] = b[i].id;
+                job->pairs[2 * (k + found) + 1] = b[j].id;
+            }
+            found++;
+        }
+        if (!job->pairs) job->offsets[i] = found;
+    }
+}
+
+//-------------------------------------------//
+//                 API PÚBLICA               //
+//-------------------------------------------//
+
+/**
+ * @brief Construye el arreglo plano de n cónicas dentro de window.
+ * @param coeffs Tabla de coeficientes, 6 por cónica.
+ * @param n Número de cónicas.
+ * @param window Ventana [x_min, y_min, x_max, y_max].
+ * @param out Arreglo de salida (liberar con arrangement_free).
+ * @return ARR_OK o el código de error.
+ * @details Solo se conservan los vértices dentro de la ventana: las cajas
+ *          están recortadas a ella, por lo que fuera no hay garantía de
+ *          haber probado todos los pares.
+ */
+ArrStatus arrangement_build(
+    const double* coeffs, size_t n,
+    const double window[4],
+    Arrangement* out
+) {
+    memset(out, 0, sizeof(*out));
+    out->conic_count = n;
+
+    ArrStatus status = ARR_OK;
+    ConicFrame* frames = malloc((n ? n : 1) * sizeof(ConicFrame));
+    SapBox* boxes = malloc((n ? n : 1) * sizeof(SapBox));
+    size_t* offsets = malloc((n ? n : 1) * sizeof(size_t));
+    out->bounds = malloc((n ? n : 1) * 4 * sizeof(double));
+    uint32_t* pairs = NULL;
+    IntersectResult* hits = NULL;
+    RawVertex* raw = NULL;
+    uint32_t* ids = NULL;
+    Incidence* inc = NULL;
+
+    if (!frames || !boxes || !offsets || !out->bounds) {
+        status = ARR_ERR_NOMEM;
+        goto done;
+    }
+
+    // 1. Cajas por cónica
+    BoundsJob bj = { coeffs, window, out->bounds, frames };
+    tp_parallel_for(0, n, 512, bounds_range, &bj);
+
+    size_t nb = 0;
+    for (size_t i = 0; i < n; i++) {
+        const double* box = out->bounds + 4 * i;
+        if (isnan(box[0])) continue;
+        boxes[nb++] = (SapBox){ box[0], box[2], box[1], box[3], (uint32_t)i };
+    }
+    out->visible = nb;
+
+    // 2. Sweep-and-prune: conteo, prefijos y relleno
+    qsort(boxes, nb, sizeof(SapBox), cmp_sap);
+
+    SapJob sj = { boxes, nb, offsets, NULL };
+    tp_parallel_for(0, nb, 256, sap_range, &sj);
+
+    size_t m = 0;
+    for (size_t i = 0; i < nb; i++) {
+        size_t c = offsets[i];
+        offsets[i] = m;
+        m += c;
+    }
+    out->candidate_pairs = m;
+    if (m > ARR_MAX_PAIRS) {
+        status = ARR_ERR_TOO_MANY_PAIRS;
+        goto done;
+    }
+
+    pairs = malloc((m ? m : 1) * 2 * sizeof(uint32_t));
+    hits = malloc((m ? m : 1) * sizeof(IntersectResult));
+    if (!pairs || !hits) {
+        status = ARR_ERR_NOMEM;
+        goto done;
+    }
+    sj.pairs = pairs;
+    tp_parallel_for(0, nb, 256, sap_range, &sj);
+
+    // 3. Intersección exacta de los candidatos
+    conic_intersect_batch(coeffs, pairs, m, hits);
+
+    if (budget_cancelled(budget_current())) {
+        status = ARR_ERR_CANCELLED;
+        goto done;
+    }
+
+    // 4. Vértices dentro de la ventana, fusionados si coinciden
+    double span = fmax(window[2] - window[0], window[3] - window[1]);
+    double tol = 1e-7 * span;
+
+    size_t nr = 0;
+    for (size_t k = 0; k < m; k++) {
+        nr += (size_t)hits[k].count;
+        out->skipped_pairs += hits[k].skipped;
+    }
+    raw = malloc((nr ? nr : 1) * sizeof(RawVertex));
+    ids = malloc((nr ? nr : 1) * sizeof(uint32_t));
+    out->vertices = malloc((nr ? nr : 1) * sizeof(ArrVertex));
+    if (!raw || !ids || !out->vertices) {
+        status = ARR_ERR_NOMEM;
+        goto done;
+    }
+
+    nr = 0;
+    for (size_t k = 0; k < m; k++) {
+        for (int p = 0; p < hits[k].count; p++) {
+            const IntersectPoint* ip = &hits[k].points[p];
+            if (ip->x < window[0] - tol || ip->x > window[2] + tol ||
+                ip->y < window[1] - tol || ip->y > window[3] + tol) continue;
+            raw[nr++] = (RawVertex){ ip->x, ip->y, pairs[2 * k], pairs[2 * k + 1], ip->multiplicity };
+        }
+    }
+    qsort(raw, nr, sizeof(RawVertex), cmp_raw);
+
+    size_t nv = 0;
+    for (size_t i = 0; i < nr; i++) {
+        ids[i] = UINT32_MAX;
+        for (size_t j = i; j-- > 0 && raw[i].x - raw[j].x <= tol;) {
+            if (fabs(raw[i].y - raw[j].y) <= tol) {
+                ids[i] = ids[j];
+                break;
+            }
+        }
+        if (ids[i] == UINT32_MAX) {
+            ids[i] = (uint32_t)nv;
+            out->vertices[nv++] = (ArrVertex){ raw[i].x, raw[i].y, 0, 0 };
+        }
+        ArrVertex* v = &out->vertices[ids[i]];
+        if (raw[i].multiplicity > v->multiplicity) v->multiplicity = raw[i].multiplicity;
+    }
+    out->vertex_count = nv;
+
+    if (budget_cancelled(budget_current())) {
+        status = ARR_ERR_CANCELLED;
+        goto done;
+    }
+
+    // 5. Incidencias ordenadas a lo largo de cada curva
+    inc = malloc((nr ? 2 * nr : 1) * sizeof(Incidence));
+    out->edges = malloc((2 * nr + 2 * nb + 1) * sizeof(ArrEdge));
+    if (!inc || !out->edges) {
+        status = ARR_ERR_NOMEM;
+        goto done;
+    }
+
+    size_t ni = 0;
+    for (size_t i = 0; i < nr; i++) {
+        uint32_t cs[2] = { raw[i].conic_a, raw[i].conic_b };
+        for (int s = 0; s < 2; s++) {
+            Incidence* in = &inc[ni];
+            if (!curve_param(&frames[cs[s]], raw[i].x, raw[i].y, &in->branch, &in->t)) continue;
+            in->conic = cs[s];
+            in->vertex = ids[i];
+            ni++;
+        }
+    }
+    qsort(inc, ni, sizeof(Incidence), cmp_incidence);
+
+    // Una incidencia por (cónica, vértice): un corte triple llega por dos pares
+    size_t nu = 0;
+    for (size_t i = 0; i < ni; i++) {
+        if (nu > 0 && inc[nu - 1].conic == inc[i].conic && inc[nu - 1].vertex == inc[i].vertex) continue;
+        inc[nu++] = inc[i];
+    }
+    ni = nu;
+
+    // Grado: pares (vértice, cónica) distintos, incluidas las degeneradas
+    uint64_t* vc = malloc((nr ? 2 * nr : 1) * sizeof(uint64_t));
+    if (!vc) {
+        status = ARR_ERR_NOMEM;
+        goto done;
+    }
+    for (size_t i = 0; i < nr; i++) {
+        vc[2 * i] = (uint64_t)ids[i] << 32 | raw[i].conic_a;
+        vc[2 * i + 1] = (uint64_t)ids[i] << 32 | raw[i].conic_b;
+    }
+    qsort(vc, 2 * nr, sizeof(uint64_t), cmp_u64);
+    for (size_t i = 0; i < 2 * nr; i++) {
+        if (i > 0 && vc[i] == vc[i - 1]) continue;
+        out->vertices[vc[i] >> 32].degree++;
+    }
+    free(vc);
+
+    // 6. Aristas entre incidencias consecutivas de cada rama
+    size_t ne = 0;
+    size_t i = 0;
+    for (uint32_t c = 0; c < n; c++) {
+        size_t start = i;
+        while (i < ni && inc[i].conic == c) i++;
+
+        const ConicFrame* f = &frames[c];
+        if (isnan(out->bounds[4 * c]) || f->type == CONIC_DEGENERATE) continue;
+
+        if (f->type == CONIC_CIRCLE || f->type == CONIC_ELLIPSE) {
+            size_t k = i - start;
+            if (k == 0) {
+                out->edges[ne++] = (ArrEdge){ c, 0, ARR_NONE, ARR_NONE, -M_PI, M_PI };
+                continue;
+            }
+            for (size_t q = 0; q < k; q++) {
+                const Incidence* a = &inc[start + q];
+                const Incidence* z = &inc[start + (q + 1) % k];
+                double t1 = q + 1 < k ? z->t : z->t + 2 * M_PI;
+                out->edges[ne++] = (ArrEdge){ c, 0, a->vertex, z->vertex, a->t, t1 };
+            }
+            continue;
+        }
+
+        // Curvas abiertas: una o dos ramas, con extremos fuera de la ventana
+        int32_t first = f->type == CONIC_HYPERBOLA ? -1 : 0;
+        int32_t last = f->type == CONIC_HYPERBOLA ? 1 : 0;
+        size_t q = start;
+        for (int32_t br = first; br <= last; br += (first == last ? 1 : 2)) {
+            uint32_t prev = ARR_NONE;
+            double tprev = -INFINITY;
+            for (; q < i && inc[q].branch == br; q++) {
+                out->edges[ne++] = (ArrEdge){ c, br, prev, inc[q].vertex, tprev, inc[q].t };
+                prev = inc[q].vertex;
+                tprev = inc[q].t;
+            }
+            out->edges[ne++] = (ArrEdge){ c, br, prev, ARR_NONE, tprev, INFINITY };
+        }
+    }
+    out->edge_count = ne;
+
+done:
+    free(frames);
+    free(boxes);
+    free(offsets);
+    free(pairs);
+    free(hits);
+    free(raw);
+    free(ids);
+    free(inc);
+    if (status != ARR_OK) arrangement_free(out);
+    return status;
+}
+
+void arrangement_free(Arrangement* a) {
+    free(a->bounds);
+    free(a->vertices);
+    free(a->edges);
+    a->bounds = NULL;
+    a->vertices = NULL;
+    a->edges = NULL;
+    a->vertex_count = a->edge_count = 0;
+}
+
+/**
+ * @brief Convierte un ArrStatus en un código de error para JSON.
+ */
+const char* arrangement_status_str(ArrStatus s) {
+    switch (s) {
+        case ARR_OK:                 return "ok";
+        case ARR_ERR_NOMEM:          return "out_of_memory";
+        case ARR_ERR_TOO_MANY_PAIRS: return "too_many_candidate_pairs";
+        case ARR_ERR_CANCELLED:      return "cancelled";
+        default:                     return "arrangement_error";
+    }
+}
@@ -0,0 +1,92 @@
+//================================================================//
+//        ARRANGEMENT HEADER - Arreglo plano de N cónicas         //
+//================================================================//
+//
+// Construye el arreglo plano de una escena de cónicas dentro de una
+// ventana: vértices (cortes, fusionados si coinciden) y aristas (trozos
+// de cada cónica entre vértices consecutivos).
+//
+// Fases:
+//   1. Cajas alineadas de cada curva recortada a la ventana (paralelo).
+//   2. Fase amplia sweep-and-prune sobre x: solo los pares cuyas cajas
+//      se solapan pasan a la fase exacta (paralelo, dos pasadas).
+//   3. Intersección exacta por lotes de los pares candidatos. Si vence
+//      el presupuesto (budget.h), los pares que faltan no aportan
+//      vértices y el arreglo queda incompleto.
+//   4. Fusión de vértices y orden de incidencias a lo largo de cada curva.
+//      Son ordenaciones en serie sin resultado parcial útil: una petición
+//      cancelada se corta antes de la fusión y antes de las incidencias.
+//
+// Parámetro t a lo largo de cada curva (ver ArrEdge):
+//   elipse/círculo  ángulo polar respecto al centro, en (-π, π]
+//   hipérbola       coordenada sobre el eje conjugado; rama = lado del
+//                   eje transverso (-1 / +1)
+//   parábola        coordenada perpendicular al eje
+// Las cónicas degeneradas aportan vértices pero no aristas.
+//
+
+#ifndef ARRANGEMENT_H
+#define ARRANGEMENT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Extremo de arista que sale de la ventana (o sin vértices: curva entera)
+#define ARR_NONE UINT32_MAX
+
+// Límite de pares candidatos (protege la memoria en escenas densas)
+#define ARR_MAX_PAIRS ((size_t)1 << 27)
+
+typedef struct {
+    double   x, y;
+    uint32_t degree;            // cónicas distintas que pasan por él
+    int      multiplicity;      // máxima multiplicidad de corte (2 = tangencia)
+} ArrVertex;
+
+typedef struct {
+    uint32_t conic;
+    int32_t  branch;            // 0, o -1/+1 en hipérbolas
+    uint32_t v0, v1;            // vértices extremos o ARR_NONE
+    double   t0, t1;            // parámetro en los extremos (±inf si ARR_NONE)
+} ArrEdge;
+
+typedef struct {
+    size_t     conic_count;
+    double*    bounds;          // 4 por cónica; NaN si no toca la ventana
+    size_t     visible;         // cónicas que tocan la ventana
+
+    size_t     candidate_pairs; // pares que superan la fase amplia
+    size_t     skipped_pairs;   // candidatos sin intersectar (presupuesto)
+
+    ArrVertex* vertices;
+    size_t     vertex_count;
+    ArrEdge*   edges;
+    size_t     edge_count;
+} Arrangement;
+
+typedef enum {
+    ARR_OK = 0,
+    ARR_ERR_NOMEM,
+    ARR_ERR_TOO_MANY_PAIRS,
+    ARR_ERR_CANCELLED           // budget_cancel entre fases (--serve)
+} ArrStatus;
+
+/**
+ * Construye el arreglo de n cónicas (coeffs: n filas de 6 coeficientes)
+ * dentro de window = [x_min, y_min, x_max, y_max].
+ */
+ArrStatus arrangement_build(
+    const double* coeffs, size_t n,
+    const double window[4],
+    Arrangement* out
+);
+
+void arrangement_free(Arrangement* a);
+
+/**
+ * Código de error legible para JSON.
+ */
+const char* arrangement_status_str(ArrStatus s);
+
+#endif
@@ -0,0 +1,150 @@
+//================================================================//
+// BEZIER - Conversión exacta de arcos de cónica
+//================================================================//
+//
+// Cada segmento es la imagen afín del arco modelo de su rama (círculo
+// unidad, hipérbola x² - y² = 1, parábola y = x²), así que basta el
+// punto de control del modelo: la transformación afín conserva pesos.
+//
+//--------------------------------//
+// Includes y dependencias
+//--------------------------------//
+#include "bezier.h"
+
+#include <math.h>
+
+#include "threadpool.h"
+
+/**
+ * @file bezier.c
+ * @brief Segmentos de Bézier racionales descritos en bezier.h.
+ */
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define BEZIER_GRAIN 64
+
+//-------------------------------------------//
+//           FUNCIONES AUXILIARES            //
+//-------------------------------------------//
+
+/**
+ * @brief Segmento exacto de [a, b] (giro de tangente < 180°).
+ * @details Con m = (a + b)/2 y h = (b - a)/2, el control del modelo es:
+ *          - círculo:   (cos m, sin m) / cos h,   w = cos h
+ *          - hipérbola: (cosh m, sinh m) / cosh h, w = cosh h
+ *          - parábola:  (m, a·b),                  w = 1
+ *          - recta:     punto medio,               w = 1
+ */
+static void segment(const ConicBranch* b, double a, double e, RationalQuad* q) {
+    double p0[2], p2[2];
+    branch_eval(b, a, p0, NULL);
+    branch_eval(b, e, p2, NULL);
+
+    double m = 0.5 * (a + e), h = 0.5 * (e - a);
+    double f1, f2, w;
+    switch (b->kind) {
+        case PARAM_ARC:
+            w = cos(h);
+            f1 = cos(m) / w;
+            f2 = sin(m) / w;
+            break;
+        case PARAM_HYPERBOLA:
+            w = cosh(h);
+            f1 = cosh(m) / w;
+            f2 = sinh(m) / w;
+            break;
+        case PARAM_PARABOLA:
+            w = 1.0;
+            f1 = m;
+            f2 = a * e;
+            break;
+        default:
+            w = 1.0;
+            f1 = m;
+            f2 = 0.0;
+            break;
+    }
+
+    q->x0 = p0[0]; q->y0 = p0[1];
+    q->x1 = b->ox + f1*b->ux + f2*b->vx;
+    q->y1 = b->oy + f1*b->uy + f2*b->vy;
+    q->x2 = p2[0]; q->y2 = p2[1];
+    q->w = w;
+}
+
+typedef struct {
+    const double* coeffs;
+    const double* window;
+    RationalQuad* out;
+    int*          counts;
+} BezierJob;
+
+static void bezier_range(size_t begin, size_t end, void* ctx) {
+    BezierJob* job = ctx;
+    for (size_t i = begin; i < end; i++) {
+        job->counts[i] = conic_to_bezier(job->coeffs + 6 * i, job->window,
+                                         job->out + i * BEZIER_MAX_SEGMENTS);
+    }
+}
+
+//-------------------------------------------//
+//               API PÚBLICA                 //
+//-------------------------------------------//
+
+/**
+ * @brief Segmentos del tramo [t0, t1] de una rama.
+ * @details Elipse: trozos iguales de como mucho π/2. Hipérbola y
+ *          parábola: se parte en el vértice (t = 0) si el tramo lo
+ *          contiene; cada mitad gira menos de 90°. Recta: un segmento.
+ */
+int bezier_from_interval(const ConicBranch* b, double t0, double t1, RationalQuad* out) {
+    if (!(t1 > t0)) return 0;
+
+    double cuts[BEZIER_MAX_PER_INTERVAL + 1] = { t0, t1 };
+    int pieces = 1;
+    if (b->kind == PARAM_ARC) {
+        pieces = (int)ceil((t1 - t0) / (0.5 * M_PI) - 1e-9);
+        if (pieces < 1) pieces = 1;
+        if (pieces > BEZIER_MAX_PER_INTERVAL) pieces = BEZIER_MAX_PER_INTERVAL;
+        for (int k = 0; k <= pieces; k++) cuts[k] = t0 + (t1 - t0) * k / pieces;
+    } else if ((b->kind == PARAM_HYPERBOLA || b->kind == PARAM_PARABOLA) &&
+               t0 < 0.0 && t1 > 0.0) {
+        pieces = 2;
+        cuts[1] = 0.0;
+        cuts[2] = t1;
+    }
+
+    for (int k = 0; k < pieces; k++) segment(b, cuts[k], cuts[k + 1], &out[k]);
+    return pieces;
+}
+
+/**
+ * @brief Segmentos de una cónica recortada a la ventana.
+ */
+int conic_to_bezier(const double c[6], const double window[4], RationalQuad* out) {
+    ConicBranch br[PARAM_MAX_BRANCHES];
+    ParamInterval iv[PARAM_MAX_INTERVALS];
+    int nb = conic_branches(c, br), count = 0;
+
+    for (int i = 0; i < nb; i++) {
+        int ni = branch_clip(&br[i], window, iv);
+        for (int j = 0; j < ni; j++) {
+            int k = bezier_from_interval(&br[i], iv[j].t0, iv[j].t1, out + count);
+            for (int s = 0; s < k; s++) out[count + s].branch = i;
+            count += k;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief conic_to_bezier por lotes, en paralelo.
+ */
+void conic_to_bezier_batch(const double* coeffs, size_t n, const double window[4],
+                           RationalQuad* out, int* counts) {
+    BezierJob job = { coeffs, window, out, counts };
+    tp_parallel_for(0, n, BEZIER_GRAIN, bezier_range, &job);
+}
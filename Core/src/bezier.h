@@ -0,0 +1,60 @@
+//================================================================//
+//      BEZIER HEADER - Arcos de cónica como Bézier racionales     //
+//================================================================//
+//
+// Todo arco de cónica es exactamente una Bézier cuadrática racional:
+// extremos P0, P2 con peso 1 y control P1 (intersección de las
+// tangentes) con peso w:
+//
+//   B(s) = ((1-s)²·P0 + 2s(1-s)·w·P1 + s²·P2) / ((1-s)² + 2s(1-s)·w + s²)
+//
+// w < 1 en elipses (w = cos h para un arco de semiamplitud h), w = 1 en
+// parábolas y rectas, w > 1 en hipérbolas (w = cosh h). La curva se
+// recorta a la ventana y cada tramo se parte lo justo para que ningún
+// segmento gire más de 90°: 4 segmentos para una elipse completa y 1 o 2
+// por rama de hipérbola o parábola. El renderizador tesela a la
+// resolución de pantalla en lugar de recibir cientos de puntos.
+//
+
+#ifndef BEZIER_H
+#define BEZIER_H
+
+#include <stddef.h>
+
+#include "param.h"
+
+// Segmentos por tramo: 4 (cuarto de elipse); por cónica, ramas x tramos
+#define BEZIER_MAX_PER_INTERVAL 4
+#define BEZIER_MAX_SEGMENTS \
+    (PARAM_MAX_BRANCHES * PARAM_MAX_INTERVALS * BEZIER_MAX_PER_INTERVAL)
+
+typedef struct {
+    double x0, y0;              // P0 (peso 1)
+    double x1, y1;              // P1 (peso w)
+    double x2, y2;              // P2 (peso 1)
+    double w;
+    int    branch;              // índice de rama (0..PARAM_MAX_BRANCHES-1)
+} RationalQuad;
+
+/**
+ * Segmentos exactos del tramo [t0, t1] de la rama b. Devuelve cuántos
+ * escribe en out (hasta BEZIER_MAX_PER_INTERVAL).
+ */
+int bezier_from_interval(const ConicBranch* b, double t0, double t1, RationalQuad* out);
+
+/**
+ * Segmentos de la cónica c = [A..F] recortada a window
+ * ([x_min, y_min, x_max, y_max]), por rama y en orden de recorrido.
+ * out debe admitir BEZIER_MAX_SEGMENTS. Devuelve el número de segmentos.
+ */
+int conic_to_bezier(const double c[6], const double window[4], RationalQuad* out);
+
+/**
+ * Lote: conic_to_bezier para n cónicas de coeffs (6 por fila), en
+ * paralelo. out reserva BEZIER_MAX_SEGMENTS por cónica; counts[i] es el
+ * número de segmentos de la cónica i.
+ */
+void conic_to_bezier_batch(const double* coeffs, size_t n, const double window[4],
+                           RationalQuad* out, int* counts);
+
+#endif
@@ -0,0 +1,68 @@
+//================================================================//
+// BUDGET - Plazos de cómputo por hilo
+//================================================================//
+//--------------------------------//
+// Includes y dependencias
+//--------------------------------//
+#include "budget.h"
+
+#include <math.h>
+#include <stddef.h>
+
+#include "utils.h"
+
+/**
+ * @file budget.c
+ * @brief Token de plazo por hilo y su consulta.
+ */
+
+static _Thread_local Budget* tls_budget = NULL;
+
+//-------------------------------------------//
+//               API PÚBLICA                 //
+//-------------------------------------------//
+
+void budget_init(Budget* b, double ms) {
+    b->deadline = ms > 0.0 ? now_ms() + ms : INFINITY;
+    atomic_init(&b->expired, false);
+    atomic_init(&b->cancelled, false);
+}
+
+Budget* budget_swap(Budget* b) {
+    Budget* prev = tls_budget;
+    tls_budget = b;
+    return prev;
+}
+
+Budget* budget_current(void) {
+    return tls_budget;
+}
+
+/**
+ * @brief Una vez vencido, el flag evita volver a leer el reloj. Un bucle
+ *        que ve la cancelación también lo marca: su resultado ya es parcial.
+ */
+bool budget_exhausted(void) {
+    Budget* b = tls_budget;
+    if (!b) return false;
+    if (atomic_load_explicit(&b->expired, memory_order_relaxed)) return true;
+    if (atomic_load_explicit(&b->cancelled, memory_order_relaxed)) {
+        atomic_store(&b->expired, true);
+        return true;
+    }
+    if (isinf(b->deadline) || now_ms() < b->deadline) return false;
+    atomic_store(&b->expired, true);
+    return true;
+}
+
+bool budget_truncated(const Budget* b) {
+    return atomic_load(&((Budget*)b)->expired);
+}
+
+void budget_cancel(Budget* b) {
+    atomic_store(&b->cancelled, true);
+}
+
+bool budget_cancelled(const Budget* b) {
+    return b && atomic_load(&((Budget*)b)->cancelled);
+}
@@ -0,0 +1,71 @@
+//================================================================//
+//        BUDGET HEADER - Plazos de cómputo con degradación       //
+//================================================================//
+//
+// Una petición puede llevar un presupuesto de tiempo. El token Budget se
+// instala en el hilo que atiende la petición y el pool (threadpool.c) lo
+// hereda en cada tarea que ese hilo reparte, así que los bucles largos
+// lo consultan con budget_exhausted() sin recibirlo por parámetro.
+//
+// Vencido el plazo no se aborta nada: cada bucle degrada a lo más barato
+// que aún dé un resultado útil (menos muestras, teselas sin dibujar,
+// filas sin puntos) y la respuesta sale marcada como truncada.
+//
+// La cancelación (modo --serve) usa el mismo camino: un token cancelado
+// se da por vencido, los bucles terminan enseguida y el resultado se
+// descarta. Si la cancelación llega cuando ningún bucle la va a ver, el
+// resultado ya está completo y se entrega.
+//
+
+#ifndef BUDGET_H
+#define BUDGET_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+typedef struct {
+    double      deadline;       // now_ms() límite; INFINITY = sin plazo
+    atomic_bool expired;        // alguna comprobación llegó tarde
+    atomic_bool cancelled;      // budget_cancel desde otro hilo
+} Budget;
+
+/**
+ * Presupuesto de ms milisegundos desde ahora; ms <= 0 no pone plazo.
+ */
+void budget_init(Budget* b, double ms);
+
+/**
+ * Instala b como token del hilo actual (NULL = sin presupuesto) y
+ * devuelve el anterior para restaurarlo.
+ */
+Budget* budget_swap(Budget* b);
+
+/**
+ * Token del hilo actual o NULL.
+ */
+Budget* budget_current(void);
+
+/**
+ * true si el token del hilo actual ya no tiene tiempo o se canceló.
+ * Cuesta una lectura del reloj: llamar por tramo, tesela o fila, no por
+ * píxel.
+ */
+bool budget_exhausted(void);
+
+/**
+ * true si algún bucle vio vencido o cancelado b (resultado parcial).
+ */
+bool budget_truncated(const Budget* b);
+
+/**
+ * Cancela b: desde ya, budget_exhausted() es true en todos los hilos
+ * que trabajan con él. Seguro desde cualquier hilo.
+ */
+void budget_cancel(Budget* b);
+
+/**
+ * true si b (puede ser NULL) se canceló.
+ */
+bool budget_cancelled(const Budget* b);
+
+#endif
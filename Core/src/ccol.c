@@ -0,0 +1,264 @@
+//================================================================//
+// CCOL - Lectura/escritura del formato columnar binario
+//================================================================//
+//
+// Lectura con mmap (cero copias, cero parseo) y escritura secuencial
+// con relleno para respetar la alineación de cada columna.
+//
+//--------------------------------//
+// Includes y dependencias
+//--------------------------------//
+#define _POSIX_C_SOURCE 200809L
+
+#include "ccol.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+_Static_assert(sizeof(CcolHeader) == CCOL_HEADER_SIZE, "CcolHeader debe ocupar 192 bytes");
+_Static_assert(sizeof(Point2D) == 2 * sizeof(double), "Point2D debe ser (x, y) contiguo");
+
+/**
+ * @file ccol.c
+ * @brief Implementación del formato CCOL descrito en ccol.h.
+ */
+
+//-------------------------------------------//
+//            FUNCIONES AUXILIARES           //
+//-------------------------------------------//
+
+/**
+ * @brief Tamaño en bytes de la columna col para rows filas y points puntos.
+ */
+static size_t column_bytes(CcolColumn col, size_t rows, size_t points) {
+    switch (col) {
+        case CCOL_COL_TYPE:
+        case CCOL_COL_FLAGS:         return rows * 4;
+        case CCOL_COL_POINT_OFFSETS: return (rows + 1) * sizeof(uint64_t);
+        case CCOL_COL_POINTS:        return points * sizeof(Point2D);
+        default:                     return rows * sizeof(double);
+    }
+}
+
+/**
+ * @brief Tabla columna -> puntero dentro de la vista CcolFile.
+ */
+static const void** column_slot(CcolFile* f, CcolColumn col) {
+    switch (col) {
+        case CCOL_COL_A:             return (const void**)&f->A;
+        case CCOL_COL_B:             return (const void**)&f->B;
+        case CCOL_COL_C:             return (const void**)&f->C;
+        case CCOL_COL_D:             return (const void**)&f->D;
+        case CCOL_COL_E:             return (const void**)&f->E;
+        case CCOL_COL_F:             return (const void**)&f->F;
+        case CCOL_COL_TYPE:          return (const void**)&f->type;
+        case CCOL_COL_FLAGS:         return (const void**)&f->flags;
+        case CCOL_COL_DELTA:         return (const void**)&f->delta;
+        case CCOL_COL_CX:            return (const void**)&f->cx;
+        case CCOL_COL_CY:            return (const void**)&f->cy;
+        case CCOL_COL_THETA:         return (const void**)&f->theta;
+        case CCOL_COL_CA:            return (const void**)&f->a;
+        case CCOL_COL_CB:            return (const void**)&f->b;
+        case CCOL_COL_POINT_OFFSETS: return (const void**)&f->point_offsets;
+        case CCOL_COL_POINTS:        return (const void**)&f->point_data;
+        default:                     return NULL;
+    }
+}
+
+static size_t align_up(size_t v) {
+    return (v + (CCOL_ALIGN - 1)) & ~(size_t)(CCOL_ALIGN - 1);
+}
+
+/**
+ * @brief Escribe n bytes de relleno a cero.
+ */
+static int write_padding(FILE* fp, size_t n) {
+    static const unsigned char zeros[CCOL_ALIGN] = {0};
+    while (n > 0) {
+        size_t k = n < sizeof(zeros) ? n : sizeof(zeros);
+        if (fwrite(zeros, 1, k, fp) != k) return -1;
+        n -= k;
+    }
+    return 0;
+}
+
+//-------------------------------------------//
+//                  LECTURA                  //
+//-------------------------------------------//
+
+/**
+ * @brief Abre y valida un fichero CCOL mapeándolo en memoria.
+ * @param path Ruta del fichero.
+ * @param f Vista a rellenar (columnas ausentes quedan a NULL).
+ * @return CCOL_OK o el código de error correspondiente.
+ */
+CcolStatus ccol_open(const char* path, CcolFile* f) {
+    memset(f, 0, sizeof(*f));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return CCOL_ERR_IO;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return CCOL_ERR_IO;
+    }
+    if ((size_t)st.st_size < CCOL_HEADER_SIZE) {
+        close(fd);
+        return CCOL_ERR_FORMAT;
+    }
+
+    size_t size = (size_t)st.st_size;
+    void* base = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return CCOL_ERR_IO;
+
+    const CcolHeader* h = (const CcolHeader*)base;
+    CcolStatus status = CCOL_OK;
+
+    if (memcmp(h->magic, CCOL_MAGIC, 4) != 0 ||
+        h->endian_tag != CCOL_ENDIAN_TAG ||
+        h->header_size < CCOL_HEADER_SIZE) {
+        status = CCOL_ERR_FORMAT;
+    } else if (h->version_major != CCOL_VERSION_MAJOR) {
+        status = CCOL_ERR_VERSION;
+    } else if (h->rows > SIZE_MAX / sizeof(uint64_t) - 1 ||
+               h->points > SIZE_MAX / sizeof(Point2D)) {
+        // column_bytes no puede desbordar con tamaños de la cabecera
+        status = CCOL_ERR_FORMAT;
+    }
+
+    f->rows = (size_t)h->rows;
+    f->points = (size_t)h->points;
+
+    for (int c = 0; c < CCOL_NCOLUMNS && status == CCOL_OK; c++) {
+        uint64_t off = h->offsets[c];
+        if (off == 0) continue;
+
+        size_t len = column_bytes((CcolColumn)c, f->rows, f->points);
+        if (off % CCOL_ALIGN != 0 || off > size || len > size - off) {
+            status = CCOL_ERR_FORMAT;
+            break;
+        }
+        *column_slot(f, (CcolColumn)c) = (const char*)base + off;
+    }
+
+    // Coeficientes obligatorios; los puntos van siempre en pareja
+    if (status == CCOL_OK &&
+        (!f->A || !f->B || !f->C || !f->D || !f->E || !f->F ||
+         (!f->point_offsets != !f->point_data))) {
+        status = CCOL_ERR_FORMAT;
+    }
+
+    // Índices de puntos crecientes y dentro de POINTS: validados una vez
+    // aquí, los lectores pueden indexar point_data sin comprobar
+    if (status == CCOL_OK && f->point_offsets) {
+        for (size_t i = 0; i < f->rows; i++) {
+            if (f->point_offsets[i] > f->point_offsets[i + 1]) {
+                status = CCOL_ERR_FORMAT;
+                break;
+            }
+        }
+        if (f->point_offsets[f->rows] > f->points) status = CCOL_ERR_FORMAT;
+    }
+
+    if (status != CCOL_OK) {
+        munmap(base, size);
+        memset(f, 0, sizeof(*f));
+        return status;
+    }
+
+    // Acceso secuencial columna a columna
+    posix_madvise(base, size, POSIX_MADV_SEQUENTIAL);
+
+    f->map_base = base;
+    f->map_size = size;
+    return CCOL_OK;
+}
+
+/**
+ * @brief Libera el mapeo de un fichero abierto con ccol_open.
+ */
+void ccol_close(CcolFile* f) {
+    if (f->map_base) munmap(f->map_base, f->map_size);
+    memset(f, 0, sizeof(*f));
+}
+
+//-------------------------------------------//
+//                 ESCRITURA                 //
+//-------------------------------------------//
+
+/**
+ * @brief Escribe un fichero CCOL con las columnas presentes en f.
+ * @param path Ruta de destino (se sobrescribe).
+ * @param f Columnas en memoria; rows y points definen los tamaños.
+ * @return CCOL_OK o el código de error correspondiente.
+ */
+CcolStatus ccol_write(const char* path, const CcolFile* f) {
+    if (!f->A || !f->B || !f->C || !f->D || !f->E || !f->F) return CCOL_ERR_FORMAT;
+    if (!f->point_offsets != !f->point_data) return CCOL_ERR_FORMAT;
+
+    CcolHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, CCOL_MAGIC, 4);
+    h.version_major = CCOL_VERSION_MAJOR;
+    h.version_minor = CCOL_VERSION_MINOR;
+    h.header_size = CCOL_HEADER_SIZE;
+    h.endian_tag = CCOL_ENDIAN_TAG;
+    h.alignment = CCOL_ALIGN;
+    h.rows = f->rows;
+    h.points = f->point_data ? f->points : 0;
+
+    // Primera pasada: offsets alineados
+    CcolFile view = *f;
+    size_t pos = align_up(CCOL_HEADER_SIZE);
+    for (int c = 0; c < CCOL_NCOLUMNS; c++) {
+        if (!*column_slot(&view, (CcolColumn)c)) continue;
+        h.offsets[c] = pos;
+        pos = align_up(pos + column_bytes((CcolColumn)c, f->rows, h.points));
+    }
+
+    if (f->delta || f->type) h.flags |= CCOL_HAS_RESULTS;
+    if (f->point_data) h.flags |= CCOL_HAS_POINTS;
+
+    FILE* fp = fopen(path, "wb");
+    if (!fp) return CCOL_ERR_IO;
+
+    int err = fwrite(&h, sizeof(h), 1, fp) != 1;
+    size_t written = sizeof(h);
+
+    // Segunda pasada: datos con relleno
+    for (int c = 0; c < CCOL_NCOLUMNS && !err; c++) {
+        const void* data = *column_slot(&view, (CcolColumn)c);
+        if (!data) continue;
+
+        size_t len = column_bytes((CcolColumn)c, f->rows, h.points);
+        err = write_padding(fp, h.offsets[c] - written) != 0 ||
+              (len > 0 && fwrite(data, 1, len, fp) != len);
+        written = h.offsets[c] + len;
+    }
+
+    if (!err) err = write_padding(fp, align_up(written) - written) != 0;
+    if (fclose(fp) != 0) err = 1;
+
+    return err ? CCOL_ERR_IO : CCOL_OK;
+}
+
+/**
+ * @brief Convierte un CcolStatus en un código de error para JSON.
+ */
+const char* ccol_status_str(CcolStatus s) {
+    switch (s) {
+        case CCOL_OK:          return "ok";
+        case CCOL_ERR_IO:      return "ccol_io_error";
+        case CCOL_ERR_FORMAT:  return "ccol_invalid_format";
+        case CCOL_ERR_VERSION: return "ccol_unsupported_version";
+        case CCOL_ERR_NOMEM:   return "ccol_out_of_memory";
+        default:               return "ccol_unknown_error";
+    }
+}
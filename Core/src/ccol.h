@@ -0,0 +1,140 @@
+//================================================================//
+//          CCOL - FORMATO COLUMNAR BINARIO (VERSIÓN 1.0)         //
+//================================================================//
+//
+// Formato binario versionado para corpus de cónicas y sus resultados.
+// Pensado para abrirse con mmap y pasar las columnas directamente a
+// los kernels por lotes, sin ningún parseo de texto.
+//
+// Disposición del fichero (little-endian):
+//
+//   [0, 192)     CcolHeader
+//   offsets[i]   columna i, alineada a CCOL_ALIGN bytes (0 = ausente)
+//
+// Columnas por fila (rows elementos cada una):
+//   A, B, C, D, E, F          float64   coeficientes
+//   TYPE                      int32     ConicType
+//   FLAGS                     uint32    CCOL_ROW_* (centro, rotación...)
+//   DELTA, CX, CY, THETA      float64   resultados de analyze_conic
+//   CA, CB                    float64   parámetros canónicos a y b
+//
+// Bloque opcional de puntos:
+//   POINT_OFFSETS             uint64    rows + 1 índices al bloque
+//   POINTS                    float64   pares (x, y); la fila i ocupa
+//                                       [off[i], off[i+1]) puntos
+//
+// Compatibilidad: un lector acepta cualquier version_minor con la
+// misma version_major; las columnas desconocidas se ignoran.
+//
+
+#ifndef CCOL_H
+#define CCOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "conics.h"
+
+#define CCOL_MAGIC          "CCOL"
+#define CCOL_VERSION_MAJOR  1
+#define CCOL_VERSION_MINOR  0
+#define CCOL_HEADER_SIZE    192
+#define CCOL_ALIGN          64
+#define CCOL_ENDIAN_TAG     0x01020304u
+
+// Flags de fichero
+#define CCOL_HAS_RESULTS    0x1u
+#define CCOL_HAS_POINTS     0x2u
+
+// Flags por fila (columna FLAGS)
+#define CCOL_ROW_CENTER     CONIC_FLAG_CENTER
+#define CCOL_ROW_ROTATION   CONIC_FLAG_ROTATION
+#define CCOL_ROW_CANONICAL  CONIC_FLAG_CANONICAL
+
+typedef enum {
+    CCOL_COL_A,
+    CCOL_COL_B,
+    CCOL_COL_C,
+    CCOL_COL_D,
+    CCOL_COL_E,
+    CCOL_COL_F,
+    CCOL_COL_TYPE,
+    CCOL_COL_FLAGS,
+    CCOL_COL_DELTA,
+    CCOL_COL_CX,
+    CCOL_COL_CY,
+    CCOL_COL_THETA,
+    CCOL_COL_CA,
+    CCOL_COL_CB,
+    CCOL_COL_POINT_OFFSETS,
+    CCOL_COL_POINTS,
+    CCOL_NCOLUMNS
+} CcolColumn;
+
+typedef struct {
+    char     magic[4];          // "CCOL"
+    uint16_t version_major;
+    uint16_t version_minor;
+    uint32_t header_size;       // CCOL_HEADER_SIZE
+    uint32_t flags;             // CCOL_HAS_*
+    uint32_t endian_tag;        // CCOL_ENDIAN_TAG
+    uint32_t alignment;         // CCOL_ALIGN
+    uint64_t rows;
+    uint64_t points;            // total de puntos en POINTS
+    uint64_t offsets[CCOL_NCOLUMNS];
+    uint8_t  reserved[CCOL_HEADER_SIZE - 40 - 8 * CCOL_NCOLUMNS];
+} CcolHeader;
+
+typedef enum {
+    CCOL_OK = 0,
+    CCOL_ERR_IO,
+    CCOL_ERR_FORMAT,
+    CCOL_ERR_VERSION,
+    CCOL_ERR_NOMEM
+} CcolStatus;
+
+/**
+ * Vista de un fichero CCOL. En lectura los punteros apuntan dentro del
+ * mapeo (solo lectura); en escritura apuntan a memoria del llamador.
+ * Las columnas ausentes valen NULL.
+ */
+typedef struct {
+    size_t rows;
+    size_t points;
+
+    const double *A, *B, *C, *D, *E, *F;
+
+    const int32_t*  type;
+    const uint32_t* flags;
+    const double *delta, *cx, *cy, *theta, *a, *b;
+
+    const uint64_t* point_offsets;
+    const Point2D*  point_data;
+
+    // Mapeo (solo lectura)
+    void*  map_base;
+    size_t map_size;
+} CcolFile;
+
+/**
+ * Abre un fichero CCOL con mmap y valida cabecera y offsets.
+ */
+CcolStatus ccol_open(const char* path, CcolFile* f);
+
+/**
+ * Libera el mapeo creado por ccol_open.
+ */
+void ccol_close(CcolFile* f);
+
+/**
+ * Escribe las columnas no nulas de f en path, alineadas a CCOL_ALIGN.
+ * Las columnas de coeficientes A..F son obligatorias.
+ */
+CcolStatus ccol_write(const char* path, const CcolFile* f);
+
+/**
+ * Descripción legible de un CcolStatus.
+ */
+const char* ccol_status_str(CcolStatus s);
+
+#endif
@@ -17,6 +17,8 @@
 #include <math.h>
 #include <string.h>
 
+#include "poly.h"
+
 /**
  * @file conics.c
  * @brief Implementación inicial del módulo de cónicas.
@@ -182,6 +184,63 @@ static void sample_points(ConicResult* r) {
     }
 }
 
+/**
+ * @brief Inicializa coeficientes y campos escalares de un resultado.
+ * @details No toca el array de puntos: permite reutilizar ConicResult en
+ *          los lotes sin pagar el memset de MAX_POINTS puntos por fila.
+ */
+static void init_result(
+    ConicResult* r,
+    double A, double B, double C,
+    double D, double E, double F
+) {
+    r->A = A; r->B = B; r->C = C;
+    r->D = D; r->E = E; r->F = F;
+
+    r->has_center = false;    r->cx = 0.0; r->cy = 0.0;
+    r->has_rotation = false;  r->theta = 0.0;
+    r->has_canonical = false; r->a = 0.0;  r->b = 0.0;
+    r->point_count = 0;
+}
+
+/**
+ * @brief Calcula clasificación, centro, rotación y parámetros canónicos.
+ * @param r Resultado con coeficientes ya inicializados.
+ */
+static void compute_invariants(ConicResult* r) {
+    r->delta = r->B*r->B - 4*r->A*r->C;
+    r->type = classify(r->A, r->B, r->C);
+
+    compute_center(r);
+    compute_rotation(r);
+
+    // Parámetros canónicos (fase 2: ahora dejamos stub limpio)
+    r->has_canonical = false;
+    compute_canonical_params(r);
+}
+
+/**
+ * @brief Marca como degenerada una parábola cuyo término F' se anula.
+ * @note Debe ejecutarse después del muestreo, que usa el tipo PARABOLA.
+ */
+static void detect_degenerate(ConicResult* r) {
+    // --- FINAL BOSS !0_0! : Detectar degeneración parabólica  ---
+    if (r->type == CONIC_PARABOLA) {
+        double h = r->cx;
+        double k = r->cy;
+        double Fp =
+            r->F +
+            r->A * h * h +
+            r->C * k * k +
+            r->D * h +
+            r->E * k;
+        double eps = 1e-8;
+        if (fabs(Fp) < eps) {
+            r->type = CONIC_DEGENERATE;
+        }
+    }
+}
+
 /**
  * @brief Analiza una cónica general Ax² + Bxy + Cy² + Dx + Ey + F = 0.
  * @param A Coeficiente de x².
@@ -201,39 +260,333 @@ ConicResult analyze_conic(
     ConicResult r;
     memset(&r, 0, sizeof(ConicResult));
 
-    r.A = A; r.B = B; r.C = C;
-    r.D = D; r.E = E; r.F = F;
+    init_result(&r, A, B, C, D, E, F);
+    compute_invariants(&r);
 
-    r.delta = B*B - 4*A*C;
-    r.type = classify(A, B, C);
+    // Fallback geométrico
+    sample_points(&r);
 
-    compute_center(&r);
-    compute_rotation(&r);
+    detect_degenerate(&r);
 
-    // Parámetros canónicos (fase 2: ahora dejamos stub limpio)
-    r.has_canonical = false;
-    compute_canonical_params(&r);
+    return r;
+}
 
-    // Fallback geométrico
-    sample_points(&r);
+/**
+ * Filas por bloque de analyze_conic_columns: tipo y flags pasan por un
+ * scratch de doubles en la pila (2 x 2 KiB).
+ */
+#define COLUMNS_BLOCK 256
 
-    // --- FINAL BOSS !0_0! : Detectar degeneración parabólica  ---
-    if (r.type == CONIC_PARABOLA) {
-        double h = r.cx;
-        double k = r.cy;
-        double Fp =
-            r.F +
-            r.A * h * h +
-            r.C * k * k +
-            r.D * h +
-            r.E * k;
-        double eps = 1e-8;
-        if (fabs(Fp) < eps) {
-            r.type = CONIC_DEGENERATE;
+/**
+ * @brief Bucle vectorizable de analyze_conic_columns sobre m filas.
+ * @details Misma lógica que classify, compute_center, compute_rotation,
+ *          compute_canonical_params y detect_degenerate, con cada if
+ *          convertido en selección. Los dos lados se calculan siempre (las
+ *          divisiones por cero o raíces negativas del lado descartado no
+ *          llegan a la salida) y en el mismo orden que en analyze_conic,
+ *          así que los resultados son idénticos bit a bit.
+ *
+ *          Tipo y flags salen como doubles enteros: GCC 12 no vectoriza
+ *          selecciones enteras que dependan de varias comparaciones de
+ *          double, pero sí las de double. Los punteros van como parámetros
+ *          restrict porque GCC no aprovecha restrict en variables locales
+ *          y sin él versiona el bucle con demasiadas comprobaciones de
+ *          solapamiento.
+ */
+static void columns_block(
+    const double* restrict A, const double* restrict B, const double* restrict C,
+    const double* restrict D, const double* restrict E, const double* restrict F,
+    double* restrict delta, double* restrict cx, double* restrict cy,
+    double* restrict ca, double* restrict cb,
+    double* restrict type, double* restrict flags, size_t m
+) {
+    for (size_t j = 0; j < m; j++) {
+        const double a = A[j], b = B[j], c = C[j], d = D[j], e = E[j], f = F[j];
+
+        // classify (NaN cae en DEGENERATE, como allí)
+        const double dl = b*b - 4*a*c;
+        const bool flat = fabs(dl) < 1e-8;
+        const bool ell = !flat & (dl < 0), hyp = !flat & (dl > 0);
+        const bool circle = ell & (fabs(b) < 1e-8) & (fabs(a - c) < 1e-8);
+        double t = hyp ? CONIC_HYPERBOLA : CONIC_DEGENERATE;
+        t = ell ? (circle ? CONIC_CIRCLE : CONIC_ELLIPSE) : t;
+        t = flat ? CONIC_PARABOLA : t;
+
+        // compute_center y compute_rotation
+        const double det = 4*a*c - b*b;
+        const bool has_c = !(fabs(det) < 1e-8);
+        const double hx = (b*e - 2*c*d) / det, ky = (b*d - 2*a*e) / det;
+        const double h = has_c ? hx : 0.0;
+        const double k = has_c ? ky : 0.0;
+        const bool has_r = !((fabs(b) < 1e-8) | (fabs(a - c) < 1e-8));
+
+        // compute_canonical_params: sqrt(-F'/A) en las cerradas,
+        // sqrt(|F'/A|) en la hipérbola; el círculo repite el radio
+        const double fp = f + a*h*h + c*k*k + d*h + e*k;
+        const bool closed = ell & (fp < 0);
+        const bool open = hyp & (fp != 0);
+        const bool has_k = !has_r & has_c & (closed | open);
+        const double qa = fp / a, qc = fp / c;
+        const double ra = sqrt(open ? fabs(qa) : -qa);
+        const double rb = circle ? ra : sqrt(open ? fabs(qc) : -qc);
+
+        // detect_degenerate (misma F' que arriba)
+        t = flat & (fabs(fp) < 1e-8) ? CONIC_DEGENERATE : t;
+
+        delta[j] = dl;
+        type[j]  = t;
+        flags[j] = (has_c ? CONIC_FLAG_CENTER    : 0.0) +
+                   (has_r ? CONIC_FLAG_ROTATION  : 0.0) +
+                   (has_k ? CONIC_FLAG_CANONICAL : 0.0);
+        cx[j] = h;
+        cy[j] = k;
+        ca[j] = has_k ? ra : 0.0;
+        cb[j] = has_k ? rb : 0.0;
+    }
+}
+
+/**
+ * @brief Analiza por lotes las filas [begin, end) sin muestrear puntos.
+ * @param in Columnas de coeficientes.
+ * @param out Columnas de resultados (todas obligatorias).
+ * @param begin Primera fila.
+ * @param end Fila final (exclusiva).
+ * @details Por bloques de COLUMNS_BLOCK filas: columns_block y el bucle
+ *          que pasa tipo y flags a las columnas de 32 bits se vectorizan
+ *          con -fno-math-errno y -fno-trapping-math (ver Makefile); atan2
+ *          no tiene versión vectorial y queda escalar, solo en las filas
+ *          con rotación.
+ */
+void analyze_conic_columns(
+    const ConicCoeffColumns* in,
+    ConicResultColumns* out,
+    size_t begin, size_t end
+) {
+    double type[COLUMNS_BLOCK], flags[COLUMNS_BLOCK];
+
+    for (size_t b0 = begin; b0 < end; b0 += COLUMNS_BLOCK) {
+        const size_t m = end - b0 < COLUMNS_BLOCK ? end - b0 : COLUMNS_BLOCK;
+        columns_block(in->A + b0, in->B + b0, in->C + b0, in->D + b0, in->E + b0, in->F + b0,
+                      out->delta + b0, out->cx + b0, out->cy + b0, out->a + b0, out->b + b0,
+                      type, flags, m);
+
+        for (size_t j = 0; j < m; j++) {
+            out->type[b0 + j]  = (int32_t)type[j];
+            out->flags[b0 + j] = (uint32_t)(int32_t)flags[j];
+        }
+
+        for (size_t i = b0; i < b0 + m; i++) {
+            out->theta[i] = (out->flags[i] & CONIC_FLAG_ROTATION)
+                          ? 0.5 * atan2(in->B[i], in->A[i] - in->C[i]) : 0.0;
         }
     }
+}
 
-    return r;
+//-------------------------------------------//
+//          RE-ANÁLISIS INCREMENTAL          //
+//-------------------------------------------//
+
+/**
+ * @brief Valor de la forma en el centro: F' = Q(cx, cy).
+ * @details Para cónicas con centro, la curva es (p-c)ᵀM(p-c) = -F'.
+ */
+static double center_value(const ConicResult* r) {
+    double h = r->cx, k = r->cy;
+    return r->A*h*h + r->B*h*k + r->C*k*k + r->D*h + r->E*k + r->F;
 }
 
+/**
+ * @brief Comprueba si la elipse de r cabe en la ventana de muestreo en x.
+ * @details Semiancho en x de (p-c)ᵀM(p-c) = -F': sqrt(-F'·C / det(M)).
+ *          Si cabe, el muestreo cubre la curva entera y se puede deformar.
+ */
+static bool ellipse_inside_window(const ConicResult* r, double Fp) {
+    double detM = r->A*r->C - 0.25*r->B*r->B;
+    if (detM <= 0 || Fp >= 0 || r->C <= 0) return false;
+
+    double hx = sqrt(-Fp * r->C / detM);
+    return r->cx - hx > -10.0 && r->cx + hx < 10.0;
+}
 
+/**
+ * @brief Re-analiza r tras sumar delta al coeficiente coef.
+ * @param r Resultado previo de analyze_conic (se actualiza en sitio).
+ * @param coef Coeficiente modificado.
+ * @param delta Incremento aplicado al coeficiente.
+ * @return true si el muestreo previo se reutilizó deformándolo.
+ * @details Solo se recalculan las magnitudes que dependen de coef:
+ *          - Δ y rotación dependen únicamente de A, B, C.
+ *          - El centro depende de A..E (F no lo mueve).
+ *          - Parámetros canónicos y muestreo dependen de todo.
+ *          Si cambia D, E o F en una elipse completamente visible, la
+ *          nueva curva es una homotecia+traslación de la anterior:
+ *          p' = c' + s·(p - c), con s = sqrt(F'_nuevo / F'_viejo). Los
+ *          puntos se transforman en sitio (siguen exactamente sobre la
+ *          curva y conservan el emparejamiento (x, y+), (x, y-)).
+ */
+bool analyze_conic_update(ConicResult* r, ConicCoef coef, double delta) {
+    bool quadratic = coef == COEF_A || coef == COEF_B || coef == COEF_C;
+
+    // Estado previo necesario para deformar el muestreo
+    bool was_ellipse = r->has_center && ellipse_inside_window(r, center_value(r));
+    double old_cx = r->cx, old_cy = r->cy;
+    double old_Fp = r->has_center ? center_value(r) : 0.0;
+
+    switch (coef) {
+        case COEF_A: r->A += delta; break;
+        case COEF_B: r->B += delta; break;
+        case COEF_C: r->C += delta; break;
+        case COEF_D: r->D += delta; break;
+        case COEF_E: r->E += delta; break;
+        case COEF_F: r->F += delta; break;
+    }
+
+    if (quadratic) {
+        r->delta = r->B*r->B - 4*r->A*r->C;
+        compute_rotation(r);
+    }
+
+    // classify es trivial y deshace un posible DEGENERATE anterior
+    r->type = classify(r->A, r->B, r->C);
+
+    if (coef != COEF_F) {
+        // Igual que init_result: sin centro, cx/cy valen 0
+        r->cx = 0.0;
+        r->cy = 0.0;
+        compute_center(r);
+    }
+
+    r->has_canonical = false;
+    compute_canonical_params(r);
+
+    bool warped = false;
+    // Sin puntos previos (caché sin "points") no hay nada que deformar
+    if (!quadratic && was_ellipse && r->has_center && r->point_count > 0) {
+        double Fp = center_value(r);
+        if (ellipse_inside_window(r, Fp)) {
+            double s = sqrt(Fp / old_Fp);
+            for (int i = 0; i < r->point_count; i++) {
+                r->points[i].x = r->cx + s * (r->points[i].x - old_cx);
+                r->points[i].y = r->cy + s * (r->points[i].y - old_cy);
+            }
+            warped = true;
+        }
+    }
+
+    if (!warped) sample_points(r);
+
+    detect_degenerate(r);
+    return warped;
+}
+
+//-------------------------------------------//
+//          MARCO PRINCIPAL Y CAJAS          //
+//-------------------------------------------//
+
+/**
+ * @brief Tipo, centro, ejes propios y F' de una cónica.
+ * @param c Coeficientes [A, B, C, D, E, F].
+ * @param f Marco de salida.
+ * @details A diferencia de compute_canonical_params, cubre cónicas
+ *          giradas: l1 y l2 son los coeficientes de u² y v² tras girar
+ *          theta, por lo que los semiejes son sqrt(-f0 / l1), sqrt(-f0 / l2).
+ *          La degeneración se decide por el determinante 3x3 y la
+ *          existencia de centro por 4AC - B², ambos relativos al tamaño
+ *          de sus términos: con los coeficientes normalizados por el
+ *          mayor, una cónica lejos del origen tiene A y C diminutos y un
+ *          umbral absoluto la daría por degenerada.
+ */
+void conic_frame(const double c[6], ConicFrame* f) {
+    double A = c[0], B = c[1], C = c[2], D = c[3], E = c[4], F = c[5];
+
+    f->type = classify(A, B, C);
+    double det3 = A*(C*F - E*E/4) - B/2*(B/2*F - E*D/4) + D/2*(B*E/4 - C*D/2);
+    double mag3 = fabs(A*C*F) + fabs(A*E*E/4) + fabs(B*B*F/4)
+                + fabs(B*E*D/4) + fabs(C*D*D/4);
+    if (fabs(det3) <= 1e-8 * mag3) f->type = CONIC_DEGENERATE;
+
+    double det = 4*A*C - B*B;
+    f->has_center = fabs(det) > 1e-8 * (fabs(4*A*C) + B*B);
+    f->cx = f->has_center ? (B*E - 2*C*D) / det : 0.0;
+    f->cy = f->has_center ? (B*D - 2*A*E) / det : 0.0;
+    f->f0 = f->has_center ? F + 0.5 * (D*f->cx + E*f->cy) : 0.0;
+
+    double t = 0.5 * atan2(B, A - C);
+    double cs = cos(t), sn = sin(t);
+    f->cos_t = cs;
+    f->sin_t = sn;
+    f->l1 = A*cs*cs + B*cs*sn + C*sn*sn;
+    f->l2 = A*sn*sn - B*cs*sn + C*cs*cs;
+}
+
+/**
+ * @brief Amplía box con (x, y) si el punto está dentro de la ventana.
+ */
+static void bounds_add(double box[4], const double w[4], double tol, double x, double y) {
+    if (x < w[0] - tol || x > w[2] + tol || y < w[1] - tol || y > w[3] + tol) return;
+    x = fmin(fmax(x, w[0]), w[2]);
+    y = fmin(fmax(y, w[1]), w[3]);
+    box[0] = fmin(box[0], x);
+    box[1] = fmin(box[1], y);
+    box[2] = fmax(box[2], x);
+    box[3] = fmax(box[3], y);
+}
+
+/**
+ * @brief Caja del trozo de curva dentro de la ventana.
+ * @param c Coeficientes [A, B, C, D, E, F].
+ * @param window Ventana [x_min, y_min, x_max, y_max].
+ * @param box Caja de salida en el mismo formato.
+ * @return false si ningún punto de la curva cae en la ventana.
+ * @details Los extremos de la curva recortada están entre los cortes con
+ *          los cuatro bordes y los puntos interiores de tangente vertical
+ *          (∂Q/∂y = 0) u horizontal (∂Q/∂x = 0); cada familia se reduce a
+ *          una cuadrática, así que el coste es fijo para cualquier tipo.
+ */
+bool conic_bounds(const double c[6], const double window[4], double box[4]) {
+    double A = c[0], B = c[1], C = c[2], D = c[3], E = c[4], F = c[5];
+    double scale = 0.0;
+    for (int i = 0; i < 6; i++) scale = fmax(scale, fabs(c[i]));
+
+    box[0] = box[1] = INFINITY;
+    box[2] = box[3] = -INFINITY;
+    if (scale == 0.0) return false;
+
+    double tol = 1e-9 * fmax(window[2] - window[0], window[3] - window[1]);
+    double r[2];
+    int n;
+
+    // Bordes verticales: C·y² + (B·x + E)·y + (A·x² + D·x + F) = 0
+    for (int k = 0; k < 2; k++) {
+        double x = window[2 * k];
+        n = poly_solve_quadratic(C, B*x + E, A*x*x + D*x + F, r);
+        for (int i = 0; i < n; i++) bounds_add(box, window, tol, x, r[i]);
+    }
+
+    // Bordes horizontales: A·x² + (B·y + D)·x + (C·y² + E·y + F) = 0
+    for (int k = 0; k < 2; k++) {
+        double y = window[2 * k + 1];
+        n = poly_solve_quadratic(A, B*y + D, C*y*y + E*y + F, r);
+        for (int i = 0; i < n; i++) bounds_add(box, window, tol, r[i], y);
+    }
+
+    // Tangentes verticales: y = al·x + be sobre la recta ∂Q/∂y = 0
+    if (fabs(C) > 1e-12 * scale) {
+        double al = -B / (2*C), be = -E / (2*C);
+        n = poly_solve_quadratic(A + B*al + C*al*al,
+                                 B*be + 2*C*al*be + D + E*al,
+                                 C*be*be + E*be + F, r);
+        for (int i = 0; i < n; i++) bounds_add(box, window, tol, r[i], al*r[i] + be);
+    }
+
+    // Tangentes horizontales: x = ga·y + de sobre la recta ∂Q/∂x = 0
+    if (fabs(A) > 1e-12 * scale) {
+        double ga = -B / (2*A), de = -D / (2*A);
+        n = poly_solve_quadratic(C + B*ga + A*ga*ga,
+                                 B*de + 2*A*ga*de + E + D*ga,
+                                 A*de*de + D*de + F, r);
+        for (int i = 0; i < n; i++) bounds_add(box, window, tol, ga*r[i] + de, r[i]);
+    }
+
+    return box[0] <= box[2];
+}
@@ -11,9 +11,16 @@
 #define CONICS_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #define MAX_POINTS 512
 
+// Flags compactos de ConicResult (has_center, has_rotation, has_canonical)
+#define CONIC_FLAG_CENTER     0x1u
+#define CONIC_FLAG_ROTATION   0x2u
+#define CONIC_FLAG_CANONICAL  0x4u
+
 typedef enum {
     CONIC_CIRCLE,   
     CONIC_ELLIPSE,
@@ -22,6 +29,18 @@ typedef enum {
     CONIC_DEGENERATE
 } ConicType;
 
+/**
+ * Índice de coeficiente en Ax² + Bxy + Cy² + Dx + Ey + F.
+ */
+typedef enum {
+    COEF_A,
+    COEF_B,
+    COEF_C,
+    COEF_D,
+    COEF_E,
+    COEF_F
+} ConicCoef;
+
 typedef struct {
     double x;
     double y;
@@ -55,6 +74,37 @@ typedef struct {
 
 } ConicResult;
 
+/**
+ * Columnas de coeficientes (structure-of-arrays) para análisis por lotes.
+ */
+typedef struct {
+    const double *A, *B, *C, *D, *E, *F;
+} ConicCoeffColumns;
+
+/**
+ * Columnas de resultados; mismo significado que los campos de ConicResult.
+ * flags combina CONIC_FLAG_*.
+ */
+typedef struct {
+    int32_t*  type;
+    uint32_t* flags;
+    double *delta, *cx, *cy, *theta, *a, *b;
+} ConicResultColumns;
+
+/**
+ * Marco principal de una cónica: tipo, centro, ejes propios de la forma
+ * cuadrática y valor en el centro. En el marco (u, v) girado theta y
+ * centrado, la curva es l1·u² + l2·v² + f0 = 0.
+ */
+typedef struct {
+    ConicType type;
+    bool   has_center;
+    double cx, cy;
+    double cos_t, sin_t;        // theta = 0.5 * atan2(B, A - C)
+    double l1, l2;              // autovalores asociados a u y v
+    double f0;                  // F' = Q(cx, cy); 0 si no hay centro
+} ConicFrame;
+
 /**
  * Analiza una cónica general:
  * Ax² + Bxy + Cy² + Dx + Ey + F = 0
@@ -64,4 +114,33 @@ ConicResult analyze_conic(
     double D, double E, double F
 );
 
+/**
+ * Re-analiza en sitio un resultado previo tras sumar delta a un único
+ * coeficiente, recalculando solo lo que depende de él. Devuelve true si
+ * el muestreo anterior se reutilizó (deformado) en vez de rehacerse.
+ */
+bool analyze_conic_update(ConicResult* r, ConicCoef coef, double delta);
+
+/**
+ * Analiza las filas [begin, end) de un lote de cónicas sin muestrear
+ * puntos. Equivale a analyze_conic fila a fila.
+ */
+void analyze_conic_columns(
+    const ConicCoeffColumns* in,
+    ConicResultColumns* out,
+    size_t begin, size_t end
+);
+
+/**
+ * Calcula el marco principal de la cónica de coeficientes c = [A..F].
+ */
+void conic_frame(const double c[6], ConicFrame* f);
+
+/**
+ * Caja alineada a los ejes del trozo de curva que cae dentro de window
+ * ([x_min, y_min, x_max, y_max]). Vale para todos los tipos, incluidas
+ * las cónicas no acotadas. Devuelve false si la curva no toca la ventana.
+ */
+bool conic_bounds(const double c[6], const double window[4], double box[4]);
+
 #endif
\ No newline at end of file
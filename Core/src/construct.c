@@ -0,0 +1,343 @@
+//================================================================//
+// CONSTRUCT - Cónicas por cinco condiciones, vectorizado por lotes
+//================================================================//
+//
+// Cada bloque copia CONSTRUCT_LANES sistemas 5x6 a un arreglo
+// M[fila][columna][carril] y los elimina a la vez. El pivote parcial de
+// cada carril se aplica con intercambios condicionales (selecciones),
+// así el bucle interior no tiene saltos. Los carriles cuyo pivote
+// mínimo queda por debajo de CONSTRUCT_RESCUE respecto al máximo se
+// repiten con pivoteo total, que también resuelve los casos en que la
+// columna libre F no es la adecuada.
+//
+//--------------------------------//
+// Includes y dependencias
+//--------------------------------//
+#include "construct.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "budget.h"
+#include "fit.h"
+#include "linalg.h"
+#include "threadpool.h"
+
+/**
+ * @file construct.c
+ * @brief Construcción de cónicas por lotes descrita en construct.h.
+ */
+
+#define CONSTRUCT_RESCUE     1e-6
+#define CONSTRUCT_DEGENERATE_TOL 1e-12
+#define CONSTRUCT_GRAIN      16
+
+#define L CONSTRUCT_LANES
+
+//-------------------------------------------//
+//           FUNCIONES AUXILIARES            //
+//-------------------------------------------//
+
+/**
+ * Normalización de un problema: u = s(x - x0), v = s(y - y0). Los
+ * problemas duales (solo rectas) se resuelven sin normalizar.
+ */
+typedef struct {
+    double s, x0, y0;
+    bool dual;
+} Norm;
+
+/**
+ * @brief Escala la fila a max |·| = 1 para que los pivotes sean
+ *        comparables entre restricciones de distinto tipo.
+ */
+static void scale_row(double r[6]) {
+    double m = 0.0;
+    for (int j = 0; j < 6; j++) m = fmax(m, fabs(r[j]));
+    if (m > 0) for (int j = 0; j < 6; j++) r[j] /= m;
+}
+
+static void point_row(double u, double v, double r[6]) {
+    r[0] = u*u; r[1] = u*v; r[2] = v*v; r[3] = u; r[4] = v; r[5] = 1.0;
+    scale_row(r);
+}
+
+/**
+ * @brief Normalización a partir de n puntos (xs, ys).
+ */
+static void normalize_points(const double* xs, const double* ys, int n, Norm* nm) {
+    double mx = 0.0, my = 0.0;
+    for (int i = 0; i < n; i++) {
+        mx += xs[i];
+        my += ys[i];
+    }
+    mx /= n;
+    my /= n;
+    double var = 0.0;
+    for (int i = 0; i < n; i++) var += (xs[i] - mx)*(xs[i] - mx) + (ys[i] - my)*(ys[i] - my);
+    var /= n;
+
+    nm->s = var > 0 ? sqrt(2.0 / var) : 1.0;
+    nm->x0 = mx;
+    nm->y0 = my;
+    nm->dual = false;
+}
+
+/**
+ * @brief Filas del problema i a partir de restricciones genéricas.
+ * @return false si las restricciones no suman 5 filas o mezclan rectas
+ *         con puntos.
+ */
+static bool rows_from_constraints(const Constraint* cons, const uint32_t* offsets, size_t i,
+                                  double M[5][6], Norm* nm) {
+    uint32_t lo = offsets[i], hi = offsets[i + 1];
+    int rows = 0, lines = 0, np = 0;
+    double xs[5], ys[5];
+    for (uint32_t k = lo; k < hi; k++) {
+        switch (cons[k].kind) {
+            case CONSTRAINT_POINT:   rows += 1; break;
+            case CONSTRAINT_TANGENT: rows += 2; break;
+            case CONSTRAINT_LINE:    rows += 1; lines++; break;
+            default:                 return false;
+        }
+        if (rows > 5) return false;
+        if (cons[k].kind != CONSTRAINT_LINE) {
+            xs[np] = cons[k].v[0];
+            ys[np] = cons[k].v[1];
+            np++;
+        }
+    }
+    if (rows != 5 || (lines && lines != 5)) return false;
+
+    if (lines) {
+        // Cónica dual: la recta (a, b, c) es un "punto" homogéneo
+        nm->s = 1.0;
+        nm->x0 = nm->y0 = 0.0;
+        nm->dual = true;
+        for (int r = 0; r < 5; r++) {
+            const double* l = cons[lo + r].v;
+            double n = sqrt(l[0]*l[0] + l[1]*l[1]);
+            if (n == 0) return false;
+            double a = l[0] / n, b = l[1] / n, c = l[2] / n;
+            double row[6] = { a*a, a*b, b*b, a*c, b*c, c*c };
+            scale_row(row);
+            memcpy(M[r], row, sizeof(row));
+        }
+        return true;
+    }
+
+    normalize_points(xs, ys, np, nm);
+    int r = 0;
+    for (uint32_t k = lo; k < hi; k++) {
+        const double* v = cons[k].v;
+        double u = nm->s * (v[0] - nm->x0), w = nm->s * (v[1] - nm->y0);
+        point_row(u, w, M[r++]);
+        if (cons[k].kind == CONSTRAINT_TANGENT) {
+            // ∇Q(p)·d = 0 (la dirección no cambia con la normalización)
+            double dx = v[2], dy = v[3];
+            double row[6] = { 2.0*u*dx, w*dx + u*dy, 2.0*w*dy, dx, dy, 0.0 };
+            scale_row(row);
+            memcpy(M[r++], row, sizeof(row));
+        }
+    }
+    return true;
+}
+
+static bool rows_from_points(const double* px, const double* py, size_t i, double M[5][6],
+                             Norm* nm) {
+    const double* xs = px + 5 * i;
+    const double* ys = py + 5 * i;
+    normalize_points(xs, ys, 5, nm);
+    for (int k = 0; k < 5; k++)
+        point_row(nm->s * (xs[k] - nm->x0), nm->s * (ys[k] - nm->y0), M[k]);
+    return true;
+}
+
+/**
+ * @brief Eliminación simultánea de L sistemas con pivoteo parcial por
+ *        selecciones y F fijada a 1.
+ * @param M Sistemas intercalados (se destruyen).
+ * @param a Vectores nulos, a[columna][carril].
+ * @param cond Razón de pivotes por carril.
+ */
+static void solve_lanes(double M[5][6][L], double a[6][L], double cond[L]) {
+    double pmin[L], pmax[L], best[L], pr[L];
+    for (int l = 0; l < L; l++) {
+        pmin[l] = INFINITY;
+        pmax[l] = 0.0;
+    }
+
+    for (int k = 0; k < 5; k++) {
+        for (int l = 0; l < L; l++) {
+            best[l] = fabs(M[k][k][l]);
+            pr[l] = k;
+        }
+        for (int r = k + 1; r < 5; r++) {
+            for (int l = 0; l < L; l++) {
+                double v = fabs(M[r][k][l]);
+                pr[l] = v > best[l] ? r : pr[l];
+                best[l] = v > best[l] ? v : best[l];
+            }
+        }
+
+        // Intercambio condicional de la fila k con la fila pivote
+        for (int r = k + 1; r < 5; r++) {
+            for (int j = k; j < 6; j++) {
+                for (int l = 0; l < L; l++) {
+                    bool sel = pr[l] == r;
+                    double top = M[k][j][l], other = M[r][j][l];
+                    M[k][j][l] = sel ? other : top;
+                    M[r][j][l] = sel ? top : other;
+                }
+            }
+        }
+
+        double inv[L];
+        for (int l = 0; l < L; l++) {
+            double p = M[k][k][l];
+            pmin[l] = fmin(pmin[l], best[l]);
+            pmax[l] = fmax(pmax[l], best[l]);
+            inv[l] = p != 0.0 ? 1.0 / p : 0.0;
+        }
+        for (int r = k + 1; r < 5; r++) {
+            double f[L];
+            for (int l = 0; l < L; l++) f[l] = M[r][k][l] * inv[l];
+            for (int j = k; j < 6; j++)
+                for (int l = 0; l < L; l++) M[r][j][l] -= f[l] * M[k][j][l];
+        }
+    }
+
+    for (int l = 0; l < L; l++) a[5][l] = 1.0;
+    for (int k = 4; k >= 0; k--) {
+        for (int l = 0; l < L; l++) {
+            double sum = 0.0;
+            for (int j = k + 1; j < 6; j++) sum += M[k][j][l] * a[j][l];
+            double p = M[k][k][l];
+            a[k][l] = p != 0.0 ? -sum / p : 0.0;
+        }
+    }
+    for (int l = 0; l < L; l++) cond[l] = pmax[l] > 0 ? pmin[l] / pmax[l] : 0.0;
+}
+
+/**
+ * @brief Coeficientes finales desde el vector nulo normalizado.
+ */
+static void finish(const double a[6], const Norm* nm, double c[6]) {
+    if (!nm->dual) {
+        fit_denormalize(a, nm->s, nm->x0, nm->y0, c);
+        return;
+    }
+
+    // Cónica primal = adjunta de la matriz dual
+    double D[9] = {
+        a[0],       0.5 * a[1], 0.5 * a[3],
+        0.5 * a[1], a[2],       0.5 * a[4],
+        0.5 * a[3], 0.5 * a[4], a[5]
+    };
+    double adj[9] = {
+        D[4]*D[8] - D[5]*D[7], D[2]*D[7] - D[1]*D[8], D[1]*D[5] - D[2]*D[4],
+        D[5]*D[6] - D[3]*D[8], D[0]*D[8] - D[2]*D[6], D[2]*D[3] - D[0]*D[5],
+        D[3]*D[7] - D[4]*D[6], D[1]*D[6] - D[0]*D[7], D[0]*D[4] - D[1]*D[3]
+    };
+    double p[6] = { adj[0], 2.0 * adj[1], adj[4], 2.0 * adj[2], 2.0 * adj[5], adj[8] };
+    fit_denormalize(p, 1.0, 0.0, 0.0, c);
+}
+
+typedef struct {
+    const Constraint* cons;
+    const uint32_t* offsets;
+    const double* xs;           // camino de cinco puntos si no es NULL
+    const double* ys;
+    size_t m;
+    double* coeffs;
+    double* cond;
+    uint8_t* status;
+} ConstructJob;
+
+static bool build_rows(const ConstructJob* job, size_t i, double M[5][6], Norm* nm) {
+    if (job->xs) return rows_from_points(job->xs, job->ys, i, M, nm);
+    return rows_from_constraints(job->cons, job->offsets, i, M, nm);
+}
+
+static void block_range(size_t begin, size_t end, void* ctx) {
+    ConstructJob* job = ctx;
+
+    for (size_t blk = begin; blk < end; blk++) {
+        size_t base = blk * L;
+        if (budget_exhausted()) {
+            for (size_t i = base; i < base + L && i < job->m; i++) {
+                memset(job->coeffs + 6 * i, 0, 6 * sizeof(double));
+                if (job->cond) job->cond[i] = 0.0;
+                if (job->status) job->status[i] = CONSTRUCT_SKIPPED;
+            }
+            continue;
+        }
+
+        double M[5][6][L], a[6][L], cond[L];
+        Norm nm[L];
+        bool valid[L];
+
+        for (int l = 0; l < L; l++) {
+            double rows[5][6];
+            size_t i = base + l;
+            valid[l] = i < job->m && build_rows(job, i, rows, &nm[l]);
+            // Los carriles vacíos o inválidos llevan la identidad para no
+            // contaminar el bloque con NaN
+            for (int r = 0; r < 5; r++)
+                for (int j = 0; j < 6; j++)
+                    M[r][j][l] = valid[l] ? rows[r][j] : (r == j ? 1.0 : 0.0);
+        }
+
+        solve_lanes(M, a, cond);
+
+        for (int l = 0; l < L; l++) {
+            size_t i = base + l;
+            if (i >= job->m) break;
+
+            double c[6] = { 0 }, k = 0.0, v[6];
+            for (int j = 0; j < 6; j++) v[j] = a[j][l];
+            ConstructStatus st = CONSTRUCT_INVALID;
+            if (valid[l]) {
+                k = cond[l];
+                if (k < CONSTRUCT_RESCUE) {
+                    double rows[5][6];
+                    build_rows(job, i, rows, &nm[l]);
+                    k = linalg_null5x6(rows, v);
+                }
+                st = k < CONSTRUCT_DEGENERATE_TOL ? CONSTRUCT_DEGENERATE : CONSTRUCT_OK;
+                if (st == CONSTRUCT_OK) finish(v, &nm[l], c);
+            }
+
+            memcpy(job->coeffs + 6 * i, c, sizeof(c));
+            if (job->cond) job->cond[i] = k;
+            if (job->status) job->status[i] = (uint8_t)st;
+        }
+    }
+}
+
+//-------------------------------------------//
+//                API PÚBLICA                //
+//-------------------------------------------//
+
+void construct_batch(const Constraint* cons, const uint32_t* offsets, size_t m,
+                     double* coeffs, double* cond, uint8_t* status) {
+    ConstructJob job = { cons, offsets, NULL, NULL, m, coeffs, cond, status };
+    tp_parallel_for(0, (m + L - 1) / L, CONSTRUCT_GRAIN, block_range, &job);
+}
+
+void construct_five_points_batch(const double* xs, const double* ys, size_t m,
+                                 double* coeffs, double* cond, uint8_t* status) {
+    ConstructJob job = { NULL, NULL, xs, ys, m, coeffs, cond, status };
+    tp_parallel_for(0, (m + L - 1) / L, CONSTRUCT_GRAIN, block_range, &job);
+}
+
+const char* construct_status_str(ConstructStatus s) {
+    switch (s) {
+        case CONSTRUCT_OK:         return "ok";
+        case CONSTRUCT_DEGENERATE: return "degenerate";
+        case CONSTRUCT_INVALID:    return "invalid";
+        case CONSTRUCT_SKIPPED:    return "skipped";
+    }
+    return "unknown";
+}
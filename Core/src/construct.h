@@ -0,0 +1,71 @@
+//================================================================//
+//      CONSTRUCT HEADER - Cónicas por restricciones, por lotes   //
+//================================================================//
+//
+// Cónica determinada por cinco condiciones lineales sobre A..F:
+//   punto (x, y)                    Q(x, y) = 0                  1 fila
+//   tangente en un punto conocido   Q(p) = 0 y ∇Q(p)·d = 0       2 filas
+//   recta tangente a·x + b·y + c    solo si las cinco son rectas: se
+//                                   resuelve la cónica dual y se
+//                                   invierte (adjunta)           1 fila
+// Cada problema se normaliza (centroide y escala √2) y se resuelve como
+// vector nulo de un sistema 5x6.
+//
+// El lote se resuelve en bloques de CONSTRUCT_LANES problemas con los
+// datos intercalados por problema (fila, columna, carril): la
+// eliminación con pivoteo parcial usa selecciones en lugar de saltos y
+// el bucle interior recorre carriles, así que GCC lo vectoriza. Los
+// problemas mal condicionados para ese camino se repiten con pivoteo
+// total (linalg_null5x6).
+//
+// Condicionamiento: razón |pivote mínimo| / |pivote máximo| en
+// coordenadas normalizadas y filas escaladas; 1 es ideal y 0 indica una
+// configuración degenerada (4 puntos alineados, repetidos...).
+//
+
+#ifndef CONSTRUCT_H
+#define CONSTRUCT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CONSTRUCT_LANES 8
+
+typedef enum {
+    CONSTRAINT_POINT,           // v = (x, y)
+    CONSTRAINT_TANGENT,         // v = (x, y, dx, dy): pasa por (x, y) con dirección d
+    CONSTRAINT_LINE             // v = (a, b, c): recta a·x + b·y + c = 0 tangente
+} ConstraintKind;
+
+typedef struct {
+    ConstraintKind kind;
+    double v[4];
+} Constraint;
+
+typedef enum {
+    CONSTRUCT_OK,
+    CONSTRUCT_DEGENERATE,       // rango < 5: infinitas cónicas
+    CONSTRUCT_INVALID,          // no suman 5 filas o mezclan rectas con puntos
+    CONSTRUCT_SKIPPED           // sin resolver: venció el presupuesto (budget.h)
+} ConstructStatus;
+
+/**
+ * Resuelve m problemas. Las restricciones del problema i son
+ * cons[offsets[i] .. offsets[i + 1]). coeffs recibe 6·m valores (A..F,
+ * ‖(A, B, C)‖ = 1), cond y status uno por problema (pueden ser NULL).
+ * El presupuesto del hilo se consulta por bloque; los problemas que
+ * quedan sin resolver salen con coeficientes y cond a 0.
+ */
+void construct_batch(const Constraint* cons, const uint32_t* offsets, size_t m,
+                     double* coeffs, double* cond, uint8_t* status);
+
+/**
+ * Caso rápido: cónica por cinco puntos en columnas; el punto k del
+ * problema i es (xs[5i + k], ys[5i + k]).
+ */
+void construct_five_points_batch(const double* xs, const double* ys, size_t m,
+                                 double* coeffs, double* cond, uint8_t* status);
+
+const char* construct_status_str(ConstructStatus s);
+
+#endif
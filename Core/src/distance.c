@@ -0,0 +1,385 @@
+//================================================================//
+// DISTANCE - Distancia exacta punto-cónica por cuártica en λ
+//================================================================//
+//
+// Pasos:
+//   1. Trasladar la cónica para que el punto consulta quede en el origen
+//      y girarla a sus ejes propios: l1·u² + l2·v² + 2bu·u + 2bv·v + f = 0.
+//   2. Los candidatos a pie son q(λ) = (λ·bu / (1 - λ·l1), λ·bv / (1 - λ·l2))
+//      con λ raíz de la cuártica (1 - λl1)²(1 - λl2)²·Q(q(λ)) = 0.
+//   3. Los λ = 1/li anulan un denominador (p sobre un eje de simetría):
+//      sus candidatos se obtienen aparte resolviendo la cónica en el eje.
+//   4. Se queda el candidato más cercano y se pule con Newton 2D.
+//   En el círculo (l1 = l2) la cuártica tiene un factor doble espurio y
+//   se resuelve la cuadrática reducida.
+//
+//--------------------------------//
+// Includes y dependencias
+//--------------------------------//
+#include "distance.h"
+
+#include <math.h>
+#include <stdatomic.h>
+#include <string.h>
+
+#include "budget.h"
+#include "poly.h"
+#include "threadpool.h"
+
+/**
+ * @file distance.c
+ * @brief Distancia punto-cónica descrita en distance.h.
+ */
+
+//-------------------------------------------//
+//            FUNCIONES AUXILIARES           //
+//-------------------------------------------//
+
+typedef struct {
+    double l1, l2, bu, bv, f;   // cónica en el marco del punto consulta
+    double best;
+    double u, v;
+} FootSearch;
+
+/**
+ * @brief Acepta (u, v) si está sobre la curva y mejora la distancia.
+ * @details λ casi singulares dan candidatos fuera de la curva: se
+ *          descartan por residuo relativo.
+ */
+static void consider(FootSearch* s, double u, double v) {
+    double terms = fabs(s->l1*u*u) + fabs(s->l2*v*v) + fabs(2*s->bu*u) + fabs(2*s->bv*v) + fabs(s->f);
+    double q = s->l1*u*u + s->l2*v*v + 2*s->bu*u + 2*s->bv*v + s->f;
+    if (fabs(q) > 1e-6 * terms) return;
+
+    double d = u*u + v*v;
+    if (isfinite(d) && d < s->best) {
+        s->best = d;
+        s->u = u;
+        s->v = v;
+    }
+}
+
+/**
+ * @brief Candidatos con λ = 1/li: la coordenada i queda libre y la otra
+ *        fija, así que la cónica se resuelve como cuadrática en el eje i.
+ */
+static void axis_candidates(FootSearch* s) {
+    double l1 = s->l1, l2 = s->l2, bu = s->bu, bv = s->bv, f = s->f;
+    double r[2];
+    for (int axis = 0; axis < 2; axis++) {
+        double li = axis == 0 ? l1 : l2, lj = axis == 0 ? l2 : l1;
+        double bi = axis == 0 ? bu : bv, bj = axis == 0 ? bv : bu;
+        if (fabs(li) <= 1e-12) continue;
+
+        double lambda = 1.0 / li;
+        double den = 1.0 - lambda * lj;
+        // Ambos denominadores nulos (círculo): la otra coordenada es la del centro
+        double qj = fabs(den) > 1e-12 ? lambda * bj / den : -bj / lj;
+
+        int n = poly_solve_quadratic(li, 2.0 * bi, lj*qj*qj + 2.0*bj*qj + f, r);
+        for (int k = 0; k < n; k++) {
+            if (axis == 0) consider(s, r[k], qj);
+            else           consider(s, qj, r[k]);
+        }
+    }
+}
+
+//-------------------------------------------//
+//                 API PÚBLICA               //
+//-------------------------------------------//
+
+/**
+ * @brief Prepara una cónica para consultas repetidas.
+ * @param c Coeficientes [A, B, C, D, E, F].
+ * @param d Cónica preparada: coeficientes normalizados, ejes propios y
+ *          orientación del interior.
+ * @details Interior: el de la elipse, la región focal de la hipérbola
+ *          (signo de Q opuesto al del centro) y el lado cóncavo de la
+ *          parábola. Lejos de la curva Q toma el signo de los autovalores,
+ *          lo que fija la orientación en elipses y parábolas.
+ */
+void distance_prepare(const double c[6], DistanceConic* d) {
+    memset(d, 0, sizeof(*d));
+    memcpy(d->c, c, sizeof(d->c));
+
+    double scale = 0.0;
+    for (int i = 0; i < 6; i++) scale = fmax(scale, fabs(c[i]));
+    d->empty = scale == 0.0;
+    d->orient = 1.0;
+    if (d->empty) return;
+
+    for (int i = 0; i < 6; i++) d->k[i] = c[i] / scale;
+    double A = d->k[0], B = d->k[1], C = d->k[2], D = d->k[3], E = d->k[4], F = d->k[5];
+
+    // Giro a los ejes propios (mismo convenio que conic_frame)
+    double t = 0.5 * atan2(B, A - C);
+    d->cos_t = cos(t);
+    d->sin_t = sin(t);
+    double cs = d->cos_t, sn = d->sin_t;
+    d->l1 = A*cs*cs + B*cs*sn + C*sn*sn;
+    d->l2 = A*sn*sn - B*cs*sn + C*cs*cs;
+
+    double det = 4*A*C - B*B;
+    if (det < -1e-12) {
+        double cx = (B*E - 2*C*D) / det, cy = (B*D - 2*A*E) / det;
+        double f0 = F + 0.5 * (D*cx + E*cy);
+        d->orient = f0 > 0 ? 1.0 : -1.0;
+    } else if (d->l1 + d->l2 < 0) {
+        d->orient = -1.0;
+    }
+}
+
+/**
+ * @brief Distancia exacta de (x, y) a una cónica preparada.
+ * @param d Cónica preparada con distance_prepare.
+ * @param x Abscisa del punto consulta.
+ * @param y Ordenada del punto consulta.
+ * @param foot Pie de la perpendicular (opcional).
+ * @return Distancia, o INFINITY si la cónica no tiene puntos reales.
+ */
+double distance_point(const DistanceConic* d, double x, double y, Point2D* foot) {
+    if (d->empty) return INFINITY;
+
+    double A = d->k[0], B = d->k[1], C = d->k[2], D = d->k[3], E = d->k[4], F = d->k[5];
+    double cs = d->cos_t, sn = d->sin_t, l1 = d->l1, l2 = d->l2;
+
+    // Traslación: el punto consulta pasa a ser el origen
+    double Dt = D + 2*A*x + B*y;
+    double Et = E + B*x + 2*C*y;
+    double f = A*x*x + B*x*y + C*y*y + D*x + E*y + F;
+    double bu = 0.5 * (Dt*cs + Et*sn);
+    double bv = 0.5 * (-Dt*sn + Et*cs);
+
+    FootSearch s = { l1, l2, bu, bv, f, INFINITY, 0.0, 0.0 };
+    double re[4], im[4];
+    int n;
+
+    if (fabs(l1 - l2) <= 1e-12) {
+        // Círculo: la cuártica tendría el factor espurio (1 - λl)²
+        double b2 = bu*bu + bv*bv;
+        double quad[3] = { l1*b2 - 2.0*b2*l1 + f*l1*l1, 2.0*b2 - 2.0*f*l1, f };
+        double r[2];
+        n = poly_solve_quadratic(quad[0], quad[1], quad[2], r);
+        for (int k = 0; k < n; k++) { re[k] = r[k]; im[k] = 0.0; }
+    } else {
+        // Cuártica en λ: suma de productos de e1 = 1 - λl1 y e2 = 1 - λl2
+        double e1[2] = { -l1, 1.0 }, e2[2] = { -l2, 1.0 };
+        double e11[3], e22[3], e122[4], e211[4], e1122[5];
+        poly_mul(e1, 1, e1, 1, e11);
+        poly_mul(e2, 1, e2, 1, e22);
+        poly_mul(e1, 1, e22, 2, e122);
+        poly_mul(e2, 1, e11, 2, e211);
+        poly_mul(e11, 2, e22, 2, e1122);
+
+        double quartic[5];
+        for (int i = 0; i < 5; i++) quartic[i] = f * e1122[i];
+        for (int i = 0; i < 3; i++) {
+            // λ²·(l1·bu²·e2² + l2·bv²·e1²)
+            quartic[i] += l1*bu*bu * e22[i] + l2*bv*bv * e11[i];
+        }
+        for (int i = 0; i < 4; i++) {
+            // λ·(2bu²·e1·e2² + 2bv²·e2·e1²)
+            quartic[i] += 2.0*bu*bu * e122[i] + 2.0*bv*bv * e211[i];
+        }
+        n = poly_solve_quartic(quartic, re, im);
+    }
+
+    for (int k = 0; k < n; k++) {
+        if (fabs(im[k]) > 1e-6 * (1.0 + fabs(re[k]))) continue;
+        double lambda = re[k];
+        double d1 = 1.0 - lambda * l1, d2 = 1.0 - lambda * l2;
+        if (fabs(d1) < 1e-12 || fabs(d2) < 1e-12) continue;
+        consider(&s, lambda * bu / d1, lambda * bv / d2);
+    }
+    axis_candidates(&s);
+
+    if (!isfinite(s.best)) return INFINITY;
+
+    // Pulido: Newton sobre {Q = 0, q × ∇Q = 0} (pie ortogonal)
+    double u = s.u, v = s.v;
+    for (int it = 0; it < 3; it++) {
+        double g1 = l1*u*u + l2*v*v + 2*bu*u + 2*bv*v + f;
+        double g2 = (l2 - l1)*u*v + bv*u - bu*v;
+        double j11 = 2*(l1*u + bu),     j12 = 2*(l2*v + bv);
+        double j21 = (l2 - l1)*v + bv,  j22 = (l2 - l1)*u - bu;
+        double det = j11*j22 - j12*j21;
+        if (fabs(det) < 1e-14 || !isfinite(det)) break;
+
+        double nu = u - ( j22*g1 - j12*g2) / det;
+        double nv = v - (-j21*g1 + j11*g2) / det;
+        // Solo se acepta si no aleja el pie del candidato (evita saltar de rama)
+        if (!isfinite(nu) || !isfinite(nv) || hypot(nu - s.u, nv - s.v) > 0.1 * (1.0 + sqrt(s.best))) break;
+        u = nu;
+        v = nv;
+    }
+
+    if (foot) {
+        foot->x = x + cs*u - sn*v;
+        foot->y = y + sn*u + cs*v;
+    }
+    return sqrt(u*u + v*v);
+}
+
+/**
+ * @brief Distancia exacta de (x, y) a la cónica c (consulta aislada).
+ */
+double conic_distance(const double c[6], double x, double y, Point2D* foot) {
+    DistanceConic d;
+    distance_prepare(c, &d);
+    return distance_point(&d, x, y, foot);
+}
+
+//-------------------------------------------//
+//            KERNELS POR LOTES              //
+//-------------------------------------------//
+//
+// Bucles planos sobre columnas x / y contiguas, sin ramas y con copias
+// locales de los coeficientes para que GCC los vectorice (-O3). Cada
+// kernel reparte el lote en rangos entre los hilos del pool.
+//
+
+// Puntos por rango de trabajo
+#define DIST_GRAIN 4096
+
+typedef struct {
+    const DistanceConic* d;
+    const double* xs;
+    const double* ys;
+    double        tol;
+    double*       out;
+    int8_t*       sign;
+    Point2D*      feet;
+    atomic_size_t approx;       // exact: puntos resueltos con Sampson
+} DistanceJob;
+
+static void eval_range(size_t begin, size_t end, void* ctx) {
+    const DistanceJob* job = ctx;
+    const double A = job->d->c[0], B = job->d->c[1], C = job->d->c[2];
+    const double D = job->d->c[3], E = job->d->c[4], F = job->d->c[5];
+    const double* restrict xs = job->xs;
+    const double* restrict ys = job->ys;
+    double* restrict out = job->out;
+
+    for (size_t i = begin; i < end; i++) {
+        double x = xs[i], y = ys[i];
+        out[i] = A*x*x + B*x*y + C*y*y + D*x + E*y + F;
+    }
+}
+
+static void sampson_range(size_t begin, size_t end, void* ctx) {
+    const DistanceJob* job = ctx;
+    const double A = job->d->k[0], B = job->d->k[1], C = job->d->k[2];
+    const double D = job->d->k[3], E = job->d->k[4], F = job->d->k[5];
+    const double* restrict xs = job->xs;
+    const double* restrict ys = job->ys;
+    double* restrict out = job->out;
+
+    for (size_t i = begin; i < end; i++) {
+        double x = xs[i], y = ys[i];
+        double q = A*x*x + B*x*y + C*y*y + D*x + E*y + F;
+        double gx = 2*A*x + B*y + D;
+        double gy = B*x + 2*C*y + E;
+        // Distancia de primer orden |Q| / |∇Q| (inf en puntos singulares)
+        out[i] = fabs(q) / sqrt(gx*gx + gy*gy);
+    }
+}
+
+/**
+ * @brief Signo orientado por bloques: el cálculo se escribe como double
+ *        (selecciones sin ramas) y se empaqueta a int8 en un segundo
+ *        bucle; mezclar tipos enteros en el primero impide vectorizar.
+ */
+static void sign_range(size_t begin, size_t end, void* ctx) {
+    const DistanceJob* job = ctx;
+    const double s = job->d->orient;
+    const double A = s*job->d->k[0], B = s*job->d->k[1], C = s*job->d->k[2];
+    const double D = s*job->d->k[3], E = s*job->d->k[4], F = s*job->d->k[5];
+    const double tol = job->tol;
+    const double* restrict xs = job->xs;
+    const double* restrict ys = job->ys;
+    double block[256];
+
+    for (size_t base = begin; base < end; base += 256) {
+        size_t len = end - base < 256 ? end - base : 256;
+        for (size_t i = 0; i < len; i++) {
+            double x = xs[base + i], y = ys[base + i];
+            double q = A*x*x + B*x*y + C*y*y + D*x + E*y + F;
+            double gx = 2*A*x + B*y + D;
+            double gy = B*x + 2*C*y + E;
+            // |Q| <= tol·|∇Q| equivale a distancia de Sampson <= tol
+            double band2 = tol*tol * (gx*gx + gy*gy);
+            block[i] = q*q > band2 ? (q > 0 ? 1.0 : -1.0) : 0.0;
+        }
+        int8_t* restrict sign = job->sign + base;
+        for (size_t i = 0; i < len; i++) sign[i] = (int8_t)block[i];
+    }
+}
+
+/**
+ * @brief Distancia exacta por rangos; sin tiempo (budget.h), el rango
+ *        entero se resuelve con Sampson y pies de primer orden.
+ */
+static void exact_range(size_t begin, size_t end, void* ctx) {
+    DistanceJob* job = ctx;
+    if (budget_exhausted()) {
+        sampson_range(begin, end, ctx);
+        atomic_fetch_add(&job->approx, end - begin);
+        if (!job->feet) return;
+
+        const double* k = job->d->k;
+        for (size_t i = begin; i < end; i++) {
+            double x = job->xs[i], y = job->ys[i];
+            double q = k[0]*x*x + k[1]*x*y + k[2]*y*y + k[3]*x + k[4]*y + k[5];
+            double gx = 2*k[0]*x + k[1]*y + k[3];
+            double gy = k[1]*x + 2*k[2]*y + k[4];
+            double s = q / (gx*gx + gy*gy);
+            job->feet[i] = (Point2D){ x - s*gx, y - s*gy };
+        }
+        return;
+    }
+    for (size_t i = begin; i < end; i++) {
+        job->out[i] = distance_point(job->d, job->xs[i], job->ys[i],
+                                     job->feet ? &job->feet[i] : NULL);
+    }
+}
+
+/**
+ * @brief Q(x, y) con los coeficientes originales para n puntos.
+ */
+void distance_eval_batch(const DistanceConic* d, const double* xs, const double* ys,
+                         size_t n, double* out) {
+    DistanceJob job = { .d = d, .xs = xs, .ys = ys, .out = out };
+    tp_parallel_for(0, n, DIST_GRAIN, eval_range, &job);
+}
+
+/**
+ * @brief Clasificación interior (-1) / sobre la curva (0) / exterior (+1).
+ * @param tol Semiancho de la banda "sobre la curva" en distancia de Sampson.
+ */
+void distance_sign_batch(const DistanceConic* d, const double* xs, const double* ys,
+                         size_t n, double tol, int8_t* out) {
+    DistanceJob job = { .d = d, .xs = xs, .ys = ys, .tol = tol, .sign = out };
+    tp_parallel_for(0, n, DIST_GRAIN, sign_range, &job);
+}
+
+/**
+ * @brief Distancia de Sampson |Q| / |∇Q| (aproximación de primer orden).
+ */
+void distance_sampson_batch(const DistanceConic* d, const double* xs, const double* ys,
+                            size_t n, double* out) {
+    DistanceJob job = { .d = d, .xs = xs, .ys = ys, .out = out };
+    tp_parallel_for(0, n, DIST_GRAIN, sampson_range, &job);
+}
+
+/**
+ * @brief Distancia ortogonal exacta (y pies opcionales) para n puntos.
+ * @return Puntos que, vencido el presupuesto, llevan la aproximación de
+ *         Sampson en lugar de la distancia exacta.
+ */
+size_t distance_exact_batch(const DistanceConic* d, const double* xs, const double* ys,
+                            size_t n, double* out, Point2D* feet) {
+    DistanceJob job = { .d = d, .xs = xs, .ys = ys, .out = out, .feet = feet };
+    atomic_init(&job.approx, 0);
+    tp_parallel_for(0, n, 256, exact_range, &job);
+    return atomic_load(&job.approx);
+}
@@ -0,0 +1,80 @@
+//================================================================//
+//         DISTANCE HEADER - Distancia punto-cónica exacta        //
+//================================================================//
+//
+// Distancia euclídea de un punto a la curva Q(x, y) = 0 y pie de la
+// perpendicular. El pie q cumple q - p = λ·∇Q(q)/2; en el marco propio
+// de la forma cuadrática eso da q(λ) en forma cerrada y Q(q(λ)) = 0 se
+// convierte en una cuártica en λ. Vale para cualquier tipo de cónica.
+//
+// Para nubes de puntos hay kernels por lotes: forma implícita, signo
+// interior/exterior, distancia de Sampson y distancia exacta.
+//
+
+#ifndef DISTANCE_H
+#define DISTANCE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "conics.h"
+
+/**
+ * Cónica preparada para muchas consultas: el giro a ejes propios y la
+ * normalización se calculan una sola vez.
+ */
+typedef struct {
+    double c[6];                // coeficientes originales
+    double k[6];                // normalizados (max |k| = 1)
+    double cos_t, sin_t;        // ejes propios
+    double l1, l2;              // autovalores (de k)
+    double orient;              // ±1: orient·Q < 0 en el interior
+    bool   empty;               // todos los coeficientes nulos
+} DistanceConic;
+
+void distance_prepare(const double c[6], DistanceConic* d);
+
+/**
+ * Distancia exacta a una cónica preparada (ver conic_distance).
+ */
+double distance_point(const DistanceConic* d, double x, double y, Point2D* foot);
+
+/**
+ * Distancia de (x, y) a la cónica c = [A..F]. Si foot no es NULL recibe
+ * el punto más cercano. Devuelve INFINITY si la curva no tiene puntos
+ * reales.
+ */
+double conic_distance(const double c[6], double x, double y, Point2D* foot);
+
+// Kernels por lotes sobre columnas xs / ys (paralelos y vectorizados)
+
+/**
+ * out[i] = Q(xs[i], ys[i]) con los coeficientes originales.
+ */
+void distance_eval_batch(const DistanceConic* d, const double* xs, const double* ys,
+                         size_t n, double* out);
+
+/**
+ * out[i] = -1 interior, +1 exterior, 0 si la distancia de Sampson <= tol.
+ */
+void distance_sign_batch(const DistanceConic* d, const double* xs, const double* ys,
+                         size_t n, double tol, int8_t* out);
+
+/**
+ * out[i] = |Q| / |∇Q|, distancia de primer orden (Sampson).
+ */
+void distance_sampson_batch(const DistanceConic* d, const double* xs, const double* ys,
+                            size_t n, double* out);
+
+/**
+ * out[i] = distancia ortogonal exacta; feet (opcional) recibe los pies.
+ * Si vence el presupuesto del hilo (budget.h), los rangos que faltan
+ * usan la distancia de Sampson y pies de primer orden; devuelve cuántos
+ * puntos quedaron así. Los demás kernels son una pasada vectorizada y
+ * no consultan el presupuesto.
+ */
+size_t distance_exact_batch(const DistanceConic* d, const double* xs, const double* ys,
+                            size_t n, double* out, Point2D* feet);
+
+#endif
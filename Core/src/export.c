@@ -0,0 +1,408 @@
+//================================================================//
+// EXPORT - Escritura incremental de SVG y PDF
+//================================================================//
+//
+// Todo pasa por un buffer fijo de EXPORT_BUFFER bytes que se vacía al
+// destino cuando se llena. Los números se formatean a mano (tres
+// decimales, sin ceros de cola): printf domina el coste en escenas
+// grandes y los trazados solo necesitan precisión de milésima de píxel.
+//
+// PDF se escribe en una sola pasada: la longitud del flujo de contenido
+// va en un objeto indirecto (5 0 R) que se emite al final, cuando ya se
+// conoce, y la tabla xref recoge las posiciones anotadas al escribir.
+//
+//--------------------------------//
+// Includes y dependencias
+//--------------------------------//
+#include "export.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "bezier.h"
+#include "param.h"
+
+/**
+ * @file export.c
+ * @brief Trazados SVG/PDF de cónicas recortadas, sin documento en memoria.
+ */
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Profundidad máxima al partir una Bézier racional (2^20 trozos)
+#define EXPORT_MAX_DEPTH 20
+
+//-------------------------------------------//
+//           FUNCIONES AUXILIARES            //
+//-------------------------------------------//
+
+/**
+ * @brief Entrega el contenido del buffer al destino.
+ */
+static void flush(ExportWriter* w) {
+    if (w->ok && w->len > 0) {
+        if (w->fp) {
+            if (fwrite(w->buf, 1, w->len, w->fp) != w->len) w->ok = false;
+        } else if (!buf_append(w->mem, w->buf, w->len)) {
+            w->ok = false;
+        }
+    }
+    w->written += w->len;
+    w->len = 0;
+}
+
+static void put(ExportWriter* w, const char* s, size_t n) {
+    while (n > 0) {
+        if (w->len == EXPORT_BUFFER) flush(w);
+        size_t k = EXPORT_BUFFER - w->len < n ? EXPORT_BUFFER - w->len : n;
+        memcpy(w->buf + w->len, s, k);
+        w->len += k;
+        s += k;
+        n -= k;
+    }
+}
+
+static void put_str(ExportWriter* w, const char* s) {
+    put(w, s, strlen(s));
+}
+
+/**
+ * @brief Número con tres decimales como mucho y sin ceros de cola.
+ */
+static void put_num(ExportWriter* w, double v) {
+    char tmp[40];
+    if (!(fabs(v) < 1e12)) {
+        int n = snprintf(tmp, sizeof(tmp), "%.6g", isfinite(v) ? v : 0.0);
+        put(w, tmp, (size_t)n);
+        return;
+    }
+
+    long long q = llround(v * 1000.0);
+    unsigned long long a = q < 0 ? (unsigned long long)(-q) : (unsigned long long)q;
+    unsigned long long ip = a / 1000;
+    unsigned frac = (unsigned)(a % 1000);
+
+    char* e = tmp + sizeof(tmp);
+    char* s = e;
+    if (frac) {
+        int digits = 3;
+        while (frac % 10 == 0) {
+            frac /= 10;
+            digits--;
+        }
+        for (int i = 0; i < digits; i++, frac /= 10) *--s = (char)('0' + frac % 10);
+        *--s = '.';
+    }
+    do {
+        *--s = (char)('0' + ip % 10);
+        ip /= 10;
+    } while (ip);
+    if (q < 0) *--s = '-';
+    put(w, s, (size_t)(e - s));
+}
+
+/**
+ * @brief "x y" seguido de sep (SVG separa con espacios, PDF igual).
+ */
+static void put_xy(ExportWriter* w, const double p[2], const char* sep) {
+    put_num(w, p[0]);
+    put(w, " ", 1);
+    put_num(w, p[1]);
+    put_str(w, sep);
+}
+
+static uint64_t position(const ExportWriter* w) {
+    return w->written + w->len;
+}
+
+/**
+ * @brief Punto del plano a coordenadas del lienzo.
+ */
+static void to_canvas(const ExportWriter* w, double x, double y, double out[2]) {
+    out[0] = (x - w->p.window[0]) / w->sx;
+    out[1] = w->fmt == EXPORT_SVG ? (w->p.window[3] - y) / w->sy
+                                  : (y - w->p.window[1]) / w->sy;
+}
+
+static void move_to(ExportWriter* w, const double p[2]) {
+    if (w->fmt == EXPORT_SVG) {
+        put(w, "M", 1);
+        put_xy(w, p, "");
+    } else {
+        put_xy(w, p, " m\n");
+    }
+}
+
+static void line_to(ExportWriter* w, const double p[2]) {
+    if (w->fmt == EXPORT_SVG) {
+        put(w, "L", 1);
+        put_xy(w, p, "");
+    } else {
+        put_xy(w, p, " l\n");
+    }
+    w->segments++;
+}
+
+/**
+ * @brief Cuadrática polinómica p0-p1-p2; en PDF como cúbica equivalente
+ *        (controles a 2/3 del camino hacia p1).
+ */
+static void quad_to(ExportWriter* w, const double p0[2], const double p1[2], const double p2[2]) {
+    if (w->fmt == EXPORT_SVG) {
+        put(w, "Q", 1);
+        put_xy(w, p1, " ");
+        put_xy(w, p2, "");
+    } else {
+        double c1[2] = { p0[0] + 2.0/3.0 * (p1[0] - p0[0]), p0[1] + 2.0/3.0 * (p1[1] - p0[1]) };
+        double c2[2] = { p2[0] + 2.0/3.0 * (p1[0] - p2[0]), p2[1] + 2.0/3.0 * (p1[1] - p2[1]) };
+        put_xy(w, c1, " ");
+        put_xy(w, c2, " ");
+        put_xy(w, p2, " c\n");
+    }
+    w->segments++;
+}
+
+/**
+ * @brief Bézier racional (p0, p1 con peso wt, p2) en cuadráticas
+ *        polinómicas con error ≤ tolerancia.
+ * @details Con peso 1 es exacta. Si no, compara el punto medio racional
+ *          (p0 + 2wt·p1 + p2) / (2 + 2wt) con el polinómico y, si se
+ *          aleja más de la tolerancia, parte en s = 1/2: controles
+ *          (p0 + wt·p1)/(1 + wt) y (wt·p1 + p2)/(1 + wt), peso
+ *          sqrt((1 + wt)/2), que tiende a 1 en cada nivel.
+ */
+static void rational_to(ExportWriter* w, const double p0[2], const double p1[2], double wt,
+                        const double p2[2], int depth) {
+    double a = 1.0 + wt;
+    double m[2] = {
+        (p0[0] + 2*wt*p1[0] + p2[0]) / (2*a),
+        (p0[1] + 2*wt*p1[1] + p2[1]) / (2*a)
+    };
+    double dx = m[0] - 0.25 * (p0[0] + 2*p1[0] + p2[0]);
+    double dy = m[1] - 0.25 * (p0[1] + 2*p1[1] + p2[1]);
+
+    if (fabs(wt - 1.0) < 1e-12 || depth >= EXPORT_MAX_DEPTH ||
+        hypot(dx, dy) <= w->p.tolerance) {
+        quad_to(w, p0, p1, p2);
+        return;
+    }
+
+    double l1[2] = { (p0[0] + wt*p1[0]) / a, (p0[1] + wt*p1[1]) / a };
+    double r1[2] = { (wt*p1[0] + p2[0]) / a, (wt*p1[1] + p2[1]) / a };
+    double nw = sqrt(0.5 * a);
+    rational_to(w, p0, l1, nw, m, depth + 1);
+    rational_to(w, m, r1, nw, p2, depth + 1);
+}
+
+/**
+ * @brief Tramo [t0, t1] de una elipse como arcos SVG exactos.
+ * @details En el lienzo la elipse es O' + cos t·U' + sin t·V' con U', V'
+ *          diámetros conjugados (la escala puede no ser uniforme). Los
+ *          semiejes y el giro salen de la SVD cerrada de M = [U' V'] y el
+ *          sentido de recorrido del signo de det M. Cada arco cubre menos
+ *          de 2π/3, así que large-arc es siempre 0 y no hay ambigüedad.
+ */
+static void svg_arcs(ExportWriter* w, const ConicBranch* b, double t0, double t1) {
+    double ys = -1.0;           // SVG: y hacia abajo
+    double a = b->ux / w->sx, c = ys * b->uy / w->sy;
+    double bb = b->vx / w->sx, d = ys * b->vy / w->sy;
+
+    double E = 0.5 * (a + d), F = 0.5 * (a - d);
+    double G = 0.5 * (c + bb), H = 0.5 * (c - bb);
+    double Q = hypot(E, H), R = hypot(F, G);
+    double rx = Q + R, ry = fabs(Q - R);
+    double rot = 0.5 * (atan2(G, F) + atan2(H, E)) * 180.0 / M_PI;
+    int sweep = a * d - bb * c > 0.0;
+
+    int pieces = (int)ceil((t1 - t0) / (2.0 * M_PI / 3.0) - 1e-9);
+    if (pieces < 1) pieces = 1;
+    for (int k = 1; k <= pieces; k++) {
+        double t = t0 + (t1 - t0) * k / pieces, p[2], q[2];
+        branch_eval(b, t, p, NULL);
+        to_canvas(w, p[0], p[1], q);
+        put(w, "A", 1);
+        put_num(w, rx);
+        put(w, " ", 1);
+        put_num(w, ry);
+        put(w, " ", 1);
+        put_num(w, rot);
+        put_str(w, sweep ? " 0 1 " : " 0 0 ");
+        put_xy(w, q, "");
+        w->segments++;
+    }
+}
+
+/**
+ * @brief Abre el trazado de una cónica con su color.
+ */
+static void open_path(ExportWriter* w, const uint8_t color[4]) {
+    char tmp[96];
+    int n;
+    if (w->fmt == EXPORT_SVG) {
+        n = color[3] < 255
+            ? snprintf(tmp, sizeof(tmp), "<path stroke=\"#%02x%02x%02x\" stroke-opacity=\"%.3g\" d=\"",
+                       color[0], color[1], color[2], color[3] / 255.0)
+            : snprintf(tmp, sizeof(tmp), "<path stroke=\"#%02x%02x%02x\" d=\"",
+                       color[0], color[1], color[2]);
+    } else {
+        n = snprintf(tmp, sizeof(tmp), "%.4g %.4g %.4g RG\n",
+                     color[0] / 255.0, color[1] / 255.0, color[2] / 255.0);
+    }
+    put(w, tmp, (size_t)n);
+}
+
+//-------------------------------------------//
+//               API PÚBLICA                 //
+//-------------------------------------------//
+
+ExportParams export_default_params(void) {
+    ExportParams p = {
+        .window = { -10.0, -10.0, 10.0, 10.0 },
+        .width = 800.0,
+        .height = 800.0,
+        .stroke_width = 2.0,
+        .tolerance = 0.05
+    };
+    return p;
+}
+
+/**
+ * @brief Escribe la cabecera del documento.
+ * @details SVG: raíz con viewBox y un grupo con el estilo común del
+ *          trazo. PDF: catálogo, árbol de páginas, la página y la
+ *          apertura del flujo de contenido (objetos 1 a 4).
+ */
+bool export_begin(ExportWriter* w, ExportFormat fmt, const ExportParams* p, FILE* fp, ByteBuf* mem) {
+    w->fmt = fmt;
+    w->p = *p;
+    w->sx = (p->window[2] - p->window[0]) / p->width;
+    w->sy = (p->window[3] - p->window[1]) / p->height;
+    w->fp = fp;
+    w->mem = mem;
+    w->written = 0;
+    w->stream_start = 0;
+    memset(w->offsets, 0, sizeof(w->offsets));
+    w->conics = 0;
+    w->segments = 0;
+    w->ok = fp != NULL || mem != NULL;
+    w->len = 0;
+
+    char tmp[512];
+    int n;
+    if (fmt == EXPORT_SVG) {
+        n = snprintf(tmp, sizeof(tmp),
+                     "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                     "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%g\" height=\"%g\" "
+                     "viewBox=\"0 0 %g %g\">\n"
+                     "<g fill=\"none\" stroke-width=\"%g\" stroke-linecap=\"round\" "
+                     "stroke-linejoin=\"round\">\n",
+                     p->width, p->height, p->width, p->height, p->stroke_width);
+        put(w, tmp, (size_t)n);
+        return w->ok;
+    }
+
+    put_str(w, "%PDF-1.4\n%\xe2\xe3\xcf\xd3\n");
+    w->offsets[1] = position(w);
+    put_str(w, "1 0 obj\n<< /Type /Catalog /Pages 2 0 R >>\nendobj\n");
+    w->offsets[2] = position(w);
+    put_str(w, "2 0 obj\n<< /Type /Pages /Kids [3 0 R] /Count 1 >>\nendobj\n");
+    w->offsets[3] = position(w);
+    n = snprintf(tmp, sizeof(tmp),
+                 "3 0 obj\n<< /Type /Page /Parent 2 0 R /MediaBox [0 0 %g %g] "
+                 "/Contents 4 0 R /Resources << >> >>\nendobj\n",
+                 p->width, p->height);
+    put(w, tmp, (size_t)n);
+    w->offsets[4] = position(w);
+    put_str(w, "4 0 obj\n<< /Length 5 0 R >>\nstream\n");
+    w->stream_start = position(w);
+    n = snprintf(tmp, sizeof(tmp), "%g w 1 J 1 j\n", p->stroke_width);
+    put(w, tmp, (size_t)n);
+    return w->ok;
+}
+
+/**
+ * @brief Añade una cónica: un <path> en SVG, un trazado con "S" en PDF.
+ */
+bool export_conic(ExportWriter* w, const double c[6], const uint8_t color[4]) {
+    ConicBranch br[PARAM_MAX_BRANCHES];
+    ParamInterval iv[PARAM_MAX_INTERVALS];
+    int nb = conic_branches(c, br);
+    bool open = false;
+
+    for (int i = 0; i < nb; i++) {
+        const ConicBranch* b = &br[i];
+        int ni = branch_clip(b, w->p.window, iv);
+        for (int j = 0; j < ni; j++) {
+            if (!open) {
+                open_path(w, color);
+                open = true;
+            }
+
+            double p[2], q[2];
+            branch_eval(b, iv[j].t0, p, NULL);
+            to_canvas(w, p[0], p[1], q);
+            move_to(w, q);
+
+            if (w->fmt == EXPORT_SVG && b->kind == PARAM_ARC) {
+                svg_arcs(w, b, iv[j].t0, iv[j].t1);
+            } else {
+                RationalQuad rq[BEZIER_MAX_PER_INTERVAL];
+                int k = bezier_from_interval(b, iv[j].t0, iv[j].t1, rq);
+                for (int s = 0; s < k; s++) {
+                    double p0[2], p1[2], p2[2];
+                    to_canvas(w, rq[s].x0, rq[s].y0, p0);
+                    to_canvas(w, rq[s].x1, rq[s].y1, p1);
+                    to_canvas(w, rq[s].x2, rq[s].y2, p2);
+                    if (b->kind == PARAM_LINE) line_to(w, p2);
+                    else rational_to(w, p0, p1, rq[s].w, p2, 0);
+                }
+            }
+
+            if (iv[j].closed) put_str(w, w->fmt == EXPORT_SVG ? "Z" : "h\n");
+        }
+    }
+
+    if (open) {
+        put_str(w, w->fmt == EXPORT_SVG ? "\"/>\n" : "S\n");
+        w->conics++;
+    }
+    return w->ok;
+}
+
+/**
+ * @brief Cierra el documento. En PDF cierra el flujo, escribe su
+ *        longitud (objeto 5), la tabla xref y el trailer.
+ */
+bool export_end(ExportWriter* w) {
+    if (w->fmt == EXPORT_SVG) {
+        put_str(w, "</g>\n</svg>\n");
+        flush(w);
+        if (w->fp && fflush(w->fp) != 0) w->ok = false;
+        return w->ok;
+    }
+
+    uint64_t length = position(w) - w->stream_start;
+    put_str(w, "endstream\nendobj\n");
+
+    char tmp[128];
+    int n;
+    w->offsets[5] = position(w);
+    n = snprintf(tmp, sizeof(tmp), "5 0 obj\n%llu\nendobj\n", (unsigned long long)length);
+    put(w, tmp, (size_t)n);
+
+    uint64_t xref = position(w);
+    put_str(w, "xref\n0 6\n0000000000 65535 f \n");
+    for (int i = 1; i <= 5; i++) {
+        n = snprintf(tmp, sizeof(tmp), "%010llu 00000 n \n", (unsigned long long)w->offsets[i]);
+        put(w, tmp, (size_t)n);
+    }
+    n = snprintf(tmp, sizeof(tmp),
+                 "trailer\n<< /Size 6 /Root 1 0 R >>\nstartxref\n%llu\n%%%%EOF\n",
+                 (unsigned long long)xref);
+    put(w, tmp, (size_t)n);
+    flush(w);
+    if (w->fp && fflush(w->fp) != 0) w->ok = false;
+    return w->ok;
+}
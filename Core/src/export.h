@@ -0,0 +1,86 @@
+//================================================================//
+//        EXPORT HEADER - Exportación vectorial SVG y PDF         //
+//================================================================//
+//
+// Escribe cónicas como trazados vectoriales a medida que llegan, sobre
+// un FILE* (o un ByteBuf) con un buffer fijo: la memoria no crece con la
+// escena, así que una exportación de cientos de MB nunca construye un
+// documento entero.
+//
+// Cada cónica se recorta a la ventana (param.h) y cada tramo se escribe
+// con la primitiva más exacta del formato:
+//
+//   SVG  elipses y círculos con arcos elípticos "A" (exactos); parábolas
+//        y rectas con "Q" (exactas, peso 1); hipérbolas con "Q" tras
+//        partir la Bézier racional (bezier.h) hasta la tolerancia.
+//   PDF  todo con cúbicas "c": las cuadráticas polinómicas pasan a
+//        cúbica sin error y las racionales se parten hasta la tolerancia.
+//
+// Las coordenadas van en unidades del lienzo (px en SVG, pt en PDF) con
+// y hacia abajo en SVG y hacia arriba en PDF, como cada formato espera.
+//
+
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "utils.h"
+
+#define EXPORT_BUFFER (64 * 1024)
+
+typedef enum {
+    EXPORT_SVG,
+    EXPORT_PDF
+} ExportFormat;
+
+typedef struct {
+    double window[4];           // [x_min, y_min, x_max, y_max] del plano
+    double width, height;       // lienzo (px en SVG, pt en PDF)
+    double stroke_width;        // unidades del lienzo
+    double tolerance;           // error máximo de las aproximaciones (lienzo)
+} ExportParams;
+
+typedef struct {
+    ExportFormat fmt;
+    ExportParams p;
+    double       sx, sy;        // unidades del plano por unidad de lienzo
+    FILE*        fp;            // destino; NULL = mem
+    ByteBuf*     mem;
+    uint64_t     written;       // bytes entregados al destino
+    uint64_t     stream_start;  // PDF: inicio del flujo de contenido
+    uint64_t     offsets[6];    // PDF: posición de cada objeto
+    size_t       conics;        // cónicas escritas
+    size_t       segments;      // comandos de curva escritos
+    bool         ok;
+    size_t       len;
+    char         buf[EXPORT_BUFFER];
+} ExportWriter;
+
+/**
+ * Ventana [-10, 10]², lienzo de 800 x 800, trazo de 2 y tolerancia 0.05.
+ */
+ExportParams export_default_params(void);
+
+/**
+ * Abre el documento. Con fp escribe en el fichero; si no, añade a mem.
+ * w es grande (lleva el buffer dentro): mejor en el montón.
+ */
+bool export_begin(ExportWriter* w, ExportFormat fmt, const ExportParams* p, FILE* fp, ByteBuf* mem);
+
+/**
+ * Añade la cónica c = [A..F] con el color RGBA dado (el alfa de PDF se
+ * ignora). Las cónicas vacías o fuera de la ventana no escriben nada.
+ */
+bool export_conic(ExportWriter* w, const double c[6], const uint8_t color[4]);
+
+/**
+ * Cierra el documento y vacía el buffer. Devuelve false si alguna
+ * escritura falló.
+ */
+bool export_end(ExportWriter* w);
+
+#endif
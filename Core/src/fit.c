@@ -0,0 +1,313 @@
+//================================================================//
+// FIT - Ajuste algebraico de cónicas por momentos
+//================================================================//
+//
+// Todo el coste está en fit_accumulate: una lectura secuencial de xs/ys
+// con acumuladores por carril (el compilador los agrupa en registros
+// SIMD) y trozos de tamaño fijo que se reducen en orden, así el
+// resultado no depende del número de hilos. El resto trabaja con 15
+// momentos y matrices 6x6.
+//
+//--------------------------------//
+// Includes y dependencias
+//--------------------------------//
+#include "fit.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "linalg.h"
+#include "poly.h"
+#include "threadpool.h"
+
+/**
+ * @file fit.c
+ * @brief Ajuste de cónicas descrito en fit.h.
+ */
+
+#define FIT_CHUNK      65536
+#define FIT_MAX_CHUNKS 256
+#define FIT_LANES      4
+
+// Exponentes (i, j) del vector de diseño (u², uv, v², u, v, 1)
+static const int DESIGN[6][2] = { {2, 0}, {1, 1}, {0, 2}, {1, 0}, {0, 1}, {0, 0} };
+
+//-------------------------------------------//
+//           FUNCIONES AUXILIARES            //
+//-------------------------------------------//
+
+typedef struct {
+    const double* xs;
+    const double* ys;
+    size_t n, chunk;
+    double x0, y0;
+    double (*partial)[14];
+} AccumJob;
+
+/**
+ * @brief Momentos de un trozo. Orden de los 14 acumuladores:
+ *        x y | x² xy y² | x³ x²y xy² y³ | x⁴ x³y x²y² xy³ y⁴.
+ */
+static void accum_range(size_t begin, size_t end, void* ctx) {
+    AccumJob* job = ctx;
+    const double x0 = job->x0, y0 = job->y0;
+
+    for (size_t c = begin; c < end; c++) {
+        size_t lo = c * job->chunk;
+        size_t hi = lo + job->chunk < job->n ? lo + job->chunk : job->n;
+        const double* restrict xs = job->xs;
+        const double* restrict ys = job->ys;
+
+        double acc[14][FIT_LANES];
+        memset(acc, 0, sizeof(acc));
+
+        size_t i = lo;
+        for (; i + FIT_LANES <= hi; i += FIT_LANES) {
+            for (int l = 0; l < FIT_LANES; l++) {
+                double x = xs[i + l] - x0, y = ys[i + l] - y0;
+                double x2 = x*x, xy = x*y, y2 = y*y;
+                acc[0][l]  += x;       acc[1][l]  += y;
+                acc[2][l]  += x2;      acc[3][l]  += xy;      acc[4][l]  += y2;
+                acc[5][l]  += x2*x;    acc[6][l]  += x2*y;
+                acc[7][l]  += x*y2;    acc[8][l]  += y2*y;
+                acc[9][l]  += x2*x2;   acc[10][l] += x2*xy;   acc[11][l] += x2*y2;
+                acc[12][l] += xy*y2;   acc[13][l] += y2*y2;
+            }
+        }
+        for (; i < hi; i++) {
+            double x = xs[i] - x0, y = ys[i] - y0;
+            double x2 = x*x, xy = x*y, y2 = y*y;
+            double v[14] = { x, y, x2, xy, y2, x2*x, x2*y, x*y2, y2*y,
+                             x2*x2, x2*xy, x2*y2, xy*y2, y2*y2 };
+            for (int k = 0; k < 14; k++) acc[k][0] += v[k];
+        }
+
+        for (int k = 0; k < 14; k++) {
+            double s = 0.0;
+            for (int l = 0; l < FIT_LANES; l++) s += acc[k][l];
+            job->partial[c][k] = s;
+        }
+    }
+}
+
+static double binom(int n, int k) {
+    static const double T[5][5] = {
+        {1, 0, 0, 0, 0}, {1, 1, 0, 0, 0}, {1, 2, 1, 0, 0}, {1, 3, 3, 1, 0}, {1, 4, 6, 4, 1}
+    };
+    return T[n][k];
+}
+
+/**
+ * @brief Momentos de (u, v) = s·(x - x0 - mx, y - y0 - my) divididos por n,
+ *        desarrollando los binomios sobre los momentos desplazados.
+ */
+static void normalized_moments(const FitMoments* m, double mx, double my, double s,
+                               double out[5][5]) {
+    double pmx[5] = { 1 }, pmy[5] = { 1 }, ps[5] = { 1 };
+    for (int k = 1; k < 5; k++) {
+        pmx[k] = pmx[k - 1] * -mx;
+        pmy[k] = pmy[k - 1] * -my;
+        ps[k] = ps[k - 1] * s;
+    }
+
+    memset(out, 0, sizeof(double) * 25);
+    for (int a = 0; a <= 4; a++) {
+        for (int b = 0; a + b <= 4; b++) {
+            double sum = 0.0;
+            for (int i = 0; i <= a; i++)
+                for (int j = 0; j <= b; j++)
+                    sum += binom(a, i) * binom(b, j) * pmx[a - i] * pmy[b - j] * m->m[i][j];
+            out[a][b] = ps[a + b] * sum / (double)m->n;
+        }
+    }
+}
+
+/**
+ * @brief Ajuste directo de elipse (Halir–Flusser): reduce el problema
+ *        generalizado 6x6 de Fitzgibbon a un autoproblema 3x3 no simétrico.
+ * @return false si no hay autovector con 4ac - b² > 0.
+ */
+static bool fit_ellipse(const double S[36], double a[6]) {
+    double S1[9], S2[9], S2t[9], S3[9];
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            S1[3*i + j] = S[6*i + j];
+            S2[3*i + j] = S[6*i + j + 3];
+            S2t[3*j + i] = S[6*i + j + 3];
+            S3[3*i + j] = S[6*(i + 3) + j + 3];
+        }
+    }
+
+    double S3i[9], T[9], ST[9], M[9];
+    if (!mat3_inverse(S3, S3i)) return false;
+    mat3_mul(S3i, S2t, T);
+    for (int i = 0; i < 9; i++) T[i] = -T[i];
+    mat3_mul(S2, T, ST);
+    for (int i = 0; i < 9; i++) ST[i] += S1[i];
+
+    // C1⁻¹·M con la restricción 4ac - b² = 1
+    for (int j = 0; j < 3; j++) {
+        M[j]     =  0.5 * ST[6 + j];
+        M[3 + j] = -ST[3 + j];
+        M[6 + j] =  0.5 * ST[j];
+    }
+
+    double tr = M[0] + M[4] + M[8];
+    double minors = (M[0]*M[4] - M[1]*M[3]) + (M[0]*M[8] - M[2]*M[6]) + (M[4]*M[8] - M[5]*M[7]);
+    double det = M[0]*(M[4]*M[8] - M[5]*M[7]) - M[1]*(M[3]*M[8] - M[5]*M[6])
+               + M[2]*(M[3]*M[7] - M[4]*M[6]);
+
+    double roots[3];
+    int nr = poly_solve_cubic(1.0, -tr, minors, -det, roots);
+
+    double best = 0.0;
+    bool found = false;
+    for (int k = 0; k < nr; k++) {
+        double v[3];
+        mat3_eigvec(M, roots[k], v);
+        double cond = 4.0*v[0]*v[2] - v[1]*v[1];
+        if (cond > best) {
+            best = cond;
+            memcpy(a, v, sizeof(v));
+            found = true;
+        }
+    }
+    if (!found) return false;
+
+    for (int i = 0; i < 3; i++)
+        a[3 + i] = T[3*i]*a[0] + T[3*i + 1]*a[1] + T[3*i + 2]*a[2];
+    return true;
+}
+
+//-------------------------------------------//
+//                API PÚBLICA                //
+//-------------------------------------------//
+
+void fit_denormalize(const double a[6], double s, double X0, double Y0, double c[6]) {
+    double s2 = s * s;
+    c[0] = a[0] * s2;
+    c[1] = a[1] * s2;
+    c[2] = a[2] * s2;
+    c[3] = a[3]*s - 2.0*a[0]*s2*X0 - a[1]*s2*Y0;
+    c[4] = a[4]*s - 2.0*a[2]*s2*Y0 - a[1]*s2*X0;
+    c[5] = a[0]*s2*X0*X0 + a[1]*s2*X0*Y0 + a[2]*s2*Y0*Y0 - a[3]*s*X0 - a[4]*s*Y0 + a[5];
+
+    // Norma de la parte cuadrática: con la nube lejos del origen F crece
+    // como s²·X0² y la norma completa aplastaría A, B, C hacia cero
+    double norm = c[0]*c[0] + c[1]*c[1] + c[2]*c[2];
+    if (norm == 0.0) for (int i = 3; i < 6; i++) norm += c[i] * c[i];
+    norm = sqrt(norm);
+    // Signo canónico: A + C >= 0 (la elipse queda con Q < 0 dentro)
+    if (c[0] + c[2] < 0) norm = -norm;
+    if (norm != 0.0) for (int i = 0; i < 6; i++) c[i] /= norm;
+}
+
+void fit_accumulate(const double* xs, const double* ys, size_t n, FitMoments* out) {
+    memset(out, 0, sizeof(*out));
+    out->n = n;
+    if (n == 0) return;
+    out->x0 = xs[0];
+    out->y0 = ys[0];
+
+    size_t chunk = FIT_CHUNK;
+    if ((n + chunk - 1) / chunk > FIT_MAX_CHUNKS) chunk = (n + FIT_MAX_CHUNKS - 1) / FIT_MAX_CHUNKS;
+    size_t chunks = (n + chunk - 1) / chunk;
+
+    double partial[FIT_MAX_CHUNKS][14];
+    AccumJob job = { xs, ys, n, chunk, out->x0, out->y0, partial };
+    tp_parallel_for(0, chunks, 1, accum_range, &job);
+
+    // Reducción en orden fijo: mismo resultado con cualquier número de hilos
+    static const int IDX[14][2] = {
+        {1, 0}, {0, 1}, {2, 0}, {1, 1}, {0, 2}, {3, 0}, {2, 1},
+        {1, 2}, {0, 3}, {4, 0}, {3, 1}, {2, 2}, {1, 3}, {0, 4}
+    };
+    out->m[0][0] = (double)n;
+    for (size_t c = 0; c < chunks; c++)
+        for (int k = 0; k < 14; k++)
+            out->m[IDX[k][0]][IDX[k][1]] += partial[c][k];
+}
+
+FitStatus fit_conic(const FitMoments* m, FitMethod method, double coeffs[6], double* rms) {
+    if (m->n < 5) return FIT_ERR_TOO_FEW;
+
+    double N = (double)m->n;
+    double mx = m->m[1][0] / N, my = m->m[0][1] / N;
+    double var = (m->m[2][0] + m->m[0][2]) / N - mx*mx - my*my;
+    if (!(var > 0)) return FIT_ERR_DEGENERATE;
+    double s = sqrt(2.0 / var);
+
+    double nm[5][5];
+    normalized_moments(m, mx, my, s, nm);
+
+    double S[36];
+    for (int p = 0; p < 6; p++)
+        for (int q = 0; q < 6; q++)
+            S[6*p + q] = nm[DESIGN[p][0] + DESIGN[q][0]][DESIGN[p][1] + DESIGN[q][1]];
+
+    double a[6];
+    if (method == FIT_ELLIPSE) {
+        if (!fit_ellipse(S, a)) return FIT_ERR_DEGENERATE;
+    } else {
+        double work[36], evals[6], evecs[36];
+        memcpy(work, S, sizeof(S));
+        linalg_sym_eigen(work, 6, evals, evecs);
+        for (int i = 0; i < 6; i++) a[i] = evecs[6*i];
+    }
+
+    if (rms) {
+        // aᵀ·S·a / ‖a‖² = media de Q² en coordenadas normalizadas
+        double num = 0.0, den = 0.0;
+        for (int p = 0; p < 6; p++) {
+            den += a[p] * a[p];
+            for (int q = 0; q < 6; q++) num += a[p] * S[6*p + q] * a[q];
+        }
+        *rms = den > 0 ? sqrt(fmax(num / den, 0.0)) : 0.0;
+    }
+
+    fit_denormalize(a, s, m->x0 + mx, m->y0 + my, coeffs);
+    return FIT_OK;
+}
+
+FitStatus fit_points(const double* xs, const double* ys, size_t n, FitMethod method,
+                     double coeffs[6], double* rms) {
+    FitMoments m;
+    fit_accumulate(xs, ys, n, &m);
+    return fit_conic(&m, method, coeffs, rms);
+}
+
+bool fit_five_points(const double xs[5], const double ys[5], double coeffs[6]) {
+    double mx = 0.0, my = 0.0;
+    for (int i = 0; i < 5; i++) {
+        mx += xs[i];
+        my += ys[i];
+    }
+    mx /= 5.0;
+    my /= 5.0;
+    double var = 0.0;
+    for (int i = 0; i < 5; i++) var += (xs[i] - mx)*(xs[i] - mx) + (ys[i] - my)*(ys[i] - my);
+    if (!(var > 0)) return false;
+    double s = sqrt(10.0 / var);
+
+    double M[5][6];
+    for (int i = 0; i < 5; i++) {
+        double u = s * (xs[i] - mx), v = s * (ys[i] - my);
+        double row[6] = { u*u, u*v, v*v, u, v, 1.0 };
+        memcpy(M[i], row, sizeof(row));
+    }
+
+    double a[6];
+    if (linalg_null5x6(M, a) < 1e-10) return false;
+
+    fit_denormalize(a, s, mx, my, coeffs);
+    return true;
+}
+
+const char* fit_status_str(FitStatus s) {
+    switch (s) {
+        case FIT_OK:             return "ok";
+        case FIT_ERR_TOO_FEW:    return "se necesitan al menos 5 puntos";
+        case FIT_ERR_DEGENERATE: return "puntos degenerados para el ajuste";
+    }
+    return "error desconocido";
+}
@@ -0,0 +1,80 @@
+//================================================================//
+//          FIT HEADER - Ajuste de cónicas a nubes de puntos      //
+//================================================================//
+//
+// Ajuste por mínimos cuadrados algebraicos de A..F a millones de puntos.
+// - Una sola pasada (paralela y vectorizada) acumula los momentos
+//   Σ x^i y^j con i + j <= 4, desplazados al primer punto para no
+//   perder precisión con coordenadas grandes.
+// - La normalización (centroide y escala √2) se aplica después sobre
+//   los momentos, de forma exacta, sin volver a leer los puntos.
+// - La matriz de dispersión 6x6 sale de esos momentos y los ajustes
+//   trabajan solo con ella:
+//     FIT_ELLIPSE  Fitzgibbon directo (forma estable de Halir–Flusser):
+//                  siempre devuelve una elipse.
+//     FIT_GENERAL  min ‖D·a‖ con ‖a‖ = 1: autovector menor; cualquier tipo.
+//
+
+#ifndef FIT_H
+#define FIT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Momentos desplazados m[i][j] = Σ (x - x0)^i (y - y0)^j, i + j <= 4.
+ * Son aditivos: dos acumulaciones con el mismo origen se suman.
+ */
+typedef struct {
+    double m[5][5];
+    double x0, y0;
+    size_t n;
+} FitMoments;
+
+typedef enum {
+    FIT_ELLIPSE,
+    FIT_GENERAL
+} FitMethod;
+
+typedef enum {
+    FIT_OK,
+    FIT_ERR_TOO_FEW,        // menos de 5 puntos
+    FIT_ERR_DEGENERATE      // puntos alineados o sin elipse compatible
+} FitStatus;
+
+/**
+ * Acumula los momentos de n puntos en una pasada. El origen es el
+ * primer punto.
+ */
+void fit_accumulate(const double* xs, const double* ys, size_t n, FitMoments* out);
+
+/**
+ * Ajusta una cónica a partir de los momentos. coeffs recibe A..F en
+ * coordenadas originales con ‖(A, B, C)‖ = 1; rms (si no es NULL) recibe el
+ * residuo algebraico cuadrático medio en coordenadas normalizadas.
+ */
+FitStatus fit_conic(const FitMoments* m, FitMethod method, double coeffs[6], double* rms);
+
+/**
+ * fit_accumulate + fit_conic.
+ */
+FitStatus fit_points(const double* xs, const double* ys, size_t n, FitMethod method,
+                     double coeffs[6], double* rms);
+
+/**
+ * Cónica que pasa por cinco puntos: vector nulo del sistema 5x6 (en
+ * coordenadas normalizadas, eliminación con pivoteo total). Devuelve
+ * false si los puntos no determinan una única cónica (4 alineados,
+ * repetidos). Misma normalización de coeficientes que fit_conic.
+ */
+bool fit_five_points(const double xs[5], const double ys[5], double coeffs[6]);
+
+/**
+ * Pasa a coordenadas originales una cónica a ajustada en coordenadas
+ * normalizadas u = s(x - x0), v = s(y - y0), con ‖(A, B, C)‖ = 1.
+ */
+void fit_denormalize(const double a[6], double s, double x0, double y0, double c[6]);
+
+const char* fit_status_str(FitStatus s);
+
+#endif
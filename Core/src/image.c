@@ -0,0 +1,375 @@
+//================================================================//
+// IMAGE - Codificadores PGM, PNG y QOI
+//================================================================//
+//
+// PNG: cabecera, IHDR, PLTE opcional, IDAT con un flujo zlib y IEND.
+// El flujo zlib usa bloques deflate sin comprimir (tipo 0): es válido
+// para cualquier lector y su coste es una copia de memoria. PNG_RLE
+// emite en su lugar un único bloque con Huffman fijo (tipo 1) cuyas
+// únicas coincidencias están a distancia de un píxel, como Z_RLE de
+// zlib: una pasada lineal sin tablas hash que comprime muy bien las
+// zonas lisas de una gráfica.
+//
+// QOI: formato sin pérdida de una sola pasada, con el mismo orden de
+// coste que la copia pero mucho más compacto en imágenes sintéticas.
+//
+//--------------------------------//
+// Includes y dependencias
+//--------------------------------//
+#define _POSIX_C_SOURCE 200809L
+
+#include "image.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @file image.c
+ * @brief Codificación de buffers de píxeles a PGM/PNG/QOI en memoria.
+ */
+
+//-------------------------------------------//
+//            FUNCIONES AUXILIARES           //
+//-------------------------------------------//
+
+static uint32_t crc_table[256];
+static pthread_once_t tables_once = PTHREAD_ONCE_INIT;
+
+// Huffman fijo de deflate (RFC 1951, 3.2.6), códigos ya invertidos para
+// escribirse LSB primero
+static uint16_t lit_code[288];
+static uint8_t  lit_bits[288];
+
+// Longitud de coincidencia 3..258 -> símbolo 257..285 y bits extra
+static uint16_t len_sym[259];
+static uint8_t  len_extra_bits[259];
+static uint16_t len_extra_val[259];
+
+static uint32_t reverse_bits(uint32_t v, int n) {
+    uint32_t r = 0;
+    for (int i = 0; i < n; i++, v >>= 1) r = (r << 1) | (v & 1);
+    return r;
+}
+
+static void tables_init(void) {
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+        crc_table[n] = c;
+    }
+
+    for (int v = 0; v < 288; v++) {
+        uint32_t code;
+        int bits;
+        if (v < 144)      { code = 0x30u + (uint32_t)v;          bits = 8; }
+        else if (v < 256) { code = 0x190u + (uint32_t)(v - 144); bits = 9; }
+        else if (v < 280) { code = (uint32_t)(v - 256);          bits = 7; }
+        else              { code = 0xc0u + (uint32_t)(v - 280);  bits = 8; }
+        lit_code[v] = (uint16_t)reverse_bits(code, bits);
+        lit_bits[v] = (uint8_t)bits;
+    }
+
+    static const uint16_t base[29] = {
+        3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+        35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+    };
+    static const uint8_t extra[29] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+        3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+    };
+    for (int len = 3, s = 0; len <= 258; len++) {
+        while (s < 28 && base[s + 1] <= len) s++;
+        len_sym[len] = (uint16_t)(257 + s);
+        len_extra_bits[len] = extra[s];
+        len_extra_val[len] = (uint16_t)(len - base[s]);
+    }
+}
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t* p, size_t n) {
+    for (size_t i = 0; i < n; i++) crc = crc_table[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+    return crc;
+}
+
+static void put_be32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+/**
+ * @brief Añade un chunk PNG (longitud, tipo, datos, CRC) a out.
+ */
+static bool png_chunk(ByteBuf* out, const char type[4], const uint8_t* data, size_t len) {
+    uint8_t hdr[8];
+    put_be32(hdr, (uint32_t)len);
+    memcpy(hdr + 4, type, 4);
+
+    uint32_t crc = crc32_update(0xffffffffu, (const uint8_t*)type, 4);
+    crc = crc32_update(crc, data, len) ^ 0xffffffffu;
+
+    uint8_t tail[4];
+    put_be32(tail, crc);
+
+    return buf_append(out, hdr, 8) &&
+           (len == 0 || buf_append(out, data, len)) &&
+           buf_append(out, tail, 4);
+}
+
+/**
+ * @brief Adler-32 de raw en bloques de 5552 bytes (sin desbordar 32 bits).
+ */
+static uint32_t adler32(const uint8_t* raw, size_t len) {
+    uint32_t a = 1, b = 0;
+    for (size_t i = 0; i < len;) {
+        size_t end = i + 5552 < len ? i + 5552 : len;
+        for (; i < end; i++) { a += raw[i]; b += a; }
+        a %= 65521u;
+        b %= 65521u;
+    }
+    return (b << 16) | a;
+}
+
+/**
+ * @brief Envuelve raw en un flujo zlib con bloques deflate almacenados.
+ */
+static bool zlib_stored(ByteBuf* z, const uint8_t* raw, size_t len) {
+    static const uint8_t zhdr[2] = { 0x78, 0x01 };
+    if (!buf_append(z, zhdr, 2)) return false;
+
+    size_t pos = 0;
+    do {
+        size_t n = len - pos > 65535 ? 65535 : len - pos;
+        uint8_t bh[5];
+        bh[0] = pos + n == len ? 1 : 0;   // BFINAL, BTYPE = 00
+        bh[1] = (uint8_t)(n & 0xff);
+        bh[2] = (uint8_t)(n >> 8);
+        bh[3] = (uint8_t)(~n & 0xff);
+        bh[4] = (uint8_t)((~n >> 8) & 0xff);
+        if (!buf_append(z, bh, 5) || (n > 0 && !buf_append(z, raw + pos, n))) return false;
+        pos += n;
+    } while (pos < len);
+
+    uint8_t adler[4];
+    put_be32(adler, adler32(raw, len));
+    return buf_append(z, adler, 4);
+}
+
+typedef struct {
+    uint8_t* p;         // siguiente byte libre
+    uint64_t acc;       // bits pendientes, LSB primero
+    int      n;
+} BitWriter;
+
+static inline void bw_put(BitWriter* bw, uint32_t v, int n) {
+    bw->acc |= (uint64_t)v << bw->n;
+    bw->n += n;
+    while (bw->n >= 8) {
+        *bw->p++ = (uint8_t)bw->acc;
+        bw->acc >>= 8;
+        bw->n -= 8;
+    }
+}
+
+/**
+ * @brief Envuelve raw en un flujo zlib con un bloque Huffman fijo cuyas
+ *        coincidencias repiten el píxel anterior (distancia dist ≤ 4).
+ * @details Un literal ocupa como mucho 9 bits, así que el peor caso cabe
+ *          en len·9/8 más cabeceras y se reserva de una vez.
+ */
+static bool zlib_rle(ByteBuf* z, const uint8_t* raw, size_t len, int dist) {
+    if (!buf_reserve(z, len + len / 8 + 16)) return false;
+
+    BitWriter bw = { z->data + z->len, 0, 0 };
+    *bw.p++ = 0x78;
+    *bw.p++ = 0x01;
+    bw_put(&bw, 1, 1);          // BFINAL
+    bw_put(&bw, 1, 2);          // BTYPE = 01 (Huffman fijo)
+
+    const uint32_t dist_code = reverse_bits((uint32_t)(dist - 1), 5);
+    size_t i = 0;
+    while (i < len) {
+        size_t run = 0;
+        if (i >= (size_t)dist) {
+            size_t max = len - i < 258 ? len - i : 258;
+            while (run < max && raw[i + run] == raw[i + run - (size_t)dist]) run++;
+        }
+        if (run >= 3) {
+            uint16_t sym = len_sym[run];
+            bw_put(&bw, lit_code[sym], lit_bits[sym]);
+            bw_put(&bw, len_extra_val[run], len_extra_bits[run]);
+            bw_put(&bw, dist_code, 5);
+            i += run;
+        } else {
+            bw_put(&bw, lit_code[raw[i]], lit_bits[raw[i]]);
+            i++;
+        }
+    }
+    bw_put(&bw, lit_code[256], lit_bits[256]);
+    if (bw.n > 0) bw_put(&bw, 0, 8 - bw.n);
+
+    put_be32(bw.p, adler32(raw, len));
+    z->len = (size_t)(bw.p + 4 - z->data);
+    return true;
+}
+
+//-------------------------------------------//
+//                 API PÚBLICA               //
+//-------------------------------------------//
+
+/**
+ * @brief Codifica px (w*h bytes) como PGM P5.
+ */
+bool image_write_pgm(ByteBuf* out, const uint8_t* px, int w, int h) {
+    char hdr[64];
+    int n = snprintf(hdr, sizeof(hdr), "P5\n%d %d\n255\n", w, h);
+    return buf_append(out, hdr, (size_t)n) && buf_append(out, px, (size_t)w * (size_t)h);
+}
+
+/**
+ * @brief Codifica px como PNG de 8 bits por canal sin filtros.
+ * @param out Buffer de destino (se añade al final).
+ * @param px Píxeles fila a fila, sin relleno.
+ * @param w Ancho en píxeles.
+ * @param h Alto en píxeles.
+ * @param color Tipo de color PNG.
+ * @param palette Paleta RGB para PNG_PALETTE (puede ser NULL en otro caso).
+ * @param palette_len Entradas de la paleta (1..256).
+ */
+bool image_write_png(
+    ByteBuf* out,
+    const uint8_t* px, int w, int h,
+    PngColor color,
+    const uint8_t* palette, int palette_len
+) {
+    return image_write_png_ex(out, px, w, h, color, palette, palette_len, PNG_STORED);
+}
+
+/**
+ * @brief image_write_png con el modo de deflate explícito.
+ * @param deflate PNG_STORED (copia) o PNG_RLE (carreras de píxeles).
+ */
+bool image_write_png_ex(
+    ByteBuf* out,
+    const uint8_t* px, int w, int h,
+    PngColor color,
+    const uint8_t* palette, int palette_len,
+    PngDeflate deflate
+) {
+    pthread_once(&tables_once, tables_init);
+
+    int channels = color == PNG_RGB ? 3 : color == PNG_RGBA ? 4 : 1;
+    size_t row = (size_t)w * (size_t)channels;
+
+    static const uint8_t sig[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    if (!buf_append(out, sig, 8)) return false;
+
+    uint8_t ihdr[13];
+    put_be32(ihdr, (uint32_t)w);
+    put_be32(ihdr + 4, (uint32_t)h);
+    ihdr[8] = 8;                // bits por canal
+    ihdr[9] = (uint8_t)color;
+    ihdr[10] = 0;               // deflate
+    ihdr[11] = 0;               // filtros adaptativos
+    ihdr[12] = 0;               // sin entrelazado
+    if (!png_chunk(out, "IHDR", ihdr, 13)) return false;
+
+    if (color == PNG_PALETTE && !png_chunk(out, "PLTE", palette, (size_t)palette_len * 3)) {
+        return false;
+    }
+
+    // Cada fila va precedida del byte de filtro (0 = None)
+    ByteBuf raw, z;
+    buf_init(&raw);
+    buf_init(&z);
+    bool ok = buf_reserve(&raw, (row + 1) * (size_t)h);
+    for (int y = 0; y < h && ok; y++) {
+        raw.data[raw.len++] = 0;
+        memcpy(raw.data + raw.len, px + (size_t)y * row, row);
+        raw.len += row;
+    }
+
+    ok = ok && (deflate == PNG_RLE ? zlib_rle(&z, raw.data, raw.len, channels)
+                                   : zlib_stored(&z, raw.data, raw.len)) &&
+         png_chunk(out, "IDAT", z.data, z.len) &&
+         png_chunk(out, "IEND", NULL, 0);
+
+    buf_free(&raw);
+    buf_free(&z);
+    return ok;
+}
+
+/**
+ * @brief Codifica px (w*h píxeles de channels bytes) como QOI.
+ * @param channels 3 (RGB) o 4 (RGBA).
+ */
+bool image_write_qoi(ByteBuf* out, const uint8_t* px, int w, int h, int channels) {
+    if (channels != 3 && channels != 4) return false;
+
+    size_t n = (size_t)w * (size_t)h;
+    if (!buf_reserve(out, 14 + n * (size_t)(channels + 1) + 8)) return false;
+    uint8_t* p = out->data + out->len;
+
+    memcpy(p, "qoif", 4);
+    put_be32(p + 4, (uint32_t)w);
+    put_be32(p + 8, (uint32_t)h);
+    p[12] = (uint8_t)channels;
+    p[13] = 0;                  // sRGB con alfa lineal
+    p += 14;
+
+    uint8_t index[64][4];
+    memset(index, 0, sizeof(index));
+    uint8_t prev[4] = { 0, 0, 0, 255 };
+    int run = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        const uint8_t* q = px + i * (size_t)channels;
+        uint8_t cur[4] = { q[0], q[1], q[2], channels == 4 ? q[3] : 255 };
+
+        if (memcmp(cur, prev, 4) == 0) {
+            if (++run == 62 || i + 1 == n) {
+                *p++ = (uint8_t)(0xc0 | (run - 1));     // QOI_OP_RUN
+                run = 0;
+            }
+            continue;
+        }
+        if (run > 0) {
+            *p++ = (uint8_t)(0xc0 | (run - 1));
+            run = 0;
+        }
+
+        int hsh = (cur[0] * 3 + cur[1] * 5 + cur[2] * 7 + cur[3] * 11) % 64;
+        if (memcmp(index[hsh], cur, 4) == 0) {
+            *p++ = (uint8_t)hsh;                        // QOI_OP_INDEX
+        } else {
+            memcpy(index[hsh], cur, 4);
+            if (cur[3] == prev[3]) {
+                int dr = (int8_t)(cur[0] - prev[0]);
+                int dg = (int8_t)(cur[1] - prev[1]);
+                int db = (int8_t)(cur[2] - prev[2]);
+                int dr_dg = dr - dg, db_dg = db - dg;
+                if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                    *p++ = (uint8_t)(0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2));
+                } else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 &&
+                           db_dg >= -8 && db_dg <= 7) {
+                    *p++ = (uint8_t)(0x80 | (dg + 32));     // QOI_OP_LUMA
+                    *p++ = (uint8_t)((dr_dg + 8) << 4 | (db_dg + 8));
+                } else {
+                    *p++ = 0xfe;                            // QOI_OP_RGB
+                    *p++ = cur[0]; *p++ = cur[1]; *p++ = cur[2];
+                }
+            } else {
+                *p++ = 0xff;                                // QOI_OP_RGBA
+                memcpy(p, cur, 4);
+                p += 4;
+            }
+        }
+        memcpy(prev, cur, 4);
+    }
+
+    static const uint8_t tail[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+    memcpy(p, tail, 8);
+    out->len = (size_t)(p + 8 - out->data);
+    return true;
+}
@@ -0,0 +1,63 @@
+//================================================================//
+//             IMAGE HEADER - Codificadores de imagen             //
+//================================================================//
+//
+// Codificadores mínimos sin dependencias externas (ni zlib ni libpng)
+// para las salidas raster del núcleo: PGM, PNG y QOI.
+//
+
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "utils.h"
+
+typedef enum {
+    PNG_GRAY    = 0,    // 1 byte por píxel
+    PNG_RGB     = 2,    // 3 bytes por píxel
+    PNG_PALETTE = 3,    // 1 índice por píxel + paleta RGB
+    PNG_RGBA    = 6     // 4 bytes por píxel
+} PngColor;
+
+typedef enum {
+    PNG_STORED,         // deflate sin comprimir: una copia de memoria
+    PNG_RLE             // deflate con carreras del píxel anterior (Huffman fijo)
+} PngDeflate;
+
+/**
+ * Escribe una imagen en escala de grises como PGM binario (P5).
+ */
+bool image_write_pgm(ByteBuf* out, const uint8_t* px, int w, int h);
+
+/**
+ * Escribe una imagen PNG de 8 bits por canal.
+ * palette (RGB, palette_len entradas) solo se usa con PNG_PALETTE.
+ */
+bool image_write_png(
+    ByteBuf* out,
+    const uint8_t* px, int w, int h,
+    PngColor color,
+    const uint8_t* palette, int palette_len
+);
+
+/**
+ * Como image_write_png, eligiendo cómo se codifica el flujo deflate.
+ * PNG_RLE reduce a una fracción las imágenes con grandes zonas lisas
+ * (gráficas, mapas) a un coste lineal.
+ */
+bool image_write_png_ex(
+    ByteBuf* out,
+    const uint8_t* px, int w, int h,
+    PngColor color,
+    const uint8_t* palette, int palette_len,
+    PngDeflate deflate
+);
+
+/**
+ * Escribe una imagen QOI (https://qoiformat.org) de 3 o 4 canales.
+ */
+bool image_write_qoi(ByteBuf* out, const uint8_t* px, int w, int h, int channels);
+
+#endif
@@ -0,0 +1,233 @@
+//================================================================//
+// INTERSECT - Intersección de cónicas por resultante cuártica
+//================================================================//
+//
+// Cada cónica se escribe como cuadrática en y:
+//     a_i·y² + b_i(x)·y + c_i(x) = 0
+// con a_i = C_i, b_i = B_i·x + E_i, c_i = A_i·x² + D_i·x + F_i.
+// Eliminando y (resultante de Sylvester) queda la cuártica en x
+//     R(x) = p² - q·r,  p = a1c2 - a2c1,  q = a1b2 - a2b1,  r = b1c2 - b2c1
+// cuyas raíces son las abscisas de los cortes (con su multiplicidad).
+//
+// Antes de eliminar, ambas cónicas se giran un ángulo fijo "genérico"
+// para que no haya cortes con la misma x ni términos en y² nulos; los
+// puntos se devuelven en el sistema original.
+//
+//--------------------------------//
+// Includes y dependencias
+//--------------------------------//
+#include "intersect.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "budget.h"
+#include "poly.h"
+#include "threadpool.h"
+
+/**
+ * @file intersect.c
+ * @brief Resultante cuártica, agrupación de raíces y pulido de Newton.
+ */
+
+// Ángulo de giro genérico (irracional respecto a π)
+#define GENERIC_ANGLE 0.5772156649015329
+
+//-------------------------------------------//
+//            FUNCIONES AUXILIARES           //
+//-------------------------------------------//
+
+/**
+ * @brief Coeficientes de la cónica tras el cambio x = c·x' - s·y',
+ *        y = s·x' + c·y'.
+ */
+static void rotate_conic(const double in[6], double c, double s, double out[6]) {
+    double A = in[0], B = in[1], C = in[2], D = in[3], E = in[4];
+    out[0] = A*c*c + B*c*s + C*s*s;
+    out[1] = 2.0*(C - A)*c*s + B*(c*c - s*s);
+    out[2] = A*s*s - B*c*s + C*c*c;
+    out[3] = D*c + E*s;
+    out[4] = -D*s + E*c;
+    out[5] = in[5];
+}
+
+/**
+ * @brief Escala los coeficientes para que el mayor valga 1 en módulo.
+ */
+static void normalize_conic(double c[6]) {
+    double m = 0.0;
+    for (int k = 0; k < 6; k++) m = fmax(m, fabs(c[k]));
+    if (m > 0) for (int k = 0; k < 6; k++) c[k] /= m;
+}
+
+static double eval_conic(const double c[6], double x, double y) {
+    return c[0]*x*x + c[1]*x*y + c[2]*y*y + c[3]*x + c[4]*y + c[5];
+}
+
+/**
+ * @brief Ordenada común de las dos cónicas en la abscisa x.
+ * @return false si en x no hay un y real que anule ambas.
+ */
+static bool common_y(const double c1[6], const double c2[6], double x, double* y) {
+    double a1 = c1[2], b1 = c1[1]*x + c1[4], k1 = c1[0]*x*x + c1[3]*x + c1[5];
+    double a2 = c2[2], b2 = c2[1]*x + c2[4], k2 = c2[0]*x*x + c2[3]*x + c2[5];
+
+    // a2·eq1 - a1·eq2 elimina y²: q·y + p = 0
+    double q = a1*b2 - a2*b1;
+    double p = a1*k2 - a2*k1;
+    double scale = fmax(fmax(fabs(a1), fabs(b1)), fmax(fabs(a2), fabs(b2)));
+    if (fabs(q) > 1e-9 * fmax(scale, 1e-300)) {
+        *y = -p / q;
+        return true;
+    }
+
+    // Caso degenerado: raíces de la primera que anulan también la segunda
+    double ys[2];
+    int n = poly_solve_quadratic(a1, b1, k1, ys);
+    double best = INFINITY;
+    for (int i = 0; i < n; i++) {
+        double r = fabs(eval_conic(c2, x, ys[i]));
+        if (r < best) { best = r; *y = ys[i]; }
+    }
+    return n > 0 && best < 1e-6;
+}
+
+/**
+ * @brief Pulido de Newton 2D sobre {f1 = 0, f2 = 0}.
+ * @details En tangencias el jacobiano es singular: se deja el punto tal cual.
+ */
+static void polish_point(const double c1[6], const double c2[6], double* x, double* y) {
+    for (int it = 0; it < 4; it++) {
+        double f1 = eval_conic(c1, *x, *y), f2 = eval_conic(c2, *x, *y);
+        double j11 = 2*c1[0]**x + c1[1]**y + c1[3], j12 = c1[1]**x + 2*c1[2]**y + c1[4];
+        double j21 = 2*c2[0]**x + c2[1]**y + c2[3], j22 = c2[1]**x + 2*c2[2]**y + c2[4];
+        double det = j11*j22 - j12*j21;
+        double norm = fmax(fabs(j11) + fabs(j12), fabs(j21) + fabs(j22));
+        if (fabs(det) < 1e-8 * norm * norm || !isfinite(det)) return;
+
+        *x -= ( j22*f1 - j12*f2) / det;
+        *y -= (-j21*f1 + j11*f2) / det;
+    }
+}
+
+//-------------------------------------------//
+//                 API PÚBLICA               //
+//-------------------------------------------//
+
+/**
+ * @brief Intersección real de dos cónicas con multiplicidades.
+ * @param c1 Coeficientes [A..F] de la primera cónica.
+ * @param c2 Coeficientes [A..F] de la segunda cónica.
+ * @param out Resultado: puntos distintos ordenados por x (tras el giro).
+ * @details Las raíces complejas con parte imaginaria despreciable se
+ *          tratan como reales: es la huella numérica de una raíz doble
+ *          (tangencia). Las raíces próximas se agrupan y el tamaño del
+ *          grupo es la multiplicidad del punto.
+ */
+void conic_intersect(const double c1[6], const double c2[6], IntersectResult* out) {
+    memset(out, 0, sizeof(*out));
+
+    double cs = cos(GENERIC_ANGLE), sn = sin(GENERIC_ANGLE);
+    double r1[6], r2[6];
+    rotate_conic(c1, cs, sn, r1);
+    rotate_conic(c2, cs, sn, r2);
+    normalize_conic(r1);
+    normalize_conic(r2);
+
+    // p (grado 2), q (grado 1), r (grado 3) en grado descendente
+    double a1 = r1[2], a2 = r2[2];
+    double b1[2] = { r1[1], r1[4] }, b2[2] = { r2[1], r2[4] };
+    double k1[3] = { r1[0], r1[3], r1[5] }, k2[3] = { r2[0], r2[3], r2[5] };
+
+    double p[3], q[2], t1[4], t2[4], r[4];
+    for (int i = 0; i < 3; i++) p[i] = a1*k2[i] - a2*k1[i];
+    for (int i = 0; i < 2; i++) q[i] = a1*b2[i] - a2*b1[i];
+    poly_mul(b1, 1, k2, 2, t1);
+    poly_mul(b2, 1, k1, 2, t2);
+    for (int i = 0; i < 4; i++) r[i] = t1[i] - t2[i];
+
+    double pp[5], qr[5], R[5];
+    poly_mul(p, 2, p, 2, pp);
+    poly_mul(q, 1, r, 3, qr);
+    double rmax = 0.0;
+    for (int i = 0; i < 5; i++) {
+        R[i] = pp[i] - qr[i];
+        rmax = fmax(rmax, fabs(R[i]));
+    }
+
+    // Resultante idénticamente nula: componente común
+    if (rmax < 1e-12) {
+        out->overlap = true;
+        return;
+    }
+
+    double re[4], im[4];
+    int n = poly_solve_quartic(R, re, im);
+
+    // Raíces (casi) reales ordenadas
+    double xs[4];
+    int nx = 0;
+    for (int i = 0; i < n; i++) {
+        if (fabs(im[i]) <= 1e-6 * (1.0 + fabs(re[i]))) xs[nx++] = re[i];
+    }
+    for (int i = 1; i < nx; i++) {
+        double v = xs[i];
+        int j = i - 1;
+        while (j >= 0 && xs[j] > v) { xs[j + 1] = xs[j]; j--; }
+        xs[j + 1] = v;
+    }
+
+    // Agrupar raíces próximas: multiplicidad
+    for (int i = 0; i < nx;) {
+        int j = i + 1;
+        double sum = xs[i];
+        while (j < nx && xs[j] - xs[j - 1] <= 1e-5 * (1.0 + fabs(xs[j]))) sum += xs[j++];
+
+        double x = sum / (j - i), y = 0.0;
+        if (common_y(r1, r2, x, &y)) {
+            polish_point(r1, r2, &x, &y);
+
+            IntersectPoint* ip = &out->points[out->count++];
+            ip->x = cs*x - sn*y;
+            ip->y = sn*x + cs*y;
+            ip->multiplicity = j - i;
+        }
+        i = j;
+    }
+}
+
+typedef struct {
+    const double*    coeffs;
+    const uint32_t*  pairs;
+    IntersectResult* out;
+} IntersectJob;
+
+static void intersect_range(size_t begin, size_t end, void* ctx) {
+    IntersectJob* job = ctx;
+    for (size_t k = begin; k < end; k++) {
+        if (budget_exhausted()) {
+            memset(&job->out[k], 0, sizeof(IntersectResult));
+            job->out[k].skipped = true;
+            continue;
+        }
+        const double* c1 = job->coeffs + 6 * (size_t)job->pairs[2 * k];
+        const double* c2 = job->coeffs + 6 * (size_t)job->pairs[2 * k + 1];
+        conic_intersect(c1, c2, &job->out[k]);
+    }
+}
+
+/**
+ * @brief Intersecta pair_count pares en paralelo.
+ * @param coeffs Tabla de cónicas, 6 coeficientes por fila.
+ * @param pairs Índices (i, j) consecutivos en la tabla.
+ * @param pair_count Número de pares.
+ * @param out Resultados, uno por par.
+ */
+void conic_intersect_batch(
+    const double* coeffs,
+    const uint32_t* pairs, size_t pair_count,
+    IntersectResult* out
+) {
+    IntersectJob job = { coeffs, pairs, out };
+    tp_parallel_for(0, pair_count, 256, intersect_range, &job);
+}
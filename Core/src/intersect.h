@@ -0,0 +1,47 @@
+//================================================================//
+//        INTERSECT HEADER - Intersección cónica-cónica           //
+//================================================================//
+//
+// Puntos reales de intersección entre pares de cónicas con su
+// multiplicidad (1 = corte transversal, 2 = tangencia, ...), y una API
+// por lotes que reparte miles de pares entre los hilos del pool.
+//
+
+#ifndef INTERSECT_H
+#define INTERSECT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    double x;
+    double y;
+    int    multiplicity;
+} IntersectPoint;
+
+typedef struct {
+    int            count;       // puntos reales distintos (0..4)
+    bool           overlap;     // comparten una componente (infinitos puntos)
+    bool           skipped;     // sin calcular: venció el presupuesto
+    IntersectPoint points[4];
+} IntersectResult;
+
+/**
+ * Intersección de dos cónicas dadas por sus coeficientes [A..F].
+ */
+void conic_intersect(const double c1[6], const double c2[6], IntersectResult* out);
+
+/**
+ * Intersecta los pares (pairs[2k], pairs[2k+1]) de la tabla coeffs
+ * (n filas de 6 coeficientes) en paralelo. out tiene pair_count entradas.
+ * Si vence el presupuesto del hilo (budget.h), los pares que faltan
+ * quedan sin puntos y con skipped.
+ */
+void conic_intersect_batch(
+    const double* coeffs,
+    const uint32_t* pairs, size_t pair_count,
+    IntersectResult* out
+);
+
+#endif
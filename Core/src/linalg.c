@@ -0,0 +1,203 @@
+//================================================================//
+// LINALG - Inversas 3x3 y autovalores simétricos por Jacobi
+//================================================================//
+//
+// Jacobi es lento para matrices grandes pero en 6x6 converge en pocas
+// barridas, es muy estable y da autovectores ortogonales a precisión de
+// máquina, que es lo que piden los ajustes por mínimos cuadrados.
+//
+//--------------------------------//
+// Includes y dependencias
+//--------------------------------//
+#include "linalg.h"
+
+#include <math.h>
+#include <string.h>
+
+/**
+ * @file linalg.c
+ * @brief Álgebra lineal densa descrita en linalg.h.
+ */
+
+#define LINALG_MAX_N 8
+
+//-------------------------------------------//
+//                MATRICES 3x3               //
+//-------------------------------------------//
+
+bool mat3_inverse(const double m[9], double out[9]) {
+    double c00 = m[4]*m[8] - m[5]*m[7];
+    double c01 = m[5]*m[6] - m[3]*m[8];
+    double c02 = m[3]*m[7] - m[4]*m[6];
+    double det = m[0]*c00 + m[1]*c01 + m[2]*c02;
+
+    double scale = 0.0;
+    for (int i = 0; i < 9; i++) scale = fmax(scale, fabs(m[i]));
+    if (scale == 0.0 || fabs(det) <= 1e-14 * scale * scale * scale) return false;
+
+    double inv = 1.0 / det;
+    out[0] = c00 * inv;
+    out[1] = (m[2]*m[7] - m[1]*m[8]) * inv;
+    out[2] = (m[1]*m[5] - m[2]*m[4]) * inv;
+    out[3] = c01 * inv;
+    out[4] = (m[0]*m[8] - m[2]*m[6]) * inv;
+    out[5] = (m[2]*m[3] - m[0]*m[5]) * inv;
+    out[6] = c02 * inv;
+    out[7] = (m[1]*m[6] - m[0]*m[7]) * inv;
+    out[8] = (m[0]*m[4] - m[1]*m[3]) * inv;
+    return true;
+}
+
+void mat3_mul(const double a[9], const double b[9], double out[9]) {
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            out[3*i + j] = a[3*i]*b[j] + a[3*i + 1]*b[3 + j] + a[3*i + 2]*b[6 + j];
+}
+
+void mat3_eigvec(const double m[9], double lambda, double v[3]) {
+    double r[3][3];
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            r[i][j] = m[3*i + j] - (i == j ? lambda : 0.0);
+
+    // El núcleo de M - λI es ortogonal a sus filas: el mayor producto
+    // vectorial entre dos filas es la dirección más estable
+    static const int pairs[3][2] = { {0, 1}, {0, 2}, {1, 2} };
+    double best = -1.0;
+    for (int p = 0; p < 3; p++) {
+        const double* a = r[pairs[p][0]];
+        const double* b = r[pairs[p][1]];
+        double c[3] = {
+            a[1]*b[2] - a[2]*b[1],
+            a[2]*b[0] - a[0]*b[2],
+            a[0]*b[1] - a[1]*b[0]
+        };
+        double n2 = c[0]*c[0] + c[1]*c[1] + c[2]*c[2];
+        if (n2 > best) {
+            best = n2;
+            memcpy(v, c, sizeof(c));
+        }
+    }
+
+    double n = sqrt(best);
+    if (n > 0) for (int i = 0; i < 3; i++) v[i] /= n;
+}
+
+//-------------------------------------------//
+//              SISTEMAS 5x6                 //
+//-------------------------------------------//
+
+double linalg_null5x6(double M[5][6], double a[6]) {
+    double scale = 0.0;
+    for (int i = 0; i < 5; i++)
+        for (int j = 0; j < 6; j++) scale = fmax(scale, fabs(M[i][j]));
+    if (scale == 0.0) return 0.0;
+
+    // La columna que queda libre es la peor condicionada para pivotar,
+    // así que fijarla a 1 es la elección más estable
+    int perm[6] = { 0, 1, 2, 3, 4, 5 };
+    double pmin = INFINITY, pmax = 0.0;
+    for (int k = 0; k < 5; k++) {
+        int pr = k, pc = k;
+        double best = 0.0;
+        for (int i = k; i < 5; i++)
+            for (int j = k; j < 6; j++)
+                if (fabs(M[i][perm[j]]) > best) {
+                    best = fabs(M[i][perm[j]]);
+                    pr = i;
+                    pc = j;
+                }
+        if (best <= 1e-14 * scale) return 0.0;
+        pmin = fmin(pmin, best);
+        pmax = fmax(pmax, best);
+
+        if (pr != k)
+            for (int j = 0; j < 6; j++) {
+                double t = M[k][j]; M[k][j] = M[pr][j]; M[pr][j] = t;
+            }
+        int t = perm[k]; perm[k] = perm[pc]; perm[pc] = t;
+
+        double piv = M[k][perm[k]];
+        for (int i = k + 1; i < 5; i++) {
+            double f = M[i][perm[k]] / piv;
+            for (int j = k; j < 6; j++) M[i][perm[j]] -= f * M[k][perm[j]];
+        }
+    }
+
+    a[perm[5]] = 1.0;
+    for (int k = 4; k >= 0; k--) {
+        double sum = 0.0;
+        for (int j = k + 1; j < 6; j++) sum += M[k][perm[j]] * a[perm[j]];
+        a[perm[k]] = -sum / M[k][perm[k]];
+    }
+    return pmin / pmax;
+}
+
+//-------------------------------------------//
+//          AUTOVALORES SIMÉTRICOS           //
+//-------------------------------------------//
+
+/**
+ * @brief Jacobi cíclico con umbral.
+ * @param a Matriz simétrica n x n por filas (se destruye).
+ * @param n Dimensión (<= LINALG_MAX_N).
+ * @param evals Autovalores en orden ascendente.
+ * @param evecs Autovectores por columnas, en el mismo orden.
+ */
+void linalg_sym_eigen(double* a, int n, double* evals, double* evecs) {
+    double v[LINALG_MAX_N * LINALG_MAX_N];
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+            v[i*n + j] = i == j ? 1.0 : 0.0;
+
+    for (int sweep = 0; sweep < 50; sweep++) {
+        double off = 0.0, diag = 0.0;
+        for (int i = 0; i < n; i++) {
+            diag += a[i*n + i] * a[i*n + i];
+            for (int j = i + 1; j < n; j++) off += a[i*n + j] * a[i*n + j];
+        }
+        if (off <= 1e-30 * diag || off == 0.0) break;
+
+        for (int p = 0; p < n; p++) {
+            for (int q = p + 1; q < n; q++) {
+                double apq = a[p*n + q];
+                if (apq == 0.0) continue;
+
+                // Rotación que anula a[p][q] (forma estable de Rutishauser)
+                double theta = (a[q*n + q] - a[p*n + p]) / (2.0 * apq);
+                double t = (theta >= 0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta*theta + 1.0));
+                double c = 1.0 / sqrt(t*t + 1.0), s = t * c;
+
+                for (int k = 0; k < n; k++) {
+                    double akp = a[k*n + p], akq = a[k*n + q];
+                    a[k*n + p] = c*akp - s*akq;
+                    a[k*n + q] = s*akp + c*akq;
+                }
+                for (int k = 0; k < n; k++) {
+                    double apk = a[p*n + k], aqk = a[q*n + k];
+                    a[p*n + k] = c*apk - s*aqk;
+                    a[q*n + k] = s*apk + c*aqk;
+                }
+                for (int k = 0; k < n; k++) {
+                    double vkp = v[k*n + p], vkq = v[k*n + q];
+                    v[k*n + p] = c*vkp - s*vkq;
+                    v[k*n + q] = s*vkp + c*vkq;
+                }
+            }
+        }
+    }
+
+    // Orden ascendente (selección; n es pequeño)
+    int order[LINALG_MAX_N];
+    for (int i = 0; i < n; i++) order[i] = i;
+    for (int i = 0; i < n; i++) {
+        int m = i;
+        for (int j = i + 1; j < n; j++)
+            if (a[order[j]*n + order[j]] < a[order[m]*n + order[m]]) m = j;
+        int t = order[i]; order[i] = order[m]; order[m] = t;
+    }
+    for (int k = 0; k < n; k++) {
+        evals[k] = a[order[k]*n + order[k]];
+        for (int i = 0; i < n; i++) evecs[i*n + k] = v[i*n + order[k]];
+    }
+}
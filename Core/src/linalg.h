@@ -0,0 +1,46 @@
+//================================================================//
+//           LINALG HEADER - Álgebra lineal densa pequeña         //
+//================================================================//
+//
+// Lo justo para ajustes y construcciones de cónicas: matrices 3x3 y
+// autovalores de matrices simétricas pequeñas (6x6 en los ajustes).
+// Matrices en orden por filas. Sin estado: seguras entre hilos.
+//
+
+#ifndef LINALG_H
+#define LINALG_H
+
+#include <stdbool.h>
+
+/**
+ * Inversa de una 3x3. Devuelve false si es (casi) singular.
+ */
+bool mat3_inverse(const double m[9], double out[9]);
+
+/**
+ * out = a·b para matrices 3x3 (out no debe solaparse con a ni b).
+ */
+void mat3_mul(const double a[9], const double b[9], double out[9]);
+
+/**
+ * Autovector (norma 1) de la 3x3 m asociado al autovalor lambda, como el
+ * mayor producto vectorial entre filas de m - lambda·I.
+ */
+void mat3_eigvec(const double m[9], double lambda, double v[3]);
+
+/**
+ * Vector nulo del sistema homogéneo 5x6 M·a = 0 por eliminación con
+ * pivoteo total (M se destruye); la columna que queda libre vale 1.
+ * Devuelve la razón |pivote mínimo| / |pivote máximo| (0 si el rango
+ * es menor que 5): una medida barata del condicionamiento.
+ */
+double linalg_null5x6(double M[5][6], double a[6]);
+
+/**
+ * Autovalores y autovectores de la simétrica n x n a (se destruye) por
+ * Jacobi cíclico. evals en orden ascendente; la columna k de evecs es el
+ * autovector de evals[k]. n <= 8.
+ */
+void linalg_sym_eigen(double* a, int n, double* evals, double* evecs);
+
+#endif
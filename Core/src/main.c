@@ -18,12 +18,36 @@
 //--------------------------------//
 // Includes y dependencias
 //--------------------------------//
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
 
+#include "arrangement.h"
+#include "bezier.h"
+#include "budget.h"
 #include "conics.h"
+#include "construct.h"
+#include "distance.h"
+#include "export.h"
+#include "fit.h"
+#include "ccol.h"
+#include "intersect.h"
+#include "morph.h"
+#include "phase.h"
+#include "polyline.h"
+#include "ransac.h"
+#include "raster.h"
+#include "spatial.h"
+#include "threadpool.h"
+#include "tiles.h"
+#include "utils.h"
+#include "vertices.h"
+#include "vision.h"
 #include "cjson/cJSON.h"
 
 //-------------------------------------------//
@@ -68,21 +92,2672 @@ static const char* conic_type_str(ConicType t) {
     }
 }
 
+/**
+ * @brief Lee un string de un objeto JSON (NULL si no existe).
+ */
+static const char* json_string(const cJSON* obj, const char* key) {
+    const cJSON* item = cJSON_GetObjectItem(obj, key);
+    return cJSON_IsString(item) ? item->valuestring : NULL;
+}
+
+/**
+ * @brief Extrae los coeficientes A..F de un objeto JSON.
+ * @param obj Objeto con claves "A".."F".
+ * @param c Array de salida [A, B, C, D, E, F].
+ * @return false si falta algún coeficiente o no es numérico.
+ */
+static bool read_coeffs(const cJSON* obj, double c[6]) {
+    static const char* keys[6] = { "A", "B", "C", "D", "E", "F" };
+    for (int i = 0; i < 6; i++) {
+        const cJSON* item = cJSON_GetObjectItem(obj, keys[i]);
+        if (!cJSON_IsNumber(item)) return false;
+        c[i] = item->valuedouble;
+    }
+    return true;
+}
+
+/**
+ * @brief Lee un número de un objeto JSON con valor por defecto.
+ * @param obj Objeto JSON (puede ser NULL).
+ * @param key Clave a buscar.
+ * @param def Valor devuelto si la clave no existe o no es numérica.
+ */
+static double json_number(const cJSON* obj, const char* key, double def) {
+    const cJSON* item = cJSON_GetObjectItem(obj, key);
+    return cJSON_IsNumber(item) ? item->valuedouble : def;
+}
+
+/**
+ * @brief Convierte "A".."F" en ConicCoef.
+ * @return false si el nombre no es un coeficiente.
+ */
+static bool parse_coef(const char* name, ConicCoef* out) {
+    if (!name || name[0] < 'A' || name[0] > 'F' || name[1] != '\0') return false;
+    *out = (ConicCoef)(name[0] - 'A');
+    return true;
+}
+
+/**
+ * true si un modo ya escribió su salida binaria en stdout: en ese caso
+ * main no imprime el JSON (el flujo debe quedar solo con el binario).
+ */
+static bool stdout_taken = false;
+
+/**
+ * true en el modo residente (--serve): stdout es el canal NDJSON de
+ * todas las peticiones, así que ningún modo puede volcar binarios en él.
+ */
+static bool serving = false;
+
+// Las líneas de peticiones concurrentes no se mezclan
+static pthread_mutex_t out_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// "id" de la petición que atiende este hilo en --serve (NULL si no hay)
+static _Thread_local const cJSON* tls_request_id = NULL;
+
+/**
+ * @brief true si la salida binaria debe ir cruda por stdout.
+ */
+static bool wants_stdout(const cJSON* root) {
+    return !serving && cJSON_IsTrue(cJSON_GetObjectItem(root, "stdout"));
+}
+
+/**
+ * @brief Entrega una salida binaria: en crudo por stdout si la petición
+ *        trae "stdout": true, a fichero si trae "output", o incrustada en
+ *        base64 bajo la clave key.
+ * @return NULL si todo va bien o un código de error.
+ */
+static const char* emit_blob(const cJSON* root, cJSON* out, const char* key, const ByteBuf* b) {
+    const char* path = json_string(root, "output");
+    if (wants_stdout(root)) {
+        if (fwrite(b->data, 1, b->len, stdout) != b->len) return "stdout_write_failed";
+        fflush(stdout);
+        stdout_taken = true;
+    } else if (path) {
+        FILE* fp = fopen(path, "wb");
+        if (!fp) return "output_open_failed";
+        size_t w = fwrite(b->data, 1, b->len, fp);
+        if (fclose(fp) != 0 || w != b->len) return "output_write_failed";
+        cJSON_AddStringToObject(out, "output", path);
+    } else {
+        char* enc = base64_encode(b->data, b->len);
+        if (!enc) return "out_of_memory";
+        cJSON_AddStringToObject(out, key, enc);
+        free(enc);
+    }
+    cJSON_AddNumberToObject(out, "bytes", (double)b->len);
+    return NULL;
+}
+
+//-------------------------------------------//
+//                   MODOS                   //
+//-------------------------------------------//
+
+/**
+ * Un modo recibe la petición JSON y rellena el objeto de salida.
+ * Devuelve NULL si todo va bien o un código de error corto.
+ */
+typedef const char* (*ModeHandler)(const cJSON* root, cJSON* out);
+
+/**
+ * @brief Vuelca un ConicResult al objeto JSON de salida.
+ * @details Formato consumido por server.py y ConicAnalysis.tsx.
+ */
+static void conic_to_json(const ConicResult* r, cJSON* out) {
+    /* coeficientes */
+    cJSON* coeffs = cJSON_AddObjectToObject(out, "coefficients");
+    cJSON_AddNumberToObject(coeffs, "A", r->A);
+    cJSON_AddNumberToObject(coeffs, "B", r->B);
+    cJSON_AddNumberToObject(coeffs, "C", r->C);
+    cJSON_AddNumberToObject(coeffs, "D", r->D);
+    cJSON_AddNumberToObject(coeffs, "E", r->E);
+    cJSON_AddNumberToObject(coeffs, "F", r->F);
+
+    /* clasificación */
+    cJSON_AddStringToObject(out, "type", conic_type_str(r->type));
+    cJSON_AddNumberToObject(out, "delta", r->delta);
+
+    /* centro */
+    cJSON* center = cJSON_AddObjectToObject(out, "center");
+    cJSON_AddBoolToObject(center, "exists", r->has_center);
+    if (r->has_center) {
+        cJSON_AddNumberToObject(center, "x", r->cx);
+        cJSON_AddNumberToObject(center, "y", r->cy);
+    }
+
+    /* rotación */
+    cJSON* rotation = cJSON_AddObjectToObject(out, "rotation");
+    cJSON_AddBoolToObject(rotation, "has_rotation", r->has_rotation);
+    cJSON_AddNumberToObject(rotation, "theta", r->theta);
+
+    /* parámetros canónicos (para render analítico React) */
+    cJSON* canonical = cJSON_CreateObject();
+    cJSON_AddBoolToObject(canonical, "exists", r->has_canonical);
+    if (r->has_canonical) {
+        cJSON_AddNumberToObject(canonical, "a", r->a);
+        cJSON_AddNumberToObject(canonical, "b", r->b);
+    }
+    cJSON_AddItemToObject(out, "canonical", canonical);
+
+    /* puntos muestreados (fallback React) */
+    cJSON* pts = cJSON_AddArrayToObject(out, "points");
+    for (int i = 0; i < r->point_count; i++) {
+        cJSON* p = cJSON_CreateObject();
+        cJSON_AddNumberToObject(p, "x", r->points[i].x);
+        cJSON_AddNumberToObject(p, "y", r->points[i].y);
+        cJSON_AddItemToArray(pts, p);
+    }
+}
+
+/**
+ * @brief Reconstruye un ConicResult desde la salida de conic_to_json.
+ * @details Es la caché del modo "update": el cliente devuelve la última
+ *          respuesta y no hace falta volver a analizar la cónica.
+ * @return false si falta algún campo o no es válido.
+ */
+static bool conic_from_json(const cJSON* in, ConicResult* r) {
+    memset(r, 0, sizeof(*r));
+
+    double c[6];
+    if (!read_coeffs(cJSON_GetObjectItem(in, "coefficients"), c)) return false;
+    r->A = c[0]; r->B = c[1]; r->C = c[2];
+    r->D = c[3]; r->E = c[4]; r->F = c[5];
+
+    const char* type = json_string(in, "type");
+    int t = 0;
+    while (t <= CONIC_DEGENERATE && !(type && strcmp(type, conic_type_str((ConicType)t)) == 0)) t++;
+    if (t > CONIC_DEGENERATE) return false;
+    r->type = (ConicType)t;
+
+    const cJSON* delta = cJSON_GetObjectItem(in, "delta");
+    if (!cJSON_IsNumber(delta)) return false;
+    r->delta = delta->valuedouble;
+
+    const cJSON* center = cJSON_GetObjectItem(in, "center");
+    r->has_center = cJSON_IsTrue(cJSON_GetObjectItem(center, "exists"));
+    r->cx = json_number(center, "x", 0.0);
+    r->cy = json_number(center, "y", 0.0);
+
+    const cJSON* rotation = cJSON_GetObjectItem(in, "rotation");
+    r->has_rotation = cJSON_IsTrue(cJSON_GetObjectItem(rotation, "has_rotation"));
+    r->theta = json_number(rotation, "theta", 0.0);
+
+    const cJSON* canonical = cJSON_GetObjectItem(in, "canonical");
+    r->has_canonical = cJSON_IsTrue(cJSON_GetObjectItem(canonical, "exists"));
+    r->a = json_number(canonical, "a", 0.0);
+    r->b = json_number(canonical, "b", 0.0);
+
+    // "points" es opcional: sin él, analyze_conic_update vuelve a muestrear
+    const cJSON* pts = cJSON_GetObjectItem(in, "points");
+    if (!pts) return true;
+    if (!cJSON_IsArray(pts) || cJSON_GetArraySize(pts) > MAX_POINTS) return false;
+    const cJSON* p;
+    cJSON_ArrayForEach(p, pts) {
+        const cJSON* x = cJSON_GetObjectItem(p, "x");
+        const cJSON* y = cJSON_GetObjectItem(p, "y");
+        if (!cJSON_IsNumber(x) || !cJSON_IsNumber(y)) return false;
+        r->points[r->point_count].x = x->valuedouble;
+        r->points[r->point_count].y = y->valuedouble;
+        r->point_count++;
+    }
+    return true;
+}
+
+/**
+ * @brief Carga una tabla de cónicas (6 coeficientes por fila).
+ * @param root JSON con "input" (fichero CCOL) o "conics" (array de {A..F}).
+ * @param n Número de cónicas leídas.
+ * @param out Tabla reservada con malloc (el llamador la libera).
+ * @return NULL o el código de error.
+ */
+static const char* load_conic_table(const cJSON* root, double** out, size_t* n) {
+    *out = NULL;
+    *n = 0;
+
+    const char* in_path = json_string(root, "input");
+    if (in_path) {
+        CcolFile in;
+        CcolStatus st = ccol_open(in_path, &in);
+        if (st != CCOL_OK) return ccol_status_str(st);
+
+        double* c = malloc((in.rows ? in.rows : 1) * 6 * sizeof(double));
+        if (!c) {
+            ccol_close(&in);
+            return "out_of_memory";
+        }
+        for (size_t i = 0; i < in.rows; i++) {
+            c[6*i + 0] = in.A[i]; c[6*i + 1] = in.B[i]; c[6*i + 2] = in.C[i];
+            c[6*i + 3] = in.D[i]; c[6*i + 4] = in.E[i]; c[6*i + 5] = in.F[i];
+        }
+        *n = in.rows;
+        *out = c;
+        ccol_close(&in);
+        return NULL;
+    }
+
+    const cJSON* conics = cJSON_GetObjectItem(root, "conics");
+    if (!cJSON_IsArray(conics)) return "missing_conics";
+
+    size_t count = (size_t)cJSON_GetArraySize(conics);
+    double* c = malloc((count ? count : 1) * 6 * sizeof(double));
+    if (!c) return "out_of_memory";
+
+    size_t i = 0;
+    const cJSON* item;
+    cJSON_ArrayForEach(item, conics) {
+        if (!read_coeffs(item, c + 6 * i++)) {
+            free(c);
+            return "missing_coefficients";
+        }
+    }
+    *n = count;
+    *out = c;
+    return NULL;
+}
+
+/**
+ * @brief Carga una nube de puntos en columnas xs / ys.
+ * @param root JSON con "points_file" (float64 x, y intercalados, binario)
+ *        o "points" (array de [x, y]).
+ * @return NULL o el código de error. xs e ys se reservan en un único
+ *         bloque que empieza en *xs (el llamador libera solo *xs).
+ */
+static const char* load_points(const cJSON* root, double** xs, double** ys, size_t* n) {
+    *xs = *ys = NULL;
+    *n = 0;
+
+    const char* path = json_string(root, "points_file");
+    if (path) {
+        FILE* fp = fopen(path, "rb");
+        if (!fp) return "points_open_failed";
+        if (fseek(fp, 0, SEEK_END) != 0) {
+            fclose(fp);
+            return "points_read_failed";
+        }
+        long size = ftell(fp);
+        rewind(fp);
+        if (size < 0 || size % (2 * sizeof(double)) != 0) {
+            fclose(fp);
+            return "points_invalid_size";
+        }
+
+        size_t count = (size_t)size / (2 * sizeof(double));
+        double* raw = malloc((count ? count : 1) * 2 * sizeof(double));
+        double* cols = malloc((count ? count : 1) * 2 * sizeof(double));
+        if (!raw || !cols || fread(raw, 2 * sizeof(double), count, fp) != count) {
+            fclose(fp);
+            free(raw);
+            free(cols);
+            return raw && cols ? "points_read_failed" : "out_of_memory";
+        }
+        fclose(fp);
+
+        // Intercalado -> columnas
+        for (size_t i = 0; i < count; i++) {
+            cols[i] = raw[2 * i];
+            cols[count + i] = raw[2 * i + 1];
+        }
+        free(raw);
+        *xs = cols;
+        *ys = cols + count;
+        *n = count;
+        return NULL;
+    }
+
+    const cJSON* pts = cJSON_GetObjectItem(root, "points");
+    if (!cJSON_IsArray(pts)) return "missing_points";
+
+    size_t count = (size_t)cJSON_GetArraySize(pts);
+    double* cols = malloc((count ? count : 1) * 2 * sizeof(double));
+    if (!cols) return "out_of_memory";
+
+    size_t i = 0;
+    const cJSON* item;
+    cJSON_ArrayForEach(item, pts) {
+        const cJSON* x = cJSON_GetArrayItem(item, 0);
+        const cJSON* y = cJSON_GetArrayItem(item, 1);
+        if (!cJSON_IsNumber(x) || !cJSON_IsNumber(y)) {
+            free(cols);
+            return "invalid_points";
+        }
+        cols[i] = x->valuedouble;
+        cols[count + i] = y->valuedouble;
+        i++;
+    }
+    *xs = cols;
+    *ys = cols + count;
+    *n = count;
+    return NULL;
+}
+
+/**
+ * @brief Lee "window":[x_min, y_min, x_max, y_max] (por defecto la
+ *        ventana de muestreo [-10, 10]²).
+ */
+static bool read_window(const cJSON* root, double w[4]) {
+    static const double def[4] = { -10.0, -10.0, 10.0, 10.0 };
+    const cJSON* arr = cJSON_GetObjectItem(root, "window");
+    for (int i = 0; i < 4; i++) {
+        const cJSON* item = cJSON_GetArrayItem(arr, i);
+        w[i] = cJSON_IsNumber(item) ? item->valuedouble : def[i];
+    }
+    return w[0] < w[2] && w[1] < w[3];
+}
+
+/**
+ * @brief Ventana de la petición o, si no trae "window", un cuadrado que
+ *        encuadra la cónica c.
+ * @details El cuadrado se centra en el centro de la cónica (o, sin centro,
+ *          en su punto más cercano al origen) con semilado igual a
+ *          max(10, 2·semieje mayor). Una cónica lejos del origen sigue
+ *          saliendo entera sin que el cliente tenga que conocerla antes.
+ */
+static bool read_conic_window(const cJSON* root, const double c[6], double w[4]) {
+    if (cJSON_GetObjectItem(root, "window")) return read_window(root, w);
+
+    ConicFrame f;
+    conic_frame(c, &f);
+    double x = 0.0, y = 0.0, half = 10.0;
+    if (f.has_center) {
+        x = f.cx;
+        y = f.cy;
+        if (f.l1 != 0.0) half = fmax(half, 2.0 * sqrt(fabs(f.f0 / f.l1)));
+        if (f.l2 != 0.0) half = fmax(half, 2.0 * sqrt(fabs(f.f0 / f.l2)));
+    } else {
+        Point2D foot;
+        if (isfinite(conic_distance(c, 0.0, 0.0, &foot))) {
+            x = foot.x;
+            y = foot.y;
+        }
+    }
+    half = fmin(half, 1e6);
+
+    w[0] = x - half;
+    w[1] = y - half;
+    w[2] = x + half;
+    w[3] = y + half;
+    return isfinite(w[0]) && isfinite(w[1]) && w[0] < w[2] && w[1] < w[3];
+}
+
+/**
+ * @brief Añade las polilíneas de pl a out[key] como objetos
+ *        {"branch", "closed", "points":[x0, y0, x1, y1, ...]}.
+ */
+static void polylines_to_json(const Polylines* pl, cJSON* out, const char* key) {
+    cJSON* arr = cJSON_AddArrayToObject(out, key);
+    for (size_t k = 0; k < pl->count; k++) {
+        uint32_t a = pl->offsets[k], b = pl->offsets[k + 1];
+        cJSON* item = cJSON_CreateObject();
+        cJSON_AddNumberToObject(item, "branch", pl->branch[k]);
+        cJSON_AddBoolToObject(item, "closed", pl->closed[k]);
+        cJSON_AddItemToObject(item, "points",
+                              cJSON_CreateDoubleArray(pl->xy + 2 * a, (int)(2 * (b - a))));
+        cJSON_AddItemToArray(arr, item);
+    }
+}
+
+/**
+ * @brief Lee "samples", "simplify", "tolerance" (píxeles), "width" y
+ *        "height" (lienzo que muestra window) para las polilíneas.
+ */
+static const char* read_polyline_params(const cJSON* root, const double window[4],
+                                        PolylineParams* p) {
+    *p = polyline_default_params();
+    p->samples = (uint32_t)fmax(2.0, fmin(json_number(root, "samples", p->samples), 1 << 20));
+    const char* method = json_string(root, "simplify");
+    if (method && !simplify_parse_method(method, &p->method)) return "invalid_simplify";
+    p->tolerance = polyline_pixel_tolerance(window, json_number(root, "width", 1000.0),
+                                            json_number(root, "height", 1000.0),
+                                            json_number(root, "tolerance", 0.5));
+    return NULL;
+}
+
+/**
+ * @brief Modo "conic": análisis completo de una cónica (modo por defecto).
+ * @details Además del análisis devuelve "segments": las polilíneas de
+ *          cada rama recortadas a "window" (ver read_polyline_params) y la
+ *          ventana usada, que sin "window" encuadra la cónica (ver
+ *          read_conic_window).
+ */
+static const char* run_conic(const cJSON* root, cJSON* out) {
+    /* extraer coeficientes */
+    double c[6];
+    if (!read_coeffs(root, c)) return "missing_coefficients";
+
+    /* análisis matemático */
+    ConicResult r = analyze_conic(c[0], c[1], c[2], c[3], c[4], c[5]);
+
+    conic_to_json(&r, out);
+
+    /* polilíneas por rama, en orden de dibujo (render sin reordenar) */
+    double window[4];
+    if (!read_conic_window(root, c, window)) return "invalid_window";
+    cJSON_AddItemToObject(out, "window", cJSON_CreateDoubleArray(window, 4));
+
+    PolylineParams p;
+    const char* err = read_polyline_params(root, window, &p);
+    if (err) return err;
+
+    Polylines pl;
+    if (!polyline_build(c, window, &p, &pl)) return "out_of_memory";
+    polylines_to_json(&pl, out, "segments");
+    polyline_free(&pl);
+    return NULL;
+}
+
+/**
+ * @brief Escribe frame como una línea NDJSON en stdout, la vacía al
+ *        momento (el cliente la ve ya) y la libera. En --serve le añade
+ *        el "id" de la petición del hilo.
+ */
+static void emit_frame(cJSON* frame) {
+    if (tls_request_id) cJSON_AddItemToObject(frame, "id", cJSON_Duplicate(tls_request_id, true));
+    char* line = cJSON_PrintUnformatted(frame);
+    if (line) {
+        pthread_mutex_lock(&out_lock);
+        fputs(line, stdout);
+        fputc('\n', stdout);
+        fflush(stdout);
+        pthread_mutex_unlock(&out_lock);
+        free(line);
+    }
+    cJSON_Delete(frame);
+}
+
+/**
+ * @brief Mayor distancia a la cónica de los puntos medios de las cuerdas
+ *        de pl: la desviación cuerda–curva que ve el cliente.
+ */
+static double polyline_deviation(const double c[6], const Polylines* pl) {
+    DistanceConic d;
+    distance_prepare(c, &d);
+    double worst = 0.0;
+    for (size_t k = 0; k < pl->count; k++) {
+        for (uint32_t i = pl->offsets[k]; i + 1 < pl->offsets[k + 1]; i++) {
+            const double* a = pl->xy + 2 * (size_t)i;
+            double e = distance_point(&d, 0.5 * (a[0] + a[2]), 0.5 * (a[1] + a[3]), NULL);
+            if (isfinite(e) && e > worst) worst = e;
+        }
+    }
+    return worst;
+}
+
+/**
+ * @brief Modo "progressive": el resultado de "conic" por fotogramas.
+ * @details Misma entrada que "conic". Cada fotograma es una línea JSON
+ *          con "frame", "seq" y "t_ms" (desde el inicio de la petición):
+ *
+ *            invariants  tipo, Δ, centro, rotación y forma canónica, sin
+ *                        muestrear (analyze_conic_columns): microsegundos.
+ *            coarse      polilíneas con "coarse_samples" muestras por
+ *                        tramo (32 por defecto).
+ *            refine      las mismas polilíneas con el doble de muestras
+ *                        cada vez; la última lleva "final":true.
+ *
+ *          Todas se simplifican a la misma tolerancia: lo que mejora es
+ *          el error de cuerda, que cae con el cuadrado de las muestras.
+ *          Cada fotograma de polilíneas sustituye al anterior y lleva en
+ *          "deviation" la mayor distancia de un punto medio de cuerda a
+ *          la curva; el refinamiento para en cuanto no supera
+ *          "tolerance" (en unidades del plano, ver read_polyline_params)
+ *          o al llegar a "samples", que es el tope.
+ *
+ *          La última línea es la respuesta normal
+ *          {"ok":true,"frame":"done",...}; con "budget_ms" y
+ *          "truncated":true, el último fotograma recibido es el
+ *          resultado.
+ */
+static const char* run_progressive(const cJSON* root, cJSON* out) {
+    double t0 = now_ms();
+    double c[6];
+    if (!read_coeffs(root, c)) return "missing_coefficients";
+
+    double window[4];
+    if (!read_conic_window(root, c, window)) return "invalid_window";
+    PolylineParams p;
+    const char* err = read_polyline_params(root, window, &p);
+    if (err) return err;
+
+    // 1. Invariantes: el análisis por columnas no muestrea puntos
+    ConicCoeffColumns in = { &c[0], &c[1], &c[2], &c[3], &c[4], &c[5] };
+    int32_t type;
+    uint32_t flags;
+    double delta, cx, cy, theta, a, b;
+    ConicResultColumns res = { &type, &flags, &delta, &cx, &cy, &theta, &a, &b };
+    analyze_conic_columns(&in, &res, 0, 1);
+
+    ConicResult r;
+    memset(&r, 0, sizeof(r));
+    r.A = c[0]; r.B = c[1]; r.C = c[2]; r.D = c[3]; r.E = c[4]; r.F = c[5];
+    r.type = (ConicType)type;
+    r.delta = delta;
+    r.has_center = (flags & CONIC_FLAG_CENTER) != 0;
+    r.has_rotation = (flags & CONIC_FLAG_ROTATION) != 0;
+    r.has_canonical = (flags & CONIC_FLAG_CANONICAL) != 0;
+    r.cx = cx; r.cy = cy; r.theta = theta; r.a = a; r.b = b;
+
+    int seq = 0;
+    cJSON* frame = cJSON_CreateObject();
+    cJSON_AddStringToObject(frame, "frame", "invariants");
+    cJSON_AddNumberToObject(frame, "seq", seq++);
+    conic_to_json(&r, frame);
+    cJSON_DeleteItemFromObject(frame, "points");
+    cJSON_AddItemToObject(frame, "window", cJSON_CreateDoubleArray(window, 4));
+    cJSON_AddNumberToObject(frame, "t_ms", now_ms() - t0);
+    emit_frame(frame);
+
+    // 2. y 3. Polilíneas con el doble de muestras en cada fotograma
+    const uint32_t target = p.samples;
+    uint32_t samples = (uint32_t)fmax(2.0, fmin(json_number(root, "coarse_samples", 32.0), target));
+    for (;;) {
+        p.samples = samples;
+        Polylines pl;
+        if (!polyline_build(c, window, &p, &pl)) return "out_of_memory";
+
+        // Vencido el plazo (budget.h) este muestreo pudo degradarse: si ya
+        // hay un fotograma de polilíneas, ese se queda como resultado
+        bool expired = budget_exhausted();
+        if (expired && seq > 1) {
+            polyline_free(&pl);
+            break;
+        }
+        double deviation = polyline_deviation(c, &pl);
+        bool last = samples >= target || expired || deviation <= p.tolerance;
+        frame = cJSON_CreateObject();
+        cJSON_AddStringToObject(frame, "frame", seq == 1 ? "coarse" : "refine");
+        cJSON_AddNumberToObject(frame, "seq", seq++);
+        cJSON_AddNumberToObject(frame, "samples", samples);
+        cJSON_AddNumberToObject(frame, "deviation", deviation);
+        cJSON_AddBoolToObject(frame, "final", last);
+        polylines_to_json(&pl, frame, "segments");
+        polyline_free(&pl);
+        cJSON_AddNumberToObject(frame, "t_ms", now_ms() - t0);
+        emit_frame(frame);
+
+        if (last) break;
+        samples = samples > target / 2 ? target : 2 * samples;
+    }
+
+    cJSON_AddStringToObject(out, "frame", "done");
+    cJSON_AddNumberToObject(out, "seq", seq);
+    cJSON_AddNumberToObject(out, "frames", seq);
+    return NULL;
+}
+
+/**
+ * @brief Modo "update": re-análisis incremental de un solo coeficiente.
+ * @details Entrada: {"mode":"update","previous":{...},"coef":"F",
+ *          "delta":0.5}, con "previous" la última respuesta de "conic" o
+ *          "update" (sin "points" basta: solo se pierde la deformación del
+ *          muestreo). Se reutilizan su clasificación, invariantes y puntos,
+ *          y analyze_conic_update recalcula solo lo que depende del
+ *          coeficiente cambiado. Sin "previous" se acepta "coefficients":
+ *          {A..F} y la cónica previa se analiza entera ("cached": false).
+ *          "sampling_reused" indica si los puntos se deformaron en lugar
+ *          de volver a muestrearse.
+ */
+static const char* run_update(const cJSON* root, cJSON* out) {
+    ConicCoef coef;
+    if (!parse_coef(json_string(root, "coef"), &coef)) return "invalid_coef";
+
+    ConicResult r;
+    const cJSON* previous = cJSON_GetObjectItem(root, "previous");
+    bool cached = previous != NULL;
+    if (cached) {
+        if (!conic_from_json(previous, &r)) return "invalid_previous";
+    } else {
+        double c[6];
+        if (!read_coeffs(cJSON_GetObjectItem(root, "coefficients"), c)) return "missing_coefficients";
+        r = analyze_conic(c[0], c[1], c[2], c[3], c[4], c[5]);
+    }
+
+    double t0 = now_ms();
+    bool reused = analyze_conic_update(&r, coef, json_number(root, "delta", 0.0));
+    double update_ms = now_ms() - t0;
+
+    conic_to_json(&r, out);
+    cJSON_AddBoolToObject(out, "cached", cached);
+    cJSON_AddBoolToObject(out, "sampling_reused", reused);
+    cJSON_AddNumberToObject(out, "update_ms", update_ms);
+    return NULL;
+}
+
+/**
+ * @brief Modo "pack": convierte una lista JSON de cónicas a un fichero CCOL.
+ * @details Entrada: {"mode":"pack","output":"f.ccol","conics":[{A..F},...]}.
+ */
+static const char* run_pack(const cJSON* root, cJSON* out) {
+    const char* path = json_string(root, "output");
+    const cJSON* list = cJSON_GetObjectItem(root, "conics");
+    if (!path) return "missing_output";
+    if (!cJSON_IsArray(list)) return "missing_conics";
+
+    size_t n = (size_t)cJSON_GetArraySize(list);
+    double* cols = malloc((n ? n : 1) * 6 * sizeof(double));
+    if (!cols) return "out_of_memory";
+
+    size_t i = 0;
+    const cJSON* item;
+    cJSON_ArrayForEach(item, list) {
+        double c[6];
+        if (!read_coeffs(item, c)) {
+            free(cols);
+            return "missing_coefficients";
+        }
+        for (int k = 0; k < 6; k++) cols[k * n + i] = c[k];
+        i++;
+    }
+
+    CcolFile f;
+    memset(&f, 0, sizeof(f));
+    f.rows = n;
+    f.A = cols;         f.B = cols + n;     f.C = cols + 2 * n;
+    f.D = cols + 3 * n; f.E = cols + 4 * n; f.F = cols + 5 * n;
+
+    CcolStatus st = ccol_write(path, &f);
+    free(cols);
+    if (st != CCOL_OK) return ccol_status_str(st);
+
+    cJSON_AddStringToObject(out, "output", path);
+    cJSON_AddNumberToObject(out, "rows", (double)n);
+    return NULL;
+}
+
+/**
+ * Trabajo paralelo de análisis por columnas.
+ */
+typedef struct {
+    ConicCoeffColumns  in;
+    ConicResultColumns out;
+} ColumnsJob;
+
+static void columns_range(size_t begin, size_t end, void* ctx) {
+    ColumnsJob* job = ctx;
+    analyze_conic_columns(&job->in, &job->out, begin, end);
+}
+
+/**
+ * Trabajo paralelo de muestreo: cada bloque de filas rellena su propio
+ * buffer de puntos, que luego se concatena en orden.
+ */
+#define SAMPLE_CHUNK_ROWS 256
+
+typedef struct {
+    const CcolFile* in;
+    uint32_t*  counts;   // puntos por fila
+    Point2D**  bufs;     // buffer por bloque (NULL si falla la reserva)
+    atomic_size_t skipped; // filas sin muestrear por falta de tiempo
+} SampleJob;
+
+static void sample_range(size_t begin, size_t end, void* ctx) {
+    SampleJob* job = ctx;
+    const CcolFile* in = job->in;
+
+    for (size_t c = begin; c < end; c++) {
+        size_t r0 = c * SAMPLE_CHUNK_ROWS;
+        size_t r1 = r0 + SAMPLE_CHUNK_ROWS < in->rows ? r0 + SAMPLE_CHUNK_ROWS : in->rows;
+
+        Point2D* buf = malloc((r1 - r0) * MAX_POINTS * sizeof(Point2D));
+        size_t used = 0;
+        if (!buf) memset(job->counts + r0, 0, (r1 - r0) * sizeof(uint32_t));
+        for (size_t i = r0; i < r1 && buf; i++) {
+            if (budget_exhausted()) {
+                job->counts[i] = 0;
+                atomic_fetch_add(&job->skipped, 1);
+                continue;
+            }
+            ConicResult r = analyze_conic(in->A[i], in->B[i], in->C[i], in->D[i], in->E[i], in->F[i]);
+            memcpy(buf + used, r.points, (size_t)r.point_count * sizeof(Point2D));
+            job->counts[i] = (uint32_t)r.point_count;
+            used += (size_t)r.point_count;
+        }
+
+        // Recortar al tamaño real para no retener MAX_POINTS por fila
+        if (buf && used > 0) {
+            Point2D* shrunk = realloc(buf, used * sizeof(Point2D));
+            if (shrunk) buf = shrunk;
+        }
+        job->bufs[c] = buf;
+    }
+}
+
+/**
+ * @brief Modo "batch": analiza todas las filas de un fichero CCOL.
+ * @details Entrada: {"mode":"batch","input":"in.ccol","output":"out.ccol",
+ *          "points":false}. Las columnas de coeficientes se leen directamente
+ *          del mapeo y se reparten entre los hilos del pool; la salida añade
+ *          las columnas de resultados y, si se pide, el bloque de puntos.
+ */
+static const char* run_batch(const cJSON* root, cJSON* out) {
+    const char* in_path = json_string(root, "input");
+    const char* out_path = json_string(root, "output");
+    bool with_points = cJSON_IsTrue(cJSON_GetObjectItem(root, "points"));
+    if (!in_path) return "missing_input";
+
+    CcolFile in;
+    CcolStatus st = ccol_open(in_path, &in);
+    if (st != CCOL_OK) return ccol_status_str(st);
+
+    size_t n = in.rows;
+    size_t cap = n ? n : 1;
+
+    // Columnas alineadas igual que en disco (múltiplos de CCOL_ALIGN)
+    size_t dbytes = ((cap * sizeof(double) + CCOL_ALIGN - 1) / CCOL_ALIGN) * CCOL_ALIGN;
+    size_t ibytes = ((cap * sizeof(int32_t) + CCOL_ALIGN - 1) / CCOL_ALIGN) * CCOL_ALIGN;
+    double* dcols = aligned_alloc(CCOL_ALIGN, dbytes * 6);
+    int32_t* type = aligned_alloc(CCOL_ALIGN, ibytes);
+    uint32_t* flags = aligned_alloc(CCOL_ALIGN, ibytes);
+    if (!dcols || !type || !flags) {
+        free(dcols); free(type); free(flags);
+        ccol_close(&in);
+        return "out_of_memory";
+    }
+
+    size_t stride = dbytes / sizeof(double);
+    ColumnsJob job = {
+        { in.A, in.B, in.C, in.D, in.E, in.F },
+        {
+            type, flags,
+            dcols, dcols + stride, dcols + 2 * stride,
+            dcols + 3 * stride, dcols + 4 * stride, dcols + 5 * stride
+        }
+    };
+
+    tp_parallel_for(0, n, 4096, columns_range, &job);
+
+    // Bloque de puntos opcional
+    uint64_t* offsets = NULL;
+    Point2D* pts = NULL;
+    size_t total = 0, unsampled = 0;
+    const char* err = NULL;
+    if (with_points) {
+        size_t chunks = (n + SAMPLE_CHUNK_ROWS - 1) / SAMPLE_CHUNK_ROWS;
+        uint32_t* row_counts = malloc(cap * sizeof(uint32_t));
+        Point2D** bufs = calloc(chunks ? chunks : 1, sizeof(Point2D*));
+        offsets = malloc((n + 1) * sizeof(uint64_t));
+
+        if (row_counts && bufs && offsets) {
+            SampleJob sjob = { &in, row_counts, bufs, 0 };
+            atomic_init(&sjob.skipped, 0);
+            tp_parallel_for(0, chunks, 1, sample_range, &sjob);
+            unsampled = atomic_load(&sjob.skipped);
+
+            // Un bloque sin buffer deja la salida incompleta: ni se suma ni
+            // se reserva el bloque de puntos
+            bool sampled = true;
+            for (size_t c = 0; c < chunks; c++) sampled = sampled && bufs[c] != NULL;
+
+            for (size_t i = 0; sampled && i < n; i++) {
+                offsets[i] = total;
+                total += row_counts[i];
+            }
+            offsets[n] = total;
+
+            pts = sampled ? malloc((total ? total : 1) * sizeof(Point2D)) : NULL;
+            for (size_t c = 0; c < chunks && pts; c++) {
+                size_t r0 = c * SAMPLE_CHUNK_ROWS;
+                size_t r1 = r0 + SAMPLE_CHUNK_ROWS < n ? r0 + SAMPLE_CHUNK_ROWS : n;
+                memcpy(pts + offsets[r0], bufs[c], (size_t)(offsets[r1] - offsets[r0]) * sizeof(Point2D));
+            }
+        }
+
+        if (!row_counts || !bufs || !offsets || !pts) err = "out_of_memory";
+        for (size_t c = 0; bufs && c < chunks; c++) free(bufs[c]);
+        free(bufs);
+        free(row_counts);
+    }
+
+    /* resumen por tipo */
+    size_t counts[CONIC_DEGENERATE + 1] = {0};
+    for (size_t i = 0; i < n; i++) {
+        if (type[i] >= 0 && type[i] <= CONIC_DEGENERATE) counts[type[i]]++;
+    }
+
+    if (!err && out_path) {
+        CcolFile o = in;
+        o.type = type;             o.flags = flags;
+        o.delta = job.out.delta;   o.cx = job.out.cx;   o.cy = job.out.cy;
+        o.theta = job.out.theta;   o.a = job.out.a;     o.b = job.out.b;
+        o.point_offsets = offsets;
+        o.point_data = pts;
+        o.points = total;
+
+        st = ccol_write(out_path, &o);
+        if (st != CCOL_OK) err = ccol_status_str(st);
+    }
+
+    if (!err) {
+        cJSON_AddNumberToObject(out, "rows", (double)n);
+        cJSON_AddNumberToObject(out, "threads", tp_thread_count());
+        if (out_path) cJSON_AddStringToObject(out, "output", out_path);
+        if (with_points) cJSON_AddNumberToObject(out, "points", (double)total);
+        if (unsampled) cJSON_AddNumberToObject(out, "unsampled_rows", (double)unsampled);
+
+        cJSON* types = cJSON_AddObjectToObject(out, "types");
+        for (int t = 0; t <= CONIC_DEGENERATE; t++) {
+            cJSON_AddNumberToObject(types, conic_type_str((ConicType)t), (double)counts[t]);
+        }
+    }
+
+    free(dcols); free(type); free(flags);
+    free(offsets); free(pts);
+    ccol_close(&in);
+    return err;
+}
+
+/**
+ * @brief Modo "phase": diagrama de fases en el plano de dos coeficientes.
+ * @details Entrada:
+ *          {"mode":"phase","coefficients":{A..F},
+ *           "x":{"coef":"B","min":-5,"max":5},"y":{"coef":"F","min":-5,"max":5},
+ *           "width":512,"height":512,"map":"type|delta|det",
+ *           "format":"png|pgm|raw","output":"ruta opcional"}
+ *          Los coeficientes barridos ignoran su valor en "coefficients".
+ */
+static const char* run_phase(const cJSON* root, cJSON* out) {
+    PhaseParams p;
+    memset(&p, 0, sizeof(p));
+
+    if (!read_coeffs(cJSON_GetObjectItem(root, "coefficients"), p.coeffs)) {
+        return "missing_coefficients";
+    }
+
+    const cJSON* ax = cJSON_GetObjectItem(root, "x");
+    const cJSON* ay = cJSON_GetObjectItem(root, "y");
+    if (!parse_coef(json_string(ax, "coef"), &p.x_coef) ||
+        !parse_coef(json_string(ay, "coef"), &p.y_coef) ||
+        p.x_coef == p.y_coef) {
+        return "invalid_axes";
+    }
+
+    p.x_min = json_number(ax, "min", -5.0);
+    p.x_max = json_number(ax, "max", 5.0);
+    p.y_min = json_number(ay, "min", -5.0);
+    p.y_max = json_number(ay, "max", 5.0);
+    p.width = (int)json_number(root, "width", 512);
+    p.height = (int)json_number(root, "height", 512);
+    if (p.width <= 0 || p.height <= 0 || p.width > 16384 || p.height > 16384) {
+        return "invalid_size";
+    }
+
+    const char* map = json_string(root, "map");
+    const char* fmt = json_string(root, "format");
+    PhaseMap which = PHASE_MAP_TYPE;
+    if (map && strcmp(map, "delta") == 0) which = PHASE_MAP_DELTA;
+    else if (map && strcmp(map, "det") == 0) which = PHASE_MAP_DET;
+    PhaseFormat format = PHASE_FMT_PNG;
+    if (fmt && strcmp(fmt, "pgm") == 0) format = PHASE_FMT_PGM;
+    else if (fmt && strcmp(fmt, "raw") == 0) format = PHASE_FMT_RAW;
+
+    PhaseMaps m;
+    if (!phase_alloc(&m, p.width, p.height)) return "out_of_memory";
+
+    double t0 = now_ms();
+    phase_diagram(&p, &m);
+    double compute_ms = now_ms() - t0;
+
+    ByteBuf img;
+    buf_init(&img);
+    const char* err = NULL;
+    if (!phase_encode(&m, p.width, p.height, which, format, &img)) err = "out_of_memory";
+    if (!err) err = emit_blob(root, out, "image", &img);
+
+    if (!err) {
+        cJSON_AddNumberToObject(out, "width", p.width);
+        cJSON_AddNumberToObject(out, "height", p.height);
+        cJSON_AddNumberToObject(out, "threads", tp_thread_count());
+        cJSON_AddNumberToObject(out, "compute_ms", compute_ms);
+
+        cJSON* types = cJSON_AddObjectToObject(out, "types");
+        for (int t = 0; t <= CONIC_DEGENERATE; t++) {
+            cJSON_AddNumberToObject(types, conic_type_str((ConicType)t), (double)m.counts[t]);
+        }
+        if (m.skipped) cJSON_AddNumberToObject(out, "skipped_cells", (double)m.skipped);
+    }
+
+    buf_free(&img);
+    phase_free(&m);
+    return err;
+}
+
+/**
+ * @brief Modo "morph": todos los frames de la transición entre dos cónicas.
+ * @details Entrada: {"mode":"morph","from":{A..F},"to":{A..F},"frames":60,
+ *          "normalize":false}. Devuelve el buffer empaquetado descrito en
+ *          morph.h (base64 en "buffer", fichero en "output" o crudo por
+ *          stdout con "stdout": true).
+ */
+static const char* run_morph(const cJSON* root, cJSON* out) {
+    MorphParams p;
+    if (!read_coeffs(cJSON_GetObjectItem(root, "from"), p.from) ||
+        !read_coeffs(cJSON_GetObjectItem(root, "to"), p.to)) {
+        return "missing_coefficients";
+    }
+    p.frames = (int)json_number(root, "frames", 60);
+    p.normalize = cJSON_IsTrue(cJSON_GetObjectItem(root, "normalize"));
+    if (p.frames < 2 || p.frames > MORPH_MAX_FRAMES) return "invalid_frames";
+
+    ByteBuf buf;
+    buf_init(&buf);
+    const char* err = morph_generate(&p, &buf) ? NULL : "out_of_memory";
+    if (!err) err = emit_blob(root, out, "buffer", &buf);
+
+    if (!err) {
+        const MorphHeader* h = (const MorphHeader*)buf.data;
+        const MorphFrame* f = (const MorphFrame*)(h + 1);
+        size_t unsampled = 0;
+        for (uint32_t i = 0; i < h->frames; i++) unsampled += (f[i].flags & MORPH_FLAG_UNSAMPLED) != 0;
+
+        cJSON_AddNumberToObject(out, "frames", h->frames);
+        cJSON_AddNumberToObject(out, "points", h->total_points);
+        if (unsampled) cJSON_AddNumberToObject(out, "unsampled_frames", (double)unsampled);
+        cJSON_AddNumberToObject(out, "threads", tp_thread_count());
+    }
+
+    buf_free(&buf);
+    return err;
+}
+
+/**
+ * @brief Modo "intersect": puntos de corte entre pares de cónicas.
+ * @details Entrada: {"mode":"intersect","conics":[{A..F}, ...],
+ *          "pairs":[[0,1],[0,2],...]} (o "input" con un fichero CCOL). Sin "pairs" se intersectan todos
+ *          los pares distintos. Cada resultado lleva "points" con x, y y
+ *          multiplicidad (2 = tangencia) y "overlap" si las cónicas
+ *          comparten una componente.
+ */
+static const char* run_intersect(const cJSON* root, cJSON* out) {
+    double* coeffs;
+    size_t n;
+    const char* err = load_conic_table(root, &coeffs, &n);
+    if (err) return err;
+    if (n < 2) {
+        free(coeffs);
+        return "missing_conics";
+    }
+
+    const cJSON* pairs = cJSON_GetObjectItem(root, "pairs");
+    if (pairs && !cJSON_IsArray(pairs)) {
+        free(coeffs);
+        return "invalid_pairs";
+    }
+    size_t m = pairs ? (size_t)cJSON_GetArraySize(pairs) : n * (n - 1) / 2;
+
+    uint32_t* idx = malloc((m ? m : 1) * 2 * sizeof(uint32_t));
+    IntersectResult* res = malloc((m ? m : 1) * sizeof(IntersectResult));
+    if (!idx || !res) err = "out_of_memory";
+
+    const cJSON* item;
+    if (!err && pairs) {
+        size_t k = 0;
+        cJSON_ArrayForEach(item, pairs) {
+            const cJSON* a = cJSON_GetArrayItem(item, 0);
+            const cJSON* b = cJSON_GetArrayItem(item, 1);
+            if (!cJSON_IsNumber(a) || !cJSON_IsNumber(b) ||
+                a->valuedouble < 0 || b->valuedouble < 0 ||
+                (size_t)a->valuedouble >= n || (size_t)b->valuedouble >= n) {
+                err = "invalid_pairs";
+                break;
+            }
+            idx[2 * k] = (uint32_t)a->valuedouble;
+            idx[2 * k + 1] = (uint32_t)b->valuedouble;
+            k++;
+        }
+    } else if (!err) {
+        size_t k = 0;
+        for (size_t a = 0; a < n; a++) {
+            for (size_t b = a + 1; b < n; b++) {
+                idx[2 * k] = (uint32_t)a;
+                idx[2 * k + 1] = (uint32_t)b;
+                k++;
+            }
+        }
+    }
+
+    if (!err) {
+        double t0 = now_ms();
+        conic_intersect_batch(coeffs, idx, m, res);
+        double compute_ms = now_ms() - t0;
+
+        size_t skipped = 0;
+        cJSON* results = cJSON_AddArrayToObject(out, "intersections");
+        for (size_t k = 0; k < m; k++) {
+            cJSON* r = cJSON_CreateObject();
+            cJSON* ij = cJSON_AddArrayToObject(r, "pair");
+            cJSON_AddItemToArray(ij, cJSON_CreateNumber(idx[2 * k]));
+            cJSON_AddItemToArray(ij, cJSON_CreateNumber(idx[2 * k + 1]));
+            cJSON_AddBoolToObject(r, "overlap", res[k].overlap);
+            if (res[k].skipped) {
+                cJSON_AddBoolToObject(r, "skipped", true);
+                skipped++;
+            }
+
+            cJSON* pts = cJSON_AddArrayToObject(r, "points");
+            for (int p = 0; p < res[k].count; p++) {
+                cJSON* pt = cJSON_CreateObject();
+                cJSON_AddNumberToObject(pt, "x", res[k].points[p].x);
+                cJSON_AddNumberToObject(pt, "y", res[k].points[p].y);
+                cJSON_AddNumberToObject(pt, "multiplicity", res[k].points[p].multiplicity);
+                cJSON_AddItemToArray(pts, pt);
+            }
+            cJSON_AddItemToArray(results, r);
+        }
+        cJSON_AddNumberToObject(out, "pairs", (double)m);
+        if (skipped) cJSON_AddNumberToObject(out, "skipped_pairs", (double)skipped);
+        cJSON_AddNumberToObject(out, "threads", tp_thread_count());
+        cJSON_AddNumberToObject(out, "compute_ms", compute_ms);
+    }
+
+    free(coeffs);
+    free(idx);
+    free(res);
+    return err;
+}
+
+/**
+ * @brief Modo "arrangement": arreglo plano (vértices y aristas) de una escena.
+ * @details Entrada: {"mode":"arrangement","conics":[...] o "input":"f.ccol",
+ *          "window":[-10,-10,10,10],"summary":false}. Con "summary" solo
+ *          se devuelven los contadores. En las aristas, -1 en "from"/"to"
+ *          indica que la curva sale de la ventana (t0/t1 = null).
+ */
+static const char* run_arrangement(const cJSON* root, cJSON* out) {
+    double window[4];
+    if (!read_window(root, window)) return "invalid_window";
+
+    double* coeffs;
+    size_t n;
+    const char* err = load_conic_table(root, &coeffs, &n);
+    if (err) return err;
+
+    Arrangement arr;
+    double t0 = now_ms();
+    ArrStatus st = arrangement_build(coeffs, n, window, &arr);
+    double compute_ms = now_ms() - t0;
+    free(coeffs);
+    if (st != ARR_OK) return arrangement_status_str(st);
+
+    cJSON_AddNumberToObject(out, "conics", (double)n);
+    cJSON_AddNumberToObject(out, "visible", (double)arr.visible);
+    cJSON_AddNumberToObject(out, "candidate_pairs", (double)arr.candidate_pairs);
+    if (arr.skipped_pairs) cJSON_AddNumberToObject(out, "skipped_pairs", (double)arr.skipped_pairs);
+    cJSON_AddNumberToObject(out, "vertex_count", (double)arr.vertex_count);
+    cJSON_AddNumberToObject(out, "edge_count", (double)arr.edge_count);
+    cJSON_AddNumberToObject(out, "threads", tp_thread_count());
+    cJSON_AddNumberToObject(out, "compute_ms", compute_ms);
+
+    if (!cJSON_IsTrue(cJSON_GetObjectItem(root, "summary"))) {
+        cJSON* verts = cJSON_AddArrayToObject(out, "vertices");
+        for (size_t i = 0; i < arr.vertex_count; i++) {
+            const ArrVertex* v = &arr.vertices[i];
+            cJSON* o = cJSON_CreateObject();
+            cJSON_AddNumberToObject(o, "x", v->x);
+            cJSON_AddNumberToObject(o, "y", v->y);
+            cJSON_AddNumberToObject(o, "degree", v->degree);
+            cJSON_AddNumberToObject(o, "multiplicity", v->multiplicity);
+            cJSON_AddItemToArray(verts, o);
+        }
+
+        cJSON* edges = cJSON_AddArrayToObject(out, "edges");
+        for (size_t i = 0; i < arr.edge_count; i++) {
+            const ArrEdge* e = &arr.edges[i];
+            cJSON* o = cJSON_CreateObject();
+            cJSON_AddNumberToObject(o, "conic", e->conic);
+            cJSON_AddNumberToObject(o, "branch", e->branch);
+            cJSON_AddNumberToObject(o, "from", e->v0 == ARR_NONE ? -1.0 : (double)e->v0);
+            cJSON_AddNumberToObject(o, "to", e->v1 == ARR_NONE ? -1.0 : (double)e->v1);
+            cJSON_AddNumberToObject(o, "t0", e->t0);
+            cJSON_AddNumberToObject(o, "t1", e->t1);
+            cJSON_AddItemToArray(edges, o);
+        }
+    }
+
+    arrangement_free(&arr);
+    return NULL;
+}
+
+/**
+ * @brief Añade los segmentos [x0, y0, x1, y1, x2, y2, w] a out["segments"].
+ */
+static void segments_to_json(const RationalQuad* q, int n, cJSON* out) {
+    cJSON* arr = cJSON_AddArrayToObject(out, "segments");
+    for (int i = 0; i < n; i++) {
+        const double v[7] = { q[i].x0, q[i].y0, q[i].x1, q[i].y1, q[i].x2, q[i].y2, q[i].w };
+        cJSON_AddItemToArray(arr, cJSON_CreateDoubleArray(v, 7));
+    }
+}
+
+/**
+ * @brief Modo "bezier": cónicas recortadas como Bézier cuadráticas racionales.
+ * @details Entrada: {"mode":"bezier","A":..,"F":..,"window":[...]} para una
+ *          cónica o "conics"/"input" para un lote. Cada segmento es
+ *          [x0, y0, x1, y1, x2, y2, w]: extremos con peso 1 y control con
+ *          peso w (ver bezier.h). Una elipse completa son 4 segmentos.
+ */
+static const char* run_bezier(const cJSON* root, cJSON* out) {
+    double window[4];
+    if (!read_window(root, window)) return "invalid_window";
+
+    double c[6];
+    if (read_coeffs(root, c)) {
+        RationalQuad q[BEZIER_MAX_SEGMENTS];
+        int n = conic_to_bezier(c, window, q);
+        ConicFrame f;
+        conic_frame(c, &f);
+        cJSON_AddStringToObject(out, "type", conic_type_str(f.type));
+        segments_to_json(q, n, out);
+        return NULL;
+    }
+
+    double* coeffs;
+    size_t n;
+    const char* err = load_conic_table(root, &coeffs, &n);
+    if (err) return err;
+
+    RationalQuad* q = malloc((n ? n : 1) * BEZIER_MAX_SEGMENTS * sizeof(RationalQuad));
+    int* counts = malloc((n ? n : 1) * sizeof(int));
+    if (!q || !counts) {
+        err = "out_of_memory";
+    } else {
+        double t0 = now_ms();
+        conic_to_bezier_batch(coeffs, n, window, q, counts);
+        double compute_ms = now_ms() - t0;
+
+        size_t total = 0;
+        cJSON* arr = cJSON_AddArrayToObject(out, "conics");
+        for (size_t i = 0; i < n; i++) {
+            cJSON* item = cJSON_CreateObject();
+            segments_to_json(q + i * BEZIER_MAX_SEGMENTS, counts[i], item);
+            cJSON_AddItemToArray(arr, item);
+            total += (size_t)counts[i];
+        }
+        cJSON_AddNumberToObject(out, "segment_count", (double)total);
+        cJSON_AddNumberToObject(out, "threads", tp_thread_count());
+        cJSON_AddNumberToObject(out, "compute_ms", compute_ms);
+    }
+
+    free(coeffs);
+    free(q);
+    free(counts);
+    return err;
+}
+
+/**
+ * @brief Modo "polyline": polilíneas recortadas y simplificadas.
+ * @details Entrada: {"mode":"polyline","A":..,"F":.. (o "conics"/"input"),
+ *          "window":[...],"samples":1024,"simplify":"dp"|"vw"|"none",
+ *          "tolerance":0.5,"width":1000,"height":1000}. tolerance va en
+ *          píxeles de un lienzo width x height que muestra window. Cada
+ *          polilínea lleva su rama y "points" = [x0, y0, x1, y1, ...].
+ */
+static const char* run_polyline(const cJSON* root, cJSON* out) {
+    double window[4];
+    if (!read_window(root, window)) return "invalid_window";
+
+    PolylineParams p;
+    const char* err = read_polyline_params(root, window, &p);
+    if (err) return err;
+
+    double c[6];
+    double* coeffs = NULL;
+    size_t n = 1;
+    bool single = read_coeffs(root, c);
+    if (!single) err = load_conic_table(root, &coeffs, &n);
+    if (err) return err;
+
+    Polylines* pl = calloc(n ? n : 1, sizeof(Polylines));
+    if (!pl) {
+        free(coeffs);
+        return "out_of_memory";
+    }
+
+    double t0 = now_ms();
+    bool ok = polyline_build_batch(single ? c : coeffs, n, window, &p, pl);
+    double compute_ms = now_ms() - t0;
+
+    if (!ok) {
+        err = "out_of_memory";
+    } else if (single) {
+        polylines_to_json(&pl[0], out, "polylines");
+    } else {
+        cJSON* arr = cJSON_AddArrayToObject(out, "conics");
+        for (size_t i = 0; i < n; i++) {
+            cJSON* item = cJSON_CreateObject();
+            polylines_to_json(&pl[i], item, "polylines");
+            cJSON_AddItemToArray(arr, item);
+        }
+    }
+
+    if (!err) {
+        size_t sampled = 0, kept = 0;
+        for (size_t i = 0; i < n; i++) {
+            sampled += pl[i].sampled;
+            kept += pl[i].count ? pl[i].offsets[pl[i].count] : 0;
+        }
+        cJSON_AddNumberToObject(out, "sampled", (double)sampled);
+        cJSON_AddNumberToObject(out, "vertices", (double)kept);
+        cJSON_AddNumberToObject(out, "threads", tp_thread_count());
+        cJSON_AddNumberToObject(out, "compute_ms", compute_ms);
+    }
+
+    for (size_t i = 0; i < n; i++) polyline_free(&pl[i]);
+    free(pl);
+    free(coeffs);
+    return err;
+}
+
+/**
+ * @brief Modo "vertices": polilíneas como buffer Float32 para la GPU.
+ * @details Misma entrada que "polyline" más "line_width" (píxeles; 0 =
+ *          sin tiras). El buffer (formato en vertices.h) sale por
+ *          emit_blob bajo la clave "buffer": con "stdout":true va en
+ *          crudo, que es como lo piden el servidor y la app de escritorio.
+ */
+static const char* run_vertices(const cJSON* root, cJSON* out) {
+    double window[4];
+    if (!read_window(root, window)) return "invalid_window";
+
+    PolylineParams p;
+    const char* err = read_polyline_params(root, window, &p);
+    if (err) return err;
+    double half_width = 0.5 * polyline_pixel_tolerance(window, json_number(root, "width", 1000.0),
+                                                       json_number(root, "height", 1000.0),
+                                                       json_number(root, "line_width", 0.0));
+
+    double c[6];
+    double* coeffs = NULL;
+    size_t n = 1;
+    bool single = read_coeffs(root, c);
+    if (!single) err = load_conic_table(root, &coeffs, &n);
+    if (err) return err;
+
+    Polylines* pl = calloc(n ? n : 1, sizeof(Polylines));
+    ByteBuf buf;
+    buf_init(&buf);
+    if (!pl) err = "out_of_memory";
+
+    double t0 = now_ms();
+    if (!err && !polyline_build_batch(single ? c : coeffs, n, window, &p, pl)) err = "out_of_memory";
+    if (!err && !vertices_pack(pl, n, half_width, &buf)) err = "out_of_memory";
+    double compute_ms = now_ms() - t0;
+
+    if (!err) {
+        const VertexHeader* h = (const VertexHeader*)buf.data;
+        cJSON_AddNumberToObject(out, "polylines", h->polylines);
+        cJSON_AddNumberToObject(out, "vertices", h->vertices);
+        cJSON_AddNumberToObject(out, "strip_vertices", h->strip_vertices);
+        cJSON_AddNumberToObject(out, "indices", h->indices);
+        cJSON_AddNumberToObject(out, "compute_ms", compute_ms);
+        err = emit_blob(root, out, "buffer", &buf);
+    }
+
+    for (size_t i = 0; pl && i < n; i++) polyline_free(&pl[i]);
+    free(pl);
+    free(coeffs);
+    buf_free(&buf);
+    return err;
+}
+
+/**
+ * @brief Lee un color [r, g, b] o [r, g, b, a] (0..255); sin alfa = 255.
+ * @return false si key no existe o no es un color válido (c intacto).
+ */
+static bool read_rgba(const cJSON* obj, const char* key, uint8_t c[4]) {
+    const cJSON* arr = cJSON_GetObjectItem(obj, key);
+    int n = cJSON_IsArray(arr) ? cJSON_GetArraySize(arr) : 0;
+    if (n != 3 && n != 4) return false;
+
+    uint8_t tmp[4] = { 0, 0, 0, 255 };
+    for (int i = 0; i < n; i++) {
+        const cJSON* item = cJSON_GetArrayItem(arr, i);
+        if (!cJSON_IsNumber(item)) return false;
+        tmp[i] = (uint8_t)fmin(fmax(item->valuedouble, 0.0), 255.0);
+    }
+    memcpy(c, tmp, 4);
+    return true;
+}
+
+/**
+ * @brief Color RGBA de cada una de las n cónicas: el "color" de cada
+ *        elemento de "conics" si lo trae, si no def.
+ * @details Recorre la lista de cJSON una sola vez (el acceso por índice
+ *          es lineal y haría cuadrático el bucle en escenas grandes).
+ */
+static void read_conic_colors(const cJSON* root, size_t n, const uint8_t def[4], uint8_t* colors) {
+    for (size_t i = 0; i < n; i++) memcpy(colors + 4*i, def, 4);
+
+    const cJSON* conics = cJSON_GetObjectItem(root, "conics");
+    if (!cJSON_IsArray(conics)) return;
+    size_t i = 0;
+    const cJSON* item;
+    cJSON_ArrayForEach(item, conics) {
+        if (i >= n) break;
+        read_rgba(item, "color", colors + 4 * i++);
+    }
+}
+
+/**
+ * @brief Modo "raster": dibuja una cónica o una escena en PNG/QOI.
+ * @details Entrada: A..F, "conics" (cada una con "color" opcional) o
+ *          "input" (CCOL), más "window", "width", "height",
+ *          "line_width" (px), "color", "background", "axes" (false o
+ *          un color) y "format":"png|qoi|raw". La imagen sale por
+ *          emit_blob bajo la clave "image".
+ */
+static const char* run_raster(const cJSON* root, cJSON* out) {
+    RasterParams p = raster_default_params();
+    if (!read_window(root, p.window)) return "invalid_window";
+    p.width = (int)json_number(root, "width", p.width);
+    p.height = (int)json_number(root, "height", p.height);
+    if (p.width <= 0 || p.height <= 0 || p.width > RASTER_MAX_SIZE || p.height > RASTER_MAX_SIZE) {
+        return "invalid_size";
+    }
+    p.line_width = json_number(root, "line_width", p.line_width);
+    read_rgba(root, "background", p.background);
+    if (cJSON_IsFalse(cJSON_GetObjectItem(root, "axes"))) p.axes[3] = 0;
+    else read_rgba(root, "axes", p.axes);
+
+    uint8_t color[4] = { 31, 119, 180, 255 };
+    read_rgba(root, "color", color);
+
+    const char* fmt = json_string(root, "format");
+    RasterFormat format = RASTER_FMT_PNG;
+    if (fmt && strcmp(fmt, "qoi") == 0) format = RASTER_FMT_QOI;
+    else if (fmt && strcmp(fmt, "raw") == 0) format = RASTER_FMT_RAW;
+    else if (fmt && strcmp(fmt, "png") != 0) return "invalid_format";
+
+    double c[6];
+    double* coeffs = NULL;
+    size_t n = 1;
+    const char* err = NULL;
+    bool single = read_coeffs(root, c);
+    if (!single) err = load_conic_table(root, &coeffs, &n);
+    if (err) return err;
+
+    size_t pixels = (size_t)p.width * (size_t)p.height;
+    uint8_t* colors = malloc((n ? n : 1) * 4);
+    uint8_t* rgba = malloc(pixels * 4);
+    ByteBuf img;
+    buf_init(&img);
+    if (!colors || !rgba) err = "out_of_memory";
+
+    if (!err) read_conic_colors(root, n, color, colors);
+
+    double t0 = now_ms();
+    if (!err && !raster_render(&p, single ? c : coeffs, colors, n, rgba)) err = "out_of_memory";
+    double compute_ms = now_ms() - t0;
+    // Cancelada en --serve: no merece la pena codificar
+    if (!err && budget_cancelled(budget_current())) err = "cancelled";
+
+    t0 = now_ms();
+    if (!err && !raster_encode(rgba, p.width, p.height, format, &img)) err = "out_of_memory";
+    double encode_ms = now_ms() - t0;
+
+    if (!err) {
+        cJSON_AddNumberToObject(out, "width", p.width);
+        cJSON_AddNumberToObject(out, "height", p.height);
+        cJSON_AddNumberToObject(out, "conics", (double)n);
+        cJSON_AddNumberToObject(out, "threads", tp_thread_count());
+        cJSON_AddNumberToObject(out, "compute_ms", compute_ms);
+        cJSON_AddNumberToObject(out, "encode_ms", encode_ms);
+        err = emit_blob(root, out, "image", &img);
+    }
+
+    free(coeffs);
+    free(colors);
+    free(rgba);
+    buf_free(&img);
+    return err;
+}
+
+/**
+ * @brief Modo "export": escena vectorial en SVG o PDF, en streaming.
+ * @details Entrada: A..F, "conics" (cada una con "color" opcional) o
+ *          "input" (CCOL), más "window", "width", "height",
+ *          "line_width", "tolerance" (unidades del lienzo), "color" y
+ *          "format":"svg|pdf". El documento se escribe según se genera:
+ *          al fichero de "output", a stdout con "stdout":true o, si no
+ *          hay ninguno, en base64 bajo la clave "document".
+ */
+static const char* run_export(const cJSON* root, cJSON* out) {
+    ExportParams p = export_default_params();
+    if (!read_window(root, p.window)) return "invalid_window";
+    p.width = json_number(root, "width", p.width);
+    p.height = json_number(root, "height", p.height);
+    if (!(p.width > 0.0) || !(p.height > 0.0)) return "invalid_size";
+    p.stroke_width = json_number(root, "line_width", p.stroke_width);
+    p.tolerance = fmax(json_number(root, "tolerance", p.tolerance), 1e-6);
+
+    const char* fmt = json_string(root, "format");
+    ExportFormat format = EXPORT_SVG;
+    if (fmt && strcmp(fmt, "pdf") == 0) format = EXPORT_PDF;
+    else if (fmt && strcmp(fmt, "svg") != 0) return "invalid_format";
+
+    uint8_t color[4] = { 31, 119, 180, 255 };
+    read_rgba(root, "color", color);
+
+    double c[6];
+    double* coeffs = NULL;
+    size_t n = 1;
+    const char* err = NULL;
+    bool single = read_coeffs(root, c);
+    if (!single) err = load_conic_table(root, &coeffs, &n);
+    if (err) return err;
+
+    // Destino: fichero, stdout o memoria (solo para documentos pequeños)
+    const char* path = json_string(root, "output");
+    bool to_stdout = wants_stdout(root);
+    FILE* fp = NULL;
+    ByteBuf mem;
+    buf_init(&mem);
+    if (to_stdout) {
+        fp = stdout;
+    } else if (path) {
+        fp = fopen(path, "wb");
+        if (!fp) {
+            free(coeffs);
+            return "output_open_failed";
+        }
+    }
+
+    ExportWriter* w = malloc(sizeof(ExportWriter));
+    uint8_t* colors = malloc((n ? n : 1) * 4);
+    if (!w || !colors) err = "out_of_memory";
+    else read_conic_colors(root, n, color, colors);
+
+    // Sin tiempo (budget.h) se dejan de añadir cónicas y el documento se
+    // cierra igualmente, válido pero incompleto
+    double t0 = now_ms();
+    size_t done = 0;
+    if (!err && !export_begin(w, format, &p, fp, fp ? NULL : &mem)) err = "output_write_failed";
+    for (; !err && done < n && !budget_exhausted(); done++) {
+        if (!export_conic(w, single ? c : coeffs + 6*done, colors + 4*done)) err = "output_write_failed";
+    }
+    if (!err && !export_end(w)) err = "output_write_failed";
+    double compute_ms = now_ms() - t0;
+
+    if (fp && fp != stdout && fclose(fp) != 0 && !err) err = "output_write_failed";
+
+    if (!err) {
+        if (to_stdout) {
+            stdout_taken = true;
+        } else if (path) {
+            cJSON_AddStringToObject(out, "output", path);
+        } else {
+            char* enc = base64_encode(mem.data, mem.len);
+            if (!enc) err = "out_of_memory";
+            else cJSON_AddStringToObject(out, "document", enc);
+            free(enc);
+        }
+    }
+    if (!err) {
+        cJSON_AddStringToObject(out, "format", format == EXPORT_PDF ? "pdf" : "svg");
+        cJSON_AddNumberToObject(out, "conics", (double)w->conics);
+        if (done < n) cJSON_AddNumberToObject(out, "skipped_conics", (double)(n - done));
+        cJSON_AddNumberToObject(out, "segments", (double)w->segments);
+        cJSON_AddNumberToObject(out, "bytes", (double)w->written);
+        cJSON_AddNumberToObject(out, "compute_ms", compute_ms);
+    }
+
+    free(w);
+    free(colors);
+    free(coeffs);
+    buf_free(&mem);
+    return err;
+}
+
+/**
+ * @brief LRU de teselas del proceso en --serve (NULL fuera de él): la
+ *        dimensiona la primera petición y la comparten todas.
+ */
+static TileCache* shared_tile_cache(double mb) {
+    static TileCache cache;
+    static bool ready = false;
+    static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    if (!serving) return NULL;
+
+    pthread_mutex_lock(&lock);
+    if (!ready) ready = tile_cache_init(&cache, (size_t)(mb * 1024.0 * 1024.0));
+    pthread_mutex_unlock(&lock);
+    return ready ? &cache : NULL;
+}
+
+/**
+ * @brief Lee una tesela [z, x, y] y comprueba que existe en su nivel.
+ */
+static bool read_tile_id(const cJSON* item, TileId* t) {
+    double v[3];
+    if (!cJSON_IsArray(item) || cJSON_GetArraySize(item) != 3) return false;
+    for (int i = 0; i < 3; i++) {
+        const cJSON* e = cJSON_GetArrayItem(item, i);
+        if (!cJSON_IsNumber(e) || e->valuedouble < 0.0 || e->valuedouble != floor(e->valuedouble)) return false;
+        v[i] = e->valuedouble;
+    }
+    if (v[0] > TILE_MAX_ZOOM) return false;
+    const double side = ldexp(1.0, (int)v[0]);
+    if (v[1] >= side || v[2] >= side) return false;
+    *t = (TileId){ (uint32_t)v[0], (uint32_t)v[1], (uint32_t)v[2] };
+    return true;
+}
+
+/**
+ * @brief Aplica "edits" a la escena y añade a out["dirty"] los rangos de
+ *        teselas invalidados entre los niveles zmin..zmax.
+ * @details Mismo esquema que el modo pick: {"op":"remove","id"} o
+ *          {"op":"update","id","conic":{A..F},"color"?}.
+ */
+static const char* apply_tile_edits(const cJSON* edits, TileScene* scene, const TileParams* p,
+                                    uint32_t zmin, uint32_t zmax, cJSON* out) {
+    TileRange* ranges = malloc(2 * (size_t)(zmax - zmin + 1) * sizeof(TileRange));
+    if (!ranges) return "out_of_memory";
+
+    cJSON* dirty = cJSON_AddArrayToObject(out, "dirty");
+    const char* err = NULL;
+    const cJSON* e;
+    cJSON_ArrayForEach(e, edits) {
+        double c[6];
+        uint8_t color[4];
+        const char* op = json_string(e, "op");
+        double id = json_number(e, "id", -1.0);
+        bool remove = op && strcmp(op, "remove") == 0;
+        bool update = op && strcmp(op, "update") == 0 && read_coeffs(cJSON_GetObjectItem(e, "conic"), c);
+        if (id < 0.0 || id >= (double)scene->count || !(remove || update)) {
+            err = "invalid_edit";
+            break;
+        }
+
+        size_t m = 0;
+        bool recolor = read_rgba(e, "color", color);
+        if (!tile_scene_edit(scene, p, (uint32_t)id, remove ? NULL : c, recolor ? color : NULL,
+                             zmin, zmax, ranges, &m)) {
+            err = "out_of_memory";
+            break;
+        }
+        for (size_t i = 0; i < m; i++) {
+            cJSON* r = cJSON_CreateObject();
+            cJSON_AddNumberToObject(r, "z", ranges[i].z);
+            cJSON_AddNumberToObject(r, "x0", ranges[i].x0);
+            cJSON_AddNumberToObject(r, "y0", ranges[i].y0);
+            cJSON_AddNumberToObject(r, "x1", ranges[i].x1);
+            cJSON_AddNumberToObject(r, "y1", ranges[i].y1);
+            cJSON_AddItemToArray(dirty, r);
+        }
+    }
+    free(ranges);
+    return err;
+}
+
+/**
+ * @brief Modo "tiles": teselas z/x/y de una escena, con caché.
+ * @details Entrada: la escena (A..F, "conics" o "input"), "window" (el
+ *          mundo del nivel 0), "tile_size", "line_width", "background",
+ *          "axes", "color", "format":"png|qoi|svg" y las teselas, como
+ *          lista "tiles":[[z, x, y], ...] o como "zoom" + "view" (todas
+ *          las del nivel que cortan la vista). "cache_dir" activa la
+ *          caché de disco y "cache_mb" acota la LRU. Fuera de --serve la
+ *          LRU nace y muere con la petición, así que solo sirve de una
+ *          petición a otra la caché de disco; en --serve la LRU es del
+ *          proceso y la dimensiona la primera petición.
+ *
+ *          "edits" (con el esquema del modo pick) cambia cónicas antes
+ *          de dibujar y devuelve en "dirty" los rangos invalidados de los
+ *          niveles "dirty_levels":[zmin, zmax] (por defecto, de 0 al mayor
+ *          nivel pedido). Cada tesela
+ *          sale con su "key", su "source" (memory|disk|render) y la
+ *          imagen en base64.
+ */
+static const char* run_tiles(const cJSON* root, cJSON* out) {
+    TileParams p = tile_default_params();
+    if (!read_window(root, p.world)) return "invalid_window";
+    p.size = (int)json_number(root, "tile_size", p.size);
+    if (p.size <= 0 || p.size > TILE_MAX_SIZE) return "invalid_size";
+    p.style.line_width = json_number(root, "line_width", p.style.line_width);
+    read_rgba(root, "background", p.style.background);
+    if (cJSON_IsFalse(cJSON_GetObjectItem(root, "axes"))) p.style.axes[3] = 0;
+    else read_rgba(root, "axes", p.style.axes);
+
+    const char* fmt = json_string(root, "format");
+    if (fmt && strcmp(fmt, "qoi") == 0) p.format = TILE_FMT_QOI;
+    else if (fmt && strcmp(fmt, "svg") == 0) p.format = TILE_FMT_SVG;
+    else if (fmt && strcmp(fmt, "png") != 0) return "invalid_format";
+
+    uint8_t color[4] = { 31, 119, 180, 255 };
+    read_rgba(root, "color", color);
+
+    // Teselas pedidas: lista explícita o rango de una vista
+    TileId* ids = NULL;
+    size_t count = 0;
+    const cJSON* list = cJSON_GetObjectItem(root, "tiles");
+    const cJSON* view = cJSON_GetObjectItem(root, "view");
+    if (cJSON_IsArray(list)) {
+        ids = malloc(((size_t)cJSON_GetArraySize(list) + 1) * sizeof(TileId));
+        if (!ids) return "out_of_memory";
+        const cJSON* item;
+        cJSON_ArrayForEach(item, list) {
+            if (!read_tile_id(item, &ids[count++])) {
+                free(ids);
+                return "invalid_tile";
+            }
+        }
+    } else if (cJSON_IsArray(view)) {
+        double box[4] = { NAN, NAN, NAN, NAN }, zoom = json_number(root, "zoom", 0.0);
+        for (int i = 0; i < 4; i++) {
+            const cJSON* e = cJSON_GetArrayItem(view, i);
+            if (cJSON_IsNumber(e)) box[i] = e->valuedouble;
+        }
+        if (!(zoom >= 0.0 && zoom <= TILE_MAX_ZOOM) || !(box[0] < box[2] && box[1] < box[3])) {
+            return "invalid_view";
+        }
+        TileRange r;
+        if (tile_range(&p, (uint32_t)zoom, box, 0.0, &r)) {
+            size_t n = (size_t)(r.x1 - r.x0 + 1) * (size_t)(r.y1 - r.y0 + 1);
+            if (n > 4096) return "too_many_tiles";
+            ids = malloc(n * sizeof(TileId));
+            if (!ids) return "out_of_memory";
+            for (uint32_t y = r.y0; y <= r.y1; y++) {
+                for (uint32_t x = r.x0; x <= r.x1; x++) ids[count++] = (TileId){ r.z, x, y };
+            }
+        }
+    }
+
+    double c[6];
+    double* coeffs = NULL;
+    size_t n = 1;
+    const char* err = NULL;
+    bool single = read_coeffs(root, c);
+    if (!single) err = load_conic_table(root, &coeffs, &n);
+    if (err) {
+        free(ids);
+        return err;
+    }
+
+    uint8_t* colors = malloc((n ? n : 1) * 4);
+    TileResult* res = calloc(count ? count : 1, sizeof(TileResult));
+    TileScene scene;
+    TileCache local;
+    TileCache* cache = NULL;
+    bool have_scene = false;
+    if (!colors || !res) err = "out_of_memory";
+    if (!err) {
+        read_conic_colors(root, n, color, colors);
+        have_scene = tile_scene_init(&scene, &p, single ? c : coeffs, colors, n);
+        double mb = fmax(json_number(root, "cache_mb", 64.0), 0.0);
+        cache = shared_tile_cache(mb);
+        if (!cache && tile_cache_init(&local, (size_t)(mb * 1024.0 * 1024.0))) cache = &local;
+        if (!have_scene || !cache) err = "out_of_memory";
+    }
+
+    const cJSON* edits = cJSON_GetObjectItem(root, "edits");
+    if (!err && cJSON_IsArray(edits)) {
+        uint32_t zmax = 0;
+        for (size_t i = 0; i < count; i++) if (ids[i].z > zmax) zmax = ids[i].z;
+        const cJSON* levels = cJSON_GetObjectItem(root, "dirty_levels");
+        const cJSON* lo = cJSON_GetArrayItem(levels, 0);
+        const cJSON* hi = cJSON_GetArrayItem(levels, 1);
+        double z0 = cJSON_IsNumber(lo) ? lo->valuedouble : 0.0;
+        double z1 = cJSON_IsNumber(hi) ? hi->valuedouble : zmax;
+        if (!(z0 >= 0.0 && z0 <= z1 && z1 <= TILE_MAX_ZOOM)) err = "invalid_levels";
+        else err = apply_tile_edits(edits, &scene, &p, (uint32_t)z0, (uint32_t)z1, out);
+    }
+
+    double t0 = now_ms();
+    for (size_t i = 0; i < count; i++) res[i].id = ids[i];
+    if (!err && !tiles_render(&scene, &p, cache, json_string(root, "cache_dir"), res, count)) {
+        err = "out_of_memory";
+    }
+    double compute_ms = now_ms() - t0;
+
+    if (!err) {
+        static const char* const sources[] = { "memory", "disk", "render" };
+        size_t by_source[3] = { 0, 0, 0 };
+        cJSON* arr = cJSON_AddArrayToObject(out, "tiles");
+        for (size_t i = 0; i < count && !err; i++) {
+            by_source[res[i].source]++;
+            char key[17];
+            snprintf(key, sizeof(key), "%016llx", (unsigned long long)res[i].key);
+            char* enc = base64_encode(res[i].data.data, res[i].data.len);
+            if (!enc) {
+                err = "out_of_memory";
+                break;
+            }
+            cJSON* o = cJSON_CreateObject();
+            cJSON_AddNumberToObject(o, "z", res[i].id.z);
+            cJSON_AddNumberToObject(o, "x", res[i].id.x);
+            cJSON_AddNumberToObject(o, "y", res[i].id.y);
+            cJSON_AddStringToObject(o, "key", key);
+            cJSON_AddStringToObject(o, "source", sources[res[i].source]);
+            cJSON_AddNumberToObject(o, "conics", (double)res[i].conics);
+            cJSON_AddNumberToObject(o, "bytes", (double)res[i].data.len);
+            if (res[i].partial) cJSON_AddBoolToObject(o, "truncated", true);
+            cJSON_AddStringToObject(o, "image", enc);
+            cJSON_AddItemToArray(arr, o);
+            free(enc);
+        }
+        cJSON_AddNumberToObject(out, "tile_size", p.size);
+        cJSON_AddNumberToObject(out, "hits", (double)by_source[TILE_SRC_MEMORY]);
+        cJSON_AddNumberToObject(out, "disk_hits", (double)by_source[TILE_SRC_DISK]);
+        cJSON_AddNumberToObject(out, "misses", (double)by_source[TILE_SRC_RENDER]);
+        cJSON_AddNumberToObject(out, "threads", tp_thread_count());
+        cJSON_AddNumberToObject(out, "compute_ms", compute_ms);
+    }
+
+    for (size_t i = 0; res && i < count; i++) buf_free(&res[i].data);
+    if (cache == &local) tile_cache_free(&local);
+    if (have_scene) tile_scene_free(&scene);
+    free(res);
+    free(colors);
+    free(coeffs);
+    free(ids);
+    return err;
+}
+
+/**
+ * @brief Añade a arr los aciertos de una consulta espacial.
+ */
+static void hits_to_json(const SpatialHit* hits, size_t n, cJSON* arr) {
+    for (size_t i = 0; i < n; i++) {
+        cJSON* o = cJSON_CreateObject();
+        cJSON_AddNumberToObject(o, "conic", hits[i].conic);
+        cJSON_AddNumberToObject(o, "distance", hits[i].distance);
+        cJSON* foot = cJSON_AddObjectToObject(o, "foot");
+        cJSON_AddNumberToObject(foot, "x", hits[i].foot.x);
+        cJSON_AddNumberToObject(foot, "y", hits[i].foot.y);
+        cJSON_AddItemToArray(arr, o);
+    }
+}
+
+/**
+ * @brief Modo "pick": picking y vecinos más cercanos sobre el índice espacial.
+ * @details Entrada: {"mode":"pick","conics":[...] o "input":"f.ccol",
+ *          "window":[...],"edits":[{"op":"remove|update","id":3,"conic":{A..F}}],
+ *          "queries":[{"x":1,"y":2,"radius":0.1} | {"x":1,"y":2,"k":5}],
+ *          "max":16}. Las ediciones se aplican de forma incremental antes
+ *          de las consultas; cada consulta devuelve sus aciertos ordenados
+ *          por distancia exacta con el pie de la perpendicular.
+ */
+static const char* run_pick(const cJSON* root, cJSON* out) {
+    double window[4];
+    if (!read_window(root, window)) return "invalid_window";
+
+    size_t max = (size_t)json_number(root, "max", 16);
+    if (max == 0 || max > 4096) return "invalid_max";
+
+    double* coeffs;
+    size_t n;
+    const char* err = load_conic_table(root, &coeffs, &n);
+    if (err) return err;
+
+    SpatialIndex idx;
+    spatial_init(&idx, window);
+    double t0 = now_ms();
+    if (!spatial_build(&idx, coeffs, n)) err = "out_of_memory";
+    double build_ms = now_ms() - t0;
+    free(coeffs);
+
+    const cJSON* item;
+    t0 = now_ms();
+    cJSON_ArrayForEach(item, cJSON_GetObjectItem(root, "edits")) {
+        if (err) break;
+        const char* op = json_string(item, "op");
+        double id = json_number(item, "id", -1);
+        double c[6];
+        if (!op || id < 0 || id > UINT32_MAX - 1) {
+            err = "invalid_edit";
+        } else if (strcmp(op, "remove") == 0) {
+            spatial_remove(&idx, (uint32_t)id);
+        } else if (strcmp(op, "update") == 0 && read_coeffs(cJSON_GetObjectItem(item, "conic"), c)) {
+            if (!spatial_update(&idx, (uint32_t)id, c)) err = "out_of_memory";
+        } else {
+            err = "invalid_edit";
+        }
+    }
+    double edit_ms = now_ms() - t0;
+
+    SpatialHit* hits = malloc(max * sizeof(SpatialHit));
+    if (!err && !hits) err = "out_of_memory";
+
+    if (!err) {
+        cJSON* results = cJSON_AddArrayToObject(out, "results");
+        t0 = now_ms();
+        size_t queries = 0;
+        cJSON_ArrayForEach(item, cJSON_GetObjectItem(root, "queries")) {
+            double x = json_number(item, "x", NAN), y = json_number(item, "y", NAN);
+            if (isnan(x) || isnan(y)) {
+                err = "invalid_query";
+                break;
+            }
+            double k = json_number(item, "k", 0);
+            size_t m = k >= 1
+                ? spatial_nearest(&idx, x, y, (size_t)fmin(k, (double)max), hits)
+                : spatial_pick(&idx, x, y, json_number(item, "radius", 0.1), hits, max);
+            cJSON* arr = cJSON_CreateArray();
+            hits_to_json(hits, m, arr);
+            cJSON_AddItemToArray(results, arr);
+            queries++;
+        }
+        double query_ms = now_ms() - t0;
+
+        cJSON_AddNumberToObject(out, "indexed", (double)idx.count);
+        cJSON_AddNumberToObject(out, "height", spatial_height(&idx));
+        cJSON_AddNumberToObject(out, "build_ms", build_ms);
+        cJSON_AddNumberToObject(out, "edit_ms", edit_ms);
+        cJSON_AddNumberToObject(out, "query_us", queries ? 1000.0 * query_ms / (double)queries : 0.0);
+    }
+
+    free(hits);
+    spatial_free(&idx);
+    return err;
+}
+
+/**
+ * @brief Modo "distance": kernels por lotes de una nube contra cónicas.
+ * @details Entrada: {"mode":"distance","conic":{A..F} o "conics":[...],
+ *          "points":[[x,y],...] o "points_file":"nube.bin",
+ *          "kernel":"eval|sign|sampson|exact","tol":0}. Devuelve un
+ *          buffer por cónica y punto (orden cónica-mayor): float64 salvo
+ *          "sign", que es int8 (-1 interior, 0 sobre la curva, +1 exterior).
+ *          Entrega como emit_blob bajo la clave "values". Si "exact" se
+ *          queda sin tiempo, "sampson_values" cuenta los valores que
+ *          llevan la aproximación de Sampson.
+ */
+static const char* run_distance(const cJSON* root, cJSON* out) {
+    const char* kernel = json_string(root, "kernel");
+    if (!kernel) kernel = "exact";
+    bool sign = strcmp(kernel, "sign") == 0;
+    if (!sign && strcmp(kernel, "eval") != 0 && strcmp(kernel, "sampson") != 0 &&
+        strcmp(kernel, "exact") != 0) {
+        return "invalid_kernel";
+    }
+    double tol = json_number(root, "tol", 0.0);
+
+    double* coeffs = NULL;
+    size_t m = 0;
+    const char* err = NULL;
+    const cJSON* single = cJSON_GetObjectItem(root, "conic");
+    if (single) {
+        coeffs = malloc(6 * sizeof(double));
+        if (!coeffs) return "out_of_memory";
+        if (!read_coeffs(single, coeffs)) err = "missing_coefficients";
+        m = 1;
+    } else {
+        err = load_conic_table(root, &coeffs, &m);
+    }
+    if (!err && (m == 0 || m > 64)) err = "invalid_conic_count";
+    if (err) {
+        free(coeffs);
+        return err;
+    }
+
+    double *xs = NULL, *ys = NULL;
+    size_t n = 0;
+    err = load_points(root, &xs, &ys, &n);
+
+    ByteBuf buf;
+    buf_init(&buf);
+    size_t elem = sign ? sizeof(int8_t) : sizeof(double);
+    if (!err && !buf_reserve(&buf, m * n * elem + 1)) err = "out_of_memory";
+
+    double compute_ms = 0.0;
+    size_t approx = 0;
+    if (!err) {
+        cJSON* counts = sign ? cJSON_AddArrayToObject(out, "inside") : NULL;
+        double t0 = now_ms();
+        for (size_t j = 0; j < m; j++) {
+            DistanceConic d;
+            distance_prepare(coeffs + 6 * j, &d);
+            void* dst = buf.data + j * n * elem;
+
+            if (sign) {
+                distance_sign_batch(&d, xs, ys, n, tol, dst);
+            } else if (strcmp(kernel, "eval") == 0) {
+                distance_eval_batch(&d, xs, ys, n, dst);
+            } else if (strcmp(kernel, "sampson") == 0) {
+                distance_sampson_batch(&d, xs, ys, n, dst);
+            } else {
+                approx += distance_exact_batch(&d, xs, ys, n, dst, NULL);
+            }
+
+            if (sign) {
+                size_t inside = 0;
+                const int8_t* sg = dst;
+                for (size_t i = 0; i < n; i++) inside += sg[i] < 0;
+                cJSON_AddItemToArray(counts, cJSON_CreateNumber((double)inside));
+            }
+        }
+        compute_ms = now_ms() - t0;
+        buf.len = m * n * elem;
+        err = emit_blob(root, out, "values", &buf);
+    }
+
+    if (!err) {
+        cJSON_AddStringToObject(out, "kernel", kernel);
+        cJSON_AddStringToObject(out, "dtype", sign ? "int8" : "float64");
+        cJSON_AddNumberToObject(out, "conics", (double)m);
+        cJSON_AddNumberToObject(out, "points", (double)n);
+        if (approx) cJSON_AddNumberToObject(out, "sampson_values", (double)approx);
+        cJSON_AddNumberToObject(out, "threads", tp_thread_count());
+        cJSON_AddNumberToObject(out, "compute_ms", compute_ms);
+    }
+
+    buf_free(&buf);
+    free(xs);
+    free(coeffs);
+    return err;
+}
+
+/**
+ * @brief Modo "fit": ajuste de una cónica a una nube de puntos.
+ * @details Entrada: {"mode":"fit","points":[[x,y],...] o
+ *          "points_file":"nube.bin","method":"ellipse|general"}. La cónica
+ *          ajustada pasa por analyze_conic y la salida tiene la misma forma
+ *          que el modo "conic", más un objeto "fit" con el método, los
+ *          residuos (algebraico normalizado y Sampson medio) y los tiempos.
+ */
+static const char* run_fit(const cJSON* root, cJSON* out) {
+    const char* method_name = json_string(root, "method");
+    if (!method_name) method_name = "ellipse";
+    FitMethod method;
+    if (strcmp(method_name, "ellipse") == 0) method = FIT_ELLIPSE;
+    else if (strcmp(method_name, "general") == 0) method = FIT_GENERAL;
+    else return "invalid_method";
+
+    double *xs = NULL, *ys = NULL;
+    size_t n = 0;
+    const char* err = load_points(root, &xs, &ys, &n);
+    if (err) return err;
+
+    double t0 = now_ms();
+    double c[6], rms = 0.0;
+    FitStatus st = fit_points(xs, ys, n, method, c, &rms);
+    double fit_ms = now_ms() - t0;
+    if (st != FIT_OK) {
+        free(xs);
+        return fit_status_str(st);
+    }
+
+    // Residuo geométrico aproximado: una pasada más con el kernel de Sampson
+    double sampson = NAN;
+    double* dist = malloc(n * sizeof(double));
+    if (dist) {
+        DistanceConic d;
+        distance_prepare(c, &d);
+        distance_sampson_batch(&d, xs, ys, n, dist);
+        double sum = 0.0;
+        for (size_t i = 0; i < n; i++) sum += dist[i];
+        sampson = sum / (double)n;
+        free(dist);
+    }
+    free(xs);
+
+    ConicResult r = analyze_conic(c[0], c[1], c[2], c[3], c[4], c[5]);
+    conic_to_json(&r, out);
+
+    cJSON* info = cJSON_AddObjectToObject(out, "fit");
+    cJSON_AddStringToObject(info, "method", method_name);
+    cJSON_AddNumberToObject(info, "points", (double)n);
+    cJSON_AddNumberToObject(info, "rms_algebraic", rms);
+    if (!isnan(sampson)) cJSON_AddNumberToObject(info, "mean_sampson", sampson);
+    cJSON_AddNumberToObject(info, "threads", tp_thread_count());
+    cJSON_AddNumberToObject(info, "fit_ms", fit_ms);
+    return NULL;
+}
+
+/**
+ * @brief Modo "ransac": detección robusta de varias cónicas en una nube.
+ * @details Entrada: {"mode":"ransac","points":[[x,y],...] o
+ *          "points_file":"nube.bin","threshold":0.01,"max_conics":4,
+ *          "max_iterations":20000,"min_inliers":50,"subset":2048,
+ *          "confidence":0.99,"seed":1,"refine":true,"labels":false}.
+ *          Devuelve "conics" con el análisis de cada cónica más sus
+ *          inliers; con "labels" entrega además un uint8 por punto (índice
+ *          de cónica o 255) como emit_blob bajo la clave "labels".
+ */
+static const char* run_ransac(const cJSON* root, cJSON* out) {
+    RansacParams p;
+    ransac_default_params(&p);
+    p.threshold = json_number(root, "threshold", p.threshold);
+    p.max_conics = (uint32_t)json_number(root, "max_conics", p.max_conics);
+    p.max_iterations = (uint32_t)json_number(root, "max_iterations", p.max_iterations);
+    p.min_inliers = (uint32_t)json_number(root, "min_inliers", p.min_inliers);
+    p.subset = (uint32_t)json_number(root, "subset", p.subset);
+    p.confidence = json_number(root, "confidence", p.confidence);
+    p.seed = (uint64_t)json_number(root, "seed", (double)p.seed);
+    if (cJSON_IsFalse(cJSON_GetObjectItem(root, "refine"))) p.refine = false;
+    if (!(p.threshold > 0) || !(p.confidence > 0 && p.confidence < 1) ||
+        p.max_conics == 0 || p.max_conics > RANSAC_MAX_CONICS) {
+        return "invalid_parameters";
+    }
+    bool want_labels = cJSON_IsTrue(cJSON_GetObjectItem(root, "labels"));
+
+    double *xs = NULL, *ys = NULL;
+    size_t n = 0;
+    const char* err = load_points(root, &xs, &ys, &n);
+    if (err) return err;
+
+    ByteBuf labels;
+    buf_init(&labels);
+    if (want_labels && !buf_reserve(&labels, n + 1)) {
+        free(xs);
+        return "out_of_memory";
+    }
+
+    RansacConic found[RANSAC_MAX_CONICS];
+    size_t count = 0;
+    double t0 = now_ms();
+    RansacStatus st = ransac_detect(xs, ys, n, &p, found, &count,
+                                    want_labels ? labels.data : NULL);
+    double compute_ms = now_ms() - t0;
+    free(xs);
+    if (st != RANSAC_OK) {
+        buf_free(&labels);
+        return ransac_status_str(st);
+    }
+
+    cJSON* arr = cJSON_AddArrayToObject(out, "conics");
+    size_t outliers = n;
+    for (size_t k = 0; k < count; k++) {
+        const double* c = found[k].coeffs;
+        ConicResult r = analyze_conic(c[0], c[1], c[2], c[3], c[4], c[5]);
+        cJSON* item = cJSON_CreateObject();
+        conic_to_json(&r, item);
+        cJSON_AddNumberToObject(item, "inliers", (double)found[k].inliers);
+        cJSON_AddNumberToObject(item, "rms", found[k].rms);
+        cJSON_AddNumberToObject(item, "hypotheses", found[k].hypotheses);
+        cJSON_AddItemToArray(arr, item);
+        outliers -= found[k].inliers;
+    }
+
+    if (want_labels) {
+        labels.len = n;
+        err = emit_blob(root, out, "labels", &labels);
+    }
+    buf_free(&labels);
+    if (err) return err;
+
+    cJSON_AddNumberToObject(out, "points", (double)n);
+    cJSON_AddNumberToObject(out, "outliers", (double)outliers);
+    cJSON_AddNumberToObject(out, "threads", tp_thread_count());
+    cJSON_AddNumberToObject(out, "compute_ms", compute_ms);
+    return NULL;
+}
+
+/**
+ * @brief Modo "detect": elipses en fotogramas de cámara.
+ * @details Entrada: {"mode":"detect","frame_file":"/dev/shm/frames.raw",
+ *          "width":1280,"height":720,"channels":4,"stride":0,
+ *          "low":80,"high":200,"min_chain":40,"max_residual":1.0,
+ *          "min_coverage":0.35,"min_axis":5,"robust":true,
+ *          "max_detections":16}. El fichero se proyecta con mmap (un
+ *          búfer compartido en /dev/shm no se copia) y puede contener
+ *          varios fotogramas seguidos; "frames" limita cuántos se procesan.
+ *          Cada detección lleva el análisis de analyze_conic, la elipse
+ *          geométrica y su soporte en píxeles.
+ */
+static const char* run_detect(const cJSON* root, cJSON* out) {
+    const char* path = json_string(root, "frame_file");
+    if (!path) return "missing_frame_file";
+
+    uint32_t w = (uint32_t)json_number(root, "width", 0);
+    uint32_t h = (uint32_t)json_number(root, "height", 0);
+    uint32_t ch = (uint32_t)json_number(root, "channels", 4);
+    uint32_t stride = (uint32_t)json_number(root, "stride", 0);
+    if (w < 3 || h < 3 || (ch != 1 && ch != 3 && ch != 4) || (stride && stride < w * ch)) {
+        return "invalid_frame_size";
+    }
+
+    VisionParams p;
+    vision_default_params(&p);
+    p.low = (uint16_t)json_number(root, "low", p.low);
+    p.high = (uint16_t)json_number(root, "high", p.high);
+    p.min_chain = (uint32_t)json_number(root, "min_chain", p.min_chain);
+    p.max_residual = json_number(root, "max_residual", p.max_residual);
+    p.min_coverage = json_number(root, "min_coverage", p.min_coverage);
+    p.min_axis = json_number(root, "min_axis", p.min_axis);
+    p.max_detections = (uint32_t)json_number(root, "max_detections", p.max_detections);
+    if (cJSON_IsFalse(cJSON_GetObjectItem(root, "robust"))) p.robust = false;
+    if (p.low > p.high || p.max_detections == 0) return "invalid_parameters";
+
+    VisionMapping map;
+    if (!vision_map_file(path, &map)) return "frame_open_failed";
+    size_t frame_bytes = (size_t)(stride ? stride : w * ch) * h;
+    size_t frames = map.size / frame_bytes;
+    size_t limit = (size_t)json_number(root, "frames", (double)frames);
+    if (limit < frames) frames = limit;
+    if (frames == 0) {
+        vision_unmap(&map);
+        return "frame_too_small";
+    }
+
+    VisionDetection* dets = malloc(p.max_detections * sizeof(VisionDetection));
+    if (!dets) {
+        vision_unmap(&map);
+        return "out_of_memory";
+    }
+
+    VisionContext ctx;
+    vision_init(&ctx);
+    const char* err = NULL;
+    cJSON* arr = cJSON_AddArrayToObject(out, "frames");
+    double total_ms = 0.0;
+
+    for (size_t f = 0; f < frames && !err; f++) {
+        VisionFrame frame = { map.data + f * frame_bytes, w, h, stride, ch };
+        size_t count = 0;
+        double t0 = now_ms();
+        if (!vision_detect(&ctx, &frame, &p, dets, &count)) {
+            err = "out_of_memory";
+            break;
+        }
+        double ms = now_ms() - t0;
+        total_ms += ms;
+
+        cJSON* item = cJSON_CreateObject();
+        cJSON_AddNumberToObject(item, "index", (double)f);
+        cJSON_AddNumberToObject(item, "edge_pixels", ctx.edge_pixels);
+        cJSON_AddNumberToObject(item, "groups", ctx.group_count);
+        cJSON_AddNumberToObject(item, "compute_ms", ms);
+        cJSON* list = cJSON_AddArrayToObject(item, "detections");
+        for (size_t k = 0; k < count; k++) {
+            const VisionDetection* d = &dets[k];
+            const double* c = d->coeffs;
+            ConicResult r = analyze_conic(c[0], c[1], c[2], c[3], c[4], c[5]);
+            cJSON* det = cJSON_CreateObject();
+            conic_to_json(&r, det);
+            cJSON* e = cJSON_AddObjectToObject(det, "ellipse");
+            cJSON_AddNumberToObject(e, "cx", d->cx);
+            cJSON_AddNumberToObject(e, "cy", d->cy);
+            cJSON_AddNumberToObject(e, "a", d->a);
+            cJSON_AddNumberToObject(e, "b", d->b);
+            cJSON_AddNumberToObject(e, "theta", d->theta);
+            cJSON_AddNumberToObject(det, "pixels", d->pixels);
+            cJSON_AddNumberToObject(det, "residual", d->residual);
+            cJSON_AddNumberToObject(det, "coverage", d->coverage);
+            cJSON_AddItemToArray(list, det);
+        }
+        cJSON_AddItemToArray(arr, item);
+    }
+
+    if (!err) {
+        cJSON_AddNumberToObject(out, "width", w);
+        cJSON_AddNumberToObject(out, "height", h);
+        cJSON_AddNumberToObject(out, "frames_processed", (double)frames);
+        cJSON_AddNumberToObject(out, "ms_per_frame", total_ms / (double)frames);
+        cJSON_AddNumberToObject(out, "fps", total_ms > 0 ? 1000.0 * (double)frames / total_ms : 0.0);
+        cJSON_AddNumberToObject(out, "threads", tp_thread_count());
+    }
+
+    vision_free(&ctx);
+    free(dets);
+    vision_unmap(&map);
+    return err;
+}
+
+/**
+ * @brief Lee un par [x, y] (o terna si n == 3) de un array JSON.
+ */
+static bool read_tuple(const cJSON* arr, double* v, int n) {
+    if (!cJSON_IsArray(arr) || cJSON_GetArraySize(arr) != n) return false;
+    for (int i = 0; i < n; i++) {
+        const cJSON* it = cJSON_GetArrayItem(arr, i);
+        if (!cJSON_IsNumber(it)) return false;
+        v[i] = it->valuedouble;
+    }
+    return true;
+}
+
+/**
+ * @brief Convierte "problems" a restricciones en formato CSR.
+ */
+static const char* load_constraints(const cJSON* problems, Constraint** cons, uint32_t** offsets,
+                                    size_t* m) {
+    size_t count = (size_t)cJSON_GetArraySize(problems), total = 0;
+    const cJSON* pb;
+    cJSON_ArrayForEach(pb, problems) {
+        total += (size_t)cJSON_GetArraySize(cJSON_GetObjectItem(pb, "points"));
+        total += (size_t)cJSON_GetArraySize(cJSON_GetObjectItem(pb, "tangents"));
+        total += (size_t)cJSON_GetArraySize(cJSON_GetObjectItem(pb, "lines"));
+    }
+
+    *cons = malloc((total ? total : 1) * sizeof(Constraint));
+    *offsets = malloc((count + 1) * sizeof(uint32_t));
+    if (!*cons || !*offsets) return "out_of_memory";
+
+    size_t k = 0, i = 0;
+    (*offsets)[0] = 0;
+    cJSON_ArrayForEach(pb, problems) {
+        const cJSON* it;
+        cJSON_ArrayForEach(it, cJSON_GetObjectItem(pb, "points")) {
+            Constraint* c = &(*cons)[k++];
+            c->kind = CONSTRAINT_POINT;
+            if (!read_tuple(it, c->v, 2)) return "invalid_points";
+        }
+        cJSON_ArrayForEach(it, cJSON_GetObjectItem(pb, "tangents")) {
+            Constraint* c = &(*cons)[k++];
+            c->kind = CONSTRAINT_TANGENT;
+            if (!read_tuple(cJSON_GetObjectItem(it, "point"), c->v, 2) ||
+                !read_tuple(cJSON_GetObjectItem(it, "direction"), c->v + 2, 2)) {
+                return "invalid_tangents";
+            }
+        }
+        cJSON_ArrayForEach(it, cJSON_GetObjectItem(pb, "lines")) {
+            Constraint* c = &(*cons)[k++];
+            c->kind = CONSTRAINT_LINE;
+            if (!read_tuple(it, c->v, 3)) return "invalid_lines";
+        }
+        (*offsets)[++i] = (uint32_t)k;
+    }
+    *m = count;
+    return NULL;
+}
+
+/**
+ * @brief Modo "construct": cónicas por cinco condiciones, por lotes.
+ * @details Dos entradas:
+ *          - {"mode":"construct","problems":[{"points":[[x,y],...],
+ *            "tangents":[{"point":[x,y],"direction":[dx,dy]}],
+ *            "lines":[[a,b,c],...]}, ...]}: cada problema suma 5 filas
+ *            (punto 1, tangente en un punto 2; rectas solo las 5 a la
+ *            vez). Devuelve "conics" con el análisis, "cond" y "status".
+ *          - {"mode":"construct","points_file":"quintetos.bin"}: bloques
+ *            de 5 puntos float64 intercalados. Devuelve por emit_blob
+ *            (clave "conics") 7 float64 por problema: A..F y cond.
+ *          cond es la razón de pivotes (1 ideal, 0 degenerado). Sin
+ *          tiempo, los problemas sin resolver cuentan en "skipped".
+ */
+static const char* run_construct(const cJSON* root, cJSON* out) {
+    const cJSON* problems = cJSON_GetObjectItem(root, "problems");
+    bool binary = !cJSON_IsArray(problems);
+
+    Constraint* cons = NULL;
+    uint32_t* offsets = NULL;
+    double *xs = NULL, *ys = NULL;
+    size_t m = 0;
+    const char* err;
+    if (binary) {
+        size_t n = 0;
+        err = load_points(root, &xs, &ys, &n);
+        if (!err && n % 5 != 0) err = "points_not_multiple_of_5";
+        m = n / 5;
+    } else {
+        err = load_constraints(problems, &cons, &offsets, &m);
+    }
+
+    double* coeffs = NULL;
+    double* cond = NULL;
+    uint8_t* status = NULL;
+    if (!err) {
+        coeffs = malloc((m ? m : 1) * 7 * sizeof(double));
+        status = malloc(m ? m : 1);
+        if (!coeffs || !status) err = "out_of_memory";
+        else cond = coeffs + 6 * m;
+    }
+
+    double compute_ms = 0.0;
+    if (!err) {
+        double t0 = now_ms();
+        if (binary) construct_five_points_batch(xs, ys, m, coeffs, cond, status);
+        else construct_batch(cons, offsets, m, coeffs, cond, status);
+        compute_ms = now_ms() - t0;
+    }
+
+    size_t counts[CONSTRUCT_SKIPPED + 1] = { 0 };
+    if (!err && binary) {
+        ByteBuf buf;
+        buf_init(&buf);
+        if (!buf_reserve(&buf, m * 7 * sizeof(double) + 1)) {
+            err = "out_of_memory";
+        } else {
+            double* rec = (double*)buf.data;
+            for (size_t i = 0; i < m; i++) {
+                memcpy(rec + 7 * i, coeffs + 6 * i, 6 * sizeof(double));
+                rec[7 * i + 6] = cond[i];
+            }
+            buf.len = m * 7 * sizeof(double);
+            err = emit_blob(root, out, "conics", &buf);
+        }
+        buf_free(&buf);
+        for (size_t i = 0; i < m; i++) counts[status[i]]++;
+    } else if (!err) {
+        cJSON* arr = cJSON_AddArrayToObject(out, "conics");
+        for (size_t i = 0; i < m; i++) {
+            cJSON* item = cJSON_CreateObject();
+            if (status[i] == CONSTRUCT_OK) {
+                const double* c = coeffs + 6 * i;
+                ConicResult r = analyze_conic(c[0], c[1], c[2], c[3], c[4], c[5]);
+                conic_to_json(&r, item);
+            }
+            cJSON_AddNumberToObject(item, "cond", cond[i]);
+            cJSON_AddStringToObject(item, "status", construct_status_str(status[i]));
+            cJSON_AddItemToArray(arr, item);
+            counts[status[i]]++;
+        }
+    }
+
+    if (!err) {
+        cJSON_AddNumberToObject(out, "problems", (double)m);
+        cJSON_AddNumberToObject(out, "ok_count", (double)counts[CONSTRUCT_OK]);
+        cJSON_AddNumberToObject(out, "degenerate", (double)counts[CONSTRUCT_DEGENERATE]);
+        cJSON_AddNumberToObject(out, "invalid", (double)counts[CONSTRUCT_INVALID]);
+        if (counts[CONSTRUCT_SKIPPED]) cJSON_AddNumberToObject(out, "skipped", (double)counts[CONSTRUCT_SKIPPED]);
+        cJSON_AddNumberToObject(out, "threads", tp_thread_count());
+        cJSON_AddNumberToObject(out, "compute_ms", compute_ms);
+    }
+
+    free(cons);
+    free(offsets);
+    free(xs);
+    free(coeffs);
+    free(status);
+    return err;
+}
+
+/**
+ * Tabla de modos. El modo se elige con la clave "mode" del JSON o con
+ * el flag equivalente en la línea de comandos (p.ej. --conic, --batch).
+ */
+static const struct {
+    const char* name;
+    ModeHandler run;
+} MODES[] = {
+    { "conic",  run_conic  },
+    { "update", run_update },
+    { "progressive", run_progressive },
+    { "pack",  run_pack  },
+    { "batch", run_batch },
+    { "phase", run_phase },
+    { "morph", run_morph },
+    { "intersect", run_intersect },
+    { "arrangement", run_arrangement },
+    { "pick", run_pick },
+    { "distance", run_distance },
+    { "fit", run_fit },
+    { "ransac", run_ransac },
+    { "detect", run_detect },
+    { "construct", run_construct },
+    { "bezier", run_bezier },
+    { "polyline", run_polyline },
+    { "vertices", run_vertices },
+    { "raster", run_raster },
+    { "export", run_export },
+    { "tiles", run_tiles },
+};
+
+static ModeHandler find_mode(const char* name) {
+    for (size_t i = 0; i < sizeof(MODES) / sizeof(MODES[0]); i++) {
+        if (strcmp(MODES[i].name, name) == 0) return MODES[i].run;
+    }
+    return NULL;
+}
+
+//-------------------------------------------//
+//             MODO RESIDENTE                //
+//-------------------------------------------//
+
+/*
+ * --serve: el proceso se queda vivo leyendo una petición JSON por línea
+ * de stdin y contesta en stdout con NDJSON. Cada petición corre en su
+ * propio hilo (las regiones paralelas entran al pool compartido) y sus
+ * líneas llevan el "id" que trajo; la última es la respuesta final, con
+ * "ok". La línea {"cancel": <id>} marca el presupuesto de esa petición:
+ * los bucles largos lo sondean (budget.h) y, si alguno paró por ello, la
+ * respuesta final es {"ok":false,"error":"cancelled"}; si el modo ya
+ * había terminado, sale su resultado normal. Al cerrar stdin se esperan
+ * las peticiones en curso.
+ */
+
+#define SERVE_MAX_ACTIVE 64
+
+typedef struct {
+    bool        used;
+    cJSON*      root;
+    char*       id;             // "id" impreso, para comparar con los cancel
+    const char* mode;           // modo por defecto (flag de la CLI)
+    Budget      budget;
+} ServeSlot;
+
+static ServeSlot       serve_slots[SERVE_MAX_ACTIVE];
+static size_t          serve_active = 0;
+static pthread_mutex_t serve_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  serve_idle = PTHREAD_COND_INITIALIZER;
+
+/**
+ * @brief Añade "truncated" (si la petición traía "budget_ms") y "timing_ms".
+ */
+static void finish_response(const cJSON* root, const Budget* budget, cJSON* out, double t0) {
+    if (json_number(root, "budget_ms", 0.0) > 0.0) {
+        cJSON_AddBoolToObject(out, "truncated", budget_truncated(budget));
+    }
+    cJSON_AddNumberToObject(out, "timing_ms", now_ms() - t0);
+}
+
+/**
+ * @brief Contesta {"ok":false,"error":err} a la petición id (puede ser NULL).
+ */
+static void serve_error(const cJSON* id, const char* err) {
+    cJSON* out = cJSON_CreateObject();
+    cJSON_AddBoolToObject(out, "ok", 0);
+    cJSON_AddStringToObject(out, "error", err);
+    const cJSON* saved = tls_request_id;
+    tls_request_id = id;
+    emit_frame(out);
+    tls_request_id = saved;
+}
+
+/**
+ * @brief Lee una línea de fp sin límite de longitud (NULL al final).
+ */
+static char* read_line(FILE* fp) {
+    size_t cap = 4096, len = 0;
+    char* buf = malloc(cap);
+    if (!buf) return NULL;
+
+    while (fgets(buf + len, (int)(cap - len), fp)) {
+        len += strlen(buf + len);
+        if (len > 0 && buf[len - 1] == '\n') break;
+        if (cap - len < 2) {
+            char* grown = realloc(buf, cap * 2);
+            if (!grown) {
+                free(buf);
+                return NULL;
+            }
+            buf = grown;
+            cap *= 2;
+        }
+    }
+    if (len == 0) {
+        free(buf);
+        return NULL;
+    }
+    return buf;
+}
+
+/**
+ * @brief Hilo de una petición: despacha el modo bajo su presupuesto y
+ *        emite la respuesta final con su "id".
+ */
+static void* serve_request(void* arg) {
+    ServeSlot* slot = arg;
+    double t0 = now_ms();
+
+    budget_swap(&slot->budget);
+    tls_request_id = cJSON_GetObjectItem(slot->root, "id");
+
+    const char* mode = json_string(slot->root, "mode");
+    ModeHandler run = find_mode(mode ? mode : slot->mode);
+
+    cJSON* out = cJSON_CreateObject();
+    cJSON_AddBoolToObject(out, "ok", 1);
+    const char* err = run ? NULL : "unknown_mode";
+    if (!err && budget_cancelled(&slot->budget)) err = "cancelled";
+    if (!err) err = run(slot->root, out);
+
+    // Solo se descarta lo que la cancelación cortó: un error o un bucle
+    // que paró antes de tiempo (un resultado ya completo se entrega)
+    if (budget_cancelled(&slot->budget) && (err || budget_truncated(&slot->budget))) {
+        err = "cancelled";
+    }
+
+    if (err) {
+        cJSON_Delete(out);
+        serve_error(tls_request_id, err);
+    } else {
+        finish_response(slot->root, &slot->budget, out, t0);
+        emit_frame(out);
+    }
+
+    budget_swap(NULL);
+    tls_request_id = NULL;
+
+    pthread_mutex_lock(&serve_lock);
+    cJSON_Delete(slot->root);
+    free(slot->id);
+    slot->root = NULL;
+    slot->id = NULL;
+    slot->used = false;
+    if (--serve_active == 0) pthread_cond_broadcast(&serve_idle);
+    pthread_mutex_unlock(&serve_lock);
+    return NULL;
+}
+
+/**
+ * @brief Reserva un hueco para root y lanza su hilo (se queda con root).
+ */
+static void serve_start(cJSON* root, const char* default_mode) {
+    const cJSON* id = cJSON_GetObjectItem(root, "id");
+
+    pthread_mutex_lock(&serve_lock);
+    ServeSlot* slot = NULL;
+    for (size_t i = 0; i < SERVE_MAX_ACTIVE && !slot; i++) {
+        if (!serve_slots[i].used) slot = &serve_slots[i];
+    }
+    if (!slot) {
+        pthread_mutex_unlock(&serve_lock);
+        serve_error(id, "busy");
+        cJSON_Delete(root);
+        return;
+    }
+    slot->used = true;
+    slot->root = root;
+    slot->id = id ? cJSON_PrintUnformatted(id) : NULL;
+    slot->mode = default_mode;
+    budget_init(&slot->budget, json_number(root, "budget_ms", 0.0));
+    serve_active++;
+    pthread_mutex_unlock(&serve_lock);
+
+    pthread_t thread;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int rc = pthread_create(&thread, &attr, serve_request, slot);
+    pthread_attr_destroy(&attr);
+    if (rc == 0) return;
+
+    serve_error(id, "thread_failed");
+    pthread_mutex_lock(&serve_lock);
+    cJSON_Delete(slot->root);
+    free(slot->id);
+    slot->root = NULL;
+    slot->id = NULL;
+    slot->used = false;
+    if (--serve_active == 0) pthread_cond_broadcast(&serve_idle);
+    pthread_mutex_unlock(&serve_lock);
+}
+
+/**
+ * @brief Cancela las peticiones en curso cuyo "id" es igual a id.
+ */
+static void serve_cancel(const cJSON* id) {
+    char* key = cJSON_PrintUnformatted(id);
+    if (!key) return;
+
+    pthread_mutex_lock(&serve_lock);
+    for (size_t i = 0; i < SERVE_MAX_ACTIVE; i++) {
+        ServeSlot* slot = &serve_slots[i];
+        if (slot->used && slot->id && strcmp(slot->id, key) == 0) budget_cancel(&slot->budget);
+    }
+    pthread_mutex_unlock(&serve_lock);
+    free(key);
+}
+
+/**
+ * @brief Bucle de --serve: una petición (o un cancel) por línea de stdin.
+ * @return Código de salida del proceso.
+ */
+static int serve_main(const char* default_mode) {
+    serving = true;
+
+    char* line;
+    while ((line = read_line(stdin)) != NULL) {
+        if (line[strspn(line, " \t\r\n")] == '\0') {
+            free(line);
+            continue;
+        }
+        cJSON* root = cJSON_Parse(line);
+        free(line);
+
+        if (!cJSON_IsObject(root)) {
+            cJSON_Delete(root);
+            serve_error(NULL, "invalid_json");
+            continue;
+        }
+
+        const cJSON* cancel = cJSON_GetObjectItem(root, "cancel");
+        if (cancel) {
+            serve_cancel(cancel);
+            cJSON_Delete(root);
+            continue;
+        }
+        serve_start(root, default_mode);
+    }
+
+    pthread_mutex_lock(&serve_lock);
+    while (serve_active > 0) pthread_cond_wait(&serve_idle, &serve_lock);
+    pthread_mutex_unlock(&serve_lock);
+
+    tp_shutdown();
+    return 0;
+}
+
 //-------------------------------------------//
 //                 MAIN FLOW                 //
 //-------------------------------------------//
 
 /**
- * @brief Ejecuta el flujo CLI: leer JSON, analizar cónica y emitir JSON.
+ * @brief Ejecuta el flujo CLI: leer JSON, despachar el modo y emitir JSON.
+ * @param argc Número de argumentos.
+ * @param argv Flags: --<modo> selecciona el modo si el JSON no lo indica;
+ *             --threads N fija los hilos del pool (0 = todas las CPUs);
+ *             --serve deja el proceso residente (ver serve_main).
  * @return Código de salida del proceso (0 éxito, !=0 error).
  */
-int main(void) {
-    clock_t t0 = clock();
+int main(int argc, char** argv) {
+    double t0 = now_ms();
+
+    const char* cli_mode = "conic";
+    int threads = 0;
+    bool serve = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strncmp(argv[i], "--threads=", 10) == 0) {
+            threads = atoi(argv[i] + 10);
+        } else if (strcmp(argv[i], "--serve") == 0) {
+            serve = true;
+        } else if (strncmp(argv[i], "--", 2) == 0 && find_mode(argv[i] + 2)) {
+            cli_mode = argv[i] + 2;
+        }
+    }
+
+    // El pool arranca en la primera región paralela (el modo conic no paga hilos)
+    tp_configure(threads);
+    if (serve) return serve_main(cli_mode);
 
     /* 1. leer input */
     char* input = read_stdin();
     if (!input) {
         fprintf(stderr, "{\"ok\":false,\"error\":\"stdin_read_failed\"}\n");
+        tp_shutdown();
         return 1;
     }
 
@@ -91,83 +2766,55 @@ int main(void) {
 
     if (!root) {
         fprintf(stderr, "{\"ok\":false,\"error\":\"invalid_json\"}\n");
+        tp_shutdown();
         return 1;
     }
 
-    /* 2. extraer coeficientes */
-    double A = cJSON_GetObjectItem(root, "A")->valuedouble;
-    double B = cJSON_GetObjectItem(root, "B")->valuedouble;
-    double C = cJSON_GetObjectItem(root, "C")->valuedouble;
-    double D = cJSON_GetObjectItem(root, "D")->valuedouble;
-    double E = cJSON_GetObjectItem(root, "E")->valuedouble;
-    double F = cJSON_GetObjectItem(root, "F")->valuedouble;
-
-    cJSON_Delete(root);
+    /* 2. seleccionar modo */
+    const char* mode = json_string(root, "mode");
+    if (!mode) mode = cli_mode;
 
-    /* 3. análisis matemático */
-    ConicResult r = analyze_conic(A, B, C, D, E, F);
+    ModeHandler run = find_mode(mode);
+    if (!run) {
+        cJSON_Delete(root);
+        fprintf(stderr, "{\"ok\":false,\"error\":\"unknown_mode\"}\n");
+        tp_shutdown();
+        return 1;
+    }
 
-    /* 4. construir JSON de salida */
+    /* 3. análisis y construcción del JSON de salida */
     cJSON* out = cJSON_CreateObject();
     cJSON_AddBoolToObject(out, "ok", 1);
 
-    /* coeficientes */
-    cJSON* coeffs = cJSON_AddObjectToObject(out, "coefficients");
-    cJSON_AddNumberToObject(coeffs, "A", A);
-    cJSON_AddNumberToObject(coeffs, "B", B);
-    cJSON_AddNumberToObject(coeffs, "C", C);
-    cJSON_AddNumberToObject(coeffs, "D", D);
-    cJSON_AddNumberToObject(coeffs, "E", E);
-    cJSON_AddNumberToObject(coeffs, "F", F);
+    // "budget_ms": plazo para los bucles largos (resultado parcial si vence)
+    Budget budget;
+    budget_init(&budget, json_number(root, "budget_ms", 0.0));
+    budget_swap(&budget);
 
-    /* clasificación */
-    cJSON_AddStringToObject(out, "type", conic_type_str(r.type));
-    cJSON_AddNumberToObject(out, "delta", r.delta);
+    const char* err = run(root, out);
+    tp_shutdown();
+    budget_swap(NULL);
 
-    /* centro */
-    cJSON* center = cJSON_AddObjectToObject(out, "center");
-    cJSON_AddBoolToObject(center, "exists", r.has_center);
-    if (r.has_center) {
-        cJSON_AddNumberToObject(center, "x", r.cx);
-        cJSON_AddNumberToObject(center, "y", r.cy);
+    if (err) {
+        cJSON_Delete(root);
+        cJSON_Delete(out);
+        fprintf(stderr, "{\"ok\":false,\"error\":\"%s\"}\n", err);
+        return 1;
     }
 
-    /* rotación */
-    cJSON* rotation = cJSON_AddObjectToObject(out, "rotation");
-    cJSON_AddBoolToObject(rotation, "has_rotation", r.has_rotation);
-    cJSON_AddNumberToObject(rotation, "theta", r.theta);
-
-    /* parámetros canónicos (para render analítico React) */
-    cJSON* canonical = cJSON_CreateObject();
-    cJSON_AddBoolToObject(canonical, "exists", r.has_canonical);
-    if (r.has_canonical) {
-        cJSON_AddNumberToObject(canonical, "a", r.a);
-        cJSON_AddNumberToObject(canonical, "b", r.b);
-    }
-    cJSON_AddItemToObject(out, "canonical", canonical);
+    /* truncated y timing */
+    finish_response(root, &budget, out, t0);
+    cJSON_Delete(root);
 
-    /* puntos muestreados (fallback React) */
-    cJSON* pts = cJSON_AddArrayToObject(out, "points");
-    for (int i = 0; i < r.point_count; i++) {
-        cJSON* p = cJSON_CreateObject();
-        cJSON_AddNumberToObject(p, "x", r.points[i].x);
-        cJSON_AddNumberToObject(p, "y", r.points[i].y);
-        cJSON_AddItemToArray(pts, p);
+    /* 4. output (si el modo no ha volcado ya un binario por stdout) */
+    if (!stdout_taken) {
+        char* json_out = cJSON_PrintUnformatted(out);
+        printf("%s\n", json_out);
+        free(json_out);
     }
 
-    /* timing */
-    clock_t t1 = clock();
-    double elapsed_ms = 1000.0 * (double)(t1 - t0) / CLOCKS_PER_SEC;
-    cJSON_AddNumberToObject(out, "timing_ms", elapsed_ms);
-
-    /* 5. output */
-    char* json_out = cJSON_PrintUnformatted(out);
-    printf("%s\n", json_out);
-
     /* cleanup */
-    free(json_out);
     cJSON_Delete(out);
 
     return 0;
 }
-
@@ -0,0 +1,171 @@
+//================================================================//
+// MORPH - Frames de animación entre dos cónicas
+//================================================================//
+//
+// Los frames son independientes: se analizan en paralelo en el pool y
+// después se empaquetan en orden (cabecera, registros, puntos).
+//
+//--------------------------------//
+// Includes y dependencias
+//--------------------------------//
+#include "morph.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "budget.h"
+#include "threadpool.h"
+
+_Static_assert(sizeof(MorphHeader) == 16, "MorphHeader debe ocupar 16 bytes");
+_Static_assert(sizeof(MorphFrame) == 48, "MorphFrame debe ocupar 48 bytes");
+
+/**
+ * @file morph.c
+ * @brief Interpolación en el haz de cónicas y empaquetado de frames.
+ */
+
+typedef struct {
+    double       c0[6];
+    double       c1[6];
+    int          frames;
+    ConicResult* results;
+    bool*        unsampled;
+} MorphJob;
+
+/**
+ * @brief Análisis sin muestreo (analyze_conic_columns con una fila).
+ */
+static void analyze_unsampled(const double c[6], ConicResult* r) {
+    int32_t type;
+    uint32_t flags;
+    ConicCoeffColumns in = { &c[0], &c[1], &c[2], &c[3], &c[4], &c[5] };
+    ConicResultColumns out = { &type, &flags, &r->delta, &r->cx, &r->cy, &r->theta, &r->a, &r->b };
+    analyze_conic_columns(&in, &out, 0, 1);
+
+    r->type = (ConicType)type;
+    r->has_center = flags & CONIC_FLAG_CENTER;
+    r->has_rotation = flags & CONIC_FLAG_ROTATION;
+    r->has_canonical = flags & CONIC_FLAG_CANONICAL;
+    r->point_count = 0;
+}
+
+/**
+ * @brief Analiza los frames [begin, end); sin tiempo (budget.h) los
+ *        frames que faltan se analizan sin puntos.
+ */
+static void morph_range(size_t begin, size_t end, void* ctx) {
+    MorphJob* job = ctx;
+
+    for (size_t i = begin; i < end; i++) {
+        double l = (double)i / (double)(job->frames - 1);
+        double c[6];
+        for (int k = 0; k < 6; k++) c[k] = (1.0 - l) * job->c0[k] + l * job->c1[k];
+
+        job->unsampled[i] = budget_exhausted();
+        if (job->unsampled[i]) analyze_unsampled(c, &job->results[i]);
+        else job->results[i] = analyze_conic(c[0], c[1], c[2], c[3], c[4], c[5]);
+    }
+}
+
+/**
+ * @brief Escala c a norma euclídea 1 (sin cambiar la cónica).
+ */
+static void normalize6(double c[6]) {
+    double n = 0.0;
+    for (int k = 0; k < 6; k++) n += c[k] * c[k];
+    n = sqrt(n);
+    if (n > 0) for (int k = 0; k < 6; k++) c[k] /= n;
+}
+
+/**
+ * @brief Genera y empaqueta los frames de la transición C0 -> C1.
+ * @param p Parámetros de la animación.
+ * @param out Buffer de salida (se añade al final).
+ * @details Con normalize, C0 y C1 se llevan a norma 1 y C1 se orienta
+ *          hacia C0 (producto escalar >= 0): k·C describe la misma cónica
+ *          para todo k != 0, así que sin normalizar la velocidad aparente
+ *          de la animación depende de la escala arbitraria de cada entrada.
+ */
+bool morph_generate(const MorphParams* p, ByteBuf* out) {
+    if (p->frames < 2 || p->frames > MORPH_MAX_FRAMES) return false;
+
+    MorphJob job;
+    memcpy(job.c0, p->from, sizeof(job.c0));
+    memcpy(job.c1, p->to, sizeof(job.c1));
+    job.frames = p->frames;
+
+    if (p->normalize) {
+        normalize6(job.c0);
+        normalize6(job.c1);
+        double dot = 0.0;
+        for (int k = 0; k < 6; k++) dot += job.c0[k] * job.c1[k];
+        if (dot < 0) for (int k = 0; k < 6; k++) job.c1[k] = -job.c1[k];
+    }
+
+    job.results = malloc((size_t)p->frames * sizeof(ConicResult));
+    job.unsampled = malloc((size_t)p->frames * sizeof(bool));
+    if (!job.results || !job.unsampled) {
+        free(job.results);
+        free(job.unsampled);
+        return false;
+    }
+
+    tp_parallel_for(0, (size_t)p->frames, 1, morph_range, &job);
+
+    uint32_t total = 0;
+    for (int i = 0; i < p->frames; i++) total += (uint32_t)job.results[i].point_count;
+
+    size_t bytes = sizeof(MorphHeader)
+                 + (size_t)p->frames * sizeof(MorphFrame)
+                 + (size_t)total * 2 * sizeof(float);
+    if (!buf_reserve(out, bytes)) {
+        free(job.results);
+        free(job.unsampled);
+        return false;
+    }
+
+    MorphHeader h;
+    memcpy(h.magic, MORPH_MAGIC, 4);
+    h.version = MORPH_VERSION;
+    h.frames = (uint32_t)p->frames;
+    h.total_points = total;
+    buf_append(out, &h, sizeof(h));
+
+    uint32_t offset = 0;
+    for (int i = 0; i < p->frames; i++) {
+        const ConicResult* r = &job.results[i];
+        MorphFrame f;
+        f.lambda = (float)((double)i / (double)(p->frames - 1));
+        f.type = (int32_t)r->type;
+        f.flags = (r->has_center    ? CONIC_FLAG_CENTER    : 0u) |
+                  (r->has_rotation  ? CONIC_FLAG_ROTATION  : 0u) |
+                  (r->has_canonical ? CONIC_FLAG_CANONICAL : 0u) |
+                  (job.unsampled[i] ? MORPH_FLAG_UNSAMPLED : 0u);
+        f.point_offset = offset;
+        f.point_count = (uint32_t)r->point_count;
+        f.delta = (float)r->delta;
+        f.cx = (float)r->cx;
+        f.cy = (float)r->cy;
+        f.theta = (float)r->theta;
+        f.a = (float)r->a;
+        f.b = (float)r->b;
+        f.reserved = 0;
+        buf_append(out, &f, sizeof(f));
+        offset += f.point_count;
+    }
+
+    for (int i = 0; i < p->frames; i++) {
+        const ConicResult* r = &job.results[i];
+        float* dst = (float*)(out->data + out->len);
+        for (int k = 0; k < r->point_count; k++) {
+            dst[2 * k]     = (float)r->points[k].x;
+            dst[2 * k + 1] = (float)r->points[k].y;
+        }
+        out->len += (size_t)r->point_count * 2 * sizeof(float);
+    }
+
+    free(job.results);
+    free(job.unsampled);
+    return true;
+}
@@ -0,0 +1,70 @@
+//================================================================//
+//         MORPH HEADER - Animación entre cónicas (haz)           //
+//================================================================//
+//
+// Genera en una sola llamada todos los frames de la transición
+// C(λ) = (1-λ)·C0 + λ·C1, con λ ∈ [0, 1], analizados y muestreados
+// en paralelo, empaquetados en un buffer compacto para el renderer.
+//
+// Disposición del buffer (little-endian, sin relleno):
+//
+//   MorphHeader                       16 bytes
+//   MorphFrame[frames]                48 bytes cada uno
+//   float32 xy[total_points][2]       puntos de todos los frames
+//
+// El frame i ocupa los puntos [point_offset, point_offset + point_count).
+//
+
+#ifndef MORPH_H
+#define MORPH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "conics.h"
+#include "utils.h"
+
+#define MORPH_MAGIC       "CMRF"
+#define MORPH_VERSION     1
+#define MORPH_MAX_FRAMES  10000
+
+// Bit de MorphFrame.flags (aparte de CONIC_FLAG_*): frame analizado sin
+// puntos porque venció el presupuesto (budget.h)
+#define MORPH_FLAG_UNSAMPLED 0x100u
+
+typedef struct {
+    char     magic[4];        // "CMRF"
+    uint32_t version;
+    uint32_t frames;
+    uint32_t total_points;
+} MorphHeader;
+
+typedef struct {
+    float    lambda;
+    int32_t  type;            // ConicType
+    uint32_t flags;           // CONIC_FLAG_* | MORPH_FLAG_UNSAMPLED
+    uint32_t point_offset;
+    uint32_t point_count;
+    float    delta;
+    float    cx, cy;
+    float    theta;
+    float    a, b;
+    uint32_t reserved;
+} MorphFrame;
+
+typedef struct {
+    double from[6];           // C0 (λ = 0)
+    double to[6];             // C1 (λ = 1)
+    int    frames;            // >= 2
+    bool   normalize;         // escalar C0 y C1 a norma 1 antes de mezclar
+} MorphParams;
+
+/**
+ * Calcula todos los frames y los empaqueta en out. Si vence el
+ * presupuesto del hilo, los frames restantes van sin puntos y con
+ * MORPH_FLAG_UNSAMPLED.
+ * Devuelve false si los parámetros no son válidos o no hay memoria.
+ */
+bool morph_generate(const MorphParams* p, ByteBuf* out);
+
+#endif
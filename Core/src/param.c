@@ -0,0 +1,305 @@
+//================================================================//
+// PARAM - Ramas con parametrización cerrada y recorte a ventana
+//================================================================//
+//
+// La cónica se normaliza (max |coef| = 1) antes de pedir su marco
+// principal, de modo que las tolerancias de conic_frame son relativas y
+// una elipse con coeficientes pequeños no se toma por degenerada.
+//
+//--------------------------------//
+// Includes y dependencias
+//--------------------------------//
+#include "param.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "conics.h"
+#include "poly.h"
+
+/**
+ * @file param.c
+ * @brief Ramas y recorte descritos en param.h.
+ */
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// |autovalor| por debajo del cual la forma cuadrática se anula en ese eje
+#define PARAM_EIG_EPS 1e-12
+
+//-------------------------------------------//
+//           FUNCIONES AUXILIARES            //
+//-------------------------------------------//
+
+static void set_branch(ConicBranch* b, ParamKind kind, double ox, double oy,
+                       double ux, double uy, double vx, double vy) {
+    b->kind = kind;
+    b->ox = ox; b->oy = oy;
+    b->ux = ux; b->uy = uy;
+    b->vx = vx; b->vy = vy;
+}
+
+/**
+ * @brief Recta que pasa por (ox, oy) con dirección (dx, dy) (se normaliza).
+ */
+static void set_line(ConicBranch* b, double ox, double oy, double dx, double dy) {
+    double n = hypot(dx, dy);
+    set_branch(b, PARAM_LINE, ox, oy, dx / n, dy / n, 0.0, 0.0);
+}
+
+/**
+ * @brief Ramas de una cónica sin centro (parábola o rectas paralelas).
+ * @details En el marco propio, con n el eje de autovalor lam ≠ 0 y z el
+ *          de autovalor nulo: lam·n² + Dn·n + Dz·z + F = 0. Si Dz ≠ 0 la
+ *          curva es la gráfica z(n), una parábola con vértice en n0; si
+ *          no, se reduce a las rectas n = raíz de lam·n² + Dn·n + F.
+ */
+static int parabolic_branches(const double k[6], const ConicFrame* f, bool degenerate,
+                              ConicBranch* out) {
+    double cs = f->cos_t, sn = f->sin_t;
+    double nx = cs, ny = sn, zx = -sn, zy = cs, lam = f->l1;
+    if (fabs(f->l1) < fabs(f->l2)) {
+        nx = -sn; ny = cs; zx = cs; zy = sn;
+        lam = f->l2;
+    }
+    double Dn = k[3]*nx + k[4]*ny;
+    double Dz = k[3]*zx + k[4]*zy;
+
+    if (!degenerate && fabs(Dz) > PARAM_EIG_EPS) {
+        double n0 = -Dn / (2.0 * lam);
+        double z0 = -(lam*n0*n0 + Dn*n0 + k[5]) / Dz;
+        double q = -lam / Dz;
+        set_branch(out, PARAM_PARABOLA, n0*nx + z0*zx, n0*ny + z0*zy,
+                   nx, ny, q*zx, q*zy);
+        return 1;
+    }
+
+    double r[2];
+    int m = poly_solve_quadratic(lam, Dn, k[5], r);
+    if (m == 2 && r[1] - r[0] <= 1e-12 * fmax(1.0, fabs(r[0]))) m = 1;
+    for (int i = 0; i < m; i++) set_line(&out[i], r[i]*nx, r[i]*ny, zx, zy);
+    return m;
+}
+
+/**
+ * @brief Raíces de O_a + f1(t)·U_a + f2(t)·V_a = w en el eje a de la rama.
+ * @return Número de raíces escritas en t (0..2).
+ */
+static int edge_crossings(const ConicBranch* b, int axis, double w, double t[2]) {
+    double o = axis ? b->oy : b->ox;
+    double u = axis ? b->uy : b->ux;
+    double v = axis ? b->vy : b->vx;
+    double c = w - o;
+    double r[2];
+    int m, k = 0;
+
+    switch (b->kind) {
+        case PARAM_ARC: {
+            // u·cos t + v·sin t = R·cos(t - φ) = c
+            double R = hypot(u, v);
+            if (R == 0.0 || fabs(c) > R) return 0;
+            double phi = atan2(v, u), a = acos(c / R);
+            t[0] = remainder(phi - a, 2.0 * M_PI);
+            t[1] = remainder(phi + a, 2.0 * M_PI);
+            return 2;
+        }
+        case PARAM_HYPERBOLA:
+            // z = e^t: (u + v)·z² - 2c·z + (u - v) = 0
+            m = poly_solve_quadratic(u + v, -2.0 * c, u - v, r);
+            for (int i = 0; i < m; i++) {
+                if (r[i] > 0.0) t[k++] = log(r[i]);
+            }
+            return k;
+        case PARAM_PARABOLA:
+            return poly_solve_quadratic(v, u, -c, t);
+        case PARAM_LINE:
+            if (u == 0.0) return 0;
+            t[0] = c / u;
+            return 1;
+    }
+    return 0;
+}
+
+static bool inside_window(const ConicBranch* b, const double w[4], double tol, double t) {
+    double p[2];
+    branch_eval(b, t, p, NULL);
+    return p[0] >= w[0] - tol && p[0] <= w[2] + tol &&
+           p[1] >= w[1] - tol && p[1] <= w[3] + tol;
+}
+
+static int cmp_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Añade [t0, t1] a out, fusionándolo con el anterior si lo continúa.
+ */
+static void push_interval(ParamInterval* out, int* count, bool* prev_inside,
+                          double t0, double t1) {
+    if (*prev_inside && *count > 0) {
+        out[*count - 1].t1 = t1;
+    } else if (*count < PARAM_MAX_INTERVALS) {
+        out[*count] = (ParamInterval){ t0, t1, false };
+        (*count)++;
+    }
+    *prev_inside = true;
+}
+
+//-------------------------------------------//
+//               API PÚBLICA                 //
+//-------------------------------------------//
+
+/**
+ * @brief Ramas reales de c = [A..F].
+ * @param c Coeficientes.
+ * @param out Ramas de salida (hasta PARAM_MAX_BRANCHES).
+ * @return Número de ramas.
+ * @details Casos:
+ *          - A = B = C = 0: una recta (si D o E no son nulos).
+ *          - Con centro, l1·u² + l2·v² + f0 = 0: elipse si l1, l2 y -f0
+ *            tienen el mismo signo; hipérbola (dos ramas sobre el eje
+ *            transverso) si l1, l2 difieren; si f0 ≈ 0 (degenerada), dos
+ *            rectas v = ±sqrt(-l1/l2)·u por el centro o un punto.
+ *          - Sin centro: ver parabolic_branches.
+ */
+int conic_branches(const double c[6], ConicBranch out[PARAM_MAX_BRANCHES]) {
+    double scale = 0.0;
+    for (int i = 0; i < 6; i++) scale = fmax(scale, fabs(c[i]));
+    if (scale == 0.0) return 0;
+
+    double k[6];
+    for (int i = 0; i < 6; i++) k[i] = c[i] / scale;
+
+    // Sin parte cuadrática: D·x + E·y + F = 0
+    if (fmax(fabs(k[0]), fmax(fabs(k[1]), fabs(k[2]))) <= PARAM_EIG_EPS) {
+        double nn = k[3]*k[3] + k[4]*k[4];
+        if (nn <= PARAM_EIG_EPS * PARAM_EIG_EPS) return 0;
+        set_line(&out[0], -k[5]*k[3] / nn, -k[5]*k[4] / nn, -k[4], k[3]);
+        return 1;
+    }
+
+    ConicFrame f;
+    conic_frame(k, &f);
+    bool degenerate = f.type == CONIC_DEGENERATE;
+    if (!f.has_center) return parabolic_branches(k, &f, degenerate, out);
+
+    double cs = f.cos_t, sn = f.sin_t;
+    double l1 = f.l1, l2 = f.l2, f0 = f.f0;
+
+    if (degenerate) {
+        if (l1 * l2 >= 0.0) return 0;       // un punto
+        double s = sqrt(-l1 / l2);
+        set_line(&out[0], f.cx, f.cy, cs - s*sn, sn + s*cs);
+        set_line(&out[1], f.cx, f.cy, cs + s*sn, sn - s*cs);
+        return 2;
+    }
+
+    if (l1 * l2 > 0.0) {
+        if (l1 * f0 >= 0.0) return 0;       // elipse imaginaria
+        double a = sqrt(-f0 / l1), b = sqrt(-f0 / l2);
+        set_branch(&out[0], PARAM_ARC, f.cx, f.cy, a*cs, a*sn, -b*sn, b*cs);
+        return 1;
+    }
+
+    // Hipérbola: U sobre el eje transverso (l·x² = -f0 > 0) y V sobre el otro
+    double tx = cs, ty = sn, cx = -sn, cy = cs, lt = l1, lc = l2;
+    if (l1 * f0 >= 0.0) {
+        tx = -sn; ty = cs; cx = cs; cy = sn;
+        lt = l2; lc = l1;
+    }
+    double a = sqrt(-f0 / lt), b = sqrt(f0 / lc);
+    for (int s = 0; s < 2; s++) {
+        double sg = s ? -1.0 : 1.0;
+        set_branch(&out[s], PARAM_HYPERBOLA, f.cx, f.cy,
+                   sg*a*tx, sg*a*ty, b*cx, b*cy);
+    }
+    return 2;
+}
+
+/**
+ * @brief Punto y derivada de la rama en t.
+ */
+void branch_eval(const ConicBranch* b, double t, double p[2], double d[2]) {
+    double f1, f2, g1, g2;
+    switch (b->kind) {
+        case PARAM_ARC:       f1 = cos(t);  f2 = sin(t);  g1 = -f2; g2 = f1; break;
+        case PARAM_HYPERBOLA: f1 = cosh(t); f2 = sinh(t); g1 = f2;  g2 = f1; break;
+        case PARAM_PARABOLA:  f1 = t;       f2 = t*t;     g1 = 1.0; g2 = 2.0*t; break;
+        default:              f1 = t;       f2 = 0.0;     g1 = 1.0; g2 = 0.0; break;
+    }
+    p[0] = b->ox + f1*b->ux + f2*b->vx;
+    p[1] = b->oy + f1*b->uy + f2*b->vy;
+    if (d) {
+        d[0] = g1*b->ux + g2*b->vx;
+        d[1] = g1*b->uy + g2*b->vy;
+    }
+}
+
+/**
+ * @brief Tramos de la rama dentro de la ventana.
+ * @param b Rama.
+ * @param window Ventana [x_min, y_min, x_max, y_max].
+ * @param out Tramos de salida, ordenados por t.
+ * @return Número de tramos.
+ * @details Los cortes con las rectas de los cuatro bordes parten el
+ *          dominio; cada trozo se clasifica por su punto medio y los
+ *          trozos interiores contiguos se fusionan (cortes tangentes o
+ *          fuera del segmento del borde). Las ramas no acotadas no vuelven
+ *          a entrar tras el último corte, así que sus colas quedan fuera.
+ *          En la elipse el recorrido es cíclico y empieza tras un trozo
+ *          exterior, por lo que un tramo puede cruzar t = π (t1 > π).
+ */
+int branch_clip(const ConicBranch* b, const double window[4],
+                ParamInterval out[PARAM_MAX_INTERVALS]) {
+    double tol = 1e-9 * fmax(window[2] - window[0], window[3] - window[1]);
+    double ts[8];
+    int n = 0;
+    for (int e = 0; e < 4; e++) n += edge_crossings(b, e & 1, window[e], ts + n);
+    qsort(ts, (size_t)n, sizeof(double), cmp_double);
+
+    int count = 0;
+    bool prev = false;
+
+    if (b->kind != PARAM_ARC) {
+        for (int i = 0; i + 1 < n; i++) {
+            if (ts[i + 1] - ts[i] <= 0.0) continue;
+            if (inside_window(b, window, tol, 0.5 * (ts[i] + ts[i + 1]))) {
+                push_interval(out, &count, &prev, ts[i], ts[i + 1]);
+            } else {
+                prev = false;
+            }
+        }
+        return count;
+    }
+
+    // Elipse: sin cortes está entera dentro o entera fuera
+    const double period = 2.0 * M_PI;
+    bool inside[8];
+    int start = -1;
+    for (int i = 0; i < n; i++) {
+        double hi = i + 1 < n ? ts[i + 1] : ts[0] + period;
+        inside[i] = inside_window(b, window, tol, 0.5 * (ts[i] + hi));
+        if (!inside[i]) start = i;
+    }
+    if (start < 0) {
+        if (n == 0 && !inside_window(b, window, tol, 0.0)) return 0;
+        out[0] = (ParamInterval){ -M_PI, M_PI, true };
+        return 1;
+    }
+
+    for (int k = 1; k <= n; k++) {
+        int i = (start + k) % n;
+        if (!inside[i]) {
+            prev = false;
+            continue;
+        }
+        double shift = start + k >= n ? period : 0.0;
+        double lo = ts[i] + shift;
+        double hi = (i + 1 < n ? ts[i + 1] : ts[0] + period) + shift;
+        if (hi > lo) push_interval(out, &count, &prev, lo, hi);
+    }
+    return count;
+}
@@ -0,0 +1,75 @@
+//================================================================//
+//        PARAM HEADER - Parametrización exacta por ramas         //
+//================================================================//
+//
+// Descompone una cónica en ramas con parametrización cerrada y recorta
+// cada rama a una ventana. Toda rama es la imagen afín de una curva
+// modelo:
+//
+//   P(t) = O + f1(t)·U + f2(t)·V
+//
+//   PARAM_ARC        f1 = cos t,  f2 = sin t    (elipse, t en [-π, π])
+//   PARAM_HYPERBOLA  f1 = cosh t, f2 = sinh t   (una rama; U lleva el signo)
+//   PARAM_PARABOLA   f1 = t,      f2 = t²
+//   PARAM_LINE       f1 = t,      f2 = 0        (degeneradas: pares de rectas)
+//
+// Los cortes con los bordes de la ventana se resuelven en forma cerrada,
+// así que recortar cuesta lo mismo para cualquier tipo. Lo usan los
+// formatos de salida que no dependen de un muestreo fijo (Bézier
+// racionales, polilíneas por rama).
+//
+
+#ifndef PARAM_H
+#define PARAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Ramas por cónica: dos en hipérbolas y pares de rectas
+#define PARAM_MAX_BRANCHES 2
+
+// Tramos visibles por rama: 4 bordes x 2 cortes acotan los cambios de lado
+#define PARAM_MAX_INTERVALS 8
+
+typedef enum {
+    PARAM_ARC,
+    PARAM_HYPERBOLA,
+    PARAM_PARABOLA,
+    PARAM_LINE
+} ParamKind;
+
+typedef struct {
+    ParamKind kind;
+    double ox, oy;              // origen O
+    double ux, uy;              // U, asociado a f1(t)
+    double vx, vy;              // V, asociado a f2(t)
+} ConicBranch;
+
+/**
+ * Tramo [t0, t1] de una rama. closed indica que cubre la elipse entera
+ * (t1 - t0 = 2π).
+ */
+typedef struct {
+    double t0, t1;
+    bool   closed;
+} ParamInterval;
+
+/**
+ * Ramas reales de c = [A..F]. Devuelve cuántas escribe en out (0 si la
+ * curva es vacía o se reduce a un punto).
+ */
+int conic_branches(const double c[6], ConicBranch out[PARAM_MAX_BRANCHES]);
+
+/**
+ * Punto P(t) y derivada P'(t) de una rama. d puede ser NULL.
+ */
+void branch_eval(const ConicBranch* b, double t, double p[2], double d[2]);
+
+/**
+ * Tramos de la rama dentro de window ([x_min, y_min, x_max, y_max]),
+ * ordenados por t. Devuelve el número de tramos.
+ */
+int branch_clip(const ConicBranch* b, const double window[4],
+                ParamInterval out[PARAM_MAX_INTERVALS]);
+
+#endif
@@ -0,0 +1,248 @@
+//================================================================//
+// PHASE - Diagrama de fases de cónicas en el plano de coeficientes
+//================================================================//
+//
+// Cada celda (x, y) fija dos coeficientes y clasifica la cónica con
+// el mismo criterio que classify() en conics.c (discriminante y caso
+// círculo). Además marca como degeneradas las celdas con det ≈ 0 (el
+// criterio proyectivo completo), que es lo interesante al enseñar.
+//
+//--------------------------------//
+// Includes y dependencias
+//--------------------------------//
+#include "phase.h"
+
+#include <math.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "budget.h"
+#include "image.h"
+#include "threadpool.h"
+
+/**
+ * @file phase.c
+ * @brief Kernel de clasificación por filas y codificación de mapas.
+ */
+
+#define PHASE_EPS 1e-8
+#define PHASE_ROW_BLOCK 1024      // celdas por tramo de fila (tmp en la pila)
+
+// Paleta por ConicType (círculo, elipse, hipérbola, parábola, degenerada)
+static const uint8_t TYPE_PALETTE[(CONIC_DEGENERATE + 1) * 3] = {
+     64, 200, 255,
+     40, 120, 220,
+    240,  90,  60,
+    250, 210,  60,
+     30,  30,  30
+};
+
+//-------------------------------------------//
+//                  KERNEL                   //
+//-------------------------------------------//
+
+typedef struct {
+    const PhaseParams* p;
+    PhaseMaps* m;
+    atomic_size_t skipped;      // filas sin clasificar por falta de tiempo
+} PhaseJob;
+
+/**
+ * @brief Clasifica las filas [begin, end) de la rejilla.
+ * @details Cada coeficiente de la fila es afín en x: c_k = base_k + sx_k·x,
+ *          con sx_k = 1 solo para el coeficiente del eje horizontal. Así el
+ *          bucle interno es aritmética pura con selects, sin ramas ni
+ *          accesos indirectos, y el compilador lo vectoriza. El
+ *          presupuesto (budget.h) se consulta por fila: sin tiempo, la
+ *          fila queda degenerada con Δ = det = 0.
+ */
+static void phase_rows(size_t begin, size_t end, void* ctx) {
+    PhaseJob* job = ctx;
+    const PhaseParams* p = job->p;
+    const int w = p->width;
+
+    const double x_min = p->x_min;
+    const double dx = (p->x_max - p->x_min) / w;
+    const double dy = (p->y_max - p->y_min) / p->height;
+
+    // Copias locales: sin posible aliasing con los mapas de salida
+    double sx[6];
+    for (int k = 0; k < 6; k++) sx[k] = (k == (int)p->x_coef) ? 1.0 : 0.0;
+    const double sA = sx[0], sB = sx[1], sC = sx[2], sD = sx[3], sE = sx[4], sF = sx[5];
+
+    // Tramo temporal de tipos en int32: el paso double -> uint8 directo no
+    // se vectoriza; int32 sí, y el empaquetado a bytes va en otro bucle.
+    // En la pila y por tramos de PHASE_ROW_BLOCK: no hay reserva que falle
+    int32_t tmp[PHASE_ROW_BLOCK];
+
+    for (size_t j = begin; j < end; j++) {
+        if (budget_exhausted()) {
+            const size_t row = j * (size_t)w;
+            memset(job->m->type + row, CONIC_DEGENERATE, (size_t)w);
+            memset(job->m->delta + row, 0, (size_t)w * sizeof(float));
+            memset(job->m->det + row, 0, (size_t)w * sizeof(float));
+            atomic_fetch_add(&job->skipped, 1);
+            continue;
+        }
+
+        const double y = p->y_max - ((double)j + 0.5) * dy;
+
+        double base[6];
+        for (int k = 0; k < 6; k++) base[k] = p->coeffs[k];
+        base[p->y_coef] = y;
+        base[p->x_coef] = 0.0;
+        const double bA = base[0], bB = base[1], bC = base[2];
+        const double bD = base[3], bE = base[4], bF = base[5];
+
+        for (int i0 = 0; i0 < w; i0 += PHASE_ROW_BLOCK) {
+            const int cnt = w - i0 < PHASE_ROW_BLOCK ? w - i0 : PHASE_ROW_BLOCK;
+            const size_t row = j * (size_t)w + (size_t)i0;
+
+            int32_t* restrict ttmp = tmp;
+            float* restrict delta = job->m->delta + row;
+            float* restrict det = job->m->det + row;
+
+            for (int i = 0; i < cnt; i++) {
+                const double x = x_min + ((double)(i0 + i) + 0.5) * dx;
+                const double A = bA + sA * x;
+                const double B = bB + sB * x;
+                const double C = bC + sC * x;
+                const double D = bD + sD * x;
+                const double E = bE + sE * x;
+                const double F = bF + sF * x;
+
+                const double d = B*B - 4*A*C;
+                const double q =
+                    A * (C*F - 0.25*E*E) -
+                    0.5*B * (0.5*B*F - 0.25*E*D) +
+                    0.5*D * (0.25*B*E - 0.5*C*D);
+
+                // Selección aritmética (máscaras 0/1) en lugar de ramas
+                const int hyp = d > PHASE_EPS;
+                const int ell = d < -PHASE_EPS;
+                const int circ = (fabs(B) < PHASE_EPS) & (fabs(A - C) < PHASE_EPS);
+                const int deg = fabs(q) < PHASE_EPS;
+
+                int t = CONIC_PARABOLA
+                      + hyp * (CONIC_HYPERBOLA - CONIC_PARABOLA)
+                      + ell * (CONIC_ELLIPSE - CONIC_PARABOLA + circ * (CONIC_CIRCLE - CONIC_ELLIPSE));
+                t += deg * (CONIC_DEGENERATE - t);
+
+                ttmp[i] = t;
+                delta[i] = (float)d;
+                det[i] = (float)q;
+            }
+
+            uint8_t* restrict type = job->m->type + row;
+            for (int i = 0; i < cnt; i++) type[i] = (uint8_t)ttmp[i];
+        }
+    }
+}
+
+//-------------------------------------------//
+//                 API PÚBLICA               //
+//-------------------------------------------//
+
+bool phase_alloc(PhaseMaps* m, int width, int height) {
+    size_t n = (size_t)width * (size_t)height;
+    memset(m, 0, sizeof(*m));
+    m->type = malloc(n ? n : 1);
+    m->delta = malloc((n ? n : 1) * sizeof(float));
+    m->det = malloc((n ? n : 1) * sizeof(float));
+    if (!m->type || !m->delta || !m->det) {
+        phase_free(m);
+        return false;
+    }
+    return true;
+}
+
+void phase_free(PhaseMaps* m) {
+    free(m->type);
+    free(m->delta);
+    free(m->det);
+    memset(m, 0, sizeof(*m));
+}
+
+/**
+ * @brief Calcula los tres mapas con las filas repartidas en el pool.
+ * @param p Parámetros del barrido.
+ * @param m Mapas reservados con phase_alloc(width, height).
+ */
+void phase_diagram(const PhaseParams* p, PhaseMaps* m) {
+    PhaseJob job = { .p = p, .m = m };
+    atomic_init(&job.skipped, 0);
+
+    // ~16k celdas por trozo: suficiente para amortizar el reparto
+    size_t grain = (size_t)(16384 / (p->width > 0 ? p->width : 1));
+    tp_parallel_for(0, (size_t)p->height, grain ? grain : 1, phase_rows, &job);
+
+    memset(m->counts, 0, sizeof(m->counts));
+    size_t n = (size_t)p->width * (size_t)p->height;
+    for (size_t i = 0; i < n; i++) m->counts[m->type[i]]++;
+
+    // Las filas saltadas no cuentan como degeneradas
+    m->skipped = atomic_load(&job.skipped) * (size_t)p->width;
+    m->counts[CONIC_DEGENERATE] -= m->skipped;
+}
+
+/**
+ * @brief Normaliza un mapa float con signo a gris (128 = 0).
+ * @details Escala por el máximo absoluto con raíz cuadrada para que las
+ *          fronteras (valores pequeños) sigan siendo visibles.
+ */
+static void signed_to_gray(const float* v, size_t n, uint8_t* out) {
+    float vmax = 0.0f;
+    for (size_t i = 0; i < n; i++) {
+        float a = fabsf(v[i]);
+        vmax = a > vmax ? a : vmax;
+    }
+    float inv = vmax > 0.0f ? 1.0f / vmax : 0.0f;
+
+    for (size_t i = 0; i < n; i++) {
+        float s = v[i] * inv;
+        float g = s < 0.0f ? -sqrtf(-s) : sqrtf(s);
+        out[i] = (uint8_t)lrintf(127.5f + 127.5f * g);
+    }
+}
+
+/**
+ * @brief Codifica el mapa which de m en el formato fmt.
+ * @return false si no hay memoria.
+ */
+bool phase_encode(
+    const PhaseMaps* m, int width, int height,
+    PhaseMap which, PhaseFormat fmt,
+    ByteBuf* out
+) {
+    size_t n = (size_t)width * (size_t)height;
+    const float* values = which == PHASE_MAP_DELTA ? m->delta : m->det;
+
+    if (fmt == PHASE_FMT_RAW) {
+        return which == PHASE_MAP_TYPE
+            ? buf_append(out, m->type, n)
+            : buf_append(out, values, n * sizeof(float));
+    }
+
+    if (which == PHASE_MAP_TYPE && fmt == PHASE_FMT_PNG) {
+        return image_write_png(out, m->type, width, height, PNG_PALETTE,
+                               TYPE_PALETTE, CONIC_DEGENERATE + 1);
+    }
+
+    uint8_t* gray = malloc(n ? n : 1);
+    if (!gray) return false;
+
+    if (which == PHASE_MAP_TYPE) {
+        // PGM: niveles de gris equiespaciados por tipo
+        for (size_t i = 0; i < n; i++) gray[i] = (uint8_t)(m->type[i] * (255 / CONIC_DEGENERATE));
+    } else {
+        signed_to_gray(values, n, gray);
+    }
+
+    bool ok = fmt == PHASE_FMT_PNG
+        ? image_write_png(out, gray, width, height, PNG_GRAY, NULL, 0)
+        : image_write_pgm(out, gray, width, height);
+
+    free(gray);
+    return ok;
+}
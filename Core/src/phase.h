@@ -0,0 +1,72 @@
+//================================================================//
+//        PHASE HEADER - Diagrama de fases en el plano de coef.   //
+//================================================================//
+//
+// Barre dos coeficientes sobre una rejilla 2D con los otros cuatro
+// fijos y clasifica cada celda. Pensado para millones de celdas por
+// frame: kernel por filas sin ramas (vectorizable) y filas en paralelo.
+//
+
+#ifndef PHASE_H
+#define PHASE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "conics.h"
+#include "utils.h"
+
+typedef struct {
+    double    coeffs[6];        // valores fijos de A..F
+    ConicCoef x_coef;           // coeficiente en el eje horizontal
+    ConicCoef y_coef;           // coeficiente en el eje vertical
+    double    x_min, x_max;
+    double    y_min, y_max;
+    int       width, height;
+} PhaseParams;
+
+/**
+ * Mapas por celda, fila a fila; la fila 0 corresponde a y_max (arriba).
+ */
+typedef struct {
+    uint8_t* type;      // ConicType
+    float*   delta;     // B² - 4AC
+    float*   det;       // determinante de la matriz 3x3 de la cónica
+    size_t   counts[CONIC_DEGENERATE + 1];
+    size_t   skipped;   // celdas sin clasificar (presupuesto vencido)
+} PhaseMaps;
+
+typedef enum {
+    PHASE_MAP_TYPE,
+    PHASE_MAP_DELTA,
+    PHASE_MAP_DET
+} PhaseMap;
+
+typedef enum {
+    PHASE_FMT_RAW,      // bytes del mapa tal cual (uint8 o float32)
+    PHASE_FMT_PGM,
+    PHASE_FMT_PNG
+} PhaseFormat;
+
+bool phase_alloc(PhaseMaps* m, int width, int height);
+void phase_free(PhaseMaps* m);
+
+/**
+ * Rellena los mapas de m para la rejilla descrita en p. Si vence el
+ * presupuesto del hilo (budget.h), las filas que faltan quedan como
+ * degeneradas con Δ = det = 0, fuera de counts y contadas en skipped.
+ */
+void phase_diagram(const PhaseParams* p, PhaseMaps* m);
+
+/**
+ * Codifica uno de los mapas en el formato pedido. El mapa de tipos usa
+ * una paleta por tipo; delta y det se normalizan con signo (gris 128 = 0).
+ */
+bool phase_encode(
+    const PhaseMaps* m, int width, int height,
+    PhaseMap which, PhaseFormat fmt,
+    ByteBuf* out
+);
+
+#endif
@@ -0,0 +1,334 @@
+//================================================================//
+// POLY - Solvers cerrados de grado 2, 3 y 4
+//================================================================//
+//
+// Grado 2 y 3 son fórmulas cerradas de coste fijo. La cuártica añade al
+// Ferrari un refinamiento de Aberth que sale antes si las semillas ya son
+// precisas o en cuanto converge: su coste depende de los datos, pero está
+// acotado (16 pasos como mucho), así que un lote de miles de problemas
+// no tiene casos patológicos.
+//
+//--------------------------------//
+// Includes y dependencias
+//--------------------------------//
+#include "poly.h"
+
+#include <complex.h>
+#include <math.h>
+
+/**
+ * @file poly.c
+ * @brief Raíces de polinomios de grado <= 4.
+ */
+
+#define POLY_EPS 1e-14
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+//-------------------------------------------//
+//            FUNCIONES AUXILIARES           //
+//-------------------------------------------//
+
+static void sort_roots(double* r, int n) {
+    for (int i = 1; i < n; i++) {
+        double v = r[i];
+        int j = i - 1;
+        while (j >= 0 && r[j] > v) { r[j + 1] = r[j]; j--; }
+        r[j + 1] = v;
+    }
+}
+
+double poly_eval(const double* c, int n, double x) {
+    double v = c[0];
+    for (int i = 1; i <= n; i++) v = v * x + c[i];
+    return v;
+}
+
+void poly_mul(const double* u, int nu, const double* v, int nv, double* out) {
+    for (int i = 0; i <= nu + nv; i++) out[i] = 0.0;
+    for (int i = 0; i <= nu; i++)
+        for (int j = 0; j <= nv; j++)
+            out[i + j] += u[i] * v[j];
+}
+
+/**
+ * @brief Pasos fijos de Newton sobre un polinomio de grado n.
+ */
+static double newton_polish(const double* c, int n, double x, int iters) {
+    for (int it = 0; it < iters; it++) {
+        double f = c[0], df = 0.0;
+        for (int i = 1; i <= n; i++) {
+            df = df * x + f;
+            f = f * x + c[i];
+        }
+        if (fabs(df) < POLY_EPS) break;
+        double nx = x - f / df;
+        if (!isfinite(nx)) break;
+        x = nx;
+    }
+    return x;
+}
+
+/**
+ * @brief Raíces complejas de x² + b·x + c.
+ */
+static void complex_quadratic(double b, double c, double re[2], double im[2]) {
+    double disc = b * b - 4.0 * c;
+    if (disc >= 0) {
+        // Forma estable: evita la cancelación de -b ± sqrt(disc)
+        double s = sqrt(disc);
+        double q = -0.5 * (b + (b >= 0 ? s : -s));
+        re[0] = q;
+        re[1] = q != 0.0 ? c / q : 0.0;
+        im[0] = im[1] = 0.0;
+    } else {
+        re[0] = re[1] = -0.5 * b;
+        im[0] = 0.5 * sqrt(-disc);
+        im[1] = -im[0];
+    }
+}
+
+/**
+ * @brief Raíces complejas de un polinomio de grado <= 3 (c[0..3]).
+ * @details La cúbica aporta su raíz real mayor y el resto sale de la
+ *          cuadrática deflactada, de modo que una raíz doble aparece
+ *          como par con parte imaginaria residual y no se pierde.
+ * @return Número de raíces escritas (grado efectivo).
+ */
+static int complex_low_degree(const double c[4], double scale, double re[3], double im[3]) {
+    if (fabs(c[0]) > POLY_EPS * scale) {
+        double r3[3];
+        int n = poly_solve_cubic(c[0], c[1], c[2], c[3], r3);
+        double r = r3[n - 1];
+        // Deflación: c(x) = (x - r)·(c0·x² + q1·x + q2)
+        double q1 = c[1] + c[0] * r;
+        double q2 = c[2] + q1 * r;
+        re[0] = r; im[0] = 0.0;
+        complex_quadratic(q1 / c[0], q2 / c[0], re + 1, im + 1);
+        return 3;
+    }
+    if (fabs(c[1]) > POLY_EPS * scale) {
+        complex_quadratic(c[2] / c[1], c[3] / c[1], re, im);
+        return 2;
+    }
+    if (fabs(c[2]) > POLY_EPS * scale) {
+        re[0] = -c[3] / c[2]; im[0] = 0.0;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Refina a la vez las 4 raíces complejas de un polinomio mónico
+ *        con el método de Aberth-Ehrlich (pasos acotados).
+ * @details Cada corrección es Newton desviado por la repulsión de las
+ *          demás raíces, por lo que converge aunque las semillas sean
+ *          malas o estén repetidas.
+ */
+static void aberth_refine(const double nc[5], double re[4], double im[4]) {
+    // Semillas ya precisas (error inverso relativo ínfimo): nada que hacer
+    double worst = 0.0;
+    for (int k = 0; k < 4 && worst <= 1e-12; k++) {
+        double complex zk = re[k] + im[k] * I, f = nc[0];
+        double mag = 1.0, az = cabs(zk);
+        for (int i = 1; i <= 4; i++) {
+            f = f * zk + nc[i];
+            mag = mag * az + fabs(nc[i]);
+        }
+        double err = cabs(f) / mag;
+        worst = isfinite(err) ? fmax(worst, err) : INFINITY;
+    }
+    if (worst <= 1e-12) return;
+
+    double complex z[4];
+    for (int k = 0; k < 4; k++) {
+        z[k] = isfinite(re[k]) && isfinite(im[k])
+             ? re[k] + im[k] * I
+             : 1.5 * cexp(I * (0.4 + M_PI * k / 2.0));
+    }
+    // Semillas repetidas: separar ligeramente para que la repulsión esté definida
+    for (int k = 1; k < 4; k++) {
+        for (int j = 0; j < k; j++) {
+            if (cabs(z[k] - z[j]) < 1e-12) z[k] += 1e-8 * (1.0 + cabs(z[k])) * I;
+        }
+    }
+
+    for (int it = 0; it < 16; it++) {
+        double moved = 0.0;
+        for (int k = 0; k < 4; k++) {
+            double complex f = nc[0], df = 0.0;
+            for (int i = 1; i <= 4; i++) {
+                df = df * z[k] + f;
+                f = f * z[k] + nc[i];
+            }
+            if (f == 0.0) continue;
+
+            double complex sum = 0.0;
+            for (int j = 0; j < 4; j++) {
+                if (j != k && z[k] != z[j]) sum += 1.0 / (z[k] - z[j]);
+            }
+            double complex ratio = f / df;
+            double complex w = ratio / (1.0 - ratio * sum);
+            if (!isfinite(creal(w)) || !isfinite(cimag(w))) continue;
+
+            z[k] -= w;
+            moved = fmax(moved, cabs(w) / (1.0 + cabs(z[k])));
+        }
+        if (moved < 1e-15) break;
+    }
+
+    for (int k = 0; k < 4; k++) {
+        re[k] = creal(z[k]);
+        im[k] = cimag(z[k]);
+    }
+}
+
+//-------------------------------------------//
+//                 API PÚBLICA               //
+//-------------------------------------------//
+
+/**
+ * @brief Raíces reales de una cuadrática con la fórmula estable.
+ */
+int poly_solve_quadratic(double a, double b, double c, double roots[2]) {
+    double scale = fmax(fabs(a), fmax(fabs(b), fabs(c)));
+    if (scale == 0.0) return 0;
+
+    if (fabs(a) <= POLY_EPS * scale) {
+        if (fabs(b) <= POLY_EPS * scale) return 0;
+        roots[0] = -c / b;
+        return 1;
+    }
+
+    double disc = b * b - 4.0 * a * c;
+    if (disc < 0) return 0;
+
+    double s = sqrt(disc);
+    double q = -0.5 * (b + (b >= 0 ? s : -s));
+    roots[0] = q / a;
+    roots[1] = q != 0.0 ? c / q : roots[0];
+    sort_roots(roots, 2);
+    return 2;
+}
+
+/**
+ * @brief Raíces reales de una cúbica.
+ * @details Forma deprimida t³ + p·t + q; con tres raíces reales usa la
+ *          fórmula trigonométrica (sin complejos), si no, Cardano. Cada
+ *          raíz se pule con dos pasos de Newton sobre el polinomio original.
+ */
+int poly_solve_cubic(double a, double b, double c, double d, double roots[3]) {
+    double scale = fmax(fmax(fabs(a), fabs(b)), fmax(fabs(c), fabs(d)));
+    if (scale == 0.0) return 0;
+    if (fabs(a) <= POLY_EPS * scale) return poly_solve_quadratic(b, c, d, roots);
+
+    double B = b / a, C = c / a, D = d / a;
+    double p = C - B * B / 3.0;
+    double q = 2.0 * B * B * B / 27.0 - B * C / 3.0 + D;
+    double shift = -B / 3.0;
+
+    double disc = q * q / 4.0 + p * p * p / 27.0;
+    int n;
+
+    if (disc > 0) {
+        double s = sqrt(disc);
+        roots[0] = cbrt(-q / 2.0 + s) + cbrt(-q / 2.0 - s) + shift;
+        n = 1;
+    } else if (p == 0.0) {
+        roots[0] = shift;
+        n = 1;
+    } else {
+        double m = 2.0 * sqrt(-p / 3.0);
+        double arg = 3.0 * q / (p * m);
+        arg = arg > 1.0 ? 1.0 : (arg < -1.0 ? -1.0 : arg);
+        double phi = acos(arg) / 3.0;
+        for (int k = 0; k < 3; k++) roots[k] = m * cos(phi - 2.0 * M_PI * k / 3.0) + shift;
+        n = 3;
+    }
+
+    double coeffs[4] = { 1.0, B, C, D };
+    for (int k = 0; k < n; k++) roots[k] = newton_polish(coeffs, 3, roots[k], 2);
+    sort_roots(roots, n);
+    return n;
+}
+
+/**
+ * @brief Todas las raíces de una cuártica: Ferrari + refinamiento de Aberth.
+ * @details Primero se equilibra la variable (x = σ·z con σ la cota de
+ *          Fujiwara de los módulos), de modo que los coeficientes del
+ *          polinomio mónico en z quedan en [-1, 1]. Ferrari da semillas:
+ *          z = t - b/4 lleva a t⁴ + p·t² + q·t + r; con q ≈ 0 es bicuadrada
+ *          y si no se toma la mayor raíz m > 0 de la resolvente
+ *          8m³ + 8p·m² + (2p² - 8r)·m - q² = 0, que factoriza en
+ *          t² ± sqrt(2m)·t + (p/2 + m ∓ q / (2·sqrt(2m))).
+ *          Ferrari pierde precisión cuando las raíces tienen escalas muy
+ *          distintas (p.ej. elipses muy alargadas en distance.c), así que
+ *          las cuatro raíces se refinan a la vez con iteraciones de Aberth
+ *          (número acotado de pasos) y las casi reales con Newton.
+ */
+int poly_solve_quartic(const double c[5], double re[4], double im[4]) {
+    double scale = 0.0;
+    for (int i = 0; i < 5; i++) scale = fmax(scale, fabs(c[i]));
+    if (scale == 0.0) return 0;
+
+    if (fabs(c[0]) <= POLY_EPS * scale) return complex_low_degree(c + 1, scale, re, im);
+
+    // Equilibrado: a_k = c_k / (c_0·σ^k) con |a_k| <= 1
+    double sigma = 0.0;
+    for (int k = 1; k <= 4; k++) sigma = fmax(sigma, pow(fabs(c[k] / c[0]), 1.0 / k));
+    if (sigma == 0.0) {
+        for (int k = 0; k < 4; k++) re[k] = im[k] = 0.0;
+        return 4;
+    }
+    double nc[5] = { 1.0, 0.0, 0.0, 0.0, 0.0 };
+    double sk = 1.0;
+    for (int k = 1; k <= 4; k++) {
+        sk *= sigma;
+        nc[k] = c[k] / (c[0] * sk);
+    }
+
+    double b = nc[1], cc = nc[2], d = nc[3], e = nc[4];
+    double b2 = b * b;
+    double p = cc - 3.0 * b2 / 8.0;
+    double q = d - b * cc / 2.0 + b2 * b / 8.0;
+    double r = e - b * d / 4.0 + b2 * cc / 16.0 - 3.0 * b2 * b2 / 256.0;
+    double shift = -b / 4.0;
+
+    if (fabs(q) <= 1e-12 * fmax(1.0, fmax(fabs(p), fabs(r)))) {
+        // Bicuadrada: t² = z con z² + p·z + r = 0
+        double zr[2], zi[2];
+        complex_quadratic(p, r, zr, zi);
+        for (int k = 0; k < 2; k++) {
+            // sqrt compleja de z = zr + i·zi
+            double mod = hypot(zr[k], zi[k]);
+            double sr = sqrt(fmax(0.0, 0.5 * (mod + zr[k])));
+            double si = sqrt(fmax(0.0, 0.5 * (mod - zr[k])));
+            if (zi[k] < 0) si = -si;
+            re[2 * k] = sr + shift;      im[2 * k] = si;
+            re[2 * k + 1] = -sr + shift; im[2 * k + 1] = -si;
+        }
+    } else {
+        double m3[3];
+        int nm = poly_solve_cubic(8.0, 8.0 * p, 2.0 * p * p - 8.0 * r, -q * q, m3);
+        double m = m3[nm - 1];
+        if (m <= 0) m = POLY_EPS;
+
+        double s = sqrt(2.0 * m);
+        double t = q / (2.0 * s);
+        complex_quadratic(s, p / 2.0 + m - t, re, im);
+        complex_quadratic(-s, p / 2.0 + m + t, re + 2, im + 2);
+        for (int k = 0; k < 4; k++) re[k] += shift;
+    }
+
+    aberth_refine(nc, re, im);
+
+    // Pulido de las raíces casi reales y vuelta a la escala original
+    for (int k = 0; k < 4; k++) {
+        if (fabs(im[k]) <= 1e-6 * (1.0 + fabs(re[k]))) re[k] = newton_polish(nc, 4, re[k], 3);
+        re[k] *= sigma;
+        im[k] *= sigma;
+    }
+    return 4;
+}
@@ -0,0 +1,46 @@
+//================================================================//
+//           POLY HEADER - Raíces de polinomios de grado <= 4     //
+//================================================================//
+//
+// Solvers para las intersecciones de cónicas y los ajustes: cuadrática,
+// cúbica (Cardano / trigonométrica) y cuártica (Ferrari refinado con
+// Aberth). Las dos primeras tienen coste fijo; la cuártica itera un
+// número acotado de pasos con salida temprana, así que su coste depende
+// de los datos. Coeficientes en orden de grado descendente. Sin estado:
+// seguros entre hilos.
+//
+
+#ifndef POLY_H
+#define POLY_H
+
+/**
+ * Raíces reales de a·x² + b·x + c. Degrada a lineal si a ≈ 0.
+ * Devuelve el número de raíces (0..2), en orden ascendente.
+ */
+int poly_solve_quadratic(double a, double b, double c, double roots[2]);
+
+/**
+ * Raíces reales de a·x³ + b·x² + c·x + d. Degrada si a ≈ 0.
+ * Devuelve el número de raíces (0..3), en orden ascendente.
+ */
+int poly_solve_cubic(double a, double b, double c, double d, double roots[3]);
+
+/**
+ * Todas las raíces (complejas) de c[0]·x⁴ + c[1]·x³ + ... + c[4].
+ * Degrada si el coeficiente principal es ≈ 0. Devuelve el grado efectivo
+ * (número de raíces en re/im). Las raíces casi reales se pulen con Newton.
+ */
+int poly_solve_quartic(const double c[5], double re[4], double im[4]);
+
+/**
+ * Producto out = u·v de polinomios de grados nu y nv (grado descendente).
+ * out debe tener nu + nv + 1 elementos y no solaparse con u ni v.
+ */
+void poly_mul(const double* u, int nu, const double* v, int nv, double* out);
+
+/**
+ * Evalúa c[0]·x^n + ... + c[n] (Horner).
+ */
+double poly_eval(const double* c, int n, double x);
+
+#endif
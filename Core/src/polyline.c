@@ -0,0 +1,188 @@
+//================================================================//
+// POLYLINE - Muestreo por tramos y etapa de simplificación
+//================================================================//
+//
+// Sustituye al muestreo fijo en x de conics.c (que intercala las dos
+// soluciones y de cada x) cuando el consumidor necesita trazos continuos:
+// los vértices siguen el orden de la curva dentro de cada tramo.
+//
+//--------------------------------//
+// Includes y dependencias
+//--------------------------------//
+#include "polyline.h"
+
+#include <math.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "budget.h"
+#include "param.h"
+#include "threadpool.h"
+
+/**
+ * @file polyline.c
+ * @brief Polilíneas descritas en polyline.h.
+ */
+
+#define POLYLINE_MAX_SPANS (PARAM_MAX_BRANCHES * PARAM_MAX_INTERVALS)
+
+// Muestras por tramo cuando el presupuesto (budget.h) ya venció, y
+// cada cuántas muestras se consulta
+#define POLYLINE_FALLBACK_SAMPLES 16
+#define POLYLINE_BUDGET_STRIDE    4096
+
+typedef struct {
+    ConicBranch branch;
+    int         index;
+    double      t0, t1;
+    bool        closed;
+} Span;
+
+//-------------------------------------------//
+//           FUNCIONES AUXILIARES            //
+//-------------------------------------------//
+
+static int collect_spans(const double c[6], const double window[4], Span* out) {
+    ConicBranch br[PARAM_MAX_BRANCHES];
+    ParamInterval iv[PARAM_MAX_INTERVALS];
+    int nb = conic_branches(c, br), count = 0;
+
+    for (int i = 0; i < nb; i++) {
+        int ni = branch_clip(&br[i], window, iv);
+        for (int j = 0; j < ni; j++) {
+            out[count++] = (Span){ br[i], i, iv[j].t0, iv[j].t1, iv[j].closed };
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief n vértices uniformes en t sobre el tramo (extremos incluidos).
+ * @details En un tramo cerrado el último vértice copia el primero para
+ *          que la polilínea cierre exactamente. Cada
+ *          POLYLINE_BUDGET_STRIDE muestras consulta el presupuesto
+ *          (budget.h) y devuelve false si venció a mitad.
+ */
+static bool sample_span(const Span* s, uint32_t n, double* xy) {
+    double step = (s->t1 - s->t0) / (n - 1);
+    for (uint32_t k = 0; k < n; k++) {
+        if (k % POLYLINE_BUDGET_STRIDE == POLYLINE_BUDGET_STRIDE - 1 && budget_exhausted()) return false;
+        branch_eval(&s->branch, s->t0 + step * k, xy + 2*k, NULL);
+    }
+    if (s->closed) {
+        xy[2*(n - 1)] = xy[0];
+        xy[2*(n - 1) + 1] = xy[1];
+    }
+    return true;
+}
+
+typedef struct {
+    const double*         coeffs;
+    const double*         window;
+    const PolylineParams* params;
+    Polylines*            out;
+    atomic_bool           failed;
+} PolylineJob;
+
+static void polyline_range(size_t begin, size_t end, void* ctx) {
+    PolylineJob* job = ctx;
+    for (size_t i = begin; i < end; i++) {
+        if (!polyline_build(job->coeffs + 6 * i, job->window, job->params, &job->out[i])) {
+            atomic_store(&job->failed, true);
+        }
+    }
+}
+
+//-------------------------------------------//
+//               API PÚBLICA                 //
+//-------------------------------------------//
+
+PolylineParams polyline_default_params(void) {
+    PolylineParams p = { 1024, SIMPLIFY_DOUGLAS_PEUCKER, 0.0 };
+    return p;
+}
+
+/**
+ * @brief Tamaño en el plano de px píxeles.
+ * @details Se toma el eje con más unidades por píxel, de modo que el
+ *          error no supera px en ninguna dirección.
+ */
+double polyline_pixel_tolerance(const double window[4], double width, double height, double px) {
+    double sx = (window[2] - window[0]) / fmax(width, 1.0);
+    double sy = (window[3] - window[1]) / fmax(height, 1.0);
+    return px * fmax(sx, sy);
+}
+
+/**
+ * @brief Muestrea y simplifica cada tramo visible de la cónica.
+ */
+bool polyline_build(const double c[6], const double window[4], const PolylineParams* p,
+                    Polylines* out) {
+    memset(out, 0, sizeof(*out));
+
+    Span spans[POLYLINE_MAX_SPANS];
+    int ns = collect_spans(c, window, spans);
+    uint32_t n = p->samples < 2 ? 2 : p->samples;
+
+    out->xy = malloc(((size_t)ns * n + 1) * 2 * sizeof(double));
+    out->offsets = malloc(((size_t)ns + 1) * sizeof(uint32_t));
+    out->branch = malloc((size_t)ns + 1);
+    out->closed = malloc((size_t)ns + 1);
+    double* buf = malloc((size_t)n * 2 * sizeof(double));
+    uint32_t* keep = malloc((size_t)n * sizeof(uint32_t));
+
+    bool ok = out->xy && out->offsets && out->branch && out->closed && buf && keep;
+    size_t len = 0;
+    if (ok) out->offsets[0] = 0;
+
+    for (int k = 0; ok && k < ns; k++) {
+        // Sin tiempo, el tramo sale grueso pero completo
+        uint32_t ks = n > POLYLINE_FALLBACK_SAMPLES && budget_exhausted() ? POLYLINE_FALLBACK_SAMPLES : n;
+        if (!sample_span(&spans[k], ks, buf)) {
+            ks = POLYLINE_FALLBACK_SAMPLES;
+            sample_span(&spans[k], ks, buf);
+        }
+        size_t m = simplify_polyline(buf, ks, p->method, p->tolerance, keep);
+        if (m == 0) {
+            ok = false;
+            break;
+        }
+        for (size_t i = 0; i < m; i++) {
+            out->xy[2*(len + i)] = buf[2*keep[i]];
+            out->xy[2*(len + i) + 1] = buf[2*keep[i] + 1];
+        }
+        len += m;
+        out->branch[k] = (uint8_t)spans[k].index;
+        out->closed[k] = spans[k].closed;
+        out->offsets[k + 1] = (uint32_t)len;
+        out->sampled += ks;
+    }
+
+    free(buf);
+    free(keep);
+    if (!ok) {
+        polyline_free(out);
+        return false;
+    }
+    out->count = (size_t)ns;
+    return true;
+}
+
+/**
+ * @brief polyline_build en paralelo sobre un lote.
+ */
+bool polyline_build_batch(const double* coeffs, size_t n, const double window[4],
+                          const PolylineParams* p, Polylines* out) {
+    PolylineJob job = { coeffs, window, p, out, false };
+    tp_parallel_for(0, n, 16, polyline_range, &job);
+    return !atomic_load(&job.failed);
+}
+
+void polyline_free(Polylines* pl) {
+    free(pl->xy);
+    free(pl->offsets);
+    free(pl->branch);
+    free(pl->closed);
+    memset(pl, 0, sizeof(*pl));
+}
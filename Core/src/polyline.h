@@ -0,0 +1,71 @@
+//================================================================//
+//       POLYLINE HEADER - Polilíneas recortadas y simplificadas   //
+//================================================================//
+//
+// Salida muestreada para los consumidores que necesitan polilíneas
+// (plotter de matplotlib, componente Line de Three.js). Cada tramo
+// visible de cada rama (param.h) se muestrea de forma uniforme en su
+// parámetro y se simplifica a la tolerancia pedida (simplify.h).
+//
+// El resultado es una tabla CSR: la polilínea k ocupa los vértices
+// [offsets[k], offsets[k + 1]) de xy. Las polilíneas salen en orden de
+// dibujo: por rama (una por rama de hipérbola o recta de un par
+// degenerado) y, dentro de cada rama, por parámetro creciente. closed[k]
+// marca las que cierran sobre sí mismas (elipse entera visible; el último
+// vértice repite el primero), de modo que cada una se puede subir tal
+// cual como buffer de línea.
+//
+
+#ifndef POLYLINE_H
+#define POLYLINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "simplify.h"
+
+typedef struct {
+    uint32_t       samples;     // vértices por tramo antes de simplificar
+    SimplifyMethod method;
+    double         tolerance;   // unidades del plano (ver polyline_pixel_tolerance)
+} PolylineParams;
+
+typedef struct {
+    double*   xy;               // vértices (x, y) intercalados
+    uint32_t* offsets;          // count + 1 entradas
+    uint8_t*  branch;           // rama de cada polilínea
+    uint8_t*  closed;           // 1 si la polilínea es cerrada
+    size_t    count;            // polilíneas
+    size_t    sampled;          // vértices antes de simplificar
+} Polylines;
+
+/**
+ * 1024 muestras por tramo, Douglas–Peucker, tolerancia 0 (sin simplificar).
+ */
+PolylineParams polyline_default_params(void);
+
+/**
+ * Tolerancia en el plano equivalente a px píxeles cuando window
+ * ([x_min, y_min, x_max, y_max]) se dibuja en width x height píxeles.
+ */
+double polyline_pixel_tolerance(const double window[4], double width, double height, double px);
+
+/**
+ * Polilíneas de la cónica c = [A..F] recortada a window. Devuelve false
+ * si falta memoria (out queda vacío).
+ */
+bool polyline_build(const double c[6], const double window[4], const PolylineParams* p,
+                    Polylines* out);
+
+/**
+ * Lote: polyline_build para n cónicas de coeffs (6 por fila), en
+ * paralelo. out[i] recibe las de la cónica i. Devuelve false si alguna
+ * se quedó sin memoria.
+ */
+bool polyline_build_batch(const double* coeffs, size_t n, const double window[4],
+                          const PolylineParams* p, Polylines* out);
+
+void polyline_free(Polylines* pl);
+
+#endif
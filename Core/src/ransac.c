@@ -0,0 +1,435 @@
+//================================================================//
+// RANSAC - Detección multi-cónica con muestras de 5 puntos
+//================================================================//
+//
+// Por ronda, tres niveles de coste creciente:
+//   1. lotes de hipótesis en paralelo que cuentan inliers sobre un
+//      subconjunto pequeño (q² <= t²·|∇Q|², sin divisiones);
+//   2. las RANSAC_TOP mejores compiten por MSAC sobre un subconjunto
+//      RANSAC_WIDE veces mayor;
+//   3. solo la ganadora recorre toda la nube activa, se reajusta y sus
+//      inliers se retiran.
+// Los kernels acumulan por carriles para que el compilador los
+// vectorice; la pasada completa se trocea como fit_accumulate.
+//
+//--------------------------------//
+// Includes y dependencias
+//--------------------------------//
+#include "ransac.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "budget.h"
+#include "fit.h"
+#include "threadpool.h"
+
+/**
+ * @file ransac.c
+ * @brief Motor RANSAC/MSAC descrito en ransac.h.
+ */
+
+#define RANSAC_BATCH      256
+#define RANSAC_TOP        8
+#define RANSAC_WIDE       16
+#define RANSAC_REFINE     65536
+#define RANSAC_CHUNK      16384
+#define RANSAC_MAX_CHUNKS 256
+#define RANSAC_LANES      4
+
+//-------------------------------------------//
+//           FUNCIONES AUXILIARES            //
+//-------------------------------------------//
+
+static uint64_t splitmix(uint64_t* s) {
+    uint64_t z = (*s += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static uint64_t stream_seed(uint64_t seed, uint64_t round, uint64_t index) {
+    uint64_t s = seed ^ (round * 0xD1B54A32D192ED03ull);
+    s ^= splitmix(&s) + index * 0x9E3779B97F4A7C15ull;
+    return s;
+}
+
+/**
+ * @brief Distancia de Sampson al cuadrado (t2 si el gradiente se anula).
+ */
+static inline double sampson2(const double c[6], double x, double y, double t2) {
+    double q = c[0]*x*x + c[1]*x*y + c[2]*y*y + c[3]*x + c[4]*y + c[5];
+    double gx = 2.0*c[0]*x + c[1]*y + c[3];
+    double gy = c[1]*x + 2.0*c[2]*y + c[4];
+    double g2 = gx*gx + gy*gy;
+    return g2 > 0 ? q*q / g2 : t2;
+}
+
+/**
+ * @brief d² <= t2 sin dividir.
+ */
+static inline bool is_inlier(const double c[6], double x, double y, double t2) {
+    double q = c[0]*x*x + c[1]*x*y + c[2]*y*y + c[3]*x + c[4]*y + c[5];
+    double gx = 2.0*c[0]*x + c[1]*y + c[3];
+    double gy = c[1]*x + 2.0*c[2]*y + c[4];
+    return q*q <= t2 * (gx*gx + gy*gy);
+}
+
+/**
+ * @brief Puntuación MSAC de un bloque contiguo.
+ * @param count Recibe el número de puntos con d² <= t2.
+ * @return Σ min(d², t2).
+ */
+static double score_block(const double c[6], const double* restrict xs,
+                          const double* restrict ys, size_t n, double t2, double* count) {
+    const double A = c[0], B = c[1], C = c[2], D = c[3], E = c[4], F = c[5];
+    double acc[RANSAC_LANES] = { 0 }, cnt[RANSAC_LANES] = { 0 };
+
+    size_t i = 0;
+    for (; i + RANSAC_LANES <= n; i += RANSAC_LANES) {
+        for (int l = 0; l < RANSAC_LANES; l++) {
+            double x = xs[i + l], y = ys[i + l];
+            double q = (A*x + B*y + D)*x + (C*y + E)*y + F;
+            double gx = 2.0*A*x + B*y + D;
+            double gy = B*x + 2.0*C*y + E;
+            double g2 = gx*gx + gy*gy;
+            double d2 = g2 > 0 ? q*q / g2 : t2;
+            acc[l] += d2 < t2 ? d2 : t2;
+            cnt[l] += d2 <= t2 ? 1.0 : 0.0;
+        }
+    }
+    for (; i < n; i++) {
+        double d2 = sampson2(c, xs[i], ys[i], t2);
+        acc[0] += d2 < t2 ? d2 : t2;
+        cnt[0] += d2 <= t2 ? 1.0 : 0.0;
+    }
+
+    double s = 0.0, k = 0.0;
+    for (int l = 0; l < RANSAC_LANES; l++) {
+        s += acc[l];
+        k += cnt[l];
+    }
+    *count = k;
+    return s;
+}
+
+/**
+ * @brief Número de puntos del bloque con d² <= t2, sin dividir.
+ */
+static double count_block(const double c[6], const double* restrict xs,
+                          const double* restrict ys, size_t n, double t2) {
+    const double A = c[0], B = c[1], C = c[2], D = c[3], E = c[4], F = c[5];
+    double cnt[RANSAC_LANES] = { 0 };
+
+    size_t i = 0;
+    for (; i + RANSAC_LANES <= n; i += RANSAC_LANES) {
+        for (int l = 0; l < RANSAC_LANES; l++) {
+            double x = xs[i + l], y = ys[i + l];
+            double q = (A*x + B*y + D)*x + (C*y + E)*y + F;
+            double gx = 2.0*A*x + B*y + D;
+            double gy = B*x + 2.0*C*y + E;
+            cnt[l] += q*q <= t2 * (gx*gx + gy*gy) ? 1.0 : 0.0;
+        }
+    }
+    for (; i < n; i++) cnt[0] += is_inlier(c, xs[i], ys[i], t2) ? 1.0 : 0.0;
+
+    double k = 0.0;
+    for (int l = 0; l < RANSAC_LANES; l++) k += cnt[l];
+    return k;
+}
+
+typedef struct {
+    const double* c;
+    const double* xs;
+    const double* ys;
+    size_t n, chunk;
+    double t2;
+    double* partial;
+} CountJob;
+
+static void count_range(size_t begin, size_t end, void* ctx) {
+    CountJob* job = ctx;
+    for (size_t k = begin; k < end; k++) {
+        size_t lo = k * job->chunk;
+        size_t len = lo + job->chunk < job->n ? job->chunk : job->n - lo;
+        job->partial[k] = count_block(job->c, job->xs + lo, job->ys + lo, len, job->t2);
+    }
+}
+
+/**
+ * @brief count_block sobre toda la nube activa, en paralelo y con
+ *        reducción en orden fijo.
+ */
+static size_t count_full(const double c[6], const double* xs, const double* ys, size_t n,
+                         double t2) {
+    size_t chunk = RANSAC_CHUNK;
+    if ((n + chunk - 1) / chunk > RANSAC_MAX_CHUNKS) chunk = (n + RANSAC_MAX_CHUNKS - 1) / RANSAC_MAX_CHUNKS;
+    size_t chunks = (n + chunk - 1) / chunk;
+
+    double partial[RANSAC_MAX_CHUNKS];
+    CountJob job = { c, xs, ys, n, chunk, t2, partial };
+    tp_parallel_for(0, chunks, 1, count_range, &job);
+
+    double k = 0.0;
+    for (size_t i = 0; i < chunks; i++) k += partial[i];
+    return (size_t)k;
+}
+
+typedef struct {
+    double c[6];
+    double inliers;             // inliers del subconjunto (-1 si no válida)
+    double score;               // MSAC sobre el subconjunto amplio
+} Hypothesis;
+
+typedef struct {
+    const double* xs;           // nube activa
+    const double* ys;
+    size_t n;
+    const double* sx;           // subconjunto de puntuación
+    const double* sy;
+    size_t ns;
+    double t2;
+    uint64_t seed, round, base;
+    Hypothesis* hyp;
+} HypJob;
+
+static void hypothesis_range(size_t begin, size_t end, void* ctx) {
+    HypJob* job = ctx;
+    for (size_t h = begin; h < end; h++) {
+        Hypothesis* H = &job->hyp[h];
+        H->inliers = -1.0;
+
+        uint64_t s = stream_seed(job->seed, job->round, job->base + h);
+        size_t idx[5];
+        double px[5], py[5];
+        for (int k = 0; k < 5; k++) {
+            bool dup;
+            do {
+                idx[k] = (size_t)(splitmix(&s) % job->n);
+                dup = false;
+                for (int j = 0; j < k; j++) dup |= idx[j] == idx[k];
+            } while (dup);
+            px[k] = job->xs[idx[k]];
+            py[k] = job->ys[idx[k]];
+        }
+
+        if (!fit_five_points(px, py, H->c)) continue;
+        H->inliers = count_block(H->c, job->sx, job->sy, job->ns, job->t2);
+    }
+}
+
+typedef struct {
+    Hypothesis* top;
+    const double* wx;
+    const double* wy;
+    size_t nw;
+    double t2;
+} MsacJob;
+
+static void msac_range(size_t begin, size_t end, void* ctx) {
+    MsacJob* job = ctx;
+    for (size_t k = begin; k < end; k++) {
+        double cnt;
+        job->top[k].score = score_block(job->top[k].c, job->wx, job->wy, job->nw, job->t2, &cnt);
+    }
+}
+
+/**
+ * @brief Inserta h en la lista top (de tamaño *nt <= RANSAC_TOP), ordenada
+ *        por inliers del subconjunto de mayor a menor.
+ */
+static void top_insert(Hypothesis* top, size_t* nt, const Hypothesis* h) {
+    if (h->inliers < 5.0) return;
+    if (*nt == RANSAC_TOP && h->inliers <= top[RANSAC_TOP - 1].inliers) return;
+
+    size_t pos = *nt < RANSAC_TOP ? (*nt)++ : RANSAC_TOP - 1;
+    while (pos > 0 && top[pos - 1].inliers < h->inliers) {
+        top[pos] = top[pos - 1];
+        pos--;
+    }
+    top[pos] = *h;
+}
+
+/**
+ * @brief Copia a dst (columnas x | y) una muestra de hasta cap puntos
+ *        activos: toda la nube si cabe, si no con reemplazo.
+ * @return Tamaño de la muestra.
+ */
+static size_t draw_subset(const double* ax, const double* ay, size_t na, size_t cap,
+                          uint64_t s, double* dst) {
+    size_t ns = na <= cap ? na : cap;
+    if (ns == na) {
+        memcpy(dst, ax, na * sizeof(double));
+        memcpy(dst + ns, ay, na * sizeof(double));
+        return ns;
+    }
+    for (size_t i = 0; i < ns; i++) {
+        size_t k = (size_t)(splitmix(&s) % na);
+        dst[i] = ax[k];
+        dst[ns + i] = ay[k];
+    }
+    return ns;
+}
+
+/**
+ * @brief Hipótesis necesarias para ver, con probabilidad conf, una
+ *        muestra de 5 inliers si la fracción de inliers es w.
+ */
+static double needed_iterations(double w, double conf) {
+    if (w <= 0.0) return INFINITY;
+    double p5 = pow(fmin(w, 1.0), 5.0);
+    if (p5 >= 1.0) return 1.0;
+    return ceil(log(1.0 - conf) / log(1.0 - p5));
+}
+
+//-------------------------------------------//
+//                API PÚBLICA                //
+//-------------------------------------------//
+
+void ransac_default_params(RansacParams* p) {
+    p->max_conics = 4;
+    p->max_iterations = 20000;
+    p->min_inliers = 50;
+    p->subset = 2048;
+    p->threshold = 0.01;
+    p->confidence = 0.99;
+    p->seed = 1;
+    p->refine = true;
+}
+
+RansacStatus ransac_detect(const double* xs, const double* ys, size_t n,
+                           const RansacParams* p, RansacConic* out, size_t* count,
+                           uint8_t* labels) {
+    *count = 0;
+    if (labels) memset(labels, RANSAC_OUTLIER, n);
+
+    size_t ns_cap = p->subset ? p->subset : 1;
+    size_t nw_cap = ns_cap * RANSAC_WIDE;
+    size_t cap = n ? n : 1;
+    double* ax = malloc(cap * 2 * sizeof(double));
+    double* gx = p->refine ? malloc(RANSAC_REFINE * 2 * sizeof(double)) : NULL;
+    size_t* aidx = malloc(cap * sizeof(size_t));
+    double* sub = malloc((ns_cap + nw_cap) * 2 * sizeof(double));
+    Hypothesis* hyp = malloc(RANSAC_BATCH * sizeof(Hypothesis));
+    if (!ax || (p->refine && !gx) || !aidx || !sub || !hyp) {
+        free(ax);
+        free(gx);
+        free(aidx);
+        free(sub);
+        free(hyp);
+        return RANSAC_ERR_NOMEM;
+    }
+
+    // Nube activa en columnas compactas: los inliers de cada cónica se
+    // retiran y las rondas siguientes recorren menos memoria
+    double* ay = ax + n;
+    memcpy(ax, xs, n * sizeof(double));
+    memcpy(ay, ys, n * sizeof(double));
+    for (size_t i = 0; i < n; i++) aidx[i] = i;
+    size_t na = n;
+
+    const double t2 = p->threshold * p->threshold;
+    uint32_t max_conics = p->max_conics < RANSAC_MAX_CONICS ? p->max_conics : RANSAC_MAX_CONICS;
+    size_t min_inliers = p->min_inliers > 5 ? p->min_inliers : 5;
+
+    // Sin presupuesto (budget.h) no se abren rondas nuevas ni más lotes
+    // de hipótesis: se devuelven las cónicas ya encontradas
+    for (uint32_t round = 0; round < max_conics && na >= min_inliers; round++) {
+        if (round > 0 && budget_exhausted()) break;
+        double* sx = sub;
+        double* wx = sub + 2 * ns_cap;
+        size_t ns = draw_subset(ax, ay, na, ns_cap, stream_seed(p->seed, round, UINT64_MAX), sx);
+        size_t nw = draw_subset(ax, ay, na, nw_cap, stream_seed(p->seed, round, UINT64_MAX - 1), wx);
+
+        // 1. Hipótesis por lotes hasta la confianza pedida
+        Hypothesis top[RANSAC_TOP];
+        size_t nt = 0;
+        double best_inliers = 0.0, needed = p->max_iterations;
+        uint32_t total = 0;
+        while (total < p->max_iterations && total < needed && !(total > 0 && budget_exhausted())) {
+            uint32_t b = p->max_iterations - total < RANSAC_BATCH ? p->max_iterations - total : RANSAC_BATCH;
+            HypJob job = { ax, ay, na, sx, sx + ns, ns, t2, p->seed, round, total, hyp };
+            tp_parallel_for(0, b, 8, hypothesis_range, &job);
+
+            for (uint32_t h = 0; h < b; h++) {
+                top_insert(top, &nt, &hyp[h]);
+                if (hyp[h].inliers > best_inliers) best_inliers = hyp[h].inliers;
+            }
+            total += b;
+            needed = fmin(needed, needed_iterations(best_inliers / (double)ns, p->confidence));
+        }
+        if (nt == 0) break;
+
+        // 2. MSAC de las finalistas sobre el subconjunto amplio
+        MsacJob mj = { top, wx, wx + nw, nw, t2 };
+        tp_parallel_for(0, nt, 1, msac_range, &mj);
+        size_t win = 0;
+        for (size_t k = 1; k < nt; k++)
+            if (top[k].score < top[win].score) win = k;
+
+        // 3. La ganadora sobre toda la nube activa
+        RansacConic best = { .hypotheses = total };
+        memcpy(best.coeffs, top[win].c, sizeof(best.coeffs));
+        best.inliers = count_full(best.coeffs, ax, ay, na, t2);
+        if (best.inliers < min_inliers) break;
+
+        // Reajuste algebraico sobre los inliers mientras gane inliers. Basta
+        // una muestra regular de la nube con hasta RANSAC_REFINE inliers
+        size_t step = na / (4 * RANSAC_REFINE) + 1;
+        for (int it = 0; p->refine && it < 3; it++) {
+            double* gy = gx + RANSAC_REFINE;
+            size_t m = 0;
+            for (size_t i = 0; i < na && m < RANSAC_REFINE; i += step) {
+                if (is_inlier(best.coeffs, ax[i], ay[i], t2)) {
+                    gx[m] = ax[i];
+                    gy[m] = ay[i];
+                    m++;
+                }
+            }
+
+            double c[6];
+            if (fit_points(gx, gy, m, FIT_GENERAL, c, NULL) != FIT_OK) break;
+            size_t cnt = count_full(c, ax, ay, na, t2);
+            if (cnt <= best.inliers) break;
+            best.inliers = cnt;
+            memcpy(best.coeffs, c, sizeof(c));
+        }
+
+        // Etiquetado y compactación de la nube activa
+        size_t kept = 0, inl = 0;
+        double sum = 0.0;
+        for (size_t i = 0; i < na; i++) {
+            if (is_inlier(best.coeffs, ax[i], ay[i], t2)) {
+                if (labels) labels[aidx[i]] = (uint8_t)*count;
+                sum += sampson2(best.coeffs, ax[i], ay[i], t2);
+                inl++;
+            } else {
+                ax[kept] = ax[i];
+                ay[kept] = ay[i];
+                aidx[kept] = aidx[i];
+                kept++;
+            }
+        }
+        // ay empieza en ax + n: la compactación in situ no solapa columnas
+        na = kept;
+        best.inliers = inl;
+        best.rms = inl ? sqrt(sum / (double)inl) : 0.0;
+        out[(*count)++] = best;
+    }
+
+    free(ax);
+    free(gx);
+    free(aidx);
+    free(sub);
+    free(hyp);
+    return RANSAC_OK;
+}
+
+const char* ransac_status_str(RansacStatus s) {
+    switch (s) {
+        case RANSAC_OK:        return "ok";
+        case RANSAC_ERR_NOMEM: return "out_of_memory";
+    }
+    return "error desconocido";
+}
@@ -0,0 +1,66 @@
+//================================================================//
+//        RANSAC HEADER - Detección robusta de varias cónicas     //
+//================================================================//
+//
+// Detecta varias cónicas superpuestas en una nube con atípicos.
+// - Hipótesis por muestras mínimas de 5 puntos (fit_five_points).
+// - Puntuación MSAC (Σ min(d², t²), d = distancia de Sampson): primero
+//   sobre un subconjunto aleatorio, luego sobre toda la nube solo para
+//   las mejores hipótesis.
+// - Las hipótesis se evalúan en paralelo por lotes; el número de lotes
+//   se adapta a la fracción de inliers observada.
+// - Cada cónica aceptada se reajusta con sus inliers, se retira de la
+//   nube y se busca la siguiente (peeling).
+//
+// Determinista: cada hipótesis usa su propia semilla derivada de
+// (seed, ronda, índice), así el resultado no depende de los hilos.
+//
+
+#ifndef RANSAC_H
+#define RANSAC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define RANSAC_MAX_CONICS 32
+#define RANSAC_OUTLIER    0xFF
+
+typedef struct {
+    uint32_t max_conics;        // cónicas a extraer (<= RANSAC_MAX_CONICS)
+    uint32_t max_iterations;    // tope de hipótesis por ronda
+    uint32_t min_inliers;       // una cónica con menos inliers detiene la búsqueda
+    uint32_t subset;            // tamaño del subconjunto de puntuación previa
+    double   threshold;         // distancia de Sampson máxima de un inlier
+    double   confidence;        // probabilidad de haber visto una muestra limpia
+    uint64_t seed;
+    bool     refine;            // reajuste algebraico sobre los inliers
+} RansacParams;
+
+typedef struct {
+    double   coeffs[6];
+    size_t   inliers;
+    double   rms;               // distancia de Sampson cuadrática media de los inliers
+    uint32_t hypotheses;        // hipótesis evaluadas en su ronda
+} RansacConic;
+
+typedef enum {
+    RANSAC_OK,
+    RANSAC_ERR_NOMEM
+} RansacStatus;
+
+void ransac_default_params(RansacParams* p);
+
+/**
+ * Extrae hasta p->max_conics cónicas de la nube (xs, ys). out recibe
+ * las cónicas en orden de detección y *count su número. Si labels no es
+ * NULL, labels[i] es el índice de la cónica del punto i o
+ * RANSAC_OUTLIER.
+ */
+RansacStatus ransac_detect(const double* xs, const double* ys, size_t n,
+                           const RansacParams* p, RansacConic* out, size_t* count,
+                           uint8_t* labels);
+
+const char* ransac_status_str(RansacStatus s);
+
+#endif
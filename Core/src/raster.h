@@ -0,0 +1,62 @@
+//================================================================//
+//        RASTER HEADER - Rasterizado antialias de cónicas        //
+//================================================================//
+//
+// Dibuja cónicas (una o una escena entera) en un buffer RGBA de 8 bits
+// sin pasar por polilíneas: cada píxel mide su distancia a la curva con
+// la aproximación de Sampson |f| / |∇f| en coordenadas de píxel y la
+// convierte en cobertura (antialias analítico, sin supermuestreo).
+//
+// La imagen se reparte en teselas de RASTER_TILE píxeles entre los hilos
+// del pool; cada tesela y cada bloque de RASTER_BLOCK píxeles descarta
+// con aritmética de intervalos las cónicas que no pueden tocarlo, así que
+// solo se sombrean los tramos cercanos al trazo.
+//
+
+#ifndef RASTER_H
+#define RASTER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "utils.h"
+
+#define RASTER_TILE     64
+#define RASTER_BLOCK    8
+#define RASTER_MAX_SIZE 16384
+
+typedef enum {
+    RASTER_FMT_RAW,     // RGBA fila a fila, sin cabecera
+    RASTER_FMT_PNG,
+    RASTER_FMT_QOI
+} RasterFormat;
+
+typedef struct {
+    double  window[4];      // [x_min, y_min, x_max, y_max] del plano
+    int     width, height;  // píxeles; la fila 0 corresponde a y_max
+    double  line_width;     // grosor del trazo en píxeles
+    uint8_t background[4];  // RGBA de fondo
+    uint8_t axes[4];        // RGBA de los ejes x = 0, y = 0; alfa 0 = sin ejes
+} RasterParams;
+
+/**
+ * Ventana [-10, 10]², 800 x 800 px, trazo de 2 px, fondo blanco y ejes
+ * grises.
+ */
+RasterParams raster_default_params(void);
+
+/**
+ * Dibuja n cónicas de coeffs (6 por fila) sobre rgba (width·height·4
+ * bytes), en orden y con mezcla "over". colors tiene 4 bytes RGBA por
+ * cónica. Devuelve false si falta memoria.
+ */
+bool raster_render(const RasterParams* p, const double* coeffs, const uint8_t* colors,
+                   size_t n, uint8_t* rgba);
+
+/**
+ * Codifica rgba en el formato pedido (PNG con deflate RLE, QOI o crudo).
+ */
+bool raster_encode(const uint8_t* rgba, int width, int height, RasterFormat fmt, ByteBuf* out);
+
+#endif
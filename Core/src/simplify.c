@@ -0,0 +1,261 @@
+//================================================================//
+// SIMPLIFY - Douglas–Peucker y Visvalingam–Whyatt
+//================================================================//
+//
+// Ambos métodos marcan vértices en un array de bytes y al final se
+// recogen los índices en orden, de modo que la salida no depende del
+// orden en que se procesan los tramos.
+//
+//--------------------------------//
+// Includes y dependencias
+//--------------------------------//
+#include "simplify.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @file simplify.c
+ * @brief Simplificación de polilíneas descrita en simplify.h.
+ */
+
+//-------------------------------------------//
+//           FUNCIONES AUXILIARES            //
+//-------------------------------------------//
+
+static size_t collect(const uint8_t* mark, size_t n, uint32_t* keep) {
+    size_t m = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (mark[i]) keep[m++] = (uint32_t)i;
+    }
+    return m;
+}
+
+/**
+ * @brief Vértice de (i, j) más alejado del segmento xy[i]–xy[j].
+ * @param d2 Distancia² de ese vértice.
+ * @details Distancia al segmento (no a la recta) para que una cuerda de
+ *          longitud nula (polilínea cerrada) mida la distancia al punto.
+ */
+static size_t farthest(const double* xy, size_t i, size_t j, double* d2) {
+    double ax = xy[2*i], ay = xy[2*i + 1];
+    double dx = xy[2*j] - ax, dy = xy[2*j + 1] - ay;
+    double len2 = dx*dx + dy*dy;
+    double inv = len2 > 0.0 ? 1.0 / len2 : 0.0;
+
+    size_t best = i;
+    double best_d2 = -1.0;
+    for (size_t k = i + 1; k < j; k++) {
+        double px = xy[2*k] - ax, py = xy[2*k + 1] - ay;
+        double t = fmin(fmax((px*dx + py*dy) * inv, 0.0), 1.0);
+        double ex = px - t*dx, ey = py - t*dy;
+        double e2 = ex*ex + ey*ey;
+        if (e2 > best_d2) {
+            best_d2 = e2;
+            best = k;
+        }
+    }
+    *d2 = best_d2;
+    return best;
+}
+
+static size_t douglas_peucker(const double* xy, size_t n, double tol, uint8_t* mark) {
+    size_t* stack = malloc(2 * n * sizeof(size_t));
+    if (!stack) return 0;
+
+    double tol2 = tol * tol;
+    size_t top = 0;
+    mark[0] = mark[n - 1] = 1;
+    stack[top++] = 0;
+    stack[top++] = n - 1;
+
+    while (top > 0) {
+        size_t j = stack[--top];
+        size_t i = stack[--top];
+        if (j - i < 2) continue;
+
+        double d2;
+        size_t k = farthest(xy, i, j, &d2);
+        if (d2 <= tol2) continue;
+
+        mark[k] = 1;
+        stack[top++] = i; stack[top++] = k;
+        stack[top++] = k; stack[top++] = j;
+    }
+    free(stack);
+    return 1;
+}
+
+// Montículo 4-ario: los 4 hijos (16 bytes cada uno) comparten línea de caché
+#define HEAP_ARITY 4
+
+typedef struct {
+    double   area;
+    uint32_t v;
+} HeapItem;
+
+typedef struct {
+    HeapItem* items;            // la clave va en el montículo: comparar no salta a area[]
+    uint32_t* pos;              // posición en items de cada vértice
+    size_t    size;
+} AreaHeap;
+
+static void heap_set(AreaHeap* h, size_t k, HeapItem it) {
+    h->items[k] = it;
+    h->pos[it.v] = (uint32_t)k;
+}
+
+static void heap_up(AreaHeap* h, size_t k) {
+    HeapItem it = h->items[k];
+    while (k > 0) {
+        size_t p = (k - 1) / HEAP_ARITY;
+        if (h->items[p].area <= it.area) break;
+        heap_set(h, k, h->items[p]);
+        k = p;
+    }
+    heap_set(h, k, it);
+}
+
+static void heap_down(AreaHeap* h, size_t k) {
+    HeapItem it = h->items[k];
+    for (;;) {
+        size_t l = HEAP_ARITY*k + 1, m = l;
+        if (l >= h->size) break;
+        size_t end = l + HEAP_ARITY < h->size ? l + HEAP_ARITY : h->size;
+        for (size_t c = l + 1; c < end; c++) {
+            if (h->items[c].area < h->items[m].area) m = c;
+        }
+        if (it.area <= h->items[m].area) break;
+        heap_set(h, k, h->items[m]);
+        k = m;
+    }
+    heap_set(h, k, it);
+}
+
+/**
+ * @brief Cambia el área del vértice v y lo recoloca.
+ */
+static void heap_update(AreaHeap* h, uint32_t v, double area) {
+    size_t k = h->pos[v];
+    double old = h->items[k].area;
+    h->items[k].area = area;
+    if (area < old) heap_up(h, k);
+    else heap_down(h, k);
+}
+
+static double triangle_area(const double* xy, uint32_t a, uint32_t b, uint32_t c) {
+    double ux = xy[2*a] - xy[2*b], uy = xy[2*a + 1] - xy[2*b + 1];
+    double vx = xy[2*c] - xy[2*b], vy = xy[2*c + 1] - xy[2*b + 1];
+    return 0.5 * fabs(ux*vy - uy*vx);
+}
+
+/**
+ * @brief Visvalingam–Whyatt con montículo de áreas efectivas.
+ * @details Al quitar un vértice, el área de sus vecinos se recalcula con
+ *          sus nuevos vecinos y nunca baja del área del eliminado (área
+ *          efectiva monótona), de modo que el orden de eliminación es el
+ *          de importancia visual.
+ */
+static size_t visvalingam(const double* xy, size_t n, double tol, uint8_t* mark) {
+    HeapItem* items = malloc(n * sizeof(HeapItem));
+    uint32_t* pos  = malloc(n * sizeof(uint32_t));
+    uint32_t* prev = malloc(n * sizeof(uint32_t));
+    uint32_t* next = malloc(n * sizeof(uint32_t));
+    size_t ok = items && pos && prev && next;
+
+    if (ok) {
+        AreaHeap h = { items, pos, 0 };
+        memset(mark, 1, n);
+        for (size_t i = 1; i + 1 < n; i++) {
+            prev[i] = (uint32_t)(i - 1);
+            next[i] = (uint32_t)(i + 1);
+            double a = triangle_area(xy, prev[i], (uint32_t)i, next[i]);
+            heap_set(&h, h.size++, (HeapItem){ a, (uint32_t)i });
+        }
+        for (size_t k = h.size / HEAP_ARITY + 1; k-- > 0;) heap_down(&h, k);
+
+        double limit = tol * tol;
+        while (h.size > 0 && items[0].area < limit) {
+            HeapItem top = items[0];
+            uint32_t v = top.v;
+            mark[v] = 0;
+            if (--h.size > 0) {
+                heap_set(&h, 0, items[h.size]);
+                heap_down(&h, 0);
+            }
+
+            uint32_t p = prev[v], q = next[v];
+            if (p > 0) {
+                next[p] = q;
+                heap_update(&h, p, fmax(triangle_area(xy, prev[p], p, q), top.area));
+            }
+            if (q + 1 < n) {
+                prev[q] = p;
+                heap_update(&h, q, fmax(triangle_area(xy, p, q, next[q]), top.area));
+            }
+        }
+    }
+
+    free(items);
+    free(pos);
+    free(prev);
+    free(next);
+    return ok;
+}
+
+//-------------------------------------------//
+//               API PÚBLICA                 //
+//-------------------------------------------//
+
+/**
+ * @brief Simplifica xy[n][2] y devuelve los índices conservados.
+ * @param xy Vértices (x, y) intercalados.
+ * @param n Número de vértices.
+ * @param method Método.
+ * @param tol Tolerancia en unidades de xy (distancia para Douglas–Peucker;
+ *        Visvalingam elimina triángulos de área < tol²).
+ * @param keep Índices de salida (hasta n).
+ * @return Vértices conservados; 0 si falta memoria.
+ */
+size_t simplify_polyline(const double* xy, size_t n, SimplifyMethod method,
+                         double tol, uint32_t* keep) {
+    if (n <= 2 || method == SIMPLIFY_NONE || !(tol > 0.0)) {
+        for (size_t i = 0; i < n; i++) keep[i] = (uint32_t)i;
+        return n;
+    }
+
+    uint8_t* mark = calloc(n, 1);
+    if (!mark) return 0;
+
+    size_t ok = method == SIMPLIFY_DOUGLAS_PEUCKER
+              ? douglas_peucker(xy, n, tol, mark)
+              : visvalingam(xy, n, tol, mark);
+    size_t m = ok ? collect(mark, n, keep) : 0;
+    free(mark);
+    return m;
+}
+
+/**
+ * @brief Traduce el nombre de un método.
+ * @return false si no se reconoce.
+ */
+bool simplify_parse_method(const char* name, SimplifyMethod* out) {
+    static const struct {
+        const char*    name;
+        SimplifyMethod method;
+    } names[] = {
+        { "none", SIMPLIFY_NONE },
+        { "dp", SIMPLIFY_DOUGLAS_PEUCKER },
+        { "douglas-peucker", SIMPLIFY_DOUGLAS_PEUCKER },
+        { "vw", SIMPLIFY_VISVALINGAM },
+        { "visvalingam", SIMPLIFY_VISVALINGAM },
+    };
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (strcmp(names[i].name, name) == 0) {
+            *out = names[i].method;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,47 @@
+//================================================================//
+//        SIMPLIFY HEADER - Simplificación de polilíneas          //
+//================================================================//
+//
+// Reduce una polilínea muestreada a los vértices que se ven a la
+// tolerancia dada:
+//
+// - Douglas–Peucker: conserva el vértice más alejado de la cuerda
+//   mientras supere tol. Iterativo (pila explícita). En el peor caso
+//   (el vértice más alejado siempre junto a un extremo del tramo) cuesta
+//   O(n²); en arcos de cónica suele caer cerca del centro del tramo y el
+//   coste típico es O(n log n).
+// - Visvalingam–Whyatt: elimina una y otra vez el vértice de menor área
+//   efectiva (triángulo con sus vecinos) mientras sea < tol². Montículo
+//   4-ario con posiciones: O(n log n) en el peor caso.
+//
+// Los extremos se conservan siempre, también si coinciden (polilínea
+// cerrada). Los vértices son (x, y) intercalados.
+//
+
+#ifndef SIMPLIFY_H
+#define SIMPLIFY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    SIMPLIFY_NONE,
+    SIMPLIFY_DOUGLAS_PEUCKER,
+    SIMPLIFY_VISVALINGAM
+} SimplifyMethod;
+
+/**
+ * Índices (ascendentes) de los vértices que se conservan de xy[n][2].
+ * keep debe admitir n índices. Devuelve cuántos se conservan, o 0 si no
+ * hay memoria para el trabajo intermedio.
+ */
+size_t simplify_polyline(const double* xy, size_t n, SimplifyMethod method,
+                         double tol, uint32_t* keep);
+
+/**
+ * "none", "dp" / "douglas-peucker", "vw" / "visvalingam".
+ */
+bool simplify_parse_method(const char* name, SimplifyMethod* out);
+
+#endif
@@ -0,0 +1,627 @@
+//================================================================//
+// SPATIAL - BVH dinámico con cajas gruesas y refinamiento exacto
+//================================================================//
+//
+// Inserción con la heurística de superficie (perímetro en 2D) y
+// rotaciones tipo AVL al subir, como los árboles de colisión dinámicos
+// de los motores de física. Los nodos viven en un array con lista libre
+// para que las ediciones no reserven memoria en régimen estacionario.
+//
+//--------------------------------//
+// Includes y dependencias
+//--------------------------------//
+#include "spatial.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "distance.h"
+#include "threadpool.h"
+
+/**
+ * @file spatial.c
+ * @brief Índice espacial descrito en spatial.h.
+ */
+
+// Holgura de las cajas gruesas, relativa a su tamaño
+#define SPATIAL_FAT 0.1
+
+// Profundidad máxima de la pila de recorrido (el árbol está equilibrado)
+#define SPATIAL_STACK 256
+
+//-------------------------------------------//
+//            FUNCIONES AUXILIARES           //
+//-------------------------------------------//
+
+static bool is_leaf(const SpatialNode* n) {
+    return n->left == SPATIAL_NULL;
+}
+
+static void box_union(const double a[4], const double b[4], double out[4]) {
+    out[0] = fmin(a[0], b[0]);
+    out[1] = fmin(a[1], b[1]);
+    out[2] = fmax(a[2], b[2]);
+    out[3] = fmax(a[3], b[3]);
+}
+
+static double box_perimeter(const double b[4]) {
+    return 2.0 * ((b[2] - b[0]) + (b[3] - b[1]));
+}
+
+static bool box_contains(const double outer[4], const double inner[4]) {
+    return outer[0] <= inner[0] && outer[1] <= inner[1] &&
+           outer[2] >= inner[2] && outer[3] >= inner[3];
+}
+
+/**
+ * @brief Distancia de (x, y) a la caja (0 si está dentro): cota inferior
+ *        de la distancia a cualquier trozo de curva contenido en ella.
+ */
+static double box_distance(const double b[4], double x, double y) {
+    double dx = fmax(fmax(b[0] - x, 0.0), x - b[2]);
+    double dy = fmax(fmax(b[1] - y, 0.0), y - b[3]);
+    return sqrt(dx*dx + dy*dy);
+}
+
+/**
+ * @brief Caja gruesa: la caja exacta ampliada en SPATIAL_FAT de su tamaño.
+ */
+static void fatten(const SpatialIndex* s, double box[4]) {
+    double span = fmax(s->window[2] - s->window[0], s->window[3] - s->window[1]);
+    double mx = SPATIAL_FAT * (box[2] - box[0]) + 1e-9 * span;
+    double my = SPATIAL_FAT * (box[3] - box[1]) + 1e-9 * span;
+    box[0] -= mx; box[1] -= my;
+    box[2] += mx; box[3] += my;
+}
+
+//-------------------------------------------//
+//              GESTIÓN DE NODOS             //
+//-------------------------------------------//
+
+static int32_t alloc_node(SpatialIndex* s) {
+    if (s->free_list == SPATIAL_NULL) {
+        size_t cap = s->node_cap ? 2 * s->node_cap : 64;
+        SpatialNode* nodes = realloc(s->nodes, cap * sizeof(SpatialNode));
+        if (!nodes) return SPATIAL_NULL;
+
+        for (size_t i = s->node_cap; i < cap; i++) {
+            nodes[i].parent = i + 1 < cap ? (int32_t)(i + 1) : SPATIAL_NULL;
+            nodes[i].height = -1;
+        }
+        s->free_list = (int32_t)s->node_cap;
+        s->nodes = nodes;
+        s->node_cap = cap;
+    }
+
+    int32_t id = s->free_list;
+    SpatialNode* n = &s->nodes[id];
+    s->free_list = n->parent;
+    n->parent = n->left = n->right = SPATIAL_NULL;
+    n->height = 0;
+    n->conic = 0;
+    return id;
+}
+
+static void free_node(SpatialIndex* s, int32_t id) {
+    s->nodes[id].parent = s->free_list;
+    s->nodes[id].height = -1;
+    s->free_list = id;
+}
+
+/**
+ * @brief Garantiza espacio para el identificador id en las tablas por cónica.
+ */
+static bool reserve_ids(SpatialIndex* s, size_t id) {
+    if (id < s->id_cap) return true;
+
+    size_t cap = s->id_cap ? s->id_cap : 64;
+    while (cap <= id) cap *= 2;
+
+    double* coeffs = realloc(s->coeffs, cap * 6 * sizeof(double));
+    if (!coeffs) return false;
+    s->coeffs = coeffs;
+
+    int32_t* leaf = realloc(s->leaf, cap * sizeof(int32_t));
+    if (!leaf) return false;
+    for (size_t i = s->id_cap; i < cap; i++) leaf[i] = SPATIAL_NULL;
+    s->leaf = leaf;
+    s->id_cap = cap;
+    return true;
+}
+
+static void refit(SpatialIndex* s, int32_t i) {
+    SpatialNode* n = &s->nodes[i];
+    const SpatialNode* l = &s->nodes[n->left];
+    const SpatialNode* r = &s->nodes[n->right];
+    box_union(l->box, r->box, n->box);
+    n->height = 1 + (l->height > r->height ? l->height : r->height);
+}
+
+/**
+ * @brief Rotación AVL en el nodo a si sus hijos difieren en altura > 1.
+ * @return Índice del nodo que ocupa ahora la posición de a.
+ */
+static int32_t balance(SpatialIndex* s, int32_t ia) {
+    SpatialNode* a = &s->nodes[ia];
+    if (is_leaf(a) || a->height < 2) return ia;
+
+    int32_t ib = a->left, ic = a->right;
+    int32_t diff = s->nodes[ic].height - s->nodes[ib].height;
+    if (diff >= -1 && diff <= 1) return ia;
+
+    // Sube el hijo más alto (up) y baja a; el nieto más bajo pasa a a
+    int32_t iup = diff > 1 ? ic : ib;
+    SpatialNode* up = &s->nodes[iup];
+    int32_t if_ = up->left, ig = up->right;
+
+    up->left = ia;
+    up->parent = a->parent;
+    a->parent = iup;
+
+    if (up->parent != SPATIAL_NULL) {
+        SpatialNode* p = &s->nodes[up->parent];
+        if (p->left == ia) p->left = iup;
+        else               p->right = iup;
+    } else {
+        s->root = iup;
+    }
+
+    int32_t keep = s->nodes[if_].height > s->nodes[ig].height ? if_ : ig;
+    int32_t give = keep == if_ ? ig : if_;
+    up->right = keep;
+    if (diff > 1) a->right = give;
+    else          a->left = give;
+    s->nodes[give].parent = ia;
+
+    refit(s, ia);
+    refit(s, iup);
+    return iup;
+}
+
+/**
+ * @brief Sube desde i reajustando cajas/alturas y equilibrando.
+ */
+static void fix_upwards(SpatialIndex* s, int32_t i) {
+    while (i != SPATIAL_NULL) {
+        i = balance(s, i);
+        refit(s, i);
+        i = s->nodes[i].parent;
+    }
+}
+
+static void insert_leaf(SpatialIndex* s, int32_t leaf) {
+    if (s->root == SPATIAL_NULL) {
+        s->root = leaf;
+        s->nodes[leaf].parent = SPATIAL_NULL;
+        return;
+    }
+
+    // Hermano con menor coste (perímetro nuevo + heredado por los ancestros)
+    const double* lb = s->nodes[leaf].box;
+    int32_t i = s->root;
+    while (!is_leaf(&s->nodes[i])) {
+        const SpatialNode* n = &s->nodes[i];
+        double u[4];
+        box_union(n->box, lb, u);
+        double combined = box_perimeter(u);
+        double cost = 2.0 * combined;
+        double inherit = 2.0 * (combined - box_perimeter(n->box));
+
+        double child_cost[2];
+        int32_t child[2] = { n->left, n->right };
+        for (int k = 0; k < 2; k++) {
+            const SpatialNode* c = &s->nodes[child[k]];
+            box_union(c->box, lb, u);
+            child_cost[k] = box_perimeter(u) + inherit -
+                            (is_leaf(c) ? 0.0 : box_perimeter(c->box));
+        }
+
+        if (cost < child_cost[0] && cost < child_cost[1]) break;
+        i = child_cost[0] < child_cost[1] ? child[0] : child[1];
+    }
+
+    int32_t sibling = i;
+    int32_t old_parent = s->nodes[sibling].parent;
+    int32_t np = alloc_node(s);
+    // alloc_node puede mover el array: no reutilizar punteros previos
+    SpatialNode* p = &s->nodes[np];
+    p->parent = old_parent;
+    p->left = sibling;
+    p->right = leaf;
+    s->nodes[sibling].parent = np;
+    s->nodes[leaf].parent = np;
+
+    if (old_parent != SPATIAL_NULL) {
+        SpatialNode* op = &s->nodes[old_parent];
+        if (op->left == sibling) op->left = np;
+        else                     op->right = np;
+    } else {
+        s->root = np;
+    }
+
+    fix_upwards(s, np);
+}
+
+static void remove_leaf(SpatialIndex* s, int32_t leaf) {
+    if (leaf == s->root) {
+        s->root = SPATIAL_NULL;
+        return;
+    }
+
+    int32_t parent = s->nodes[leaf].parent;
+    int32_t grand = s->nodes[parent].parent;
+    int32_t sibling = s->nodes[parent].left == leaf ? s->nodes[parent].right
+                                                     : s->nodes[parent].left;
+
+    if (grand != SPATIAL_NULL) {
+        SpatialNode* g = &s->nodes[grand];
+        if (g->left == parent) g->left = sibling;
+        else                   g->right = sibling;
+        s->nodes[sibling].parent = grand;
+        free_node(s, parent);
+        fix_upwards(s, grand);
+    } else {
+        s->root = sibling;
+        s->nodes[sibling].parent = SPATIAL_NULL;
+        free_node(s, parent);
+    }
+}
+
+//-------------------------------------------//
+//               CARGA MASIVA                //
+//-------------------------------------------//
+
+typedef struct {
+    double  cx, cy;
+    int32_t node;
+} BuildItem;
+
+typedef struct {
+    const double* coeffs;
+    const double* window;
+    double*       boxes;
+} BoxJob;
+
+static void box_range(size_t begin, size_t end, void* ctx) {
+    BoxJob* job = ctx;
+    for (size_t i = begin; i < end; i++) {
+        double* box = job->boxes + 4 * i;
+        if (!conic_bounds(job->coeffs + 6 * i, job->window, box)) box[0] = NAN;
+    }
+}
+
+static double item_key(const BuildItem* it, int axis) {
+    return axis == 0 ? it->cx : it->cy;
+}
+
+/**
+ * @brief Selección de Hoare: deja en items[k] el k-ésimo por el eje y a
+ *        su izquierda los menores (O(n) en media, sin ordenar del todo).
+ */
+static void select_kth(BuildItem* items, size_t n, size_t k, int axis) {
+    size_t lo = 0, hi = n - 1;
+    while (lo < hi) {
+        double pivot = item_key(&items[lo + (hi - lo) / 2], axis);
+        size_t i = lo, j = hi;
+        while (i <= j) {
+            while (item_key(&items[i], axis) < pivot) i++;
+            while (item_key(&items[j], axis) > pivot) j--;
+            if (i <= j) {
+                BuildItem t = items[i];
+                items[i] = items[j];
+                items[j] = t;
+                i++;
+                if (j == 0) break;
+                j--;
+            }
+        }
+        if (k <= j) hi = j;
+        else if (k >= i) lo = i;
+        else break;
+    }
+}
+
+/**
+ * @brief Construye el subárbol de items[0, n) partiendo por la mediana
+ *        del eje en que más se dispersan los centros.
+ * @return Raíz del subárbol, o SPATIAL_NULL sin memoria.
+ */
+static int32_t build_range(SpatialIndex* s, BuildItem* items, size_t n) {
+    if (n == 1) return items[0].node;
+
+    double lo[2] = { INFINITY, INFINITY }, hi[2] = { -INFINITY, -INFINITY };
+    for (size_t i = 0; i < n; i++) {
+        lo[0] = fmin(lo[0], items[i].cx); hi[0] = fmax(hi[0], items[i].cx);
+        lo[1] = fmin(lo[1], items[i].cy); hi[1] = fmax(hi[1], items[i].cy);
+    }
+    size_t mid = n / 2;
+    select_kth(items, n, mid, hi[0] - lo[0] >= hi[1] - lo[1] ? 0 : 1);
+
+    int32_t l = build_range(s, items, mid);
+    int32_t r = l == SPATIAL_NULL ? SPATIAL_NULL : build_range(s, items + mid, n - mid);
+    if (r == SPATIAL_NULL) return SPATIAL_NULL;
+
+    int32_t id = alloc_node(s);
+    if (id == SPATIAL_NULL) return SPATIAL_NULL;
+    s->nodes[id].left = l;
+    s->nodes[id].right = r;
+    s->nodes[l].parent = id;
+    s->nodes[r].parent = id;
+    refit(s, id);
+    return id;
+}
+
+//-------------------------------------------//
+//                 API PÚBLICA               //
+//-------------------------------------------//
+
+/**
+ * @brief Inicializa un índice vacío sobre la ventana de la escena.
+ */
+bool spatial_init(SpatialIndex* s, const double window[4]) {
+    memset(s, 0, sizeof(*s));
+    s->root = SPATIAL_NULL;
+    s->free_list = SPATIAL_NULL;
+    memcpy(s->window, window, sizeof(s->window));
+    return window[0] < window[2] && window[1] < window[3];
+}
+
+void spatial_free(SpatialIndex* s) {
+    free(s->nodes);
+    free(s->coeffs);
+    free(s->leaf);
+    memset(s, 0, sizeof(*s));
+    s->root = SPATIAL_NULL;
+    s->free_list = SPATIAL_NULL;
+}
+
+/**
+ * @brief Carga masiva: cajas de todas las cónicas y partición top-down.
+ * @param s Índice vacío.
+ * @param coeffs n filas de 6 coeficientes (ids 0..n-1).
+ * @param n Número de cónicas.
+ * @return false sin memoria o si el índice no estaba vacío.
+ */
+bool spatial_build(SpatialIndex* s, const double* coeffs, size_t n) {
+    if (s->root != SPATIAL_NULL || n == 0) return n == 0 && s->root == SPATIAL_NULL;
+    if (!reserve_ids(s, n - 1)) return false;
+
+    BuildItem* items = malloc(n * sizeof(BuildItem));
+    double* boxes = malloc(n * 4 * sizeof(double));
+    if (!items || !boxes) {
+        free(items);
+        free(boxes);
+        return false;
+    }
+
+    // Las cajas son independientes: se calculan en paralelo
+    BoxJob job = { coeffs, s->window, boxes };
+    tp_parallel_for(0, n, 1024, box_range, &job);
+
+    size_t m = 0;
+    bool ok = true;
+    for (size_t i = 0; i < n && ok; i++) {
+        memcpy(s->coeffs + 6 * i, coeffs + 6 * i, 6 * sizeof(double));
+        double* box = boxes + 4 * i;
+        if (isnan(box[0])) continue;
+
+        int32_t leaf = alloc_node(s);
+        if (leaf == SPATIAL_NULL) {
+            ok = false;
+            break;
+        }
+        fatten(s, box);
+        memcpy(s->nodes[leaf].box, box, 4 * sizeof(double));
+        s->nodes[leaf].conic = (uint32_t)i;
+        s->leaf[i] = leaf;
+        items[m++] = (BuildItem){ 0.5 * (box[0] + box[2]), 0.5 * (box[1] + box[3]), leaf };
+    }
+    free(boxes);
+
+    if (ok && m > 0) {
+        s->root = build_range(s, items, m);
+        ok = s->root != SPATIAL_NULL;
+        if (ok) s->nodes[s->root].parent = SPATIAL_NULL;
+    }
+    s->count = m;
+    free(items);
+    return ok;
+}
+
+/**
+ * @brief Inserta (o reemplaza) la cónica id.
+ * @return false sin memoria. Si la curva no toca la ventana se guarda
+ *         pero no se indexa.
+ */
+bool spatial_insert(SpatialIndex* s, uint32_t id, const double c[6]) {
+    if (!reserve_ids(s, id)) return false;
+    if (s->leaf[id] != SPATIAL_NULL) spatial_remove(s, id);
+
+    memcpy(s->coeffs + 6 * (size_t)id, c, 6 * sizeof(double));
+    double box[4];
+    if (!conic_bounds(c, s->window, box)) return true;
+
+    int32_t leaf = alloc_node(s);
+    if (leaf == SPATIAL_NULL) return false;
+    fatten(s, box);
+    memcpy(s->nodes[leaf].box, box, sizeof(box));
+    s->nodes[leaf].conic = id;
+    s->leaf[id] = leaf;
+
+    insert_leaf(s, leaf);
+    s->count++;
+    return true;
+}
+
+bool spatial_remove(SpatialIndex* s, uint32_t id) {
+    if (id >= s->id_cap || s->leaf[id] == SPATIAL_NULL) return false;
+
+    int32_t leaf = s->leaf[id];
+    remove_leaf(s, leaf);
+    free_node(s, leaf);
+    s->leaf[id] = SPATIAL_NULL;
+    s->count--;
+    return true;
+}
+
+/**
+ * @brief Actualiza la cónica id; el árbol solo cambia si la nueva caja
+ *        exacta se sale de la caja gruesa guardada.
+ */
+bool spatial_update(SpatialIndex* s, uint32_t id, const double c[6]) {
+    if (id >= s->id_cap || s->leaf[id] == SPATIAL_NULL) return spatial_insert(s, id, c);
+
+    double box[4];
+    if (conic_bounds(c, s->window, box) && box_contains(s->nodes[s->leaf[id]].box, box)) {
+        memcpy(s->coeffs + 6 * (size_t)id, c, 6 * sizeof(double));
+        return true;
+    }
+    return spatial_insert(s, id, c);
+}
+
+/**
+ * @brief Inserta un acierto en la lista ordenada hits[0, *n) de tamaño max.
+ */
+static void hits_push(SpatialHit* hits, size_t* n, size_t max, SpatialHit h) {
+    if (*n == max && h.distance >= hits[max - 1].distance) return;
+
+    size_t i = *n < max ? (*n)++ : max - 1;
+    while (i > 0 && hits[i - 1].distance > h.distance) {
+        hits[i] = hits[i - 1];
+        i--;
+    }
+    hits[i] = h;
+}
+
+/**
+ * @brief Picking: cónicas a distancia <= radius de (x, y).
+ * @details Recorrido en profundidad podando por distancia a caja; cuando
+ *          la lista está llena, el radio se reduce al peor acierto.
+ */
+size_t spatial_pick(const SpatialIndex* s, double x, double y, double radius,
+                    SpatialHit* hits, size_t max) {
+    if (s->root == SPATIAL_NULL || max == 0) return 0;
+
+    int32_t stack[SPATIAL_STACK];
+    int top = 0;
+    size_t n = 0;
+    stack[top++] = s->root;
+
+    while (top > 0) {
+        const SpatialNode* node = &s->nodes[stack[--top]];
+        double limit = n == max ? fmin(radius, hits[max - 1].distance) : radius;
+        if (box_distance(node->box, x, y) > limit) continue;
+
+        if (is_leaf(node)) {
+            SpatialHit h;
+            h.conic = node->conic;
+            h.distance = conic_distance(s->coeffs + 6 * (size_t)node->conic, x, y, &h.foot);
+            if (h.distance <= limit) hits_push(hits, &n, max, h);
+        } else if (top + 2 <= SPATIAL_STACK) {
+            stack[top++] = node->left;
+            stack[top++] = node->right;
+        }
+    }
+    return n;
+}
+
+static bool box_overlaps(const double a[4], const double b[4]) {
+    return a[0] <= b[2] && b[0] <= a[2] && a[1] <= b[3] && b[1] <= a[3];
+}
+
+/**
+ * @brief Recorrido en profundidad de los nodos cuya caja corta box.
+ */
+size_t spatial_query(const SpatialIndex* s, const double box[4], uint32_t* ids, size_t max) {
+    if (s->root == SPATIAL_NULL) return 0;
+
+    int32_t stack[SPATIAL_STACK];
+    int top = 0;
+    size_t n = 0;
+    stack[top++] = s->root;
+
+    while (top > 0) {
+        const SpatialNode* node = &s->nodes[stack[--top]];
+        if (!box_overlaps(node->box, box)) continue;
+
+        if (is_leaf(node)) {
+            if (n < max) ids[n] = node->conic;
+            n++;
+        } else if (top + 2 <= SPATIAL_STACK) {
+            stack[top++] = node->left;
+            stack[top++] = node->right;
+        }
+    }
+    return n;
+}
+
+typedef struct {
+    double  bound;
+    int32_t node;
+} HeapItem;
+
+static void heap_push(HeapItem* h, size_t* n, HeapItem it) {
+    size_t i = (*n)++;
+    while (i > 0 && h[(i - 1) / 2].bound > it.bound) {
+        h[i] = h[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    h[i] = it;
+}
+
+static HeapItem heap_pop(HeapItem* h, size_t* n) {
+    HeapItem top = h[0], last = h[--(*n)];
+    size_t i = 0;
+    for (;;) {
+        size_t c = 2 * i + 1;
+        if (c >= *n) break;
+        if (c + 1 < *n && h[c + 1].bound < h[c].bound) c++;
+        if (h[c].bound >= last.bound) break;
+        h[i] = h[c];
+        i = c;
+    }
+    if (*n > 0) h[i] = last;
+    return top;
+}
+
+/**
+ * @brief k vecinos más cercanos por búsqueda best-first.
+ * @details Se expanden los nodos en orden de distancia a caja; se para
+ *          cuando la menor cota pendiente supera al k-ésimo acierto.
+ */
+size_t spatial_nearest(const SpatialIndex* s, double x, double y, size_t k,
+                       SpatialHit* hits) {
+    if (s->root == SPATIAL_NULL || k == 0) return 0;
+
+    // Cada nodo entra en el montículo como mucho una vez
+    size_t live = 2 * s->count;
+    HeapItem* heap = malloc((live ? live : 1) * sizeof(HeapItem));
+    if (!heap) return 0;
+
+    size_t hn = 0, n = 0;
+    heap_push(heap, &hn, (HeapItem){ box_distance(s->nodes[s->root].box, x, y), s->root });
+
+    while (hn > 0) {
+        HeapItem it = heap_pop(heap, &hn);
+        if (n == k && it.bound >= hits[k - 1].distance) break;
+
+        const SpatialNode* node = &s->nodes[it.node];
+        if (is_leaf(node)) {
+            SpatialHit h;
+            h.conic = node->conic;
+            h.distance = conic_distance(s->coeffs + 6 * (size_t)node->conic, x, y, &h.foot);
+            if (isfinite(h.distance)) hits_push(hits, &n, k, h);
+        } else {
+            heap_push(heap, &hn, (HeapItem){ box_distance(s->nodes[node->left].box, x, y), node->left });
+            heap_push(heap, &hn, (HeapItem){ box_distance(s->nodes[node->right].box, x, y), node->right });
+        }
+    }
+
+    free(heap);
+    return n;
+}
+
+int spatial_height(const SpatialIndex* s) {
+    return s->root == SPATIAL_NULL ? 0 : s->nodes[s->root].height;
+}
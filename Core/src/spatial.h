@@ -0,0 +1,106 @@
+//================================================================//
+//        SPATIAL HEADER - Índice espacial dinámico (BVH)         //
+//================================================================//
+//
+// Árbol de cajas alineadas (BVH dinámico, equilibrado tipo AVL) sobre
+// las cónicas de una escena, para picking y vecinos más cercanos:
+// - Carga masiva top-down (mediana por el eje más largo).
+// - Inserción, borrado y actualización incrementales en O(log n).
+// - Cajas "gruesas": una edición pequeña que cabe en la caja guardada
+//   no toca el árbol.
+// - Refinamiento exacto con conic_distance solo en las hojas candidatas.
+//
+// Las cajas son las de conic_bounds dentro de la ventana de la escena;
+// las consultas están pensadas para puntos dentro de esa ventana.
+//
+
+#ifndef SPATIAL_H
+#define SPATIAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "conics.h"
+
+#define SPATIAL_NULL (-1)
+
+typedef struct {
+    double   box[4];            // x_min, y_min, x_max, y_max
+    int32_t  parent;
+    int32_t  left, right;       // SPATIAL_NULL en hojas
+    int32_t  height;            // 0 en hojas; -1 en nodos libres
+    uint32_t conic;             // solo en hojas
+} SpatialNode;
+
+typedef struct {
+    SpatialNode* nodes;
+    size_t       node_cap;
+    int32_t      root;
+    int32_t      free_list;     // encadenada por parent
+
+    double       window[4];
+
+    // Por identificador de cónica
+    double*      coeffs;        // 6 por id
+    int32_t*     leaf;          // nodo hoja o SPATIAL_NULL
+    size_t       id_cap;
+    size_t       count;
+} SpatialIndex;
+
+typedef struct {
+    uint32_t conic;
+    double   distance;
+    Point2D  foot;
+} SpatialHit;
+
+bool spatial_init(SpatialIndex* s, const double window[4]);
+void spatial_free(SpatialIndex* s);
+
+/**
+ * Carga masiva de n cónicas con identificadores 0..n-1 (el índice debe
+ * estar vacío). Las que no tocan la ventana no se indexan.
+ */
+bool spatial_build(SpatialIndex* s, const double* coeffs, size_t n);
+
+/**
+ * Inserta o reemplaza la cónica id. Devuelve false sin memoria.
+ */
+bool spatial_insert(SpatialIndex* s, uint32_t id, const double c[6]);
+
+/**
+ * Elimina la cónica id. Devuelve false si no estaba.
+ */
+bool spatial_remove(SpatialIndex* s, uint32_t id);
+
+/**
+ * Actualiza los coeficientes de id; reinserta solo si su nueva caja se
+ * sale de la caja gruesa guardada.
+ */
+bool spatial_update(SpatialIndex* s, uint32_t id, const double c[6]);
+
+/**
+ * Cónicas a distancia <= radius de (x, y), ordenadas por distancia.
+ * Escribe como mucho max hits y devuelve cuántas se escribieron.
+ */
+size_t spatial_pick(const SpatialIndex* s, double x, double y, double radius,
+                    SpatialHit* hits, size_t max);
+
+/**
+ * Identificadores de las cónicas cuya caja (gruesa) corta box. Escribe
+ * como mucho max y devuelve el total encontrado, que puede ser mayor.
+ */
+size_t spatial_query(const SpatialIndex* s, const double box[4], uint32_t* ids, size_t max);
+
+/**
+ * Las k cónicas más cercanas a (x, y) por distancia exacta.
+ */
+size_t spatial_nearest(const SpatialIndex* s, double x, double y, size_t k,
+                       SpatialHit* hits);
+
+/**
+ * Altura del árbol (0 si está vacío o tiene una hoja).
+ */
+int spatial_height(const SpatialIndex* s);
+
+#endif
@@ -0,0 +1,476 @@
+//================================================================//
+// THREAD POOL - Planificador con robo de trabajo (pthreads)
+//================================================================//
+//
+// Implementación del pool descrito en threadpool.h.
+//
+// Cada worker tiene un deque protegido por su propio mutex (contención
+// mínima: solo coinciden dueño y ladrón sobre el mismo deque). Los hilos
+// externos al pool (main y, en --serve, hasta 64 hilos de petición)
+// comparten el deque 0, y con él su mutex, y participan en el trabajo
+// mientras esperan a su grupo.
+//
+//--------------------------------//
+// Includes y dependencias
+//--------------------------------//
+#define _POSIX_C_SOURCE 200809L
+
+#include "threadpool.h"
+
+#include "budget.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * @file threadpool.c
+ * @brief Deques por worker, robo aleatorio y parallel_for recursivo.
+ */
+
+//-------------------------------------------//
+//                   TIPOS                   //
+//-------------------------------------------//
+
+typedef struct Task Task;
+
+/**
+ * Tarea almacenada por valor en los deques (sin malloc por tarea).
+ */
+struct Task {
+    void (*run)(Task* t);
+    TaskGroup* group;
+    Budget*    budget;          // presupuesto del hilo que la creó
+    union {
+        struct { TaskFn fn; void* arg; } call;
+        struct { size_t begin, end, grain; RangeFn fn; void* ctx; } range;
+    } u;
+};
+
+/**
+ * Deque circular: el dueño trabaja en bottom, los ladrones en top.
+ * Índices monótonos; cap es potencia de dos.
+ */
+typedef struct {
+    pthread_mutex_t lock;
+    Task*  buf;
+    size_t cap;
+    size_t top;
+    size_t bottom;
+} Deque;
+
+typedef struct {
+    int        n;             // deques reservados; fijo mientras hay workers
+    int        workers;       // hilos en marcha, el llamador incluido (<= n)
+    Deque*     deques;
+    pthread_t* threads;
+
+    atomic_bool   stop;
+    atomic_size_t queued;     // tareas en los deques
+    atomic_int    sleepers;   // workers dormidos (modificado bajo sleep_lock)
+
+    pthread_mutex_t sleep_lock;
+    pthread_cond_t  sleep_cond;
+} Pool;
+
+static Pool pool;
+static atomic_bool pool_ready = false;
+
+// Arranque perezoso (tp_configure): -1 = sin configurar
+static pthread_mutex_t init_lock = PTHREAD_MUTEX_INITIALIZER;
+static int pool_requested = -1;
+
+static _Thread_local int      tls_worker = 0;     // externos usan el deque 0
+static _Thread_local unsigned tls_seed = 0x9e3779b9u;
+
+//-------------------------------------------//
+//                   DEQUE                   //
+//-------------------------------------------//
+
+static void deque_init(Deque* d) {
+    pthread_mutex_init(&d->lock, NULL);
+    d->cap = 256;
+    d->buf = malloc(d->cap * sizeof(Task));
+    d->top = d->bottom = 0;
+}
+
+static void deque_destroy(Deque* d) {
+    pthread_mutex_destroy(&d->lock);
+    free(d->buf);
+}
+
+/**
+ * @brief Apila una tarea por abajo (lado del dueño), creciendo si hace falta.
+ * @return false si no hay memoria para crecer.
+ */
+static bool deque_push(Deque* d, const Task* t) {
+    pthread_mutex_lock(&d->lock);
+    if (d->bottom - d->top == d->cap) {
+        size_t cap = d->cap * 2;
+        Task* buf = malloc(cap * sizeof(Task));
+        if (!buf) {
+            pthread_mutex_unlock(&d->lock);
+            return false;
+        }
+        for (size_t i = d->top; i != d->bottom; i++) {
+            buf[i & (cap - 1)] = d->buf[i & (d->cap - 1)];
+        }
+        free(d->buf);
+        d->buf = buf;
+        d->cap = cap;
+    }
+    d->buf[d->bottom & (d->cap - 1)] = *t;
+    d->bottom++;
+    pthread_mutex_unlock(&d->lock);
+    return true;
+}
+
+/**
+ * @brief Desapila la tarea más reciente (LIFO, buena localidad de caché).
+ */
+static bool deque_pop(Deque* d, Task* out) {
+    pthread_mutex_lock(&d->lock);
+    bool ok = d->bottom != d->top;
+    if (ok) {
+        d->bottom--;
+        *out = d->buf[d->bottom & (d->cap - 1)];
+    }
+    pthread_mutex_unlock(&d->lock);
+    return ok;
+}
+
+/**
+ * @brief Roba la tarea más antigua (FIFO: suele ser el rango más grande).
+ */
+static bool deque_steal(Deque* d, Task* out) {
+    if (pthread_mutex_trylock(&d->lock) != 0) return false;
+    bool ok = d->bottom != d->top;
+    if (ok) {
+        *out = d->buf[d->top & (d->cap - 1)];
+        d->top++;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return ok;
+}
+
+//-------------------------------------------//
+//               PLANIFICACIÓN               //
+//-------------------------------------------//
+
+static unsigned next_random(void) {
+    // xorshift32 por hilo
+    unsigned x = tls_seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    tls_seed = x;
+    return x;
+}
+
+/**
+ * @brief Publica una tarea en el deque del hilo actual y despierta a un
+ *        worker dormido si lo hay. Sin memoria, la ejecuta en línea.
+ */
+static void push_task(const Task* t) {
+    if (!deque_push(&pool.deques[tls_worker], t)) {
+        Task copy = *t;
+        copy.run(&copy);
+        atomic_fetch_sub(&copy.group->pending, 1);
+        return;
+    }
+
+    atomic_fetch_add(&pool.queued, 1);
+    if (atomic_load(&pool.sleepers) > 0) {
+        pthread_mutex_lock(&pool.sleep_lock);
+        pthread_cond_signal(&pool.sleep_cond);
+        pthread_mutex_unlock(&pool.sleep_lock);
+    }
+}
+
+/**
+ * @brief Busca trabajo: primero el deque propio, luego robo aleatorio.
+ */
+static bool find_task(Task* out) {
+    int self = tls_worker;
+    bool ok = deque_pop(&pool.deques[self], out);
+
+    if (!ok) {
+        int start = (int)(next_random() % (unsigned)pool.n);
+        for (int i = 0; i < pool.n && !ok; i++) {
+            int victim = (start + i) % pool.n;
+            if (victim != self) ok = deque_steal(&pool.deques[victim], out);
+        }
+    }
+
+    if (ok) atomic_fetch_sub(&pool.queued, 1);
+    return ok;
+}
+
+/**
+ * @brief Ejecuta t con el presupuesto de quien la creó (budget.h) y lo
+ *        restaura después: un hilo que ayuda mientras espera puede estar
+ *        atendiendo otra petición.
+ */
+static void execute(Task* t) {
+    TaskGroup* g = t->group;
+    Budget* prev = budget_swap(t->budget);
+    t->run(t);
+    budget_swap(prev);
+    atomic_fetch_sub(&g->pending, 1);
+}
+
+static void run_call(Task* t) {
+    t->u.call.fn(t->u.call.arg);
+}
+
+/**
+ * @brief Ejecuta un rango partiéndolo por la mitad mientras supere grain.
+ * @details Cada mitad derecha se publica como tarea robable; el hilo actual
+ *          continúa con la izquierda. Los ladrones se llevan así los trozos
+ *          grandes y el reparto se adapta solo a la carga.
+ */
+static void run_range(Task* t) {
+    size_t b = t->u.range.begin;
+    size_t e = t->u.range.end;
+
+    while (e - b > t->u.range.grain) {
+        size_t mid = b + (e - b) / 2;
+
+        Task right = *t;
+        right.u.range.begin = mid;
+        right.u.range.end = e;
+        atomic_fetch_add(&t->group->pending, 1);
+        push_task(&right);
+
+        e = mid;
+    }
+
+    t->u.range.fn(b, e, t->u.range.ctx);
+}
+
+/**
+ * @brief Bucle principal de cada worker: trabajar, girar un poco y dormir.
+ */
+static void* worker_main(void* arg) {
+    tls_worker = (int)(size_t)arg;
+    tls_seed = 0x9e3779b9u * (unsigned)(tls_worker + 1);
+
+    int spins = 0;
+    while (!atomic_load(&pool.stop)) {
+        Task t;
+        if (find_task(&t)) {
+            execute(&t);
+            spins = 0;
+            continue;
+        }
+
+        if (++spins < 64) {
+            sched_yield();
+            continue;
+        }
+
+        pthread_mutex_lock(&pool.sleep_lock);
+        atomic_fetch_add(&pool.sleepers, 1);
+        while (atomic_load(&pool.queued) == 0 && !atomic_load(&pool.stop)) {
+            pthread_cond_wait(&pool.sleep_cond, &pool.sleep_lock);
+        }
+        atomic_fetch_sub(&pool.sleepers, 1);
+        pthread_mutex_unlock(&pool.sleep_lock);
+        spins = 0;
+    }
+    return NULL;
+}
+
+//-------------------------------------------//
+//                 API PÚBLICA               //
+//-------------------------------------------//
+
+/**
+ * @brief Libera los pool.n deques (también los de workers que no
+ *        llegaron a arrancar) y las primitivas del pool.
+ */
+static void pool_release(void) {
+    for (int i = 0; i < pool.n; i++) deque_destroy(&pool.deques[i]);
+    pthread_mutex_destroy(&pool.sleep_lock);
+    pthread_cond_destroy(&pool.sleep_cond);
+    free(pool.deques);
+    free(pool.threads);
+}
+
+/**
+ * @brief Crea el pool global con n hilos en total.
+ * @param n Hilos totales (el llamador cuenta como uno); <= 0 = CPUs en línea.
+ * @return Número de hilos efectivos.
+ * @warning No llamar mientras haya trabajo en curso.
+ */
+int tp_init(int n) {
+    if (atomic_load(&pool_ready)) tp_shutdown();
+
+    if (n <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        n = cpus > 0 ? (int)cpus : 1;
+    }
+    if (n == 1) return 1;
+
+    memset(&pool, 0, sizeof(pool));
+    pool.n = n;
+    pool.deques = calloc((size_t)n, sizeof(Deque));
+    pool.threads = calloc((size_t)n, sizeof(pthread_t));
+    if (!pool.deques || !pool.threads) {
+        free(pool.deques);
+        free(pool.threads);
+        return 1;
+    }
+
+    for (int i = 0; i < n; i++) deque_init(&pool.deques[i]);
+    pthread_mutex_init(&pool.sleep_lock, NULL);
+    pthread_cond_init(&pool.sleep_cond, NULL);
+    atomic_init(&pool.stop, false);
+    atomic_init(&pool.queued, 0);
+    atomic_init(&pool.sleepers, 0);
+
+    // El hilo 0 es el llamador; se lanzan n - 1 workers. Si alguno no
+    // arranca, sus deques siguen reservados (vacíos): los workers ya en
+    // marcha leen pool.n, que no se toca
+    int started = 1;
+    for (int i = 1; i < n; i++) {
+        if (pthread_create(&pool.threads[i], NULL, worker_main, (void*)(size_t)i) != 0) break;
+        started++;
+    }
+
+    if (started == 1) {
+        pool_release();
+        return 1;
+    }
+
+    // pool_ready publica workers a los demás hilos (tp_thread_count)
+    pool.workers = started;
+    atomic_store(&pool_ready, true);
+    return started;
+}
+
+/**
+ * @brief Detiene los workers y libera deques y primitivas.
+ */
+void tp_shutdown(void) {
+    if (!atomic_load(&pool_ready)) return;
+
+    pthread_mutex_lock(&pool.sleep_lock);
+    atomic_store(&pool.stop, true);
+    pthread_cond_broadcast(&pool.sleep_cond);
+    pthread_mutex_unlock(&pool.sleep_lock);
+
+    for (int i = 1; i < pool.workers; i++) pthread_join(pool.threads[i], NULL);
+    pool_release();
+
+    atomic_store(&pool_ready, false);
+    pool_requested = -1;
+}
+
+/**
+ * @brief Guarda el tamaño deseado; el pool arranca en ensure_pool().
+ */
+void tp_configure(int n) {
+    pthread_mutex_lock(&init_lock);
+    pool_requested = n;
+    pthread_mutex_unlock(&init_lock);
+}
+
+/**
+ * @brief Arranca el pool configurado si aún no existe (seguro entre hilos).
+ * @return true si hay workers disponibles.
+ */
+static bool ensure_pool(void) {
+    if (atomic_load(&pool_ready)) return true;
+
+    pthread_mutex_lock(&init_lock);
+    if (!atomic_load(&pool_ready) && pool_requested >= 0) {
+        int n = pool_requested;
+        pool_requested = -1;   // un fallo no se reintenta en cada llamada
+        tp_init(n);
+    }
+    pthread_mutex_unlock(&init_lock);
+    return atomic_load(&pool_ready);
+}
+
+int tp_thread_count(void) {
+    return atomic_load(&pool_ready) ? pool.workers : 1;
+}
+
+void tp_group_init(TaskGroup* g) {
+    atomic_init(&g->pending, 0);
+}
+
+/**
+ * @brief Encola fn(arg) en el grupo g (en línea si no hay pool).
+ */
+void tp_group_spawn(TaskGroup* g, TaskFn fn, void* arg) {
+    if (!ensure_pool()) {
+        fn(arg);
+        return;
+    }
+
+    Task t;
+    t.run = run_call;
+    t.group = g;
+    t.budget = budget_current();
+    t.u.call.fn = fn;
+    t.u.call.arg = arg;
+
+    atomic_fetch_add(&g->pending, 1);
+    push_task(&t);
+}
+
+/**
+ * @brief Espera al grupo g ayudando con cualquier tarea disponible.
+ */
+void tp_group_wait(TaskGroup* g) {
+    while (atomic_load(&g->pending) > 0) {
+        Task t;
+        if (find_task(&t)) execute(&t);
+        else sched_yield();
+    }
+}
+
+/**
+ * @brief parallel_for sobre [begin, end) con división recursiva.
+ * @param begin Inicio del rango.
+ * @param end Fin del rango (exclusivo).
+ * @param grain Tamaño mínimo de trozo; 0 = automático (~8 trozos por hilo).
+ * @param fn Función de rango.
+ * @param ctx Contexto pasado a fn.
+ */
+void tp_parallel_for(size_t begin, size_t end, size_t grain, RangeFn fn, void* ctx) {
+    if (end <= begin) return;
+
+    size_t n = end - begin;
+    int threads = ensure_pool() ? pool.workers : 1;
+    if (grain == 0) {
+        grain = n / ((size_t)threads * 8);
+        if (grain == 0) grain = 1;
+    }
+
+    if (threads == 1 || n <= grain) {
+        fn(begin, end, ctx);
+        return;
+    }
+
+    TaskGroup g;
+    atomic_init(&g.pending, 1);
+
+    Task root;
+    root.run = run_range;
+    root.group = &g;
+    root.budget = budget_current();
+    root.u.range.begin = begin;
+    root.u.range.end = end;
+    root.u.range.grain = grain;
+    root.u.range.fn = fn;
+    root.u.range.ctx = ctx;
+
+    execute(&root);
+    tp_group_wait(&g);
+}
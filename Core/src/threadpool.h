@@ -0,0 +1,76 @@
+//================================================================//
+//            THREAD POOL HEADER - WORK STEALING (V 1.0)          //
+//================================================================//
+//
+// Planificador con robo de trabajo sobre pthreads para todo el núcleo.
+// - Un deque por worker: el dueño apila/desapila por abajo y los
+//   ladrones roban por arriba (las tareas más grandes).
+// - parallel_for divide rangos de forma recursiva bajo demanda.
+// - Grupos de tareas con espera activa: quien espera también ejecuta
+//   trabajo, por lo que el paralelismo anidado no bloquea el pool.
+// - Cada tarea hereda el presupuesto (budget.h) del hilo que la crea.
+//
+// Con un solo hilo todo se ejecuta en línea, sin sincronización.
+//
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+typedef void (*TaskFn)(void* arg);
+typedef void (*RangeFn)(size_t begin, size_t end, void* ctx);
+
+/**
+ * Grupo de tareas: cuenta las pendientes para poder esperarlas.
+ */
+typedef struct {
+    atomic_size_t pending;
+} TaskGroup;
+
+/**
+ * Inicializa el pool global con n hilos en total (incluido el llamador).
+ * n <= 0 usa el número de CPUs en línea. Devuelve los hilos efectivos.
+ * Si ya estaba iniciado, lo reinicia con el nuevo tamaño.
+ */
+int tp_init(int n);
+
+/**
+ * Fija el tamaño del pool sin arrancarlo: los hilos se crean en la
+ * primera región paralela. Sin configurar, todo se ejecuta en línea.
+ */
+void tp_configure(int n);
+
+/**
+ * Detiene y libera el pool. Llamadas posteriores se ejecutan en línea
+ * hasta un nuevo tp_init.
+ */
+void tp_shutdown(void);
+
+/**
+ * Número de hilos del pool (1 si no está iniciado ni configurado).
+ */
+int tp_thread_count(void);
+
+void tp_group_init(TaskGroup* g);
+
+/**
+ * Encola fn(arg) en el deque del hilo actual como parte del grupo g.
+ */
+void tp_group_spawn(TaskGroup* g, TaskFn fn, void* arg);
+
+/**
+ * Espera a que terminen todas las tareas de g ejecutando trabajo
+ * pendiente mientras tanto.
+ */
+void tp_group_wait(TaskGroup* g);
+
+/**
+ * Ejecuta fn sobre [begin, end) troceado en rangos de al menos grain
+ * elementos. grain == 0 elige un tamaño automático. Bloquea hasta
+ * terminar; fn puede llamarse concurrentemente desde varios hilos.
+ */
+void tp_parallel_for(size_t begin, size_t end, size_t grain, RangeFn fn, void* ctx);
+
+#endif
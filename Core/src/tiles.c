@@ -0,0 +1,559 @@
+//================================================================//
+// TILES - Pirámide de teselas z/x/y con caché LRU y de disco
+//================================================================//
+//
+// tiles_render resuelve un lote de teselas en cuatro fases:
+//
+//   1. (paralela) candidatas de cada tesela: consulta al BVH con la
+//      ventana ampliada por el alcance del trazo, filtrada con
+//      conic_bounds sobre esa ventana; ids ordenados (orden de escena) y
+//      clave de contenido.
+//   2. (serie)    búsqueda en la LRU, con su cerrojo.
+//   3. (paralela) las que faltan: disco o dibujo; cada dibujo reparte a
+//      su vez sus teselas de raster entre los hilos (el pool admite
+//      anidamiento).
+//   4. (serie)    alta en la LRU, con su cerrojo.
+//
+// La clave es un hash de 64 bits: una colisión exige dos escenas
+// distintas con la misma clave en la misma caché, algo despreciable
+// frente a las 2^32 teselas que harían falta.
+//
+//--------------------------------//
+// Includes y dependencias
+//--------------------------------//
+#define _POSIX_C_SOURCE 200809L
+
+#include "tiles.h"
+
+#include <math.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "budget.h"
+#include "export.h"
+#include "threadpool.h"
+
+/**
+ * @file tiles.c
+ * @brief Geometría de la pirámide, claves de contenido, LRU y disco.
+ */
+
+//-------------------------------------------//
+//           FUNCIONES AUXILIARES            //
+//-------------------------------------------//
+
+#define TILE_NULL (-1)
+
+typedef struct {
+    uint32_t* ids;              // candidatas, en orden de escena
+    size_t    n;
+    bool      pending;          // no estaba en la LRU
+} TileWork;
+
+typedef struct {
+    const TileScene*  s;
+    const TileParams* p;
+    const char*       dir;
+    TileResult*       out;
+    TileWork*         work;
+    atomic_bool       failed;
+} TileJob;
+
+static const char* const TILE_EXT[] = { "png", "qoi", "svg" };
+
+/**
+ * @brief Paso de splitmix64 sobre h ^ v: cada palabra difunde por toda
+ *        la clave.
+ */
+static uint64_t mix64(uint64_t h, uint64_t v) {
+    uint64_t z = h ^ v;
+    z += 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+static uint64_t mix_double(uint64_t h, double d) {
+    uint64_t v;
+    if (d == 0.0) d = 0.0;      // -0 y +0 dibujan lo mismo
+    memcpy(&v, &d, sizeof(v));
+    return mix64(h, v);
+}
+
+static uint64_t mix_rgba(uint64_t h, const uint8_t c[4]) {
+    return mix64(h, (uint64_t)c[0] | (uint64_t)c[1] << 8 | (uint64_t)c[2] << 16 | (uint64_t)c[3] << 24);
+}
+
+/**
+ * @brief Alcance del trazo más allá de la curva, en píxeles: el de
+ *        raster.c (semiancho ≥ 0.5 más medio píxel) con un píxel de margen.
+ */
+static double tile_pad(const TileParams* p) {
+    return fmax(0.5 * p->style.line_width, 0.5) + 1.0;
+}
+
+static int cmp_u32(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Candidatas y clave de las teselas [begin, end).
+ */
+static void tiles_collect(size_t begin, size_t end, void* ctx) {
+    TileJob* job = ctx;
+    const TileParams* p = job->p;
+    const SpatialIndex* idx = &job->s->index;
+
+    for (size_t t = begin; t < end; t++) {
+        TileResult* r = &job->out[t];
+        TileWork* w = &job->work[t];
+
+        double win[4];
+        tile_window(p, r->id, win);
+        const double padx = tile_pad(p) * (win[2] - win[0]) / p->size;
+        const double pady = tile_pad(p) * (win[3] - win[1]) / p->size;
+        const double query[4] = { win[0] - padx, win[1] - pady, win[2] + padx, win[3] + pady };
+
+        size_t m = spatial_query(idx, query, NULL, 0);
+        w->ids = malloc((m ? m : 1) * sizeof(uint32_t));
+        if (!w->ids) {
+            atomic_store(&job->failed, true);
+            continue;
+        }
+        spatial_query(idx, query, w->ids, m);
+
+        // La caja gruesa del BVH es holgada: solo cuentan las que tocan
+        size_t k = 0;
+        for (size_t i = 0; i < m; i++) {
+            double box[4];
+            if (conic_bounds(idx->coeffs + 6 * (size_t)w->ids[i], query, box)) w->ids[k++] = w->ids[i];
+        }
+        w->n = k;
+        qsort(w->ids, k, sizeof(uint32_t), cmp_u32);
+
+        uint64_t h = mix64(0x636f6e6963746c73ull, (uint64_t)p->format << 32 | (uint64_t)p->size);
+        for (int i = 0; i < 4; i++) h = mix_double(h, p->world[i]);
+        h = mix64(h, (uint64_t)r->id.z << 32 | r->id.x);
+        h = mix64(h, r->id.y);
+        h = mix_double(h, p->style.line_width);
+        h = mix_rgba(h, p->style.background);
+        h = mix_rgba(h, p->style.axes);
+        for (size_t i = 0; i < k; i++) {
+            const double* c = idx->coeffs + 6 * (size_t)w->ids[i];
+            h = mix64(h, w->ids[i]);
+            for (int j = 0; j < 6; j++) h = mix_double(h, c[j]);
+            h = mix_rgba(h, job->s->colors + 4 * (size_t)w->ids[i]);
+        }
+        r->key = h;
+        r->conics = k;
+    }
+}
+
+/**
+ * @brief Ruta de la clave en la caché de disco; crea el subdirectorio
+ *        <hh> si se va a escribir.
+ */
+static void disk_path(const char* dir, uint64_t key, TileFormat fmt, bool create,
+                      char* path, size_t size) {
+    if (create) {
+        snprintf(path, size, "%s/%02x", dir, (unsigned)(key >> 56));
+        mkdir(path, 0755);
+    }
+    snprintf(path, size, "%s/%02x/%016llx.%s", dir, (unsigned)(key >> 56),
+             (unsigned long long)key, TILE_EXT[fmt]);
+}
+
+static bool disk_read(const char* path, ByteBuf* out) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return false;
+
+    bool ok = fseek(fp, 0, SEEK_END) == 0;
+    long len = ok ? ftell(fp) : -1;
+    ok = len > 0 && fseek(fp, 0, SEEK_SET) == 0 && buf_reserve(out, (size_t)len)
+      && fread(out->data + out->len, 1, (size_t)len, fp) == (size_t)len;
+    if (ok) out->len += (size_t)len;
+    fclose(fp);
+    return ok;
+}
+
+/**
+ * @brief Escribe en un temporal y renombra: un lector concurrente ve el
+ *        fichero entero o no lo ve. Un fallo solo cuesta el acierto.
+ */
+static void disk_write(const char* path, const ByteBuf* b, size_t tag) {
+    char tmp[4096 + 64];
+    snprintf(tmp, sizeof(tmp), "%s.%ld.%zu.tmp", path, (long)getpid(), tag);
+
+    FILE* fp = fopen(tmp, "wb");
+    if (!fp) return;
+    size_t w = fwrite(b->data, 1, b->len, fp);
+    if (fclose(fp) != 0 || w != b->len || rename(tmp, path) != 0) remove(tmp);
+}
+
+/**
+ * @brief Dibuja la tesela t con sus candidatas y la codifica en out.
+ */
+static bool tile_draw(const TileJob* job, size_t t, ByteBuf* out) {
+    const TileParams* p = job->p;
+    const TileWork* w = &job->work[t];
+    const double* all = job->s->index.coeffs;
+
+    double win[4];
+    tile_window(p, job->out[t].id, win);
+
+    if (p->format == TILE_FMT_SVG) {
+        ExportParams ep = export_default_params();
+        memcpy(ep.window, win, sizeof(win));
+        ep.width = ep.height = p->size;
+        ep.stroke_width = p->style.line_width;
+
+        ExportWriter* ew = malloc(sizeof(ExportWriter));
+        bool ok = ew && export_begin(ew, EXPORT_SVG, &ep, NULL, out);
+        for (size_t i = 0; ok && i < w->n; i++) {
+            ok = export_conic(ew, all + 6 * (size_t)w->ids[i], job->s->colors + 4 * (size_t)w->ids[i]);
+        }
+        ok = ok && export_end(ew);
+        free(ew);
+        return ok;
+    }
+
+    RasterParams rp = p->style;
+    memcpy(rp.window, win, sizeof(win));
+    rp.width = rp.height = p->size;
+
+    double* coeffs = malloc((w->n ? w->n : 1) * 6 * sizeof(double));
+    uint8_t* colors = malloc((w->n ? w->n : 1) * 4);
+    uint8_t* rgba = malloc((size_t)p->size * (size_t)p->size * 4);
+    bool ok = coeffs && colors && rgba;
+    for (size_t i = 0; ok && i < w->n; i++) {
+        memcpy(coeffs + 6 * i, all + 6 * (size_t)w->ids[i], 6 * sizeof(double));
+        memcpy(colors + 4 * i, job->s->colors + 4 * (size_t)w->ids[i], 4);
+    }
+    ok = ok && raster_render(&rp, coeffs, colors, w->n, rgba)
+            && raster_encode(rgba, p->size, p->size,
+                             p->format == TILE_FMT_QOI ? RASTER_FMT_QOI : RASTER_FMT_PNG, out);
+    free(coeffs);
+    free(colors);
+    free(rgba);
+    return ok;
+}
+
+/**
+ * @brief Disco o dibujo para las teselas pendientes de [begin, end).
+ */
+static void tiles_produce(size_t begin, size_t end, void* ctx) {
+    TileJob* job = ctx;
+
+    for (size_t t = begin; t < end; t++) {
+        TileResult* r = &job->out[t];
+        if (!job->work[t].pending) continue;
+
+        char path[4096];
+        if (job->dir) {
+            disk_path(job->dir, r->key, job->p->format, false, path, sizeof(path));
+            if (disk_read(path, &r->data)) {
+                r->source = TILE_SRC_DISK;
+                continue;
+            }
+        }
+
+        r->source = TILE_SRC_RENDER;
+        if (!tile_draw(job, t, &r->data)) {
+            atomic_store(&job->failed, true);
+            continue;
+        }
+        // Si el plazo venció, el dibujo pudo quedar a medias
+        r->partial = budget_exhausted();
+        if (job->dir && !r->partial) {
+            disk_path(job->dir, r->key, job->p->format, true, path, sizeof(path));
+            disk_write(path, &r->data, t);
+        }
+    }
+}
+
+//--------------------------------//
+// LRU
+//--------------------------------//
+
+static int32_t cache_find(const TileCache* c, uint64_t key) {
+    int32_t i = c->buckets[key & (c->bucket_count - 1)];
+    while (i != TILE_NULL && c->entries[i].key != key) i = c->entries[i].chain;
+    return i;
+}
+
+static void lru_unlink(TileCache* c, int32_t i) {
+    TileEntry* e = &c->entries[i];
+    if (e->prev != TILE_NULL) c->entries[e->prev].next = e->next;
+    else c->head = e->next;
+    if (e->next != TILE_NULL) c->entries[e->next].prev = e->prev;
+    else c->tail = e->prev;
+}
+
+static void lru_push_front(TileCache* c, int32_t i) {
+    TileEntry* e = &c->entries[i];
+    e->prev = TILE_NULL;
+    e->next = c->head;
+    if (c->head != TILE_NULL) c->entries[c->head].prev = i;
+    c->head = i;
+    if (c->tail == TILE_NULL) c->tail = i;
+}
+
+static void bucket_unlink(TileCache* c, int32_t i) {
+    int32_t* link = &c->buckets[c->entries[i].key & (c->bucket_count - 1)];
+    while (*link != i) link = &c->entries[*link].chain;
+    *link = c->entries[i].chain;
+}
+
+static void bucket_link(TileCache* c, int32_t i) {
+    int32_t* head = &c->buckets[c->entries[i].key & (c->bucket_count - 1)];
+    c->entries[i].chain = *head;
+    *head = i;
+}
+
+static void cache_evict(TileCache* c, int32_t i) {
+    lru_unlink(c, i);
+    bucket_unlink(c, i);
+    c->bytes -= c->entries[i].data.len;
+    buf_free(&c->entries[i].data);
+    c->entries[i].chain = c->free_list;
+    c->free_list = i;
+    c->count--;
+    c->evictions++;
+}
+
+/**
+ * @brief Duplica la tabla de cubos y reencadena las entradas vivas.
+ */
+static bool cache_rehash(TileCache* c) {
+    size_t nb = c->bucket_count * 2;
+    int32_t* b = malloc(nb * sizeof(int32_t));
+    if (!b) return false;
+    for (size_t i = 0; i < nb; i++) b[i] = TILE_NULL;
+
+    free(c->buckets);
+    c->buckets = b;
+    c->bucket_count = nb;
+    for (int32_t i = c->head; i != TILE_NULL; i = c->entries[i].next) bucket_link(c, i);
+    return true;
+}
+
+static int32_t cache_alloc(TileCache* c) {
+    if (c->free_list != TILE_NULL) {
+        int32_t i = c->free_list;
+        c->free_list = c->entries[i].chain;
+        return i;
+    }
+    if (c->count == c->entry_cap) {
+        size_t cap = c->entry_cap ? 2 * c->entry_cap : 64;
+        if (cap > INT32_MAX) return TILE_NULL;
+        TileEntry* e = realloc(c->entries, cap * sizeof(TileEntry));
+        if (!e) return TILE_NULL;
+        c->entries = e;
+        c->entry_cap = cap;
+    }
+    return (int32_t)c->count;
+}
+
+/**
+ * @brief Copia b en la LRU bajo key, expulsando por la cola hasta caber.
+ */
+static bool cache_put(TileCache* c, uint64_t key, const ByteBuf* b) {
+    if (b->len > c->capacity || cache_find(c, key) != TILE_NULL) return true;
+    while (c->bytes + b->len > c->capacity && c->tail != TILE_NULL) cache_evict(c, c->tail);
+    if (c->count + 1 > c->bucket_count && !cache_rehash(c)) return false;
+
+    int32_t i = cache_alloc(c);
+    if (i == TILE_NULL) return false;
+    TileEntry* e = &c->entries[i];
+    e->key = key;
+    buf_init(&e->data);
+    if (!buf_append(&e->data, b->data, b->len)) {
+        e->chain = c->free_list;
+        c->free_list = i;
+        return false;
+    }
+    bucket_link(c, i);
+    lru_push_front(c, i);
+    c->count++;
+    c->bytes += b->len;
+    return true;
+}
+
+//-------------------------------------------//
+//               API PÚBLICA                 //
+//-------------------------------------------//
+
+TileParams tile_default_params(void) {
+    TileParams p;
+    p.style = raster_default_params();
+    memcpy(p.world, p.style.window, sizeof(p.world));
+    p.size = TILE_DEFAULT_SIZE;
+    p.format = TILE_FMT_PNG;
+    return p;
+}
+
+void tile_window(const TileParams* p, TileId t, double window[4]) {
+    const double n = ldexp(1.0, (int)t.z);
+    const double w = (p->world[2] - p->world[0]) / n;
+    const double h = (p->world[3] - p->world[1]) / n;
+    window[0] = p->world[0] + t.x * w;
+    window[1] = p->world[3] - (t.y + 1.0) * h;
+    window[2] = p->world[0] + (t.x + 1.0) * w;
+    window[3] = p->world[3] - t.y * h;
+}
+
+/**
+ * @brief Índices de columna y fila por división, recortados a [0, 2^z).
+ */
+bool tile_range(const TileParams* p, uint32_t z, const double box[4], double pad, TileRange* r) {
+    const double n = ldexp(1.0, (int)z);
+    const double w = (p->world[2] - p->world[0]) / n;
+    const double h = (p->world[3] - p->world[1]) / n;
+    const double px = pad * w / p->size, py = pad * h / p->size;
+    const double b[4] = { box[0] - px, box[1] - py, box[2] + px, box[3] + py };
+    if (b[2] < p->world[0] || b[0] > p->world[2] || b[3] < p->world[1] || b[1] > p->world[3]) {
+        return false;
+    }
+
+    const double last = n - 1.0;
+    r->z = z;
+    r->x0 = (uint32_t)fmin(fmax(floor((b[0] - p->world[0]) / w), 0.0), last);
+    r->x1 = (uint32_t)fmin(fmax(floor((b[2] - p->world[0]) / w), 0.0), last);
+    r->y0 = (uint32_t)fmin(fmax(floor((p->world[3] - b[3]) / h), 0.0), last);
+    r->y1 = (uint32_t)fmin(fmax(floor((p->world[3] - b[1]) / h), 0.0), last);
+    return true;
+}
+
+bool tile_scene_init(TileScene* s, const TileParams* p, const double* coeffs,
+                     const uint8_t* colors, size_t n) {
+    memset(s, 0, sizeof(*s));
+    if (!spatial_init(&s->index, p->world)) return false;
+    s->colors = malloc((n ? n : 1) * 4);
+    if (!s->colors || !spatial_build(&s->index, coeffs, n)) {
+        tile_scene_free(s);
+        return false;
+    }
+    memcpy(s->colors, colors, n * 4);
+    s->count = n;
+    return true;
+}
+
+void tile_scene_free(TileScene* s) {
+    spatial_free(&s->index);
+    free(s->colors);
+    s->colors = NULL;
+    s->count = 0;
+}
+
+/**
+ * @brief Rangos sucios de la caja vieja y la nueva; si coinciden en un
+ *        nivel se escribe uno solo.
+ */
+bool tile_scene_edit(TileScene* s, const TileParams* p, uint32_t id, const double c[6],
+                     const uint8_t* color, uint32_t zmin, uint32_t zmax,
+                     TileRange* dirty, size_t* ndirty) {
+    *ndirty = 0;
+    if (id >= s->count) return false;
+
+    double before[4], after[4];
+    bool had = conic_bounds(s->index.coeffs + 6 * (size_t)id, p->world, before);
+    bool has = c && conic_bounds(c, p->world, after);
+    const double pad = tile_pad(p);
+
+    for (uint32_t z = zmin; z <= zmax && z <= TILE_MAX_ZOOM; z++) {
+        TileRange a, b;
+        bool ra = had && tile_range(p, z, before, pad, &a);
+        bool rb = has && tile_range(p, z, after, pad, &b);
+        if (ra) dirty[(*ndirty)++] = a;
+        if (rb && !(ra && memcmp(&a, &b, sizeof(a)) == 0)) dirty[(*ndirty)++] = b;
+    }
+
+    if (!c) {
+        spatial_remove(&s->index, id);
+        return true;
+    }
+    if (color) memcpy(s->colors + 4 * (size_t)id, color, 4);
+    return spatial_update(&s->index, id, c);
+}
+
+bool tile_cache_init(TileCache* c, size_t capacity) {
+    memset(c, 0, sizeof(*c));
+    c->head = c->tail = c->free_list = TILE_NULL;
+    c->capacity = capacity;
+    c->bucket_count = 64;
+    c->buckets = malloc(c->bucket_count * sizeof(int32_t));
+    if (!c->buckets) return false;
+    for (size_t i = 0; i < c->bucket_count; i++) c->buckets[i] = TILE_NULL;
+    pthread_mutex_init(&c->lock, NULL);
+    return true;
+}
+
+void tile_cache_free(TileCache* c) {
+    for (int32_t i = c->head; i != TILE_NULL; i = c->entries[i].next) buf_free(&c->entries[i].data);
+    free(c->entries);
+    free(c->buckets);
+    pthread_mutex_destroy(&c->lock);
+    memset(c, 0, sizeof(*c));
+    c->head = c->tail = c->free_list = TILE_NULL;
+}
+
+bool tiles_render(const TileScene* s, const TileParams* p, TileCache* cache,
+                  const char* dir, TileResult* out, size_t n) {
+    if (n == 0) return true;
+    TileWork* work = calloc(n, sizeof(TileWork));
+    if (!work) return false;
+
+    TileJob job;
+    job.s = s;
+    job.p = p;
+    job.dir = dir;
+    job.out = out;
+    job.work = work;
+    atomic_init(&job.failed, false);
+    for (size_t t = 0; t < n; t++) {
+        buf_init(&out[t].data);
+        out[t].conics = 0;
+        out[t].partial = false;
+    }
+
+    tp_parallel_for(0, n, 1, tiles_collect, &job);
+
+    bool ok = !atomic_load(&job.failed);
+    if (cache) pthread_mutex_lock(&cache->lock);
+    for (size_t t = 0; ok && t < n; t++) {
+        int32_t i = cache ? cache_find(cache, out[t].key) : TILE_NULL;
+        if (i != TILE_NULL) {
+            lru_unlink(cache, i);
+            lru_push_front(cache, i);
+            ok = buf_append(&out[t].data, cache->entries[i].data.data, cache->entries[i].data.len);
+            out[t].source = TILE_SRC_MEMORY;
+            cache->hits++;
+        } else {
+            work[t].pending = true;
+        }
+    }
+    if (cache) pthread_mutex_unlock(&cache->lock);
+
+    if (ok) {
+        tp_parallel_for(0, n, 1, tiles_produce, &job);
+        ok = !atomic_load(&job.failed);
+    }
+
+    if (cache) pthread_mutex_lock(&cache->lock);
+    for (size_t t = 0; ok && cache && t < n; t++) {
+        if (!work[t].pending) continue;
+        if (out[t].source == TILE_SRC_DISK) cache->disk_hits++;
+        else cache->misses++;
+        if (!out[t].partial) ok = cache_put(cache, out[t].key, &out[t].data);
+    }
+    if (cache) pthread_mutex_unlock(&cache->lock);
+
+    for (size_t t = 0; t < n; t++) free(work[t].ids);
+    free(work);
+    return ok;
+}
@@ -0,0 +1,150 @@
+//================================================================//
+//        TILES HEADER - Pirámide de teselas z/x/y con caché      //
+//================================================================//
+//
+// Divide el mundo de la escena en una pirámide de teselas al estilo de
+// los mapas web: el nivel z parte la ventana en 2^z x 2^z teselas de
+// size x size píxeles, con la fila y = 0 arriba (y_max). Cada tesela se
+// dibuja bajo demanda con raster.c (PNG/QOI) o export.c (SVG) usando solo
+// las cónicas que el índice espacial (spatial.h) sitúa cerca de ella.
+//
+// Caché direccionada por contenido: la clave de una tesela mezcla su
+// posición, el estilo y los coeficientes y colores de las cónicas que la
+// tocan. Editar una cónica cambia la clave solo de las teselas por las
+// que pasa (antes o después), así que el resto sigue acertando sin
+// invalidar nada a mano, y la caché sobrevive a recargar la escena.
+//
+// Dos niveles:
+// - Memoria: LRU acotada en bytes (tabla hash + lista doble), con su
+//   propio cerrojo: la comparten las peticiones del modo --serve.
+// - Disco (opcional): <dir>/<hh>/<clave>.<ext>, escrito con rename
+//   atómico; lo comparten procesos distintos.
+//
+
+#ifndef TILES_H
+#define TILES_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "raster.h"
+#include "spatial.h"
+#include "utils.h"
+
+#define TILE_DEFAULT_SIZE 256
+#define TILE_MAX_SIZE     4096
+#define TILE_MAX_ZOOM     30
+
+typedef enum {
+    TILE_FMT_PNG,
+    TILE_FMT_QOI,
+    TILE_FMT_SVG
+} TileFormat;
+
+typedef enum {
+    TILE_SRC_MEMORY,            // acierto en la LRU
+    TILE_SRC_DISK,              // acierto en la caché de disco
+    TILE_SRC_RENDER             // dibujada ahora
+} TileSource;
+
+typedef struct {
+    uint32_t z, x, y;
+} TileId;
+
+typedef struct {
+    uint32_t z;
+    uint32_t x0, y0, x1, y1;    // inclusivos
+} TileRange;
+
+typedef struct {
+    double       world[4];      // [x_min, y_min, x_max, y_max] del nivel 0
+    int          size;          // píxeles por lado
+    RasterParams style;         // line_width, background y axes (el resto se ignora)
+    TileFormat   format;
+} TileParams;
+
+typedef struct {
+    SpatialIndex index;         // guarda los coeficientes por id
+    uint8_t*     colors;        // RGBA por id
+    size_t       count;         // ids 0..count-1
+} TileScene;
+
+typedef struct {
+    uint64_t key;
+    ByteBuf  data;
+    int32_t  prev, next;        // LRU: head = más reciente
+    int32_t  chain;             // siguiente en el mismo cubo; libres encadenadas aquí
+} TileEntry;
+
+typedef struct {
+    pthread_mutex_t lock;
+    TileEntry* entries;
+    size_t     entry_cap;
+    int32_t*   buckets;
+    size_t     bucket_count;    // potencia de dos
+    int32_t    head, tail, free_list;
+    size_t     count;
+    size_t     bytes, capacity; // bytes de datos en memoria / tope
+    uint64_t   hits, disk_hits, misses, evictions;
+} TileCache;
+
+typedef struct {
+    TileId     id;              // entrada
+    uint64_t   key;             // salida
+    TileSource source;
+    size_t     conics;          // cónicas candidatas de la tesela
+    bool       partial;         // dibujada sin presupuesto (budget.h): no se guarda
+    ByteBuf    data;            // tesela codificada (la libera el llamante)
+} TileResult;
+
+/**
+ * Teselas de 256 px sobre [-10, 10]² con el estilo por defecto de raster.h.
+ */
+TileParams tile_default_params(void);
+
+/**
+ * Ventana del plano que cubre la tesela t.
+ */
+void tile_window(const TileParams* p, TileId t, double window[4]);
+
+/**
+ * Rango de teselas del nivel z que corta box, ampliada pad píxeles del
+ * nivel. Devuelve false si box cae fuera del mundo.
+ */
+bool tile_range(const TileParams* p, uint32_t z, const double box[4], double pad, TileRange* r);
+
+/**
+ * Indexa n cónicas (ids 0..n-1) con sus colores RGBA.
+ */
+bool tile_scene_init(TileScene* s, const TileParams* p, const double* coeffs,
+                     const uint8_t* colors, size_t n);
+void tile_scene_free(TileScene* s);
+
+/**
+ * Cambia los coeficientes (y el color, si no es NULL) de la cónica id, o
+ * la quita de la escena si c es NULL, y escribe en dirty las teselas de
+ * los niveles zmin..zmax que tocaba antes o toca ahora: hasta 2 rangos por
+ * nivel, *ndirty dice cuántos. Esas son las únicas cuya clave cambia.
+ */
+bool tile_scene_edit(TileScene* s, const TileParams* p, uint32_t id, const double c[6],
+                     const uint8_t* color, uint32_t zmin, uint32_t zmax,
+                     TileRange* dirty, size_t* ndirty);
+
+/**
+ * LRU de capacity bytes.
+ */
+bool tile_cache_init(TileCache* c, size_t capacity);
+void tile_cache_free(TileCache* c);
+
+/**
+ * Resuelve las teselas out[0..n) (id rellenado por el llamante): busca
+ * en memoria, luego en la caché de disco dir (si no es NULL; el
+ * directorio debe existir), y dibuja en paralelo las que falten. cache
+ * puede ser NULL. Devuelve false si falta memoria.
+ */
+bool tiles_render(const TileScene* s, const TileParams* p, TileCache* cache,
+                  const char* dir, TileResult* out, size_t n);
+
+#endif
@@ -0,0 +1,100 @@
+//================================================================//
+// UTILS - Utilidades comunes del núcleo
+//================================================================//
+//--------------------------------//
+// Includes y dependencias
+//--------------------------------//
+#define _POSIX_C_SOURCE 200809L
+
+#include "utils.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @brief Devuelve el reloj monotónico en milisegundos.
+ * @details A diferencia de clock(), mide tiempo real: con varios hilos
+ *          clock() suma el tiempo de CPU de todos ellos.
+ */
+double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1.0e6;
+}
+
+//-------------------------------------------//
+//              BUFFER DE BYTES              //
+//-------------------------------------------//
+
+void buf_init(ByteBuf* b) {
+    b->data = NULL;
+    b->len = 0;
+    b->cap = 0;
+}
+
+void buf_free(ByteBuf* b) {
+    free(b->data);
+    buf_init(b);
+}
+
+/**
+ * @brief Reserva espacio para extra bytes más, duplicando la capacidad.
+ */
+bool buf_reserve(ByteBuf* b, size_t extra) {
+    if (b->len + extra <= b->cap) return true;
+
+    size_t cap = b->cap ? b->cap : 256;
+    while (cap < b->len + extra) cap *= 2;
+
+    uint8_t* data = realloc(b->data, cap);
+    if (!data) return false;
+    b->data = data;
+    b->cap = cap;
+    return true;
+}
+
+bool buf_append(ByteBuf* b, const void* src, size_t n) {
+    if (!buf_reserve(b, n)) return false;
+    memcpy(b->data + b->len, src, n);
+    b->len += n;
+    return true;
+}
+
+//-------------------------------------------//
+//                  BASE64                   //
+//-------------------------------------------//
+
+/**
+ * @brief Codifica data en base64 para incrustar binarios en el JSON.
+ * @return String reservado con malloc (liberar con free) o NULL.
+ */
+char* base64_encode(const uint8_t* data, size_t len) {
+    static const char tbl[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    size_t out_len = 4 * ((len + 2) / 3);
+    char* out = malloc(out_len + 1);
+    if (!out) return NULL;
+
+    size_t i = 0, o = 0;
+    for (; i + 2 < len; i += 3) {
+        uint32_t v = (uint32_t)data[i] << 16 | (uint32_t)data[i + 1] << 8 | data[i + 2];
+        out[o++] = tbl[(v >> 18) & 63];
+        out[o++] = tbl[(v >> 12) & 63];
+        out[o++] = tbl[(v >> 6) & 63];
+        out[o++] = tbl[v & 63];
+    }
+
+    if (i < len) {
+        uint32_t v = (uint32_t)data[i] << 16;
+        if (i + 1 < len) v |= (uint32_t)data[i + 1] << 8;
+        out[o++] = tbl[(v >> 18) & 63];
+        out[o++] = tbl[(v >> 12) & 63];
+        out[o++] = i + 1 < len ? tbl[(v >> 6) & 63] : '=';
+        out[o++] = '=';
+    }
+
+    out[o] = '\0';
+    return out;
+}
@@ -0,0 +1,48 @@
+//================================================================//
+//                 UTILS HEADER - ConiCrypt Lab                   //
+//================================================================//
+//
+// Utilidades comunes del núcleo (tiempo, buffers de bytes, base64).
+//
+
+#ifndef UTILS_H
+#define UTILS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Buffer de bytes creciente para salidas binarias (imágenes, paquetes).
+ */
+typedef struct {
+    uint8_t* data;
+    size_t   len;
+    size_t   cap;
+} ByteBuf;
+
+/**
+ * Reloj monotónico en milisegundos (tiempo real, no de CPU).
+ */
+double now_ms(void);
+
+void buf_init(ByteBuf* b);
+void buf_free(ByteBuf* b);
+
+/**
+ * Garantiza espacio para extra bytes más. false si no hay memoria.
+ */
+bool buf_reserve(ByteBuf* b, size_t extra);
+
+/**
+ * Añade n bytes al final. false si no hay memoria.
+ */
+bool buf_append(ByteBuf* b, const void* src, size_t n);
+
+/**
+ * Codifica en base64 (RFC 4648). Devuelve un string NUL-terminado
+ * reservado con malloc, o NULL si no hay memoria.
+ */
+char* base64_encode(const uint8_t* data, size_t len);
+
+#endif
@@ -0,0 +1,226 @@
+//================================================================//
+// VERTICES - Empaquetado Float32 e ingletes para trazos gruesos
+//================================================================//
+//
+// Dos pasadas: la primera fija los rangos de cada polilínea (prefijos) y
+// la segunda rellena vértices, tiras e índices de cada cónica en
+// paralelo, cada una en su propia zona del buffer.
+//
+//--------------------------------//
+// Includes y dependencias
+//--------------------------------//
+#include "vertices.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "threadpool.h"
+
+/**
+ * @file vertices.c
+ * @brief Buffers de vértices descritos en vertices.h.
+ */
+
+//-------------------------------------------//
+//           FUNCIONES AUXILIARES            //
+//-------------------------------------------//
+
+/**
+ * @brief Dirección unitaria de a hacia b; false si coinciden.
+ */
+static bool unit_dir(const double* a, const double* b, double d[2]) {
+    double dx = b[0] - a[0], dy = b[1] - a[1];
+    double len = hypot(dx, dy);
+    if (len == 0.0) return false;
+    d[0] = dx / len;
+    d[1] = dy / len;
+    return true;
+}
+
+/**
+ * @brief Desplazamiento del vértice k hacia la izquierda del trazo.
+ * @details Con normales n0 (tramo entrante) y n1 (saliente), el inglete
+ *          sigue la bisectriz m = (n0 + n1)/|n0 + n1| con longitud
+ *          hw / (m·n1), recortada a VERTEX_MITER_LIMIT·hw en giros
+ *          cerrados. En los extremos de una polilínea abierta se usa la
+ *          normal del único tramo (remate plano); en una cerrada el
+ *          primer y último vértice (repetidos) usan a los vecinos de la
+ *          vuelta.
+ */
+static void miter(const double* xy, uint32_t n, bool closed, uint32_t k, double hw, double off[2]) {
+    double din[2], dout[2];
+    bool has_in = false, has_out = false;
+
+    if (k > 0) has_in = unit_dir(xy + 2*(k - 1), xy + 2*k, din);
+    else if (closed && n > 2) has_in = unit_dir(xy + 2*(n - 2), xy, din);
+    if (k + 1 < n) has_out = unit_dir(xy + 2*k, xy + 2*(k + 1), dout);
+    else if (closed && n > 2) has_out = unit_dir(xy + 2*k, xy + 2, dout);
+
+    if (!has_in && !has_out) {
+        off[0] = off[1] = 0.0;
+        return;
+    }
+    if (!has_in) memcpy(din, dout, sizeof(din));
+    if (!has_out) memcpy(dout, din, sizeof(dout));
+
+    double n0x = -din[1], n0y = din[0];
+    double n1x = -dout[1], n1y = dout[0];
+    double mx = n0x + n1x, my = n0y + n1y;
+    double ml = hypot(mx, my);
+    if (ml < 1e-12) {
+        off[0] = n1x * hw;
+        off[1] = n1y * hw;
+        return;
+    }
+    mx /= ml;
+    my /= ml;
+    double scale = fmin(1.0 / fmax(mx*n1x + my*n1y, 1e-12), VERTEX_MITER_LIMIT);
+    off[0] = mx * hw * scale;
+    off[1] = my * hw * scale;
+}
+
+typedef struct {
+    const Polylines* sets;
+    const uint32_t*  first;     // primer rango de cada cónica
+    VertexRange*     ranges;
+    float*           lines;
+    float*           strips;    // NULL sin tiras
+    uint32_t*        index;
+    double           hw;
+} PackJob;
+
+static void pack_range(size_t begin, size_t end, void* ctx) {
+    PackJob* job = ctx;
+    for (size_t i = begin; i < end; i++) {
+        const Polylines* pl = &job->sets[i];
+        for (size_t k = 0; k < pl->count; k++) {
+            const VertexRange* r = &job->ranges[job->first[i] + k];
+            const double* xy = pl->xy + 2 * (size_t)pl->offsets[k];
+            uint32_t n = r->count;
+
+            float* dst = job->lines + 3 * (size_t)r->offset;
+            for (uint32_t v = 0; v < n; v++) {
+                dst[3*v]     = (float)xy[2*v];
+                dst[3*v + 1] = (float)xy[2*v + 1];
+                dst[3*v + 2] = 0.0f;
+            }
+            if (!job->strips) continue;
+
+            bool closed = r->flags & VERTEX_FLAG_CLOSED;
+            float* sv = job->strips + 3 * (size_t)r->strip_offset;
+            for (uint32_t v = 0; v < n; v++) {
+                double off[2];
+                miter(xy, n, closed, v, job->hw, off);
+                sv[6*v]     = (float)(xy[2*v] + off[0]);
+                sv[6*v + 1] = (float)(xy[2*v + 1] + off[1]);
+                sv[6*v + 2] = 0.0f;
+                sv[6*v + 3] = (float)(xy[2*v] - off[0]);
+                sv[6*v + 4] = (float)(xy[2*v + 1] - off[1]);
+                sv[6*v + 5] = 0.0f;
+            }
+
+            uint32_t* idx = job->index + r->index_offset;
+            for (uint32_t s = 0; s + 1 < n; s++) {
+                uint32_t a = r->strip_offset + 2*s;
+                idx[6*s]     = a;
+                idx[6*s + 1] = a + 1;
+                idx[6*s + 2] = a + 2;
+                idx[6*s + 3] = a + 1;
+                idx[6*s + 4] = a + 3;
+                idx[6*s + 5] = a + 2;
+            }
+        }
+    }
+}
+
+//-------------------------------------------//
+//               API PÚBLICA                 //
+//-------------------------------------------//
+
+/**
+ * @brief Empaqueta las polilíneas de un lote en el formato de vertices.h.
+ */
+bool vertices_pack(const Polylines* sets, size_t n, double half_width, ByteBuf* out) {
+    bool strips = half_width > 0.0;
+
+    uint32_t* first = malloc((n + 1) * sizeof(uint32_t));
+    if (!first) return false;
+
+    uint64_t polylines = 0, vertices = 0, segments = 0;
+    for (size_t i = 0; i < n; i++) {
+        first[i] = (uint32_t)polylines;
+        polylines += sets[i].count;
+        for (size_t k = 0; k < sets[i].count; k++) {
+            uint32_t c = sets[i].offsets[k + 1] - sets[i].offsets[k];
+            vertices += c;
+            segments += c > 1 ? c - 1 : 0;
+        }
+    }
+    first[n] = (uint32_t)polylines;
+
+    uint64_t strip_vertices = strips ? 2 * vertices : 0;
+    uint64_t indices = strips ? 6 * segments : 0;
+    if (polylines > UINT32_MAX || vertices > UINT32_MAX
+        || strip_vertices > UINT32_MAX || indices > UINT32_MAX) {
+        free(first);
+        return false;
+    }
+
+    size_t bytes = sizeof(VertexHeader)
+                 + (size_t)polylines * sizeof(VertexRange)
+                 + (size_t)(vertices + strip_vertices) * 3 * sizeof(float)
+                 + (size_t)indices * sizeof(uint32_t);
+    if (!buf_reserve(out, bytes)) {
+        free(first);
+        return false;
+    }
+
+    VertexHeader h;
+    memcpy(h.magic, VERTEX_MAGIC, 4);
+    h.version = VERTEX_VERSION;
+    h.flags = strips ? VERTEX_FLAG_STRIPS : 0u;
+    h.polylines = (uint32_t)polylines;
+    h.vertices = (uint32_t)vertices;
+    h.strip_vertices = (uint32_t)strip_vertices;
+    h.indices = (uint32_t)indices;
+    h.reserved = 0;
+    buf_append(out, &h, sizeof(h));
+
+    VertexRange* ranges = (VertexRange*)(out->data + out->len);
+    uint32_t offset = 0, index_offset = 0;
+    for (size_t i = 0; i < n; i++) {
+        for (size_t k = 0; k < sets[i].count; k++) {
+            VertexRange* r = &ranges[first[i] + k];
+            uint32_t c = sets[i].offsets[k + 1] - sets[i].offsets[k];
+            uint32_t segs = c > 1 ? c - 1 : 0;
+            r->conic = (uint32_t)i;
+            r->offset = offset;
+            r->count = c;
+            r->strip_offset = strips ? 2 * offset : 0;
+            r->strip_count = strips ? 2 * c : 0;
+            r->index_offset = index_offset;
+            r->index_count = strips ? 6 * segs : 0;
+            r->branch = sets[i].branch[k];
+            r->flags = sets[i].closed[k] ? VERTEX_FLAG_CLOSED : 0u;
+            offset += c;
+            index_offset += r->index_count;
+        }
+    }
+    out->len += (size_t)polylines * sizeof(VertexRange);
+
+    PackJob job;
+    job.sets = sets;
+    job.first = first;
+    job.ranges = ranges;
+    job.lines = (float*)(out->data + out->len);
+    job.strips = strips ? job.lines + 3 * vertices : NULL;
+    job.index = (uint32_t*)(job.lines + 3 * (vertices + strip_vertices));
+    job.hw = half_width;
+    tp_parallel_for(0, n, 16, pack_range, &job);
+
+    out->len += (size_t)(vertices + strip_vertices) * 3 * sizeof(float)
+              + (size_t)indices * sizeof(uint32_t);
+    free(first);
+    return true;
+}
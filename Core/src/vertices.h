@@ -0,0 +1,71 @@
+//================================================================//
+//     VERTICES HEADER - Buffers de vértices listos para la GPU    //
+//================================================================//
+//
+// Empaqueta polilíneas (polyline.h) en un único buffer binario que el
+// renderizador sube tal cual: Float32 xyz intercalado (z = 0) para
+// líneas y, opcionalmente, tiras de triángulos para trazos gruesos con
+// uniones en inglete, ya indexadas como lista de triángulos.
+//
+// Disposición del buffer (little-endian, sin relleno, todo alineado a 4):
+//
+//   VertexHeader                      32 bytes
+//   VertexRange[polylines]            32 bytes cada uno
+//   float32 xyz[vertices][3]          vértices de las líneas
+//   float32 xyz[strip_vertices][3]    2 por vértice de línea (izq., der.)
+//   uint32  index[indices]            6 por tramo, sobre strip_vertices
+//
+// La polilínea k ocupa [offset, offset + count) de las líneas, sus tiras
+// [strip_offset, strip_offset + strip_count) y sus índices
+// [index_offset, index_offset + index_count). Los índices son absolutos
+// dentro de las tiras, así que todas caben en una sola geometría.
+//
+
+#ifndef VERTICES_H
+#define VERTICES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "polyline.h"
+#include "utils.h"
+
+#define VERTEX_MAGIC    "CVTX"
+#define VERTEX_VERSION  1
+
+#define VERTEX_FLAG_STRIPS  0x1u    // cabecera: hay tiras e índices
+#define VERTEX_FLAG_CLOSED  0x1u    // rango: polilínea cerrada
+
+// Longitud máxima del inglete en semianchos; por encima se recorta
+#define VERTEX_MITER_LIMIT  4.0
+
+typedef struct {
+    char     magic[4];          // "CVTX"
+    uint32_t version;
+    uint32_t flags;             // VERTEX_FLAG_STRIPS
+    uint32_t polylines;
+    uint32_t vertices;
+    uint32_t strip_vertices;
+    uint32_t indices;
+    uint32_t reserved;
+} VertexHeader;
+
+typedef struct {
+    uint32_t conic;             // índice de la cónica en el lote
+    uint32_t offset, count;
+    uint32_t strip_offset, strip_count;
+    uint32_t index_offset, index_count;
+    uint16_t branch;
+    uint16_t flags;             // VERTEX_FLAG_CLOSED
+} VertexRange;
+
+/**
+ * Empaqueta las polilíneas de n cónicas (sets[i] es la cónica i) al final
+ * de out. Con half_width > 0 añade las tiras de ese semiancho (unidades
+ * del plano). Devuelve false si no hay memoria o el buffer excede 2³²
+ * vértices.
+ */
+bool vertices_pack(const Polylines* sets, size_t n, double half_width, ByteBuf* out);
+
+#endif
@@ -0,0 +1,469 @@
+//================================================================//
+// VISION - Sobel/Canny, cadenas de bordes y ajuste de elipses
+//================================================================//
+//
+// Los kernels de gris, Sobel y no máximos recorren filas contiguas con
+// aritmética entera y sin saltos en el bucle interior, para que GCC los
+// vectorice con -O3. La histéresis es secuencial pero solo visita
+// píxeles de borde. El ajuste de cada grupo es independiente y se
+// reparte entre hilos.
+//
+//--------------------------------//
+// Includes y dependencias
+//--------------------------------//
+#define _POSIX_C_SOURCE 200809L
+
+#include "vision.h"
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "conics.h"
+#include "fit.h"
+#include "ransac.h"
+#include "threadpool.h"
+
+/**
+ * @file vision.c
+ * @brief Tubería de detección descrita en vision.h.
+ */
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define VISION_ROW_GRAIN 16
+
+// Etiquetas del mapa de bordes
+enum { EDGE_NONE = 0, EDGE_WEAK = 1, EDGE_STRONG = 2, EDGE_SEEN = 3 };
+
+//-------------------------------------------//
+//           FUNCIONES AUXILIARES            //
+//-------------------------------------------//
+
+/**
+ * @brief Gris de una fila RGBA/RGB con canal constante (vectorizable).
+ */
+static void gray_row4(const uint8_t* restrict src, uint8_t* restrict dst, uint32_t w) {
+    for (size_t x = 0; x < w; x++) {
+        uint32_t r = src[4*x], g = src[4*x + 1], b = src[4*x + 2];
+        dst[x] = (uint8_t)((77*r + 150*g + 29*b + 128) >> 8);
+    }
+}
+
+static void gray_row3(const uint8_t* restrict src, uint8_t* restrict dst, uint32_t w) {
+    for (size_t x = 0; x < w; x++) {
+        uint32_t r = src[3*x], g = src[3*x + 1], b = src[3*x + 2];
+        dst[x] = (uint8_t)((77*r + 150*g + 29*b + 128) >> 8);
+    }
+}
+
+typedef struct {
+    const VisionFrame* f;
+    uint8_t* gray;
+} GrayJob;
+
+static void gray_range(size_t begin, size_t end, void* ctx) {
+    GrayJob* job = ctx;
+    const VisionFrame* f = job->f;
+    uint32_t w = f->width, ch = f->channels;
+    size_t stride = f->stride ? f->stride : (size_t)w * ch;
+
+    for (size_t y = begin; y < end; y++) {
+        const uint8_t* src = f->data + y * stride;
+        uint8_t* dst = job->gray + y * w;
+        if (ch == 4) gray_row4(src, dst, w);
+        else if (ch == 3) gray_row3(src, dst, w);
+        else memcpy(dst, src, w);
+    }
+}
+
+/**
+ * @brief Sobel 3x3 de una fila interior: gradientes int16 y magnitud L1.
+ */
+static void sobel_row(const uint8_t* restrict r0, const uint8_t* restrict r1,
+                      const uint8_t* restrict r2, int16_t* restrict gx,
+                      int16_t* restrict gy, uint16_t* restrict mag, uint32_t w) {
+    for (uint32_t x = 1; x + 1 < w; x++) {
+        int a = r0[x - 1], b = r0[x], c = r0[x + 1];
+        int d = r1[x - 1],             f = r1[x + 1];
+        int g = r2[x - 1], h = r2[x], i = r2[x + 1];
+        int sx = (c + 2*f + i) - (a + 2*d + g);
+        int sy = (g + 2*h + i) - (a + 2*b + c);
+        gx[x] = (int16_t)sx;
+        gy[x] = (int16_t)sy;
+        mag[x] = (uint16_t)((sx < 0 ? -sx : sx) + (sy < 0 ? -sy : sy));
+    }
+    gx[0] = gy[0] = gx[w - 1] = gy[w - 1] = 0;
+    mag[0] = mag[w - 1] = 0;
+}
+
+/**
+ * @brief No máximos y doble umbral de una fila interior.
+ * @details Se evalúan los cuatro sectores con desplazamientos fijos y se
+ *          elige el del gradiente (tan 22.5° ≈ 106/256) con selecciones,
+ *          así el bucle no tiene accesos indirectos ni saltos.
+ */
+static void nms_row(const uint16_t* restrict up, const uint16_t* restrict mid,
+                    const uint16_t* restrict down, const int16_t* restrict gx,
+                    const int16_t* restrict gy, uint8_t* restrict out, uint32_t w,
+                    int low, int high) {
+    for (uint32_t x = 1; x + 1 < w; x++) {
+        int m = mid[x];
+        int ax = gx[x] < 0 ? -gx[x] : gx[x];
+        int ay = gy[x] < 0 ? -gy[x] : gy[x];
+        int horiz = ay * 256 <= ax * 106;
+        int vert = ax * 256 <= ay * 106;
+        int same = (gx[x] ^ gy[x]) >= 0;
+
+        int ph = (m >= mid[x - 1]) & (m > mid[x + 1]);
+        int pv = (m >= up[x]) & (m > down[x]);
+        int pd = (m >= up[x - 1]) & (m > down[x + 1]);
+        int pa = (m >= up[x + 1]) & (m > down[x - 1]);
+        int peak = horiz ? ph : vert ? pv : same ? pd : pa;
+
+        int cls = m >= high ? EDGE_STRONG : EDGE_WEAK;
+        out[x] = (uint8_t)((peak & (m >= low)) ? cls : EDGE_NONE);
+    }
+    out[0] = out[w - 1] = EDGE_NONE;
+}
+
+typedef struct {
+    const uint8_t* gray;
+    VisionContext* ctx;
+    uint16_t low, high;
+} FilterJob;
+
+static void sobel_range(size_t begin, size_t end, void* ctx) {
+    FilterJob* job = ctx;
+    VisionContext* vc = job->ctx;
+    uint32_t w = vc->width;
+    for (size_t y = begin; y < end; y++) {
+        sobel_row(job->gray + (y - 1) * w, job->gray + y * w, job->gray + (y + 1) * w,
+                  vc->gx + y * w, vc->gy + y * w, vc->mag + y * w, w);
+    }
+}
+
+static void nms_range(size_t begin, size_t end, void* ctx) {
+    FilterJob* job = ctx;
+    VisionContext* vc = job->ctx;
+    uint32_t w = vc->width;
+    for (size_t y = begin; y < end; y++) {
+        nms_row(vc->mag + (y - 1) * w, vc->mag + y * w, vc->mag + (y + 1) * w,
+                vc->gx + y * w, vc->gy + y * w, vc->edges + y * w, w, job->low, job->high);
+    }
+}
+
+/**
+ * @brief Histéresis y agrupación: cada componente 8-conexa de bordes con
+ *        algún píxel fuerte y al menos min_chain píxeles es un grupo.
+ */
+static bool group_edges(VisionContext* ctx, uint32_t min_chain) {
+    uint32_t w = ctx->width, h = ctx->height;
+    uint8_t* e = ctx->edges;
+    const int nb[8] = { -1, 1, -(int)w, (int)w, -(int)w - 1, -(int)w + 1, (int)w - 1, (int)w + 1 };
+
+    size_t np = 0, ng = 0;
+    ctx->groups[0] = 0;
+    ctx->edge_pixels = 0;
+
+    for (uint32_t y = 1; y + 1 < h; y++) {
+        for (uint32_t x = 1; x + 1 < w; x++) {
+            uint32_t s = y * w + x;
+            if (e[s] != EDGE_STRONG) continue;
+
+            size_t start = np, top = 0;
+            e[s] = EDGE_SEEN;
+            ctx->stack[top++] = s;
+            while (top) {
+                uint32_t p = ctx->stack[--top];
+                ctx->pixels[np++] = p;
+                for (int k = 0; k < 8; k++) {
+                    uint32_t q = (uint32_t)((int)p + nb[k]);
+                    if (e[q] == EDGE_WEAK || e[q] == EDGE_STRONG) {
+                        e[q] = EDGE_SEEN;
+                        ctx->stack[top++] = q;
+                    }
+                }
+            }
+            ctx->edge_pixels += (uint32_t)(np - start);
+
+            if (np - start < min_chain) {
+                np = start;
+                continue;
+            }
+            if (ng + 2 > ctx->group_cap) {
+                size_t cap = ctx->group_cap * 2;
+                uint32_t* g = realloc(ctx->groups, cap * sizeof(uint32_t));
+                if (!g) return false;
+                ctx->groups = g;
+                ctx->group_cap = cap;
+            }
+            ctx->groups[++ng] = (uint32_t)np;
+        }
+    }
+    ctx->group_count = (uint32_t)ng;
+    return true;
+}
+
+/**
+ * @brief Elipse geométrica de c y filtros de forma, residuo y cobertura
+ *        sobre los píxeles (xs, ys).
+ */
+static bool accept_ellipse(const double c[6], const double* xs, const double* ys, size_t n,
+                           const VisionParams* p, uint32_t w, uint32_t h, VisionDetection* d) {
+    ConicFrame f;
+    conic_frame(c, &f);
+    if (!f.has_center || f.l1 * f.l2 <= 0 || -f.f0 / f.l1 <= 0) return false;
+
+    double a = sqrt(-f.f0 / f.l1), b = sqrt(-f.f0 / f.l2);
+    double theta = atan2(f.sin_t, f.cos_t);
+    if (a < b) {
+        double t = a; a = b; b = t;
+        theta += M_PI / 2;
+    }
+    if (theta > M_PI / 2) theta -= M_PI;
+    if (theta <= -M_PI / 2) theta += M_PI;
+
+    double size = w > h ? w : h;
+    if (b < p->min_axis || a > 2.0 * size) return false;
+    if (f.cx < 0 || f.cy < 0 || f.cx > w || f.cy > h) return false;
+
+    double sum = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        double x = xs[i], y = ys[i];
+        double q = c[0]*x*x + c[1]*x*y + c[2]*y*y + c[3]*x + c[4]*y + c[5];
+        double gx = 2.0*c[0]*x + c[1]*y + c[3];
+        double gy = c[1]*x + 2.0*c[2]*y + c[4];
+        double g = sqrt(gx*gx + gy*gy);
+        sum += g > 0 ? fabs(q) / g : p->max_residual;
+    }
+    double residual = sum / (double)n;
+
+    // Perímetro de Ramanujan
+    double perim = M_PI * (3.0*(a + b) - sqrt((3.0*a + b) * (a + 3.0*b)));
+    double coverage = (double)n / perim;
+    if (residual > p->max_residual || coverage < p->min_coverage) return false;
+
+    memcpy(d->coeffs, c, sizeof(d->coeffs));
+    d->cx = f.cx;
+    d->cy = f.cy;
+    d->a = a;
+    d->b = b;
+    d->theta = theta;
+    d->pixels = (uint32_t)n;
+    d->residual = residual;
+    d->coverage = coverage;
+    return true;
+}
+
+typedef struct {
+    const VisionContext* ctx;
+    const VisionParams* p;
+    VisionDetection* dets;
+    bool* ok;
+} FitJob;
+
+static void fit_range(size_t begin, size_t end, void* ctx) {
+    FitJob* job = ctx;
+    const VisionContext* vc = job->ctx;
+    uint32_t w = vc->width;
+
+    for (size_t g = begin; g < end; g++) {
+        job->ok[g] = false;
+        size_t lo = vc->groups[g], n = vc->groups[g + 1] - lo;
+        double* xs = malloc(n * 2 * sizeof(double));
+        if (!xs) continue;
+        double* ys = xs + n;
+        for (size_t i = 0; i < n; i++) {
+            uint32_t px = vc->pixels[lo + i];
+            xs[i] = (double)(px % w);
+            ys[i] = (double)(px / w);
+        }
+
+        double c[6];
+        if (fit_points(xs, ys, n, FIT_ELLIPSE, c, NULL) == FIT_OK &&
+            accept_ellipse(c, xs, ys, n, job->p, w, vc->height, &job->dets[g])) {
+            job->ok[g] = true;
+        } else if (job->p->robust && n >= 2 * (size_t)job->p->min_chain) {
+            // El grupo mezcla la elipse con otros bordes: RANSAC aísla la
+            // elipse y el filtro se aplica solo a sus inliers
+            RansacParams rp;
+            ransac_default_params(&rp);
+            rp.max_conics = 1;
+            rp.threshold = job->p->max_residual * 1.5;
+            rp.min_inliers = job->p->min_chain;
+            rp.max_iterations = 512;
+            rp.subset = 512;
+            rp.seed = g + 1;
+
+            RansacConic rc;
+            size_t found = 0;
+            if (ransac_detect(xs, ys, n, &rp, &rc, &found, NULL) == RANSAC_OK && found) {
+                double t = rp.threshold;
+                size_t m = 0;
+                for (size_t i = 0; i < n; i++) {
+                    double x = xs[i], y = ys[i];
+                    const double* k = rc.coeffs;
+                    double q = k[0]*x*x + k[1]*x*y + k[2]*y*y + k[3]*x + k[4]*y + k[5];
+                    double gx = 2.0*k[0]*x + k[1]*y + k[3];
+                    double gy = k[1]*x + 2.0*k[2]*y + k[4];
+                    if (q*q <= t*t * (gx*gx + gy*gy)) {
+                        xs[m] = x;
+                        ys[m] = y;
+                        m++;
+                    }
+                }
+                job->ok[g] = m >= job->p->min_chain &&
+                             accept_ellipse(rc.coeffs, xs, ys, m, job->p, w, vc->height, &job->dets[g]);
+            }
+        }
+        free(xs);
+    }
+}
+
+static int by_pixels_desc(const void* a, const void* b) {
+    const VisionDetection* x = a;
+    const VisionDetection* y = b;
+    return (x->pixels < y->pixels) - (x->pixels > y->pixels);
+}
+
+/**
+ * @brief Ajusta los búferes de trabajo al tamaño del fotograma.
+ */
+static bool ensure_buffers(VisionContext* ctx, uint32_t w, uint32_t h) {
+    if (ctx->width == w && ctx->height == h && ctx->gray) return true;
+    vision_free(ctx);
+
+    size_t n = (size_t)w * h;
+    ctx->width = w;
+    ctx->height = h;
+    ctx->gray = malloc(n);
+    ctx->gx = malloc(n * sizeof(int16_t));
+    ctx->gy = malloc(n * sizeof(int16_t));
+    ctx->mag = calloc(n, sizeof(uint16_t));
+    ctx->edges = calloc(n, 1);
+    ctx->stack = malloc(n * sizeof(uint32_t));
+    ctx->pixels = malloc(n * sizeof(uint32_t));
+    ctx->group_cap = 256;
+    ctx->groups = malloc(ctx->group_cap * sizeof(uint32_t));
+    if (!ctx->gray || !ctx->gx || !ctx->gy || !ctx->mag || !ctx->edges || !ctx->stack ||
+        !ctx->pixels || !ctx->groups) {
+        vision_free(ctx);
+        return false;
+    }
+    return true;
+}
+
+//-------------------------------------------//
+//                API PÚBLICA                //
+//-------------------------------------------//
+
+void vision_default_params(VisionParams* p) {
+    p->low = 80;
+    p->high = 200;
+    p->min_chain = 40;
+    p->max_residual = 1.0;
+    p->min_coverage = 0.35;
+    p->min_axis = 5.0;
+    p->robust = true;
+    p->max_detections = 16;
+}
+
+void vision_init(VisionContext* ctx) {
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+void vision_free(VisionContext* ctx) {
+    free(ctx->gray);
+    free(ctx->gx);
+    free(ctx->gy);
+    free(ctx->mag);
+    free(ctx->edges);
+    free(ctx->stack);
+    free(ctx->pixels);
+    free(ctx->groups);
+    vision_init(ctx);
+}
+
+bool vision_detect(VisionContext* ctx, const VisionFrame* frame, const VisionParams* p,
+                   VisionDetection* out, size_t* count) {
+    *count = 0;
+    uint32_t w = frame->width, h = frame->height, ch = frame->channels;
+    if (w < 3 || h < 3 || (ch != 1 && ch != 3 && ch != 4) || !frame->data) return false;
+    if (!ensure_buffers(ctx, w, h)) return false;
+
+    // 1. Gris (sin copia si el fotograma ya es gris compacto)
+    const uint8_t* gray = frame->data;
+    if (ch != 1 || (frame->stride && frame->stride != w)) {
+        GrayJob gj = { frame, ctx->gray };
+        tp_parallel_for(0, h, VISION_ROW_GRAIN, gray_range, &gj);
+        gray = ctx->gray;
+    }
+
+    // 2-3. Sobel y no máximos (las filas de borde quedan a cero)
+    FilterJob fj = { gray, ctx, p->low, p->high };
+    tp_parallel_for(1, h - 1, VISION_ROW_GRAIN, sobel_range, &fj);
+    tp_parallel_for(1, h - 1, VISION_ROW_GRAIN, nms_range, &fj);
+    memset(ctx->edges, 0, w);
+    memset(ctx->edges + (size_t)(h - 1) * w, 0, w);
+
+    // 4. Histéresis y grupos
+    if (!group_edges(ctx, p->min_chain > 5 ? p->min_chain : 5)) return false;
+    size_t ng = ctx->group_count;
+    if (ng == 0) return true;
+
+    // 5. Ajuste por grupo
+    VisionDetection* dets = malloc(ng * sizeof(VisionDetection));
+    bool* ok = malloc(ng * sizeof(bool));
+    if (!dets || !ok) {
+        free(dets);
+        free(ok);
+        return false;
+    }
+    FitJob job = { ctx, p, dets, ok };
+    tp_parallel_for(0, ng, 1, fit_range, &job);
+
+    size_t m = 0;
+    for (size_t g = 0; g < ng; g++)
+        if (ok[g]) dets[m++] = dets[g];
+    qsort(dets, m, sizeof(VisionDetection), by_pixels_desc);
+    if (m > p->max_detections) m = p->max_detections;
+    memcpy(out, dets, m * sizeof(VisionDetection));
+    *count = m;
+
+    free(dets);
+    free(ok);
+    return true;
+}
+
+bool vision_map_file(const char* path, VisionMapping* m) {
+    m->data = NULL;
+    m->size = 0;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+    void* p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return false;
+
+    m->data = p;
+    m->size = (size_t)st.st_size;
+    return true;
+}
+
+void vision_unmap(VisionMapping* m) {
+    if (m->data) munmap((void*)m->data, m->size);
+    m->data = NULL;
+    m->size = 0;
+}
@@ -0,0 +1,94 @@
+//================================================================//
+//        VISION HEADER - Detección de elipses en fotogramas      //
+//================================================================//
+//
+// Tubería por fotograma (gris o RGBA, 8 bits por canal):
+//   1. escala de grises (pesos enteros 77/150/29)
+//   2. Sobel 3x3 en int16 y magnitud L1 |gx| + |gy|
+//   3. Canny: supresión de no máximos en 4 sectores y doble umbral
+//   4. histéresis por componentes 8-conexas: cada cadena de bordes
+//      que contiene algún píxel fuerte es un grupo candidato
+//   5. ajuste de elipse por grupo (fit.h), con RANSAC si el grupo mezcla
+//      la elipse con otros bordes, y filtros de residuo y cobertura
+// Los pasos 1-3 y 5 se reparten por filas/grupos en el pool de hilos.
+//
+// Un VisionContext guarda los búferes de trabajo para procesar vídeo sin
+// reservar memoria en cada fotograma. Coordenadas en píxeles (x a la
+// derecha, y hacia abajo).
+//
+
+#ifndef VISION_H
+#define VISION_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    const uint8_t* data;
+    uint32_t width, height;
+    uint32_t stride;            // bytes por fila (0 = width·channels)
+    uint32_t channels;          // 1 (gris), 3 (RGB) o 4 (RGBA)
+} VisionFrame;
+
+typedef struct {
+    uint16_t low, high;         // umbrales de Canny sobre |gx| + |gy|
+    uint32_t min_chain;         // píxeles mínimos de un grupo
+    double   max_residual;      // distancia de Sampson media máxima (px)
+    double   min_coverage;      // píxeles / perímetro mínimo
+    double   min_axis;          // semieje menor mínimo (px)
+    bool     robust;            // RANSAC sobre grupos rechazados
+    uint32_t max_detections;
+} VisionParams;
+
+typedef struct {
+    double   coeffs[6];
+    double   cx, cy, a, b, theta;   // elipse en forma geométrica
+    uint32_t pixels;                // píxeles de borde que la soportan
+    double   residual;              // distancia de Sampson media (px)
+    double   coverage;              // pixels / perímetro
+} VisionDetection;
+
+/**
+ * Búferes de trabajo reutilizables entre fotogramas.
+ */
+typedef struct {
+    uint32_t width, height;
+    uint8_t*  gray;
+    int16_t*  gx;
+    int16_t*  gy;
+    uint16_t* mag;
+    uint8_t*  edges;
+    uint32_t* stack;
+    uint32_t* pixels;           // píxeles de todos los grupos, contiguos
+    uint32_t* groups;           // offsets de grupo (CSR)
+    size_t    group_cap;
+    uint32_t  edge_pixels;      // píxeles de borde del último fotograma
+    uint32_t  group_count;      // grupos candidatos del último fotograma
+} VisionContext;
+
+/**
+ * Fichero de fotogramas proyectado en memoria (p.ej. en /dev/shm).
+ */
+typedef struct {
+    const uint8_t* data;
+    size_t size;
+} VisionMapping;
+
+void vision_default_params(VisionParams* p);
+
+void vision_init(VisionContext* ctx);
+void vision_free(VisionContext* ctx);
+
+/**
+ * Procesa un fotograma. out recibe hasta p->max_detections elipses
+ * ordenadas por píxeles de soporte. Devuelve false si no hay memoria o
+ * el fotograma no es válido.
+ */
+bool vision_detect(VisionContext* ctx, const VisionFrame* frame, const VisionParams* p,
+                   VisionDetection* out, size_t* count);
+
+bool vision_map_file(const char* path, VisionMapping* m);
+void vision_unmap(VisionMapping* m);
+
+#endif
@@ -6,17 +6,12 @@
 # Módulos y dependencias
 #--------------------------------#
 import json
-import matplotlib.pyplot as plt
+import subprocess
+import sys
 import asyncio
 import websockets
 
-try:
-    import numpy as np
-    has_numpy = True
-except Exception:
-    import math
-    has_numpy = False
-
+CORE_BIN = "/app/Core/bin/conicrypt"
 DATA_PATH = "/app/Data/conic.json"
 OUTPUT_PATH = "/app/Output/conic_plot.png"
 
@@ -30,44 +25,27 @@ except FileNotFoundError:
     print(f"[ERROR] No se encontró el archivo {DATA_PATH}")
     exit(1)
 
-if "delta" not in data or "type" not in data:
-    print("[ERROR] El archivo JSON no tiene los campos esperados (delta, type).")
+# La salida del modo "conic" trae los coeficientes en "coefficients";
+# se aceptan también A..F en la raíz
+coeffs = data.get("coefficients", data)
+if not all(k in coeffs for k in ("A", "B", "C")):
+    print("[ERROR] El archivo JSON no tiene los coeficientes de la cónica (A..F).")
     exit(1)
 
-# Generar puntos
-if has_numpy:
-    x = np.linspace(-10, 10, 400)
-    scale = np.sqrt(abs((data["delta"]) / 4.0))
-    y = scale * x
-else:
-    import math
-    def linspace(a, b, num):
-        """Genera una lista de valores 
-
-        Argumentos:
-            a (float): Valor inicial.
-            b (float): Valor final.
-            num (int): Número de puntos.
+# El núcleo dibuja la curva real (modo "raster": antialias analítico y
+# PNG propio), sin arrancar matplotlib
+request = {"mode": "raster", "output": OUTPUT_PATH, "width": 800, "height": 800}
+for k in ("A", "B", "C", "D", "E", "F"):
+    request[k] = coeffs.get(k, 0)
 
-        Returns:
-            list: Lista de valores equiespaciados.
-        """
-        if num <= 1:
-            return [a]
-        step = (b - a) / (num - 1)
-        return [a + i * step for i in range(num)]
-    x = linspace(-10, 10, 400)
-    scale = math.sqrt(abs((data["delta"]) / 4.0))
-    y = [scale * xi for xi in x]
-
-plt.figure(figsize=(6, 4))
-plt.plot(x, y, label=f'{data["type"]}')
-plt.title("Conic visualization")
-plt.legend()
-plt.grid(True)
-plt.savefig(OUTPUT_PATH)
+proc = subprocess.run([CORE_BIN], input=json.dumps(request),
+                      capture_output=True, text=True, timeout=10)
+if proc.returncode != 0:
+    print(f"[ERROR] El núcleo no pudo dibujar la cónica: {proc.stderr.strip()}")
+    exit(1)
 
-print(f"[OK] Gráfica guardada en {OUTPUT_PATH}")
+print(f"[OK] Gráfica guardada en {OUTPUT_PATH} "
+      f"({json.loads(proc.stdout).get('compute_ms', 0):.1f} ms)")
 
 # =====================================================
 # Notificación al WebSocket de Tauri 
@@ -90,7 +68,6 @@ async def notify_update():
             await ws.send(payload)
             print("[plotter]  Notificación enviada:", payload)
     except Exception as e:
-        import sys
         print("[plotter]  Error al notificar:", e, file=sys.stderr)
 
 if __name__ == "__main__":
@@ -1,98 +1,379 @@
-from flask import Flask, request, jsonify
+from flask import Flask, Response, request, jsonify
 from flask_cors import CORS
 import subprocess
+import itertools
 import json
+import math
 import os
+import queue
+import tempfile
+import threading
+import time
 
 app = Flask(__name__)
 CORS(app)
 
 CORE_BIN = "/app/Core/bin/conicrypt"
 
+# Los fotogramas se pasan al núcleo por memoria compartida cuando existe
+# /dev/shm: el núcleo los proyecta con mmap sin copiarlos.
+FRAME_DIR = "/dev/shm" if os.path.isdir("/dev/shm") else None
 
-@app.route("/conic", methods=["POST"])
-def conic():
+DETECT_PARAMS = ("low", "high", "min_chain", "max_residual", "min_coverage",
+                 "min_axis", "max_detections")
+
+# Claves que cada ruta deja pasar al núcleo. El modo lo fija el servidor
+# y ninguna ruta acepta rutas de fichero ("input", "output", ...).
+CONIC_PARAMS = ("window", "samples", "simplify", "tolerance", "width", "height",
+                "budget_ms")
+
+PROGRESSIVE_PARAMS = CONIC_PARAMS + ("coarse_samples",)
+
+VERTEX_PARAMS = ("window", "samples", "simplify", "tolerance", "width", "height",
+                 "line_width", "conics")
+
+RASTER_PARAMS = ("window", "width", "height", "line_width", "color", "background",
+                 "axes", "conics")
+
+RASTER_MIMETYPES = {"png": "image/png", "qoi": "image/qoi"}
+
+# Parte del timeout que se da al núcleo como "budget_ms": al vencer
+# devuelve lo que tenga con "truncated":true en vez de morir con un 504.
+CORE_BUDGET_FRACTION = 0.8
+
+
+def read_object():
+    """Cuerpo JSON de la petición si es un objeto no vacío (si no, None)."""
     data = request.get_json(silent=True)
-    if not data:
-        return jsonify({"ok": False, "error": "Invalid JSON"}), 400
+    return data if isinstance(data, dict) and data else None
+
+
+def core_payload(data, mode, params):
+    """Payload para el núcleo: el modo de la ruta, A..F y las claves params."""
+    payload = {"mode": mode}
+    for key in ("A", "B", "C", "D", "E", "F") + params:
+        if key in data:
+            payload[key] = data[key]
+    return payload
+
+
+def with_budget(payload, timeout):
+    """Añade budget_ms al payload si el cliente no pidió uno menor.
 
+    Un budget_ms que no sea un número finito y positivo (texto, booleano,
+    NaN, <= 0, que el núcleo leería como "sin plazo") se ignora.
+    """
+    budget = timeout * 1000 * CORE_BUDGET_FRACTION
+    asked = payload.get("budget_ms")
     try:
-        payload = json.dumps(data)
+        asked = float(asked) if not isinstance(asked, bool) else None
+    except (TypeError, ValueError):
+        asked = None
+    if asked is None or not math.isfinite(asked) or asked <= 0:
+        asked = budget
+    payload["budget_ms"] = min(asked, budget)
+    return payload
+
+
+class CoreServer:
+    """Núcleo residente (conicrypt --serve) compartido por las peticiones.
+
+    Cada petición va como una línea con un "id" propio y un hilo lector
+    reparte las líneas NDJSON de la salida a la cola de su id; la última
+    de cada petición es la que trae "ok". Así no se paga un arranque de
+    proceso por petición, las peticiones corren a la vez sobre el mismo
+    pool de hilos y una que vence su timeout se cancela ({"cancel": id})
+    en lugar de matar el proceso. Si el núcleo muere, las peticiones en
+    curso fallan con "core_exited" y la siguiente lo relanza.
+
+    self.lock solo protege proc y pending; las escrituras en stdin van bajo
+    write_lock. Una escritura puede bloquearse si el núcleo no lee mientras
+    espera a que se vacíe su stdout, y eso depende del hilo lector: si este
+    necesitara el mismo cerrojo que la escritura, se bloquearían los dos.
+    """
 
-        proc = subprocess.Popen(
-            [CORE_BIN],
+    def __init__(self, binary):
+        self.binary = binary
+        self.lock = threading.Lock()
+        self.write_lock = threading.Lock()
+        self.proc = None
+        self.pending = {}
+        self.ids = itertools.count(1)
+
+    def _ensure(self):
+        """Arranca el proceso si no está vivo (con self.lock tomado)."""
+        if self.proc is not None and self.proc.poll() is None:
+            return
+        self.proc = subprocess.Popen(
+            [self.binary, "--serve"],
             stdin=subprocess.PIPE,
             stdout=subprocess.PIPE,
-            stderr=subprocess.PIPE,
-            text=True
+            stderr=subprocess.DEVNULL,
+            text=True,
+            bufsize=1
         )
+        threading.Thread(target=self._read, args=(self.proc,), daemon=True).start()
 
-        stdout, stderr = proc.communicate(payload, timeout=5)
+    def _read(self, proc):
+        for line in proc.stdout:
+            try:
+                msg = json.loads(line)
+            except json.JSONDecodeError:
+                continue
+            with self.lock:
+                entry = self.pending.get(msg.get("id"))
+            if entry:
+                entry[1].put(msg)
 
-        if proc.returncode != 0:
-            return jsonify({
-                "ok": False,
-                "error": "Core execution failed",
-                "stderr": stderr,
-                "stdout": stdout
-            }), 500
+        with self.lock:
+            orphans = [q for owner, q in self.pending.values() if owner is proc]
+        for q in orphans:
+            q.put({"ok": False, "error": "core_exited"})
 
-        if not stdout.strip():
-            return jsonify({
-                "ok": False,
-                "error": "Core returned empty output"
-            }), 500
+    def _send(self, proc, message):
+        with self.write_lock:
+            proc.stdin.write(json.dumps(message) + "\n")
+            proc.stdin.flush()
+
+    def frames(self, payload, timeout):
+        """Genera las líneas de una petición (sin "id") hasta la final.
 
+        Lanza TimeoutError si no termina en timeout segundos; si se deja de
+        consumir antes de la final, la petición se cancela en el núcleo.
+        """
+        rid = next(self.ids)
+        replies = queue.Queue()
+        with self.lock:
+            self._ensure()
+            proc = self.proc
+            self.pending[rid] = (proc, replies)
         try:
-            result = json.loads(stdout)
+            self._send(proc, dict(payload, id=rid))
+        except OSError:
+            with self.lock:
+                self.pending.pop(rid, None)
+            raise
+
+        deadline = time.monotonic() + timeout
+        done = False
+        try:
+            while not done:
+                try:
+                    msg = replies.get(timeout=max(deadline - time.monotonic(), 0))
+                except queue.Empty:
+                    raise TimeoutError from None
+                msg.pop("id", None)
+                done = "ok" in msg
+                yield msg
+        finally:
+            with self.lock:
+                self.pending.pop(rid)
+            if not done and proc.poll() is None:
+                try:
+                    self._send(proc, {"cancel": rid})
+                except OSError:
+                    pass
+
+
+CORE = CoreServer(CORE_BIN)
+
+
+def run_core(payload, timeout=5):
+    """Ejecuta el núcleo con un JSON y devuelve (resultado, respuesta_error).
+
+    Va por el núcleo residente: el resultado es la línea final de la
+    petición.
+    """
+    try:
+        for result in CORE.frames(with_budget(payload, timeout), timeout):
+            pass
+    except TimeoutError:
+        return None, (jsonify({"ok": False, "error": "Core timeout"}), 504)
+    except OSError as e:
+        return None, (jsonify({"ok": False, "error": "Core unavailable", "exception": str(e)}), 500)
+
+    if result.get("error") == "core_exited":
+        return None, (jsonify(result), 500)
+    if not result.get("ok"):
+        return None, (jsonify(result), 400)
+    return result, None
+
+
+def run_core_binary(payload, timeout=5):
+    """Como run_core, pero para modos que escriben un binario en stdout.
+
+    Lanza un proceso por petición: en --serve "stdout" se ignora.
+    """
+    proc = subprocess.Popen(
+        [CORE_BIN],
+        stdin=subprocess.PIPE,
+        stdout=subprocess.PIPE,
+        stderr=subprocess.PIPE
+    )
+    try:
+        stdout, stderr = proc.communicate(json.dumps(with_budget(payload, timeout)).encode(),
+                                          timeout=timeout)
+    except subprocess.TimeoutExpired:
+        proc.kill()
+        proc.communicate()
+        return None, (jsonify({"ok": False, "error": "Core timeout"}), 504)
+
+    if proc.returncode != 0:
+        try:
+            return None, (jsonify(json.loads(stdout)), 400)
         except json.JSONDecodeError:
-            return jsonify({
+            return None, (jsonify({
                 "ok": False,
-                "error": "Invalid JSON returned by core",
-                "raw": stdout
-            }), 500
+                "error": "Core execution failed",
+                "stderr": stderr.decode(errors="replace")
+            }), 500)
+    return stdout, None
+
+
+@app.route("/conic", methods=["POST"])
+def conic():
+    data = read_object()
+    if data is None:
+        return jsonify({"ok": False, "error": "Invalid JSON"}), 400
 
+    result, error = run_core(core_payload(data, "conic", CONIC_PARAMS))
+    if error:
+        return error
 
-        # ===== DEBUG / LOGS =====
-        print("====== CONIC ANALYSIS RESULT ======")
-        print(f"Tipo        : {result.get('type')}")
-        print(f"Delta (Δ)   : {result.get('delta')}")
+    # ===== DEBUG / LOGS =====
+    print("====== CONIC ANALYSIS RESULT ======")
+    print(f"Tipo        : {result.get('type')}")
+    print(f"Delta (Δ)   : {result.get('delta')}")
 
-        center = result.get("center", {})
-        if center.get("exists"):
-            print(f"Centro      : ({center.get('x')}, {center.get('y')})")
-        else:
-            print("Centro      : No existe")
+    center = result.get("center", {})
+    if center.get("exists"):
+        print(f"Centro      : ({center.get('x')}, {center.get('y')})")
+    else:
+        print("Centro      : No existe")
 
-        canonical = result.get("canonical", {})
-        if canonical.get("exists"):
-            print(f"Forma can.  : a={canonical.get('a')}, b={canonical.get('b')}")
-        else:
-            print("Forma can.  : No disponible")
+    canonical = result.get("canonical", {})
+    if canonical.get("exists"):
+        print(f"Forma can.  : a={canonical.get('a')}, b={canonical.get('b')}")
+    else:
+        print("Forma can.  : No disponible")
 
-        rotation = result.get("rotation", {})
-        if rotation.get("has_rotation"):
-            print(f"Rotación    : θ={rotation.get('theta')}")
-        else:
-            print("Rotación    : No")
+    rotation = result.get("rotation", {})
+    if rotation.get("has_rotation"):
+        print(f"Rotación    : θ={rotation.get('theta')}")
+    else:
+        print("Rotación    : No")
 
-        print(f"Puntos      : {len(result.get('points', []))}")
-        print("===================================")
+    print(f"Puntos      : {len(result.get('points', []))}")
+    print(f"Segmentos   : {len(result.get('segments', []))}")
+    print("===================================")
 
-        return jsonify(result), 200
+    return jsonify(result), 200
 
-    except subprocess.TimeoutExpired:
-        return jsonify({
-            "ok": False,
-            "error": "Core timeout"
-        }), 504
-
-    except Exception as e:
-        return jsonify({
-            "ok": False,
-            "error": "Unhandled server error",
-            "exception": str(e)
-        }), 500
+
+@app.route("/conic/progressive", methods=["POST"])
+def conic_progressive():
+    """Análisis por fotogramas (modo "progressive" del núcleo).
+
+    Reenvía cada línea NDJSON según el núcleo la escribe: invariantes,
+    polilínea gruesa y refinamientos, y al final {"ok":true,"frame":"done"}.
+    El cliente puede pintar con el primer fotograma sin esperar al resto;
+    si corta la conexión, la petición se cancela en el núcleo residente.
+    """
+    data = read_object()
+    if data is None:
+        return jsonify({"ok": False, "error": "Invalid JSON"}), 400
+
+    payload = with_budget(core_payload(data, "progressive", PROGRESSIVE_PARAMS), 5)
+
+    def frames():
+        try:
+            for msg in CORE.frames(payload, 5):
+                yield json.dumps(msg) + "\n"
+        except TimeoutError:
+            yield json.dumps({"ok": False, "error": "Core timeout"}) + "\n"
+
+    return Response(frames(), mimetype="application/x-ndjson")
+
+
+@app.route("/conic/vertices", methods=["POST"])
+def conic_vertices():
+    """Buffer Float32 de vértices (modo "vertices" del núcleo, ver vertices.h).
+
+    Cuerpo JSON con los coeficientes A..F (o "conics") y las opciones de
+    muestreo. Responde application/octet-stream, listo para la GPU.
+    """
+    data = read_object()
+    if data is None:
+        return jsonify({"ok": False, "error": "Invalid JSON"}), 400
+
+    payload = dict(core_payload(data, "vertices", VERTEX_PARAMS), stdout=True)
+
+    body, error = run_core_binary(payload)
+    if error:
+        return error
+    return Response(body, mimetype="application/octet-stream")
+
+
+@app.route("/conic/plot", methods=["POST"])
+def conic_plot():
+    """Imagen de una cónica o escena (modo "raster" del núcleo, ver raster.h).
+
+    Cuerpo JSON con A..F (o "conics") y las opciones de dibujo; "format"
+    elige png (por defecto) o qoi. Responde la imagen directamente.
+    """
+    data = read_object()
+    if data is None:
+        return jsonify({"ok": False, "error": "Invalid JSON"}), 400
+
+    fmt = data.get("format", "png")
+    if fmt not in RASTER_MIMETYPES:
+        return jsonify({"ok": False, "error": "Invalid format"}), 400
+
+    payload = dict(core_payload(data, "raster", RASTER_PARAMS), format=fmt, stdout=True)
+
+    body, error = run_core_binary(payload)
+    if error:
+        return error
+    return Response(body, mimetype=RASTER_MIMETYPES[fmt])
+
+
+@app.route("/detect", methods=["POST"])
+def detect():
+    """Detección de elipses en un fotograma crudo (cuerpo binario).
+
+    Parámetros en la query: width, height, channels (4 = RGBA) y los
+    umbrales opcionales del modo "detect" del núcleo. El cuerpo se copia
+    una vez a un fichero de FRAME_DIR, que el núcleo residente proyecta
+    con mmap: el búfer no se comparte con el cliente.
+    """
+    try:
+        width = int(request.args.get("width", 0))
+        height = int(request.args.get("height", 0))
+        channels = int(request.args.get("channels", 4))
+    except ValueError:
+        return jsonify({"ok": False, "error": "Invalid frame size"}), 400
+
+    frame = request.get_data(cache=False)
+    if width <= 0 or height <= 0 or len(frame) != width * height * channels:
+        return jsonify({"ok": False, "error": "Frame size mismatch"}), 400
+
+    payload = {"mode": "detect", "width": width, "height": height, "channels": channels}
+    for key in DETECT_PARAMS:
+        if key in request.args:
+            try:
+                payload[key] = float(request.args[key])
+            except ValueError:
+                return jsonify({"ok": False, "error": f"Invalid {key}"}), 400
+
+    with tempfile.NamedTemporaryFile(dir=FRAME_DIR, suffix=".raw") as tmp:
+        tmp.write(frame)
+        tmp.flush()
+        payload["frame_file"] = tmp.name
+        result, error = run_core(payload)
+
+    if error:
+        return error
+    return jsonify(result), 200
 
 
 if __name__ == "__main__":
@@ -6,7 +6,7 @@ make -C ../Core
 echo " Ejecutando análisis de cónica..."
 echo '{"A":1,"B":0,"C":1,"D":0,"E":0,"F":-9}' | ../Core/bin/conicrypt --conic > ../Data/conic.json
 
-echo "Generando gráfica con Python..."
+echo " Generando gráfica (núcleo, modo raster)..."
 python3 ../Python/plot_conics.py
 
 echo " Proceso completo. Resultado en /Output/"